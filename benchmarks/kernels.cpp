@@ -0,0 +1,619 @@
+// benchmarks of the numerical kernels of bssm, run outside of R
+//
+// built as target bssm_benchmarks of CMakeLists.txt, linked to the core
+// library compiled without R
+//
+// usage: bssm_benchmarks [output.csv] [repetitions]
+//
+// each kernel is run once as a warm-up and then the given number of times
+// (default 5), and the median and minimum wall clock times are written as
+// comma separated values with the dimensions of the model, one row per kernel
+// and setting. The data are simulated with a fixed seed so that the results
+// of different versions can be compared.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/ugg_ssm.h"
+#include "../src/ung_ssm.h"
+#include "../src/nlg_ssm.h"
+#include "../inst/include/bssm/nlg_static.h"
+#include "../src/sde_ssm.h"
+#include "../src/msde_ssm.h"
+#include "../src/mgg_ssm.h"
+#include "../src/conditional_dist.h"
+#include "../src/filter_smoother.h"
+#include "../src/summary.h"
+
+namespace {
+
+// results are accumulated here so that the kernels are not optimized away
+volatile double sink = 0.0;
+
+struct setting {
+  unsigned int m;
+  unsigned int n;
+  unsigned int p;
+  unsigned int nsim;
+  unsigned int time_varying;
+};
+
+class benchmark_output {
+
+public:
+
+  benchmark_output(std::ostream& out, const unsigned int reps) : out(out), reps(reps) {
+    out << "kernel,m,n,p,nsim,time_varying,reps,median_s,min_s" << std::endl;
+  }
+
+  // time f() after a warm-up run
+  template <class F>
+  void run(const std::string& kernel, const setting& s, F& f) {
+    sink = sink + f();
+    std::vector<double> times(reps);
+    for (unsigned int i = 0; i < reps; i++) {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      sink = sink + f();
+      times[i] = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    }
+    std::sort(times.begin(), times.end());
+    double median = reps % 2 ? times[reps / 2] :
+      (times[reps / 2 - 1] + times[reps / 2]) / 2.0;
+    out << kernel << "," << s.m << "," << s.n << "," << s.p << "," << s.nsim << "," <<
+      s.time_varying << "," << reps << "," << median << "," << times[0] << std::endl;
+  }
+
+private:
+  std::ostream& out;
+  const unsigned int reps;
+};
+
+// random numbers from std distributions with sitmo, so that the data are the
+// same with all versions of armadillo
+arma::mat rnorm(const unsigned int n_rows, const unsigned int n_cols,
+  sitmo::prng_engine& engine) {
+  std::normal_distribution<> normal(0.0, 1.0);
+  arma::mat x(n_rows, n_cols);
+  for (unsigned int i = 0; i < x.n_elem; i++) {
+    x(i) = normal(engine);
+  }
+  return x;
+}
+
+// random walk model with m states, the sum of the states is observed
+ugg_ssm random_walk_model(const setting& s, sitmo::prng_engine& engine) {
+
+  arma::mat Z(s.m, s.time_varying ? s.n : 1, arma::fill::ones);
+  arma::cube T(s.m, s.m, s.time_varying ? s.n : 1);
+  arma::cube R(s.m, s.m, s.time_varying ? s.n : 1);
+  for (unsigned int t = 0; t < T.n_slices; t++) {
+    T.slice(t).eye();
+    R.slice(t) = 0.1 * arma::eye(s.m, s.m);
+  }
+  if (s.time_varying) {
+    Z += 0.1 * rnorm(s.m, s.n, engine);
+  }
+  arma::vec a1(s.m, arma::fill::zeros);
+  arma::mat P1 = arma::eye(s.m, s.m);
+  arma::vec H(1);
+  H(0) = 1.0;
+  arma::vec y = arma::cumsum(arma::vectorise(rnorm(s.n, 1, engine)));
+  return ugg_ssm(y, Z, H, T, R, a1, P1, arma::mat(s.n, 0), arma::vec(0),
+    arma::zeros(1), arma::zeros(s.m, 1), 1);
+}
+
+// poisson model with the same states as in random_walk_model
+ung_ssm poisson_model(const setting& s, sitmo::prng_engine& engine) {
+
+  ugg_ssm gaussian = random_walk_model(s, engine);
+  gaussian.R *= 0.1;
+  arma::vec signal = arma::sum(gaussian.Z, 0).t() %
+    arma::cumsum(arma::vectorise(0.1 * rnorm(s.n, 1, engine)));
+  arma::vec y(s.n);
+  for (unsigned int t = 0; t < s.n; t++) {
+    std::poisson_distribution<> poisson(std::exp(std::min(signal(t), 5.0)));
+    y(t) = poisson(engine);
+  }
+  return ung_ssm(y, gaussian.Z, gaussian.T, gaussian.R, gaussian.a1, gaussian.P1,
+    1.0, arma::ones(s.n), 1, arma::mat(s.n, 0), arma::vec(0), arma::zeros(1),
+    arma::zeros(s.m, 1), 1);
+}
+
+// nonlinear model y_t = exp(alpha_1t / 2) + sum(sin(alpha_t)) + eps_t,
+// alpha_t+1 = 0.9 * alpha_t + 0.1 * sin(alpha_t) + eta_t, with p
+// observations per time point. The observation equation of time point t
+// is scaled by known_tv_params when the model is time-varying
+arma::vec nlg_Z(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::vec Z(static_cast<unsigned int>(known_params(0)));
+  for (unsigned int i = 0; i < Z.n_elem; i++) {
+    Z(i) = std::exp(alpha(0) / 2.0) / (i + 1.0) + arma::accu(arma::sin(alpha));
+  }
+  return Z * known_tv_params(0, t * (known_tv_params.n_cols > 1));
+}
+arma::mat nlg_H(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  return theta(0) * arma::eye(known_params(0), known_params(0));
+}
+arma::vec nlg_T(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  return 0.9 * alpha + 0.1 * arma::sin(alpha);
+}
+arma::mat nlg_R(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  return theta(1) * arma::eye(alpha.n_elem, alpha.n_elem);
+}
+arma::mat nlg_Zg(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::mat Zg(static_cast<unsigned int>(known_params(0)), alpha.n_elem);
+  for (unsigned int i = 0; i < Zg.n_rows; i++) {
+    Zg.row(i) = arma::cos(alpha).t();
+    Zg(i, 0) += std::exp(alpha(0) / 2.0) / (2.0 * (i + 1.0));
+  }
+  return Zg * known_tv_params(0, t * (known_tv_params.n_cols > 1));
+}
+arma::mat nlg_Tg(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  return arma::diagmat(0.9 + 0.1 * arma::cos(alpha));
+}
+arma::vec nlg_a1(const arma::vec& theta, const arma::vec& known_params) {
+  return arma::zeros(known_params(1));
+}
+arma::mat nlg_P1(const arma::vec& theta, const arma::vec& known_params) {
+  return arma::eye(known_params(1), known_params(1));
+}
+double nlg_prior(const arma::vec& theta) {
+  return 0.0;
+}
+
+nlg_ssm nonlinear_model(const setting& s, sitmo::prng_engine& engine) {
+
+  arma::vec theta(2);
+  theta(0) = 0.5;
+  theta(1) = 0.1;
+  arma::vec known_params(2);
+  known_params(0) = s.p;
+  known_params(1) = s.m;
+  arma::mat known_tv_params = arma::ones(1, s.time_varying ? s.n : 1);
+  if (s.time_varying) {
+    known_tv_params += 0.1 * arma::abs(rnorm(1, s.n, engine));
+  }
+  arma::uvec time_varying(4);
+  time_varying.fill(s.time_varying);
+  arma::mat y = rnorm(s.p, s.n, engine);
+  return nlg_ssm(y, nlg_Z, nlg_H, nlg_T, nlg_R, nlg_Zg, nlg_Tg, nlg_a1, nlg_P1,
+    theta, nlg_prior, known_params, known_tv_params, s.m, s.m, time_varying, 1);
+}
+
+// the same nonlinear model with the model functions known at compile time,
+// with the Jacobians of Z and T by automatic differentiation
+template <unsigned int M, unsigned int P>
+struct static_nonlinear : nlg_static_ad<static_nonlinear<M, P>, M, M, P> {
+
+  typedef nlg_static_dims<M, M, P> dims;
+
+  template <class S>
+  static void Z_fn(const unsigned int t, const S* alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params, S* result) {
+    using std::exp;
+    using std::sin;
+    S tmp = sin(alpha[0]);
+    for (unsigned int i = 1; i < M; i++) {
+      tmp += sin(alpha[i]);
+    }
+    double scale = known_tv_params(0, t * (known_tv_params.n_cols > 1));
+    for (unsigned int i = 0; i < P; i++) {
+      result[i] = (exp(alpha[0] / 2.0) / (i + 1.0) + tmp) * scale;
+    }
+  }
+  template <class S>
+  static void T_fn(const unsigned int t, const S* alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params, S* result) {
+    using std::sin;
+    for (unsigned int i = 0; i < M; i++) {
+      result[i] = 0.9 * alpha[i] + 0.1 * sin(alpha[i]);
+    }
+  }
+  static typename dims::obs_mat H(const unsigned int t,
+    const typename dims::state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    typename dims::obs_mat H(arma::fill::eye);
+    return theta(0) * H;
+  }
+  static typename dims::noise_mat R(const unsigned int t,
+    const typename dims::state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    typename dims::noise_mat R(arma::fill::eye);
+    return theta(1) * R;
+  }
+  static typename dims::state_vec a1(const arma::vec& theta,
+    const arma::vec& known_params) {
+    return typename dims::state_vec(arma::fill::zeros);
+  }
+  static typename dims::state_mat P1(const arma::vec& theta,
+    const arma::vec& known_params) {
+    return typename dims::state_mat(arma::fill::eye);
+  }
+  static double log_prior_pdf(const arma::vec& theta) {
+    return 0.0;
+  }
+};
+
+// geometric Brownian motion observed with gaussian noise
+double sde_drift(const double x, const arma::vec& theta) {
+  return theta(0) * x;
+}
+double sde_diffusion(const double x, const arma::vec& theta) {
+  return theta(1) * x;
+}
+double sde_ddiffusion(const double x, const arma::vec& theta) {
+  return theta(1);
+}
+double sde_prior(const arma::vec& theta) {
+  return 0.0;
+}
+arma::vec sde_obs_density(const double y, const arma::vec& alpha,
+  const arma::vec& theta) {
+  return -0.5 * arma::square(y - alpha) / (theta(2) * theta(2)) - std::log(theta(2));
+}
+
+sde_ssm sde_model(const setting& s, sitmo::prng_engine& engine) {
+  arma::vec theta(3);
+  theta(0) = 0.01;
+  theta(1) = 0.1;
+  theta(2) = 0.5;
+  arma::vec y = 1.0 + arma::cumsum(arma::vectorise(0.1 * rnorm(s.n, 1, engine)));
+  return sde_ssm(y, theta, 1.0, true, 1, sde_drift, sde_diffusion, sde_ddiffusion,
+    sde_prior, sde_obs_density);
+}
+
+// m geometric Brownian motions driven by two common Brownian motions (which
+// gives commutative noise), observed with gaussian noise
+arma::vec msde_drift(const arma::vec& x, const arma::vec& theta) {
+  return theta(0) * x;
+}
+arma::mat msde_diffusion(const arma::vec& x, const arma::vec& theta) {
+  arma::mat sigma(x.n_elem, 2);
+  sigma.col(0) = theta(1) * x;
+  sigma.col(1) = 0.5 * theta(1) * x;
+  return sigma;
+}
+arma::cube msde_ddiffusion(const arma::vec& x, const arma::vec& theta) {
+  arma::cube dsigma(x.n_elem, 2, x.n_elem, arma::fill::zeros);
+  for (unsigned int l = 0; l < x.n_elem; l++) {
+    dsigma(l, 0, l) = theta(1);
+    dsigma(l, 1, l) = 0.5 * theta(1);
+  }
+  return dsigma;
+}
+arma::vec msde_obs_density(const arma::vec& y, const arma::mat& alpha,
+  const arma::vec& theta) {
+  arma::mat v = alpha;
+  v.each_col() -= y;
+  return arma::sum(-0.5 * arma::square(v) / (theta(2) * theta(2)) - std::log(theta(2)), 0).t();
+}
+
+msde_ssm msde_model(const setting& s, sitmo::prng_engine& engine) {
+  arma::vec theta(3);
+  theta(0) = 0.01;
+  theta(1) = 0.1;
+  theta(2) = 0.5;
+  arma::mat y = 1.0 + arma::cumsum(0.1 * rnorm(s.m, s.n, engine), 1);
+  return msde_ssm(y, theta, arma::ones(s.m), 1, msde_drift, msde_diffusion, 
+    msde_ddiffusion, sde_prior, msde_obs_density);
+}
+
+// the kernels
+struct log_likelihood_kernel {
+  const ugg_ssm& model;
+  double operator()() { return model.log_likelihood(); }
+};
+struct fast_smoother_kernel {
+  const ugg_ssm& model;
+  double operator()() { return model.fast_smoother()(0, 0); }
+};
+struct simulate_states_kernel {
+  ugg_ssm& model;
+  unsigned int nsim;
+  double operator()() { return model.simulate_states(nsim)(0, 0, 0); }
+};
+struct ugg_bsf_kernel {
+  ugg_ssm& model;
+  unsigned int nsim;
+  double operator()() {
+    arma::cube alpha(model.m, model.n + 1, nsim);
+    arma::mat weights(nsim, model.n + 1);
+    arma::umat indices(nsim, model.n);
+    return model.bsf_filter(nsim, alpha, weights, indices);
+  }
+};
+struct approximate_kernel {
+  ung_ssm& model;
+  arma::vec initial_mode;
+  double operator()() {
+    arma::vec mode_estimate = initial_mode;
+    return model.approximate(mode_estimate, model.max_iter, model.conv_tol).y(0);
+  }
+};
+struct psi_filter_kernel {
+  ung_ssm& model;
+  const ugg_ssm& approx_model;
+  double approx_loglik;
+  const arma::vec& scales;
+  unsigned int nsim;
+  double operator()() {
+    arma::cube alpha(model.m, model.n + 1, nsim);
+    arma::mat weights(nsim, model.n + 1);
+    arma::umat indices(nsim, model.n);
+    return model.psi_filter(approx_model, approx_loglik, scales, nsim,
+      alpha, weights, indices);
+  }
+};
+struct ung_bsf_kernel {
+  ung_ssm& model;
+  unsigned int nsim;
+  double operator()() {
+    arma::cube alpha(model.m, model.n + 1, nsim);
+    arma::mat weights(nsim, model.n + 1);
+    arma::umat indices(nsim, model.n);
+    return model.bsf_filter(nsim, alpha, weights, indices);
+  }
+};
+struct ekf_kernel {
+  const nlg_ssm& model;
+  double operator()() {
+    arma::mat at(model.m, model.n + 1);
+    arma::mat att(model.m, model.n);
+    arma::cube Pt(model.m, model.m, model.n + 1);
+    arma::cube Ptt(model.m, model.m, model.n);
+    return model.ekf(at, att, Pt, Ptt, 0);
+  }
+};
+struct ukf_kernel {
+  const nlg_ssm& model;
+  double operator()() {
+    arma::mat at(model.m, model.n + 1);
+    arma::mat att(model.m, model.n);
+    arma::cube Pt(model.m, model.m, model.n + 1);
+    arma::cube Ptt(model.m, model.m, model.n);
+    return model.ukf(at, att, Pt, Ptt);
+  }
+};
+struct nlg_bsf_kernel {
+  nlg_ssm& model;
+  unsigned int nsim;
+  double operator()() {
+    arma::cube alpha(model.m, model.n + 1, nsim);
+    arma::mat weights(nsim, model.n + 1);
+    arma::umat indices(nsim, model.n);
+    return model.bsf_filter(nsim, alpha, weights, indices);
+  }
+};
+struct nlg_ekf_loglik_kernel {
+  const nlg_ssm& model;
+  double operator()() {
+    return model.ekf_loglik(0);
+  }
+};
+template <class T>
+struct static_ekf_loglik_kernel {
+  const T& model;
+  double operator()() {
+    return model.ekf_loglik();
+  }
+};
+template <class T>
+struct static_bsf_kernel {
+  T& model;
+  unsigned int nsim;
+  double operator()() {
+    arma::cube alpha(model.m, model.n + 1, nsim);
+    arma::mat weights(nsim, model.n + 1);
+    arma::umat indices(nsim, model.n);
+    return model.bsf_filter(nsim, alpha, weights, indices);
+  }
+};
+template <class T>
+struct sde_bsf_kernel {
+  T& model;
+  unsigned int nsim;
+  unsigned int L;
+  double operator()() {
+    arma::cube alpha(model.m, model.n + 1, nsim);
+    arma::mat weights(nsim, model.n + 1);
+    arma::umat indices(nsim, model.n);
+    return model.bsf_filter(nsim, L, alpha, weights, indices);
+  }
+};
+struct conditional_cov_kernel {
+  const arma::cube& V;
+  double operator()() {
+    arma::cube Vt = V;
+    arma::cube Ct(V.n_rows, V.n_cols, V.n_slices);
+    conditional_cov(Vt, Ct);
+    return Ct(0, 0, 0);
+  }
+};
+struct weighted_summary_kernel {
+  const arma::cube& alpha;
+  const arma::vec& weights;
+  double operator()() {
+    arma::mat mean_alpha(alpha.n_rows, alpha.n_cols);
+    arma::cube cov_alpha(alpha.n_rows, alpha.n_rows, alpha.n_cols);
+    weighted_summary(alpha, mean_alpha, cov_alpha, weights);
+    return mean_alpha(0, 0);
+  }
+};
+struct filter_smoother_kernel {
+  const arma::cube& alpha;
+  const arma::umat& indices;
+  double operator()() {
+    arma::cube alpha_copy = alpha;
+    filter_smoother(alpha_copy, indices);
+    return alpha_copy(0, 0, 0);
+  }
+};
+
+// kernels of the nonlinear model with static model functions, using the same
+// data and parameters as the given nlg_ssm
+template <unsigned int M, unsigned int P>
+void static_nonlinear_kernels(benchmark_output& out, setting s, const nlg_ssm& model,
+  const unsigned int* nsims) {
+  typedef nlg_static_ssm<static_nonlinear<M, P> > static_ssm;
+  static_ssm static_model(model.y, model.theta, model.known_params,
+    model.known_tv_params, 1);
+  s.nsim = 0;
+  static_ekf_loglik_kernel<static_ssm> ekf = {static_model};
+  out.run("nlg_static_ssm::ekf_loglik", s, ekf);
+  for (unsigned int l = 0; l < 2; l++) {
+    s.nsim = nsims[l];
+    static_bsf_kernel<static_ssm> bsf = {static_model, s.nsim};
+    out.run("nlg_static_ssm::bsf_filter", s, bsf);
+  }
+}
+
+// the dimensions of the static models need to be known at compile time
+void run_static_nonlinear(benchmark_output& out, const setting& s,
+  const nlg_ssm& model, const unsigned int* nsims) {
+  if (s.m == 1 && s.p == 1) static_nonlinear_kernels<1, 1>(out, s, model, nsims);
+  if (s.m == 1 && s.p == 3) static_nonlinear_kernels<1, 3>(out, s, model, nsims);
+  if (s.m == 4 && s.p == 1) static_nonlinear_kernels<4, 1>(out, s, model, nsims);
+  if (s.m == 4 && s.p == 3) static_nonlinear_kernels<4, 3>(out, s, model, nsims);
+  if (s.m == 10 && s.p == 1) static_nonlinear_kernels<10, 1>(out, s, model, nsims);
+  if (s.m == 10 && s.p == 3) static_nonlinear_kernels<10, 3>(out, s, model, nsims);
+}
+
+}
+
+int main(int argc, char** argv) {
+
+  std::ofstream file;
+  if (argc > 1) {
+    file.open(argv[1]);
+    if (!file.is_open()) {
+      std::cerr << "Could not open the output file '" << argv[1] << "'." << std::endl;
+      return 1;
+    }
+  }
+  unsigned int reps = argc > 2 ? std::atoi(argv[2]) : 5;
+  if (reps == 0) {
+    std::cerr << "The number of repetitions must be positive." << std::endl;
+    return 1;
+  }
+  benchmark_output out(argc > 1 ? file : std::cout, reps);
+
+  const unsigned int ms[] = {1, 4, 10};
+  const unsigned int ns[] = {100, 1000};
+  const unsigned int ps[] = {1, 3};
+  const unsigned int nsims[] = {10, 100};
+
+  sitmo::prng_engine engine(1);
+
+  for (unsigned int tv = 0; tv < 2; tv++) {
+    for (unsigned int i = 0; i < 3; i++) {
+      for (unsigned int j = 0; j < 2; j++) {
+
+        setting s = {ms[i], ns[j], 1, 0, tv};
+
+        // linear gaussian and poisson models
+        ugg_ssm gaussian = random_walk_model(s, engine);
+        ung_ssm poisson = poisson_model(s, engine);
+        log_likelihood_kernel loglik = {gaussian};
+        out.run("ugg_ssm::log_likelihood", s, loglik);
+        fast_smoother_kernel smoother = {gaussian};
+        out.run("ugg_ssm::fast_smoother", s, smoother);
+        arma::vec initial_mode = arma::log(poisson.y + 0.1);
+        approximate_kernel approx = {poisson, initial_mode};
+        out.run("ung_ssm::approximate", s, approx);
+
+        arma::vec mode_estimate = initial_mode;
+        ugg_ssm approx_model = poisson.approximate(mode_estimate, poisson.max_iter,
+          poisson.conv_tol);
+        arma::vec scales = poisson.scaling_factors(approx_model, mode_estimate);
+        double approx_loglik = approx_model.log_likelihood() + arma::accu(scales);
+
+        for (unsigned int l = 0; l < 2; l++) {
+          s.nsim = nsims[l];
+          simulate_states_kernel sim = {gaussian, s.nsim};
+          out.run("ugg_ssm::simulate_states", s, sim);
+          ugg_bsf_kernel ugg_bsf = {gaussian, s.nsim};
+          out.run("ugg_ssm::bsf_filter", s, ugg_bsf);
+          psi_filter_kernel psi = {poisson, approx_model, approx_loglik, scales, s.nsim};
+          out.run("ung_ssm::psi_filter", s, psi);
+          ung_bsf_kernel ung_bsf = {poisson, s.nsim};
+          out.run("ung_ssm::bsf_filter", s, ung_bsf);
+
+          // helpers of the particle filters and smoothers
+          arma::cube alpha(s.m, s.n + 1, s.nsim);
+          arma::mat weights(s.nsim, s.n + 1);
+          arma::umat indices(s.nsim, s.n);
+          poisson.bsf_filter(s.nsim, alpha, weights, indices);
+          filter_smoother_kernel fs = {alpha, indices};
+          out.run("filter_smoother", s, fs);
+          arma::vec w = weights.col(s.n) / arma::accu(weights.col(s.n));
+          weighted_summary_kernel summary = {alpha, w};
+          out.run("weighted_summary", s, summary);
+        }
+
+        s.nsim = 0;
+        arma::cube V(s.m, s.m, s.n + 1);
+        for (unsigned int t = 0; t <= s.n; t++) {
+          arma::mat A = rnorm(s.m, s.m, engine);
+          V.slice(t) = A * A.t() + arma::eye(s.m, s.m);
+        }
+        conditional_cov_kernel ccov = {V};
+        out.run("conditional_cov", s, ccov);
+
+        // nonlinear models
+        for (unsigned int k = 0; k < 2; k++) {
+          s.p = ps[k];
+          s.nsim = 0;
+          nlg_ssm nonlinear = nonlinear_model(s, engine);
+          ekf_kernel ekf = {nonlinear};
+          out.run("nlg_ssm::ekf", s, ekf);
+          ukf_kernel ukf = {nonlinear};
+          out.run("nlg_ssm::ukf", s, ukf);
+          nlg_ekf_loglik_kernel ekf_loglik = {nonlinear};
+          out.run("nlg_ssm::ekf_loglik", s, ekf_loglik);
+          for (unsigned int l = 0; l < 2; l++) {
+            s.nsim = nsims[l];
+            nlg_bsf_kernel nlg_bsf = {nonlinear, s.nsim};
+            out.run("nlg_ssm::bsf_filter", s, nlg_bsf);
+          }
+          s.nsim = 0;
+          run_static_nonlinear(out, s, nonlinear, nsims);
+        }
+      }
+    }
+  }
+
+  // univariate SDE, L = 4 levels of discretization
+  for (unsigned int j = 0; j < 2; j++) {
+    for (unsigned int l = 0; l < 2; l++) {
+      setting s = {1, ns[j], 1, nsims[l], 0};
+      sde_ssm sde = sde_model(s, engine);
+      sde_bsf_kernel<sde_ssm> sde_bsf = {sde, s.nsim, 4};
+      out.run("sde_ssm::bsf_filter", s, sde_bsf);
+    }
+  }
+  
+  // multivariate SDE with m = 3 and two dimensional noise
+  for (unsigned int j = 0; j < 2; j++) {
+    for (unsigned int l = 0; l < 2; l++) {
+      setting s = {3, ns[j], 3, nsims[l], 0};
+      msde_ssm msde = msde_model(s, engine);
+      sde_bsf_kernel<msde_ssm> msde_bsf = {msde, s.nsim, 4};
+      out.run("msde_ssm::bsf_filter", s, msde_bsf);
+    }
+  }
+
+  return 0;
+}
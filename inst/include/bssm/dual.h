@@ -0,0 +1,169 @@
+// dual numbers for forward mode automatic differentiation, carrying the value
+// and the partial derivatives with respect to N variables. Functions written
+// as templates over the scalar type can then be evaluated with dual<N> in
+// place of double, which gives the Jacobian in a single evaluation. The math
+// functions are found by argument dependent lookup, so the templated functions
+// should call them unqualified after using std::exp etc.
+//
+// The value type V can itself be a dual number, so that dual<M, dual<N> >
+// gives the derivatives of a Jacobian with respect to N other variables.
+
+#ifndef BSSM_DUAL_H
+#define BSSM_DUAL_H
+
+#include <cmath>
+#include <type_traits>
+
+template <unsigned int N, class V = double>
+class dual {
+
+public:
+
+  dual() : val(0.0) {
+    for (unsigned int i = 0; i < N; i++) d[i] = 0.0;
+  }
+  dual(const V& x) : val(x) {
+    for (unsigned int i = 0; i < N; i++) d[i] = 0.0;
+  }
+  // constants such as 0.5 when V is a dual number
+  template <class U, class = typename std::enable_if<std::is_arithmetic<U>::value>::type>
+  dual(const U x) : val(x) {
+    for (unsigned int i = 0; i < N; i++) d[i] = 0.0;
+  }
+  // i:th independent variable with value x
+  dual(const V& x, const unsigned int i) : val(x) {
+    for (unsigned int j = 0; j < N; j++) d[j] = 0.0;
+    d[i] = 1.0;
+  }
+
+  dual& operator+=(const dual& x) {
+    val += x.val;
+    for (unsigned int i = 0; i < N; i++) d[i] += x.d[i];
+    return *this;
+  }
+  dual& operator-=(const dual& x) {
+    val -= x.val;
+    for (unsigned int i = 0; i < N; i++) d[i] -= x.d[i];
+    return *this;
+  }
+  dual& operator*=(const dual& x) {
+    for (unsigned int i = 0; i < N; i++) d[i] = d[i] * x.val + val * x.d[i];
+    val *= x.val;
+    return *this;
+  }
+  dual& operator/=(const dual& x) {
+    V inv = 1.0 / x.val;
+    val *= inv;
+    for (unsigned int i = 0; i < N; i++) d[i] = (d[i] - val * x.d[i]) * inv;
+    return *this;
+  }
+
+  V val;
+  V d[N];
+};
+
+// chain rule for a function f with f(x.val) = value and f'(x.val) = deriv
+template <unsigned int N, class V>
+inline dual<N, V> chain(const dual<N, V>& x, const V& value, const V& deriv) {
+  dual<N, V> out(value);
+  for (unsigned int i = 0; i < N; i++) out.d[i] = deriv * x.d[i];
+  return out;
+}
+
+template <unsigned int N, class V>
+inline dual<N, V> operator-(const dual<N, V>& x) {
+  return chain(x, V(-x.val), V(-1.0));
+}
+
+template <unsigned int N, class V>
+inline dual<N, V> operator+(dual<N, V> x, const dual<N, V>& y) { return x += y; }
+template <unsigned int N, class V>
+inline dual<N, V> operator-(dual<N, V> x, const dual<N, V>& y) { return x -= y; }
+template <unsigned int N, class V>
+inline dual<N, V> operator*(dual<N, V> x, const dual<N, V>& y) { return x *= y; }
+template <unsigned int N, class V>
+inline dual<N, V> operator/(dual<N, V> x, const dual<N, V>& y) { return x /= y; }
+
+template <unsigned int N, class V>
+inline dual<N, V> operator+(dual<N, V> x, const double y) { x.val += y; return x; }
+template <unsigned int N, class V>
+inline dual<N, V> operator+(const double x, dual<N, V> y) { y.val += x; return y; }
+template <unsigned int N, class V>
+inline dual<N, V> operator-(dual<N, V> x, const double y) { x.val -= y; return x; }
+template <unsigned int N, class V>
+inline dual<N, V> operator-(const double x, const dual<N, V>& y) {
+  return chain(y, V(x - y.val), V(-1.0));
+}
+template <unsigned int N, class V>
+inline dual<N, V> operator*(const dual<N, V>& x, const double y) {
+  return chain(x, V(x.val * y), V(y));
+}
+template <unsigned int N, class V>
+inline dual<N, V> operator*(const double x, const dual<N, V>& y) {
+  return chain(y, V(x * y.val), V(x));
+}
+template <unsigned int N, class V>
+inline dual<N, V> operator/(const dual<N, V>& x, const double y) {
+  return chain(x, V(x.val / y), V(1.0 / y));
+}
+template <unsigned int N, class V>
+inline dual<N, V> operator/(const double x, const dual<N, V>& y) {
+  return chain(y, V(x / y.val), V(-x / (y.val * y.val)));
+}
+
+template <unsigned int N, class V>
+inline bool operator<(const dual<N, V>& x, const dual<N, V>& y) { return x.val < y.val; }
+template <unsigned int N, class V>
+inline bool operator>(const dual<N, V>& x, const dual<N, V>& y) { return x.val > y.val; }
+template <unsigned int N, class V>
+inline bool operator<(const dual<N, V>& x, const double y) { return x.val < y; }
+template <unsigned int N, class V>
+inline bool operator>(const dual<N, V>& x, const double y) { return x.val > y; }
+
+template <unsigned int N, class V>
+inline dual<N, V> exp(const dual<N, V>& x) {
+  using std::exp;
+  V value = exp(x.val);
+  return chain(x, value, value);
+}
+template <unsigned int N, class V>
+inline dual<N, V> log(const dual<N, V>& x) {
+  using std::log;
+  return chain(x, V(log(x.val)), V(1.0 / x.val));
+}
+template <unsigned int N, class V>
+inline dual<N, V> sqrt(const dual<N, V>& x) {
+  using std::sqrt;
+  V value = sqrt(x.val);
+  return chain(x, value, V(0.5 / value));
+}
+template <unsigned int N, class V>
+inline dual<N, V> pow(const dual<N, V>& x, const double y) {
+  using std::pow;
+  return chain(x, V(pow(x.val, y)), V(y * pow(x.val, y - 1.0)));
+}
+template <unsigned int N, class V>
+inline dual<N, V> sin(const dual<N, V>& x) {
+  using std::sin;
+  using std::cos;
+  return chain(x, V(sin(x.val)), V(cos(x.val)));
+}
+template <unsigned int N, class V>
+inline dual<N, V> cos(const dual<N, V>& x) {
+  using std::sin;
+  using std::cos;
+  return chain(x, V(cos(x.val)), V(-sin(x.val)));
+}
+template <unsigned int N, class V>
+inline dual<N, V> tanh(const dual<N, V>& x) {
+  using std::tanh;
+  V value = tanh(x.val);
+  return chain(x, value, V(1.0 - value * value));
+}
+template <unsigned int N, class V>
+inline dual<N, V> abs(const dual<N, V>& x) {
+  using std::abs;
+  return chain(x, V(abs(x.val)), V(x.val < 0.0 ? -1.0 : 1.0));
+}
+
+#endif
@@ -0,0 +1,896 @@
+// nonlinear gaussian state space model with the model functions given as static
+// member functions of a model class, as an alternative to the function pointers
+// of nlg_ssm. As the functions are known at compile time, they can be inlined
+// into the filters, and fixed size vectors and matrices avoid the dynamic
+// memory allocations of small models.
+//
+// The header is installed with the package, so that the model can be compiled
+// with Rcpp::sourceCpp using
+//
+//   // [[Rcpp::depends(RcppArmadillo, sitmo, bssm)]]
+//   #include <bssm/nlg_static.h>
+//
+// The model class derives from nlg_static_dims<m, k, p> and defines
+//
+//   static obs_vec Z(t, alpha, theta, known_params, known_tv_params);
+//   static obs_mat H(t, alpha, theta, known_params, known_tv_params);
+//   static state_vec T(t, alpha, theta, known_params, known_tv_params);
+//   static noise_mat R(t, alpha, theta, known_params, known_tv_params);
+//   static obs_state_mat Z_gn(t, alpha, theta, known_params, known_tv_params);
+//   static state_mat T_gn(t, alpha, theta, known_params, known_tv_params);
+//   static state_vec a1(theta, known_params);
+//   static state_mat P1(theta, known_params);
+//   static double log_prior_pdf(theta);
+//
+// where alpha is of type state_vec. Only the EKF log-likelihood and the
+// bootstrap filter of nlg_static_ssm<Model> are inlined with the model. From R
+// they are available by exporting nlg_static_loglik<Model> in the same file:
+//
+//   // [[Rcpp::export]]
+//   double my_loglik(const arma::mat& y, const arma::vec& theta,
+//     const arma::vec& known_params, const arma::mat& known_tv_params,
+//     const unsigned int nsim, const unsigned int seed) {
+//     return nlg_static_loglik<my_model>(y, theta, known_params,
+//       known_tv_params, nsim, seed);
+//   }
+//
+// Everything else (ukf, ekf_smoother, approximate, the other particle filters
+// and run_mcmc) uses the functions of nlg_ssm, for which nlg_static_pointers
+// <Model>() returns the model functions as external pointers, so the model
+// needs to be written only once but these methods are not inlined. Within the
+// C++ library, nlg_static_ssm<Model> can also be used with the generic
+// samplers of mcmc (spec_mcmc and pt_mcmc with bsf_loglik of pm_loglik.h),
+// which are not exported to R. There is no static counterpart of lgg_ssm.
+//
+// Alternatively the model class derives from nlg_static_ad<Model, m, k, p> and
+// defines Z and T as templates over the scalar type,
+//
+//   template <class S> static void Z_fn(t, const S* alpha, theta,
+//     known_params, known_tv_params, S* result);
+//   template <class S> static void T_fn(t, const S* alpha, theta,
+//     known_params, known_tv_params, S* result);
+//
+// in which case Z_gn and T_gn are computed by forward mode automatic
+// differentiation (dual.h). The pointers of nlg_static_pointers then give the
+// same Jacobians to ekf, ekf_smoother, approximate and ekpf_filter of nlg_ssm.
+//
+// For the gradient of the EKF log-likelihood with respect to theta, the model
+// class derives from nlg_static_grad<Model, m, k, p, n_theta> and defines all
+// the model functions as templates over the scalar type of both alpha and theta,
+//
+//   template <class S> static void Z_fn(t, const S* alpha, const S* theta,
+//     known_params, known_tv_params, S* result);
+//   template <class S> static void H_fn(t, alpha, theta, known_params,
+//     known_tv_params, S* result);
+//   template <class S> static void T_fn(t, alpha, theta, known_params,
+//     known_tv_params, S* result);
+//   template <class S> static void R_fn(t, alpha, theta, known_params,
+//     known_tv_params, S* result);
+//   template <class S> static void a1_fn(const S* theta, known_params, S* result);
+//   template <class S> static void P1_fn(const S* theta, known_params, S* result);
+//   static double log_prior_pdf(theta);
+//
+// where the matrices H, R and P1 are written in column-major order. Then
+// ekf_loglik_gradient of nlg_static_ssm<Model> gives the log-likelihood and
+// its gradient in a single pass of the EKF with dual<n_theta> numbers, where
+// the Jacobians of Z and T are differentiated with respect to theta by nested
+// dual numbers. The filter is written for the dual numbers with fixed size
+// arrays, as armadillo supports only the standard element types.
+
+#ifndef BSSM_NLG_STATIC_H
+#define BSSM_NLG_STATIC_H
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#ifdef BSSM_STANDALONE
+#include <armadillo>
+#else
+#include <RcppArmadillo.h>
+#endif
+#include <sitmo.h>
+#include "dual.h"
+
+// the header does not link to the package library, so the few helpers of the
+// filters are defined here
+namespace nlg_static_detail {
+
+// Cholesky factor of a positive semidefinite matrix with zeros on the diagonal
+inline arma::mat psd_chol(const arma::mat& x) {
+  arma::uvec nonzero =
+    arma::find(x.diag() > std::max(std::numeric_limits<double>::epsilon(),
+      std::numeric_limits<double>::epsilon() * x.n_cols * x.diag().max()));
+  arma::mat cholx(x.n_cols, x.n_cols, arma::fill::zeros);
+  if (nonzero.n_elem > 0) {
+    cholx.submat(nonzero, nonzero) = arma::chol(x.submat(nonzero, nonzero), "lower");
+  }
+  return cholx;
+}
+
+// log-density of N(mean, H H') at the observed elements of y, H lower triangular
+inline double dmvnorm_chol(const arma::vec& y, const arma::vec& mean,
+  const arma::mat& H) {
+  arma::uvec obs = arma::find_finite(y);
+  arma::mat L = H;
+  if (obs.n_elem < y.n_elem) {
+    L = psd_chol(arma::mat(H * H.t()).submat(obs, obs));
+  } else {
+    obs = arma::regspace<arma::uvec>(0, y.n_elem - 1);
+  }
+  arma::uvec nonzero = arma::find(L.diag() >
+    (std::numeric_limits<double>::epsilon() * obs.n_elem * L.diag().max()));
+  arma::vec tmp = arma::solve(arma::trimatl(L.submat(nonzero, nonzero)),
+    arma::vec(y.rows(obs) - mean.rows(obs)).rows(nonzero));
+  return -0.5 * (nonzero.n_elem * std::log(2.0 * M_PI) +
+    2.0 * arma::accu(arma::log(L.submat(nonzero, nonzero).diag())) +
+    arma::dot(tmp, tmp));
+}
+
+// products, Cholesky factors and triangular solves of small matrices of a
+// generic scalar type, stored in column-major order
+
+// out = x y, or x y' if trans_y is true, where x is r x q
+template <class S>
+inline void mult(const S* x, const S* y, S* out, const unsigned int r,
+  const unsigned int q, const unsigned int c, const bool trans_y = false) {
+  for (unsigned int j = 0; j < c; j++) {
+    for (unsigned int i = 0; i < r; i++) {
+      S sum(0.0);
+      for (unsigned int l = 0; l < q; l++) {
+        sum += x[i + l * r] * (trans_y ? y[j + l * c] : y[l + j * q]);
+      }
+      out[i + j * r] = sum;
+    }
+  }
+}
+
+// lower triangular L with L L' = x, false if x is not positive definite
+template <class S>
+inline bool chol_lower(const S* x, S* L, const unsigned int n) {
+  using std::sqrt;
+  for (unsigned int j = 0; j < n; j++) {
+    S d = x[j + j * n];
+    for (unsigned int l = 0; l < j; l++) {
+      d -= L[j + l * n] * L[j + l * n];
+    }
+    if (!(d > 0.0)) return false;
+    L[j + j * n] = sqrt(d);
+    for (unsigned int i = 0; i < j; i++) {
+      L[i + j * n] = 0.0;
+    }
+    for (unsigned int i = j + 1; i < n; i++) {
+      S tmp = x[i + j * n];
+      for (unsigned int l = 0; l < j; l++) {
+        tmp -= L[i + l * n] * L[j + l * n];
+      }
+      L[i + j * n] = tmp / L[j + j * n];
+    }
+  }
+  return true;
+}
+
+// solves L x = b in place, b is n x c
+template <class S>
+inline void forward_solve(const S* L, S* b, const unsigned int n,
+  const unsigned int c) {
+  for (unsigned int j = 0; j < c; j++) {
+    for (unsigned int i = 0; i < n; i++) {
+      for (unsigned int l = 0; l < i; l++) {
+        b[i + j * n] -= L[i + l * n] * b[l + j * n];
+      }
+      b[i + j * n] /= L[i + i * n];
+    }
+  }
+}
+
+// solves L' x = b in place, b is n x c
+template <class S>
+inline void backward_solve(const S* L, S* b, const unsigned int n,
+  const unsigned int c) {
+  for (unsigned int j = 0; j < c; j++) {
+    for (unsigned int i = n; i-- > 0;) {
+      for (unsigned int l = i + 1; l < n; l++) {
+        b[i + j * n] -= L[l + i * n] * b[l + j * n];
+      }
+      b[i + j * n] /= L[i + i * n];
+    }
+  }
+}
+
+// stratified resampling of N indices with probabilities p, r from U(0, 1)
+inline arma::uvec stratified_sample(arma::vec& p, const arma::vec& r,
+  const unsigned int N) {
+  arma::uvec xp(N);
+  p = arma::cumsum(p);
+  p(p.n_elem - 1) = 1;
+  unsigned int j = 0;
+  double alpha = 1.0 / N;
+  for(unsigned int k = 0; k < p.n_elem && j < N; k++) {
+    while (j < N && (r(j) + j) * alpha <= p(k)) {
+      xp(j) = k;
+      j++;
+    }
+  }
+  while (j < N) {
+    xp(j) = N;
+    j++;
+  }
+  return xp;
+}
+
+}
+
+template <unsigned int M, unsigned int K, unsigned int P>
+struct nlg_static_dims {
+
+  static constexpr unsigned int m = M;
+  static constexpr unsigned int k = K;
+  static constexpr unsigned int p = P;
+
+  typedef arma::vec::fixed<M> state_vec;
+  typedef arma::vec::fixed<K> noise_vec;
+  typedef arma::vec::fixed<P> obs_vec;
+  typedef arma::mat::fixed<M, M> state_mat;
+  typedef arma::mat::fixed<M, K> noise_mat;
+  typedef arma::mat::fixed<P, P> obs_mat;
+  typedef arma::mat::fixed<P, M> obs_state_mat;
+};
+
+template <unsigned int M, unsigned int K, unsigned int P>
+constexpr unsigned int nlg_static_dims<M, K, P>::m;
+template <unsigned int M, unsigned int K, unsigned int P>
+constexpr unsigned int nlg_static_dims<M, K, P>::k;
+template <unsigned int M, unsigned int K, unsigned int P>
+constexpr unsigned int nlg_static_dims<M, K, P>::p;
+
+template <class Model, unsigned int M, unsigned int K, unsigned int P>
+struct nlg_static_ad : nlg_static_dims<M, K, P> {
+
+  typedef nlg_static_dims<M, K, P> dims;
+
+  static typename dims::obs_vec Z(const unsigned int t,
+    const typename dims::state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    typename dims::obs_vec result;
+    Model::Z_fn(t, alpha.memptr(), theta, known_params, known_tv_params,
+      result.memptr());
+    return result;
+  }
+  static typename dims::state_vec T(const unsigned int t,
+    const typename dims::state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    typename dims::state_vec result;
+    Model::T_fn(t, alpha.memptr(), theta, known_params, known_tv_params,
+      result.memptr());
+    return result;
+  }
+  static typename dims::obs_state_mat Z_gn(const unsigned int t,
+    const typename dims::state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    dual<M> x[M];
+    for (unsigned int j = 0; j < M; j++) {
+      x[j] = dual<M>(alpha(j), j);
+    }
+    dual<M> z[P];
+    Model::Z_fn(t, x, theta, known_params, known_tv_params, z);
+    typename dims::obs_state_mat Zg;
+    for (unsigned int i = 0; i < P; i++) {
+      for (unsigned int j = 0; j < M; j++) {
+        Zg(i, j) = z[i].d[j];
+      }
+    }
+    return Zg;
+  }
+  static typename dims::state_mat T_gn(const unsigned int t,
+    const typename dims::state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    dual<M> x[M];
+    for (unsigned int j = 0; j < M; j++) {
+      x[j] = dual<M>(alpha(j), j);
+    }
+    dual<M> z[M];
+    Model::T_fn(t, x, theta, known_params, known_tv_params, z);
+    typename dims::state_mat Tg;
+    for (unsigned int i = 0; i < M; i++) {
+      for (unsigned int j = 0; j < M; j++) {
+        Tg(i, j) = z[i].d[j];
+      }
+    }
+    return Tg;
+  }
+};
+
+template <class Model, unsigned int M, unsigned int K, unsigned int P,
+  unsigned int N>
+struct nlg_static_grad : nlg_static_dims<M, K, P> {
+
+  typedef nlg_static_dims<M, K, P> dims;
+
+  static constexpr unsigned int n_theta = N;
+
+  // values and Jacobians of Z and T with respect to alpha, at alpha and theta
+  // of scalar type S
+  template <class S>
+  static void Z_jacobian(const unsigned int t, const S* alpha, const S* theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params,
+    S* value, S* jacobian) {
+    dual<M, S> x[M];
+    for (unsigned int j = 0; j < M; j++) {
+      x[j] = dual<M, S>(alpha[j], j);
+    }
+    dual<M, S> th[N];
+    for (unsigned int j = 0; j < N; j++) {
+      th[j] = dual<M, S>(theta[j]);
+    }
+    dual<M, S> z[P];
+    Model::Z_fn(t, x, th, known_params, known_tv_params, z);
+    for (unsigned int i = 0; i < P; i++) {
+      value[i] = z[i].val;
+      for (unsigned int j = 0; j < M; j++) {
+        jacobian[i + j * P] = z[i].d[j];
+      }
+    }
+  }
+  template <class S>
+  static void T_jacobian(const unsigned int t, const S* alpha, const S* theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params,
+    S* value, S* jacobian) {
+    dual<M, S> x[M];
+    for (unsigned int j = 0; j < M; j++) {
+      x[j] = dual<M, S>(alpha[j], j);
+    }
+    dual<M, S> th[N];
+    for (unsigned int j = 0; j < N; j++) {
+      th[j] = dual<M, S>(theta[j]);
+    }
+    dual<M, S> z[M];
+    Model::T_fn(t, x, th, known_params, known_tv_params, z);
+    for (unsigned int i = 0; i < M; i++) {
+      value[i] = z[i].val;
+      for (unsigned int j = 0; j < M; j++) {
+        jacobian[i + j * M] = z[i].d[j];
+      }
+    }
+  }
+
+  static typename dims::obs_vec Z(const unsigned int t,
+    const typename dims::state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    typename dims::obs_vec result;
+    Model::Z_fn(t, alpha.memptr(), theta.memptr(), known_params,
+      known_tv_params, result.memptr());
+    return result;
+  }
+  static typename dims::obs_mat H(const unsigned int t,
+    const typename dims::state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    typename dims::obs_mat result;
+    Model::H_fn(t, alpha.memptr(), theta.memptr(), known_params,
+      known_tv_params, result.memptr());
+    return result;
+  }
+  static typename dims::state_vec T(const unsigned int t,
+    const typename dims::state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    typename dims::state_vec result;
+    Model::T_fn(t, alpha.memptr(), theta.memptr(), known_params,
+      known_tv_params, result.memptr());
+    return result;
+  }
+  static typename dims::noise_mat R(const unsigned int t,
+    const typename dims::state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    typename dims::noise_mat result;
+    Model::R_fn(t, alpha.memptr(), theta.memptr(), known_params,
+      known_tv_params, result.memptr());
+    return result;
+  }
+  static typename dims::obs_state_mat Z_gn(const unsigned int t,
+    const typename dims::state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    typename dims::obs_vec value;
+    typename dims::obs_state_mat Zg;
+    Z_jacobian(t, alpha.memptr(), theta.memptr(), known_params,
+      known_tv_params, value.memptr(), Zg.memptr());
+    return Zg;
+  }
+  static typename dims::state_mat T_gn(const unsigned int t,
+    const typename dims::state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    typename dims::state_vec value;
+    typename dims::state_mat Tg;
+    T_jacobian(t, alpha.memptr(), theta.memptr(), known_params,
+      known_tv_params, value.memptr(), Tg.memptr());
+    return Tg;
+  }
+  static typename dims::state_vec a1(const arma::vec& theta,
+    const arma::vec& known_params) {
+    typename dims::state_vec result;
+    Model::a1_fn(theta.memptr(), known_params, result.memptr());
+    return result;
+  }
+  static typename dims::state_mat P1(const arma::vec& theta,
+    const arma::vec& known_params) {
+    typename dims::state_mat result;
+    Model::P1_fn(theta.memptr(), known_params, result.memptr());
+    return result;
+  }
+};
+
+template <class Model, unsigned int M, unsigned int K, unsigned int P,
+  unsigned int N>
+constexpr unsigned int nlg_static_grad<Model, M, K, P, N>::n_theta;
+
+template <class Model>
+class nlg_static_ssm {
+
+public:
+
+  typedef typename Model::state_vec state_vec;
+  typedef typename Model::noise_vec noise_vec;
+  typedef typename Model::obs_vec obs_vec;
+  typedef typename Model::state_mat state_mat;
+  typedef typename Model::noise_mat noise_mat;
+  typedef typename Model::obs_mat obs_mat;
+  typedef typename Model::obs_state_mat obs_state_mat;
+
+  nlg_static_ssm(const arma::mat& y, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params,
+    const unsigned int seed);
+
+  void update_model(const arma::vec& new_theta) {
+    theta = new_theta;
+  }
+  double log_prior_pdf(const arma::vec& x) const {
+    return Model::log_prior_pdf(x);
+  }
+  // no parameter transformations in non-linear models
+  double log_proposal_ratio(const arma::vec& new_theta,
+    const arma::vec& old_theta) const {
+    return 0.0;
+  }
+
+  // log-likelihood using the extended Kalman filter
+  double ekf_loglik() const;
+  // the same log-likelihood and its gradient with respect to theta, for the
+  // models of nlg_static_grad
+  double ekf_loglik_gradient(arma::vec& gradient) const;
+
+  // bootstrap filter, gives the same particles as nlg_ssm::bsf_filter with 
+  // the same seed when the auxiliary filter is not used
+  double bsf_filter(const unsigned int nsim, arma::cube& alpha,
+    arma::mat& weights, arma::umat& indices);
+
+  // compute logarithms of _unnormalized_ densities g(y_t | alpha_t)
+  arma::vec log_obs_density(const unsigned int t, const arma::cube& alpha) const;
+
+  arma::mat y;
+  arma::vec theta;
+  arma::vec known_params;
+  arma::mat known_tv_params;
+
+  const unsigned int m;
+  const unsigned int k;
+  const unsigned int n;
+  const unsigned int p;
+
+  unsigned int seed;
+  sitmo::prng_engine engine;
+};
+
+template <class Model>
+nlg_static_ssm<Model>::nlg_static_ssm(const arma::mat& y, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params,
+  const unsigned int seed) :
+  y(y), theta(theta), known_params(known_params), known_tv_params(known_tv_params),
+  m(Model::m), k(Model::k), n(y.n_cols), p(Model::p), seed(seed), engine(seed) {
+
+  if (y.n_rows != Model::p) {
+    throw std::invalid_argument("Number of rows of y (" + std::to_string(y.n_rows) +
+      ") does not match the dimension of the model (" + std::to_string(Model::p) + ").");
+  }
+}
+
+template <class Model>
+double nlg_static_ssm<Model>::ekf_loglik() const {
+  state_vec at = Model::a1(theta, known_params);
+  state_mat Pt = Model::P1(theta, known_params);
+
+  const double LOG2PI = std::log(2.0 * M_PI);
+  double logLik = 0.0;
+
+  for (unsigned int t = 0; t < n; t++) {
+
+    arma::uvec na_y = arma::find_nonfinite(y.col(t));
+
+    state_vec att = at;
+    state_mat Ptt = Pt;
+    if (na_y.n_elem < p) {
+      obs_state_mat Zg = Model::Z_gn(t, at, theta, known_params, known_tv_params);
+      obs_mat HHt = Model::H(t, at, theta, known_params, known_tv_params);
+      HHt = HHt * HHt.t();
+
+      if (na_y.n_elem > 0) {
+        Zg.rows(na_y).zeros();
+        HHt.rows(na_y).zeros();
+        HHt.cols(na_y).zeros();
+        HHt.submat(na_y, na_y) = arma::eye(na_y.n_elem, na_y.n_elem);
+      }
+
+      obs_mat Ft = Zg * Pt * Zg.t() + HHt;
+      // first check avoid armadillo warnings
+      bool chol_ok = Ft.is_finite() && arma::all(Ft.diag() > 0);
+      if (!chol_ok) return -std::numeric_limits<double>::infinity();
+      obs_mat cholF;
+      chol_ok = arma::chol(cholF, Ft);
+      if (!chol_ok) return -std::numeric_limits<double>::infinity();
+
+      obs_vec vt = y.col(t) - Model::Z(t, at, theta, known_params, known_tv_params);
+      vt.rows(na_y).zeros();
+
+      obs_mat inv_cholF = arma::inv(arma::trimatu(cholF));
+      arma::mat::fixed<Model::m, Model::p> Kt = Pt * Zg.t() * inv_cholF * inv_cholF.t();
+
+      att = at + Kt * vt;
+      state_mat tmp = arma::eye(m, m) - Kt * Zg;
+      Ptt = tmp * Pt * tmp.t() + Kt * HHt * Kt.t();
+
+      obs_vec Fv = inv_cholF.t() * vt;
+      logLik -= 0.5 * arma::as_scalar((p - na_y.n_elem) * LOG2PI +
+        2.0 * arma::accu(arma::log(arma::diagvec(cholF))) + Fv.t() * Fv);
+    }
+
+    at = Model::T(t, att, theta, known_params, known_tv_params);
+    state_mat Tg = Model::T_gn(t, att, theta, known_params, known_tv_params);
+    noise_mat Rt = Model::R(t, att, theta, known_params, known_tv_params);
+    Pt = Tg * Ptt * Tg.t() + Rt * Rt.t();
+  }
+
+  return logLik;
+}
+
+template <class Model>
+double nlg_static_ssm<Model>::ekf_loglik_gradient(arma::vec& gradient) const {
+
+  using std::log;
+  const unsigned int M = Model::m;
+  const unsigned int K = Model::k;
+  const unsigned int P = Model::p;
+  const unsigned int N = Model::n_theta;
+  typedef dual<N> G;
+
+  if (theta.n_elem != N) {
+    throw std::invalid_argument("Length of theta (" + std::to_string(theta.n_elem) +
+      ") does not match the number of parameters of the model (" +
+      std::to_string(N) + ").");
+  }
+  gradient.zeros(N);
+
+  G th[N];
+  for (unsigned int i = 0; i < N; i++) {
+    th[i] = G(theta(i), i);
+  }
+  G at[M];
+  G Pt[M * M];
+  Model::a1_fn(th, known_params, at);
+  Model::P1_fn(th, known_params, Pt);
+
+  const double LOG2PI = std::log(2.0 * M_PI);
+  G logLik(0.0);
+
+  for (unsigned int t = 0; t < n; t++) {
+
+    arma::uvec na_y = arma::find_nonfinite(y.col(t));
+
+    G att[M];
+    G Ptt[M * M];
+    std::copy(at, at + M, att);
+    std::copy(Pt, Pt + M * M, Ptt);
+    if (na_y.n_elem < p) {
+      G Zt[P];
+      G Zg[P * M];
+      Model::Z_jacobian(t, at, th, known_params, known_tv_params, Zt, Zg);
+      G Ht[P * P];
+      G HHt[P * P];
+      Model::H_fn(t, at, th, known_params, known_tv_params, Ht);
+      nlg_static_detail::mult(Ht, Ht, HHt, P, P, P, true);
+
+      G vt[P];
+      for (unsigned int i = 0; i < P; i++) {
+        vt[i] = y(i, t) - Zt[i];
+      }
+      for (unsigned int j = 0; j < na_y.n_elem; j++) {
+        unsigned int i = na_y(j);
+        vt[i] = 0.0;
+        for (unsigned int l = 0; l < M; l++) {
+          Zg[i + l * P] = 0.0;
+        }
+        for (unsigned int l = 0; l < P; l++) {
+          HHt[i + l * P] = 0.0;
+          HHt[l + i * P] = 0.0;
+        }
+        HHt[i + i * P] = 1.0;
+      }
+
+      // F = Zg Pt Zg' + HHt
+      G ZP[P * M];
+      nlg_static_detail::mult(Zg, Pt, ZP, P, M, M);
+      G Ft[P * P];
+      nlg_static_detail::mult(ZP, Zg, Ft, P, M, P, true);
+      for (unsigned int i = 0; i < P * P; i++) {
+        Ft[i] += HHt[i];
+      }
+      G L[P * P];
+      if (!nlg_static_detail::chol_lower(Ft, L, P)) {
+        gradient.fill(arma::datum::nan);
+        return -std::numeric_limits<double>::infinity();
+      }
+
+      // K' = F^-1 Zg Pt
+      G KtT[P * M];
+      std::copy(ZP, ZP + P * M, KtT);
+      nlg_static_detail::forward_solve(L, KtT, P, M);
+      nlg_static_detail::backward_solve(L, KtT, P, M);
+      G Kt[M * P];
+      for (unsigned int i = 0; i < M; i++) {
+        for (unsigned int j = 0; j < P; j++) {
+          Kt[i + j * M] = KtT[j + i * P];
+        }
+      }
+
+      G Fv[P];
+      std::copy(vt, vt + P, Fv);
+      nlg_static_detail::forward_solve(L, Fv, P, 1);
+      G quad(0.0);
+      for (unsigned int i = 0; i < P; i++) {
+        quad += Fv[i] * Fv[i] + 2.0 * log(L[i + i * P]);
+      }
+      logLik -= 0.5 * ((p - na_y.n_elem) * LOG2PI + quad);
+
+      // att = at + K v, Ptt = (I - K Zg) Pt (I - K Zg)' + K HHt K'
+      nlg_static_detail::mult(Kt, vt, att, M, P, 1);
+      for (unsigned int i = 0; i < M; i++) {
+        att[i] += at[i];
+      }
+      G tmp[M * M];
+      nlg_static_detail::mult(Kt, Zg, tmp, M, P, M);
+      for (unsigned int i = 0; i < M * M; i++) {
+        tmp[i] = -tmp[i];
+      }
+      for (unsigned int i = 0; i < M; i++) {
+        tmp[i + i * M] += 1.0;
+      }
+      G tmpP[M * M];
+      nlg_static_detail::mult(tmp, Pt, tmpP, M, M, M);
+      nlg_static_detail::mult(tmpP, tmp, Ptt, M, M, M, true);
+      G KH[M * P];
+      nlg_static_detail::mult(Kt, HHt, KH, M, P, P);
+      G KHK[M * M];
+      nlg_static_detail::mult(KH, Kt, KHK, M, P, M, true);
+      for (unsigned int i = 0; i < M * M; i++) {
+        Ptt[i] += KHK[i];
+      }
+    }
+
+    // Pt = Tg Ptt Tg' + R R'
+    G Tg[M * M];
+    Model::T_jacobian(t, att, th, known_params, known_tv_params, at, Tg);
+    G Rt[M * K];
+    Model::R_fn(t, att, th, known_params, known_tv_params, Rt);
+    G TP[M * M];
+    nlg_static_detail::mult(Tg, Ptt, TP, M, M, M);
+    nlg_static_detail::mult(TP, Tg, Pt, M, M, M, true);
+    G RR[M * M];
+    nlg_static_detail::mult(Rt, Rt, RR, M, K, M, true);
+    for (unsigned int i = 0; i < M * M; i++) {
+      Pt[i] += RR[i];
+    }
+  }
+
+  for (unsigned int i = 0; i < N; i++) {
+    gradient(i) = logLik.d[i];
+  }
+  return logLik.val;
+}
+
+template <class Model>
+arma::vec nlg_static_ssm<Model>::log_obs_density(const unsigned int t,
+  const arma::cube& alpha) const {
+
+  arma::vec weights(alpha.n_slices, arma::fill::zeros);
+
+  arma::uvec na_y = arma::find_nonfinite(y.col(t));
+  if (na_y.n_elem < p) {
+    for (unsigned int i = 0; i < alpha.n_slices; i++) {
+      state_vec alpha_t = alpha.slice(i).col(t);
+      weights(i) = nlg_static_detail::dmvnorm_chol(y.col(t),
+        Model::Z(t, alpha_t, theta, known_params, known_tv_params),
+        Model::H(t, alpha_t, theta, known_params, known_tv_params));
+    }
+  }
+  return weights;
+}
+
+template <class Model>
+double nlg_static_ssm<Model>::bsf_filter(const unsigned int nsim, arma::cube& alpha,
+  arma::mat& weights, arma::umat& indices) {
+  state_vec a1 = Model::a1(theta, known_params);
+  arma::mat L_P1 = nlg_static_detail::psd_chol(Model::P1(theta, known_params));
+  std::normal_distribution<> normal(0.0, 1.0);
+  for (unsigned int i = 0; i < nsim; i++) {
+    state_vec um;
+    for(unsigned int j = 0; j < m; j++) {
+      um(j) = normal(engine);
+    }
+    alpha.slice(i).col(0) = a1 + L_P1 * um;
+  }
+  std::uniform_real_distribution<> unif(0.0, 1.0);
+  arma::vec normalized_weights(nsim);
+  double loglik = 0.0;
+
+  arma::uvec na_y = arma::find_nonfinite(y.col(0));
+  if (na_y.n_elem < p) {
+    weights.col(0) = log_obs_density(0, alpha);
+    double max_weight = weights.col(0).max();
+    weights.col(0) = arma::exp(weights.col(0) - max_weight);
+    double sum_weights = arma::accu(weights.col(0));
+
+    if(sum_weights > 0.0){
+      normalized_weights = weights.col(0) / sum_weights;
+    } else {
+      return -std::numeric_limits<double>::infinity();
+    }
+    loglik = max_weight + std::log(sum_weights / nsim);
+  } else {
+    weights.col(0).ones();
+    normalized_weights.fill(1.0 / nsim);
+  }
+  for (unsigned int t = 0; t < n; t++) {
+
+    arma::vec r(nsim);
+    for (unsigned int i = 0; i < nsim; i++) {
+      r(i) = unif(engine);
+    }
+
+    indices.col(t) = nlg_static_detail::stratified_sample(normalized_weights, r, nsim);
+
+    arma::mat alphatmp(m, nsim);
+
+    for (unsigned int i = 0; i < nsim; i++) {
+      alphatmp.col(i) = alpha.slice(indices(i, t)).col(t);
+    }
+
+    for (unsigned int i = 0; i < nsim; i++) {
+      noise_vec uk;
+      for(unsigned int j = 0; j < k; j++) {
+        uk(j) = normal(engine);
+      }
+      state_vec alpha_t = alphatmp.col(i);
+      alpha.slice(i).col(t + 1) =
+        Model::T(t, alpha_t, theta, known_params, known_tv_params) +
+        Model::R(t, alpha_t, theta, known_params, known_tv_params) * uk;
+    }
+
+    if (t < (n - 1) && arma::uvec(arma::find_nonfinite(y.col(t + 1))).n_elem < p) {
+      weights.col(t + 1) = log_obs_density(t + 1, alpha);
+
+      double max_weight = weights.col(t + 1).max();
+      weights.col(t + 1) = arma::exp(weights.col(t + 1) - max_weight);
+      double sum_weights = arma::accu(weights.col(t + 1));
+      if(sum_weights > 0.0){
+        normalized_weights = weights.col(t + 1) / sum_weights;
+      } else {
+        return -std::numeric_limits<double>::infinity();
+      }
+      loglik += max_weight + std::log(sum_weights / nsim);
+    } else {
+      weights.col(t + 1).ones();
+      normalized_weights.fill(1.0/nsim);
+    }
+  }
+  return loglik;
+}
+
+#ifndef BSSM_STANDALONE
+
+// log-likelihood of the model by the EKF if nsim is 0 and otherwise by the
+// bootstrap filter with nsim particles, y is n x p as in nlg_ssm
+template <class Model>
+double nlg_static_loglik(const arma::mat& y, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params,
+  const unsigned int nsim, const unsigned int seed) {
+
+  nlg_static_ssm<Model> model(y.t(), theta, known_params, known_tv_params, seed);
+  if (nsim == 0) {
+    return model.ekf_loglik();
+  }
+  arma::cube alpha(model.m, model.n + 1, nsim);
+  arma::mat weights(nsim, model.n + 1);
+  arma::umat indices(nsim, model.n);
+  return model.bsf_filter(nsim, alpha, weights, indices);
+}
+
+// the functions of the model class with the signatures of the model functions
+// of nlg_ssm
+template <class Model>
+struct nlg_static_fns {
+
+  typedef typename Model::state_vec state_vec;
+
+  static arma::vec Z(const unsigned int t, const arma::vec& alpha,
+    const arma::vec& theta, const arma::vec& known_params,
+    const arma::mat& known_tv_params) {
+    return Model::Z(t, state_vec(alpha), theta, known_params, known_tv_params);
+  }
+  static arma::mat H(const unsigned int t, const arma::vec& alpha,
+    const arma::vec& theta, const arma::vec& known_params,
+    const arma::mat& known_tv_params) {
+    return Model::H(t, state_vec(alpha), theta, known_params, known_tv_params);
+  }
+  static arma::vec T(const unsigned int t, const arma::vec& alpha,
+    const arma::vec& theta, const arma::vec& known_params,
+    const arma::mat& known_tv_params) {
+    return Model::T(t, state_vec(alpha), theta, known_params, known_tv_params);
+  }
+  static arma::mat R(const unsigned int t, const arma::vec& alpha,
+    const arma::vec& theta, const arma::vec& known_params,
+    const arma::mat& known_tv_params) {
+    return Model::R(t, state_vec(alpha), theta, known_params, known_tv_params);
+  }
+  static arma::mat Z_gn(const unsigned int t, const arma::vec& alpha,
+    const arma::vec& theta, const arma::vec& known_params,
+    const arma::mat& known_tv_params) {
+    return Model::Z_gn(t, state_vec(alpha), theta, known_params, known_tv_params);
+  }
+  static arma::mat T_gn(const unsigned int t, const arma::vec& alpha,
+    const arma::vec& theta, const arma::vec& known_params,
+    const arma::mat& known_tv_params) {
+    return Model::T_gn(t, state_vec(alpha), theta, known_params, known_tv_params);
+  }
+  static arma::vec a1(const arma::vec& theta, const arma::vec& known_params) {
+    return Model::a1(theta, known_params);
+  }
+  static arma::mat P1(const arma::vec& theta, const arma::vec& known_params) {
+    return Model::P1(theta, known_params);
+  }
+  static double log_prior_pdf(const arma::vec& theta) {
+    return Model::log_prior_pdf(theta);
+  }
+};
+
+// external pointers to the model functions, named as the arguments of nlg_ssm,
+// so that the model can be used with all the methods of nlg_ssm:
+//
+//   // [[Rcpp::export]]
+//   Rcpp::List create_xptrs() {
+//     return nlg_static_pointers<my_model>();
+//   }
+template <class Model>
+Rcpp::List nlg_static_pointers() {
+
+  typedef arma::vec (*nvec_fnPtr)(const unsigned int t, const arma::vec& alpha,
+    const arma::vec& theta, const arma::vec& known_params, const arma::mat& known_tv_params);
+  typedef arma::mat (*nmat_fnPtr)(const unsigned int t, const arma::vec& alpha,
+    const arma::vec& theta, const arma::vec& known_params, const arma::mat& known_tv_params);
+  typedef arma::vec (*a1_fnPtr)(const arma::vec& theta, const arma::vec& known_params);
+  typedef arma::mat (*P1_fnPtr)(const arma::vec& theta, const arma::vec& known_params);
+  typedef double (*prior_fnPtr)(const arma::vec&);
+
+  typedef nlg_static_fns<Model> fns;
+  return Rcpp::List::create(
+    Rcpp::Named("a1_fn") = Rcpp::XPtr<a1_fnPtr>(new a1_fnPtr(&fns::a1)),
+    Rcpp::Named("P1_fn") = Rcpp::XPtr<P1_fnPtr>(new P1_fnPtr(&fns::P1)),
+    Rcpp::Named("Z_fn") = Rcpp::XPtr<nvec_fnPtr>(new nvec_fnPtr(&fns::Z)),
+    Rcpp::Named("H_fn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(&fns::H)),
+    Rcpp::Named("T_fn") = Rcpp::XPtr<nvec_fnPtr>(new nvec_fnPtr(&fns::T)),
+    Rcpp::Named("R_fn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(&fns::R)),
+    Rcpp::Named("Z_gn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(&fns::Z_gn)),
+    Rcpp::Named("T_gn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(&fns::T_gn)),
+    Rcpp::Named("log_prior_pdf") =
+      Rcpp::XPtr<prior_fnPtr>(new prior_fnPtr(&fns::log_prior_pdf)));
+}
+
+#endif
+
+#endif
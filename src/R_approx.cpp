@@ -49,7 +49,8 @@ Rcpp::List gaussian_approx_model_nlg(const arma::mat& y, SEXP Z, SEXP H,
   const arma::mat& known_tv_params, const unsigned int n_states,
   const unsigned int n_etas,  const arma::uvec& time_varying,
   const unsigned int max_iter, 
-  const double conv_tol, const unsigned int iekf_iter) {
+  const double conv_tol, const unsigned int iekf_iter, 
+  const unsigned int n_threads, const bool unscented) {
 
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
   Rcpp::XPtr<nmat_fnPtr> xpfun_H(H);
@@ -64,6 +65,9 @@ Rcpp::List gaussian_approx_model_nlg(const arma::mat& y, SEXP Z, SEXP H,
   nlg_ssm model(y, *xpfun_Z, *xpfun_H, *xpfun_T, *xpfun_R, *xpfun_Zg, *xpfun_Tg, 
     *xpfun_a1, *xpfun_P1,  theta, *xpfun_prior, known_params, known_tv_params, n_states, n_etas,
     time_varying, 1);
+  model.n_threads = n_threads;
+  model.parallel_scan = n_threads > 1;
+  model.unscented_approx = unscented;
   
   arma::mat mode_estimate(model.m, model.n);
   mgg_ssm approx_model = model.approximate(mode_estimate, max_iter, 
@@ -76,5 +80,5 @@ Rcpp::List gaussian_approx_model_nlg(const arma::mat& y, SEXP Z, SEXP H,
     Rcpp::Named("Z") = approx_model.Z, Rcpp::Named("H") = approx_model.H,
     Rcpp::Named("C") = approx_model.C, Rcpp::Named("T") = approx_model.T,
     Rcpp::Named("R") = approx_model.R, Rcpp::Named("a1") = approx_model.a1,
-    Rcpp::Named("P1") = approx_model.P1);
+    Rcpp::Named("P1") = approx_model.P1, Rcpp::Named("mode") = mode_estimate);
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 
 #include "filter_smoother.h"
 #include "summary.h"
+#include "packed_states.h"
 // [[Rcpp::export]]
 Rcpp::List bsf(const Rcpp::List& model_,
   const unsigned int nsim_states, const unsigned int seed, 
@@ -197,7 +198,7 @@ Rcpp::List bsf(const Rcpp::List& model_,
 // [[Rcpp::export]]
 Rcpp::List bsf_smoother(const Rcpp::List& model_,
   const unsigned int nsim_states, const unsigned int seed, 
-  bool gaussian, const int model_type) {
+  bool gaussian, const int model_type, const unsigned int precision) {
   
   if (gaussian) {
     switch (model_type) {
@@ -221,7 +222,7 @@ Rcpp::List bsf_smoother(const Rcpp::List& model_,
     return Rcpp::List::create(
       Rcpp::Named("alphahat") = alphahat, Rcpp::Named("Vt") = Vt, 
       Rcpp::Named("weights") = weights,
-      Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
+      Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = pack_states(alpha, precision));
   } break;
       case 2: {
         ugg_bsm model(clone(model_), seed);
@@ -242,7 +243,7 @@ Rcpp::List bsf_smoother(const Rcpp::List& model_,
         return Rcpp::List::create(
           Rcpp::Named("alphahat") = alphahat, Rcpp::Named("Vt") = Vt, 
           Rcpp::Named("weights") = weights,
-          Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
+          Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = pack_states(alpha, precision));
         
       } break;
     case 3: {
@@ -264,7 +265,7 @@ Rcpp::List bsf_smoother(const Rcpp::List& model_,
         return Rcpp::List::create(
           Rcpp::Named("alphahat") = alphahat, Rcpp::Named("Vt") = Vt, 
           Rcpp::Named("weights") = weights,
-          Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
+          Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = pack_states(alpha, precision));
         
       } break;
       }
@@ -290,7 +291,7 @@ Rcpp::List bsf_smoother(const Rcpp::List& model_,
       return Rcpp::List::create(
         Rcpp::Named("alphahat") = alphahat, Rcpp::Named("Vt") = Vt, 
         Rcpp::Named("weights") = weights,
-        Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
+        Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = pack_states(alpha, precision));
     } break;
       case 2: {
         ung_bsm model(clone(model_), seed);
@@ -311,7 +312,7 @@ Rcpp::List bsf_smoother(const Rcpp::List& model_,
         return Rcpp::List::create(
           Rcpp::Named("alphahat") = alphahat, Rcpp::Named("Vt") = Vt, 
           Rcpp::Named("weights") = weights,
-          Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
+          Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = pack_states(alpha, precision));
         
     } break;
     case 3: {
@@ -333,7 +334,7 @@ Rcpp::List bsf_smoother(const Rcpp::List& model_,
       return Rcpp::List::create(
         Rcpp::Named("alphahat") = alphahat, Rcpp::Named("Vt") = Vt, 
         Rcpp::Named("weights") = weights,
-        Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
+        Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = pack_states(alpha, precision));
       
     } break;
       case 4: {
@@ -355,7 +356,7 @@ Rcpp::List bsf_smoother(const Rcpp::List& model_,
       return Rcpp::List::create(
         Rcpp::Named("alphahat") = alphahat, Rcpp::Named("Vt") = Vt, 
         Rcpp::Named("weights") = weights,
-        Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
+        Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = pack_states(alpha, precision));
       
     } break;
     }
@@ -371,7 +372,8 @@ Rcpp::List bsf_nlg(const arma::mat& y, SEXP Z, SEXP H,
   const arma::mat& known_tv_params, const unsigned int n_states, 
   const unsigned int n_etas,  const arma::uvec& time_varying,
   const unsigned int nsim_states, 
-  const unsigned int seed) {
+  const unsigned int seed,
+  SEXP T_batch, SEXP Z_batch) {
   
   
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
@@ -387,6 +389,7 @@ Rcpp::List bsf_nlg(const arma::mat& y, SEXP Z, SEXP H,
   nlg_ssm model(y, *xpfun_Z, *xpfun_H, *xpfun_T, *xpfun_R, *xpfun_Zg, *xpfun_Tg, 
     *xpfun_a1, *xpfun_P1,  theta, *xpfun_prior, known_params, known_tv_params, n_states, n_etas,
     time_varying, seed);
+  model.set_batch_fns(T_batch, Z_batch);
   
   unsigned int m = model.m;
   unsigned n = model.n;
@@ -396,9 +399,9 @@ Rcpp::List bsf_nlg(const arma::mat& y, SEXP Z, SEXP H,
   arma::umat indices(nsim_states, n);
   double loglik = model.bsf_filter(nsim_states, alpha, weights, indices);
   
-  arma::mat at(m, n);
+  arma::mat at(m, n + 1);
   arma::mat att(m, n);
-  arma::cube Pt(m, m, n);
+  arma::cube Pt(m, m, n + 1);
   arma::cube Ptt(m, m, n);
   filter_summary(alpha, at, att, Pt, Ptt, weights);
   
@@ -417,7 +420,8 @@ Rcpp::List bsf_smoother_nlg(const arma::mat& y, SEXP Z, SEXP H,
   const arma::mat& known_tv_params, const unsigned int n_states, 
   const unsigned int n_etas,  const arma::uvec& time_varying,
   const unsigned int nsim_states, 
-  const unsigned int seed) {
+  const unsigned int seed,
+  SEXP T_batch, SEXP Z_batch) {
   
   
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
@@ -433,6 +437,7 @@ Rcpp::List bsf_smoother_nlg(const arma::mat& y, SEXP Z, SEXP H,
   nlg_ssm model(y, *xpfun_Z, *xpfun_H, *xpfun_T, *xpfun_R, *xpfun_Zg, *xpfun_Tg, 
     *xpfun_a1, *xpfun_P1,  theta, *xpfun_prior, known_params, known_tv_params, n_states, n_etas,
     time_varying, seed);
+  model.set_batch_fns(T_batch, Z_batch);
   
   unsigned int m = model.m;
   unsigned n = model.n;
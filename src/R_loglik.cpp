@@ -81,7 +81,8 @@ double nonlinear_loglik(const arma::mat& y, SEXP Z, SEXP H,
   const unsigned int n_etas,  const arma::uvec& time_varying,
   const unsigned int nsim_states, 
   const unsigned int seed, const unsigned int max_iter, 
-  const double conv_tol, const unsigned int iekf_iter, const unsigned int method) {
+  const double conv_tol, const unsigned int iekf_iter, const unsigned int method,
+  SEXP T_batch, SEXP Z_batch, const bool unscented, const bool auxiliary) {
   
   
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
@@ -97,6 +98,9 @@ double nonlinear_loglik(const arma::mat& y, SEXP Z, SEXP H,
   nlg_ssm model(y, *xpfun_Z, *xpfun_H, *xpfun_T, *xpfun_R, *xpfun_Zg, *xpfun_Tg, 
     *xpfun_a1, *xpfun_P1,  theta, *xpfun_prior, known_params, known_tv_params, n_states, n_etas,
     time_varying, seed);
+  model.set_batch_fns(T_batch, Z_batch);
+  model.unscented_approx = unscented && method == 1;
+  model.auxiliary = auxiliary;
   
   
   unsigned int m = model.m;
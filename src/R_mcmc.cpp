@@ -10,13 +10,37 @@
 #include "ugg_ar1.h"
 #include "summary.h"
 
+// samples of states as an array, or as a list if they are packed
+SEXP states_output(const mcmc& mcmc_run) {
+  if (mcmc_run.packed_alpha.precision > 1) {
+    return mcmc_run.packed_alpha.to_list();
+  }
+  return Rcpp::wrap(mcmc_run.alpha_storage);
+}
+
+// quantiles of states from the sketches as (n + 1) x m x probs.n_elem array
+arma::cube quantiles_output(mcmc& mcmc_run, const arma::vec& probs) {
+  arma::cube q = mcmc_run.alpha_sketch.quantiles(probs);
+  arma::cube alpha_quantiles(q.n_cols, q.n_rows, q.n_slices);
+  for (unsigned int i = 0; i < q.n_slices; i++) {
+    alpha_quantiles.slice(i) = q.slice(i).t();
+  }
+  return alpha_quantiles;
+}
+
 // [[Rcpp::export]]
 Rcpp::List gaussian_mcmc(const Rcpp::List& model_,
   const unsigned int type, const unsigned int n_iter, const unsigned int n_burnin,
   const unsigned int n_thin, const double gamma, const double target_acceptance,
   const arma::mat S, const unsigned int seed, const bool end_ram,
   const unsigned int n_threads, const int model_type, const arma::uvec& Z_ind,
-  const arma::uvec& H_ind, const arma::uvec& T_ind, const arma::uvec& R_ind) {
+  const arma::uvec& H_ind, const arma::uvec& T_ind, const arma::uvec& R_ind,
+  const unsigned int n_chains, const bool shared_warmup, const unsigned int n_temps,
+  const bool speculative, const std::string& output_file, 
+  const unsigned int precision,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval,
+  const arma::vec& probs, const double max_rhat, const double min_ess,
+  const unsigned int check_interval) {
   
   arma::vec a1 = Rcpp::as<arma::vec>(model_["a1"]);
   unsigned int m = a1.n_elem;
@@ -31,16 +55,28 @@ Rcpp::List gaussian_mcmc(const Rcpp::List& model_,
   }
   
   mcmc mcmc_run(n_iter, n_burnin, n_thin, n, m,
-    target_acceptance, gamma, S, type == 1);
+    target_acceptance, gamma, S, (type == 1 || type == 4) ? type : 0, output_file, precision);
+  mcmc_run.set_checkpoint(checkpoint_file, checkpoint_interval, seed);
+  
+  Rcpp::List out = Rcpp::List::create(Rcpp::Named("error") = "error");
   
   switch (model_type) {
   case 1: {
     ugg_ssm model(clone(model_), seed, Z_ind, H_ind, T_ind, R_ind);
-    mcmc_run.mcmc_gaussian(model, end_ram);
+    if (n_temps > 1) {
+      mcmc_run.pt_mcmc_gaussian(model, end_ram, n_temps, seed, n_threads);
+    } else if (n_chains > 1) {
+      mcmc_run.mcmc_gaussian_chains(model, end_ram, seed, n_chains, 
+        shared_warmup, n_threads, max_rhat, min_ess, check_interval);
+    } else if (speculative) {
+      mcmc_run.spec_mcmc_gaussian(model, end_ram, n_threads);
+    } else {
+      mcmc_run.mcmc_gaussian(model, end_ram);
+    }
     switch (type) { 
     case 1: {
       mcmc_run.state_posterior(model, n_threads); //sample states
-      return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+      out = Rcpp::List::create(Rcpp::Named("alpha") = states_output(mcmc_run),
         Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
@@ -51,15 +87,25 @@ Rcpp::List gaussian_mcmc(const Rcpp::List& model_,
       arma::mat alphahat(m, n + 1);
       arma::cube Vt(m, m, n + 1);
       mcmc_run.state_summary(model, alphahat, Vt);
-      return Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      out = Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("alphahat") = alphahat.t(), Rcpp::Named("Vt") = Vt,
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
         Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
     } break;
+    case 4: {
+      //streaming quantiles of states
+      mcmc_run.state_posterior(model, n_threads);
+      out = Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+        Rcpp::Named("alphahat") = mcmc_run.alpha_sketch.mean().t(),
+        Rcpp::Named("alpha_quantiles") = quantiles_output(mcmc_run, probs),
+        Rcpp::Named("counts") = mcmc_run.count_storage,
+        Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
+        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+    } break;
     case 3: {
       //marginal of theta
-      return Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      out = Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
         Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
@@ -68,11 +114,20 @@ Rcpp::List gaussian_mcmc(const Rcpp::List& model_,
   }break;
   case 2: {
     ugg_bsm model(clone(model_), seed);
-    mcmc_run.mcmc_gaussian(model, end_ram);
+    if (n_temps > 1) {
+      mcmc_run.pt_mcmc_gaussian(model, end_ram, n_temps, seed, n_threads);
+    } else if (n_chains > 1) {
+      mcmc_run.mcmc_gaussian_chains(model, end_ram, seed, n_chains, 
+        shared_warmup, n_threads, max_rhat, min_ess, check_interval);
+    } else if (speculative) {
+      mcmc_run.spec_mcmc_gaussian(model, end_ram, n_threads);
+    } else {
+      mcmc_run.mcmc_gaussian(model, end_ram);
+    }
     switch (type) { 
     case 1: {
       mcmc_run.state_posterior(model, n_threads); //sample states
-      return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+      out = Rcpp::List::create(Rcpp::Named("alpha") = states_output(mcmc_run),
         Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
@@ -83,15 +138,25 @@ Rcpp::List gaussian_mcmc(const Rcpp::List& model_,
       arma::mat alphahat(m, n + 1);
       arma::cube Vt(m, m, n + 1);
       mcmc_run.state_summary(model, alphahat, Vt);
-      return Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      out = Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("alphahat") = alphahat.t(), Rcpp::Named("Vt") = Vt,
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
         Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
     } break;
+    case 4: {
+      //streaming quantiles of states
+      mcmc_run.state_posterior(model, n_threads);
+      out = Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+        Rcpp::Named("alphahat") = mcmc_run.alpha_sketch.mean().t(),
+        Rcpp::Named("alpha_quantiles") = quantiles_output(mcmc_run, probs),
+        Rcpp::Named("counts") = mcmc_run.count_storage,
+        Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
+        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+    } break;
     case 3: {
       //marginal of theta
-      return Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      out = Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
         Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
@@ -100,11 +165,20 @@ Rcpp::List gaussian_mcmc(const Rcpp::List& model_,
   } break;
   case 3: {
     ugg_ar1 model(clone(model_), seed);
-    mcmc_run.mcmc_gaussian(model, end_ram);
+    if (n_temps > 1) {
+      mcmc_run.pt_mcmc_gaussian(model, end_ram, n_temps, seed, n_threads);
+    } else if (n_chains > 1) {
+      mcmc_run.mcmc_gaussian_chains(model, end_ram, seed, n_chains, 
+        shared_warmup, n_threads, max_rhat, min_ess, check_interval);
+    } else if (speculative) {
+      mcmc_run.spec_mcmc_gaussian(model, end_ram, n_threads);
+    } else {
+      mcmc_run.mcmc_gaussian(model, end_ram);
+    }
     switch (type) { 
     case 1: {
       mcmc_run.state_posterior(model, n_threads); //sample states
-      return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+      out = Rcpp::List::create(Rcpp::Named("alpha") = states_output(mcmc_run),
         Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
@@ -115,15 +189,25 @@ Rcpp::List gaussian_mcmc(const Rcpp::List& model_,
       arma::mat alphahat(m, n + 1);
       arma::cube Vt(m, m, n + 1);
       mcmc_run.state_summary(model, alphahat, Vt);
-      return Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      out = Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("alphahat") = alphahat.t(), Rcpp::Named("Vt") = Vt,
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
         Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
     } break;
+    case 4: {
+      //streaming quantiles of states
+      mcmc_run.state_posterior(model, n_threads);
+      out = Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+        Rcpp::Named("alphahat") = mcmc_run.alpha_sketch.mean().t(),
+        Rcpp::Named("alpha_quantiles") = quantiles_output(mcmc_run, probs),
+        Rcpp::Named("counts") = mcmc_run.count_storage,
+        Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
+        Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+    } break;
     case 3: {
       //marginal of theta
-      return Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      out = Rcpp::List::create(Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
         Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
@@ -131,7 +215,18 @@ Rcpp::List gaussian_mcmc(const Rcpp::List& model_,
     } 
   } break;
   }
-  return Rcpp::List::create(Rcpp::Named("error") = "error");
+  mcmc_run.close_output();
+  if (n_chains > 1) {
+    out.push_back(mcmc_run.chain_storage, "chain");
+    out.push_back(mcmc_run.rhat, "rhat");
+    out.push_back(mcmc_run.ess, "ess");
+    out.push_back(mcmc_run.stop_iter, "n_iter");
+  }
+  if (n_temps > 1) {
+    out.push_back(mcmc_run.beta, "beta");
+    out.push_back(mcmc_run.swap_rate, "swap_rate");
+  }
+  return out;
 }
 // [[Rcpp::export]]
 Rcpp::List nongaussian_pm_mcmc(const Rcpp::List& model_,
@@ -143,7 +238,11 @@ Rcpp::List nongaussian_pm_mcmc(const Rcpp::List& model_,
   const bool local_approx, const arma::vec initial_mode,
   const unsigned int max_iter, const double conv_tol,
   const unsigned int simulation_method, const int model_type,
-  const arma::uvec& Z_ind, const arma::uvec& T_ind, const arma::uvec& R_ind) {
+  const arma::uvec& Z_ind, const arma::uvec& T_ind, const arma::uvec& R_ind,
+  const unsigned int n_temps, const bool speculative, const std::string& output_file,
+  const unsigned int precision,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval,
+  const arma::vec& probs) {
   
   arma::vec a1 = Rcpp::as<arma::vec>(model_["a1"]);
   unsigned int m = a1.n_elem;
@@ -158,100 +257,148 @@ Rcpp::List nongaussian_pm_mcmc(const Rcpp::List& model_,
   }
   
   mcmc mcmc_run(n_iter, n_burnin, n_thin, n, m,
-    target_acceptance, gamma, S, type);
+    target_acceptance, gamma, S, type, output_file, precision);
+  mcmc_run.set_checkpoint(checkpoint_file, checkpoint_interval, seed);
   
   switch (model_type) {
   case 1: {
     ung_ssm model(clone(model_), seed, Z_ind, T_ind, R_ind);
-    switch (simulation_method) {
-    case 1:
-      mcmc_run.pm_mcmc_psi(model, end_ram, nsim_states, local_approx, initial_mode,
-        max_iter, conv_tol);
-      break;
-    case 2:
-      mcmc_run.pm_mcmc_bsf(model, end_ram, nsim_states);
-      break;
-    case 3:
-      mcmc_run.pm_mcmc_spdk(model, end_ram, nsim_states, local_approx, initial_mode,
-        max_iter, conv_tol);
-      break;
+    if (n_temps > 1) {
+      mcmc_run.pt_mcmc_pm(model, end_ram, nsim_states, simulation_method, 
+        local_approx, initial_mode, max_iter, conv_tol, n_temps, seed, n_threads);
+    } else if (speculative) {
+      mcmc_run.spec_mcmc_pm(model, end_ram, nsim_states, simulation_method, 
+        initial_mode, max_iter, conv_tol, n_threads);
+    } else {
+      switch (simulation_method) {
+      case 1:
+        mcmc_run.pm_mcmc_psi(model, end_ram, nsim_states, local_approx, initial_mode,
+          max_iter, conv_tol);
+        break;
+      case 2:
+        mcmc_run.pm_mcmc_bsf(model, end_ram, nsim_states);
+        break;
+      case 3:
+        mcmc_run.pm_mcmc_spdk(model, end_ram, nsim_states, local_approx, initial_mode,
+          max_iter, conv_tol);
+        break;
+      }
     }
   } break;
   case 2: {
     ung_bsm model(clone(model_), seed);
-    switch (simulation_method) {
-    case 1:
-      mcmc_run.pm_mcmc_psi(model, end_ram, nsim_states, local_approx, initial_mode,
-        max_iter, conv_tol);
-      break;
-    case 2:
-      mcmc_run.pm_mcmc_bsf(model, end_ram, nsim_states);
-      break;
-    case 3:
-      mcmc_run.pm_mcmc_spdk(model, end_ram, nsim_states, local_approx, initial_mode,
-        max_iter, conv_tol);
-      break;
+    if (n_temps > 1) {
+      mcmc_run.pt_mcmc_pm(model, end_ram, nsim_states, simulation_method, 
+        local_approx, initial_mode, max_iter, conv_tol, n_temps, seed, n_threads);
+    } else if (speculative) {
+      mcmc_run.spec_mcmc_pm(model, end_ram, nsim_states, simulation_method, 
+        initial_mode, max_iter, conv_tol, n_threads);
+    } else {
+      switch (simulation_method) {
+      case 1:
+        mcmc_run.pm_mcmc_psi(model, end_ram, nsim_states, local_approx, initial_mode,
+          max_iter, conv_tol);
+        break;
+      case 2:
+        mcmc_run.pm_mcmc_bsf(model, end_ram, nsim_states);
+        break;
+      case 3:
+        mcmc_run.pm_mcmc_spdk(model, end_ram, nsim_states, local_approx, initial_mode,
+          max_iter, conv_tol);
+        break;
+      }
     }
   } break;
   case 3: {
     ung_svm model(clone(model_), seed);
-    switch (simulation_method) {
-    case 1:
-      mcmc_run.pm_mcmc_psi(model, end_ram, nsim_states, local_approx, initial_mode,
-        max_iter, conv_tol);
-      break;
-    case 2:
-      mcmc_run.pm_mcmc_bsf(model, end_ram, nsim_states);
-      break;
-    case 3:
-      mcmc_run.pm_mcmc_spdk(model, end_ram, nsim_states, local_approx, initial_mode,
-        max_iter, conv_tol);
-      break;
+    if (n_temps > 1) {
+      mcmc_run.pt_mcmc_pm(model, end_ram, nsim_states, simulation_method, 
+        local_approx, initial_mode, max_iter, conv_tol, n_temps, seed, n_threads);
+    } else if (speculative) {
+      mcmc_run.spec_mcmc_pm(model, end_ram, nsim_states, simulation_method, 
+        initial_mode, max_iter, conv_tol, n_threads);
+    } else {
+      switch (simulation_method) {
+      case 1:
+        mcmc_run.pm_mcmc_psi(model, end_ram, nsim_states, local_approx, initial_mode,
+          max_iter, conv_tol);
+        break;
+      case 2:
+        mcmc_run.pm_mcmc_bsf(model, end_ram, nsim_states);
+        break;
+      case 3:
+        mcmc_run.pm_mcmc_spdk(model, end_ram, nsim_states, local_approx, initial_mode,
+          max_iter, conv_tol);
+        break;
+      }
     }
   } break;
   case 4: {
     ung_ar1 model(clone(model_), seed);
-    switch (simulation_method) {
-    case 1:
-      mcmc_run.pm_mcmc_psi(model, end_ram, nsim_states, local_approx, initial_mode,
-        max_iter, conv_tol);
-      break;
-    case 2:
-      mcmc_run.pm_mcmc_bsf(model, end_ram, nsim_states);
-      break;
-    case 3:
-      mcmc_run.pm_mcmc_spdk(model, end_ram, nsim_states, local_approx, initial_mode,
-        max_iter, conv_tol);
-      break;
+    if (n_temps > 1) {
+      mcmc_run.pt_mcmc_pm(model, end_ram, nsim_states, simulation_method, 
+        local_approx, initial_mode, max_iter, conv_tol, n_temps, seed, n_threads);
+    } else if (speculative) {
+      mcmc_run.spec_mcmc_pm(model, end_ram, nsim_states, simulation_method, 
+        initial_mode, max_iter, conv_tol, n_threads);
+    } else {
+      switch (simulation_method) {
+      case 1:
+        mcmc_run.pm_mcmc_psi(model, end_ram, nsim_states, local_approx, initial_mode,
+          max_iter, conv_tol);
+        break;
+      case 2:
+        mcmc_run.pm_mcmc_bsf(model, end_ram, nsim_states);
+        break;
+      case 3:
+        mcmc_run.pm_mcmc_spdk(model, end_ram, nsim_states, local_approx, initial_mode,
+          max_iter, conv_tol);
+        break;
+      }
     }
   } break;
   }
+  
+  mcmc_run.close_output();
+  Rcpp::List out = Rcpp::List::create(Rcpp::Named("error") = "error");
   switch (type) { 
   case 1: {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    out = Rcpp::List::create(Rcpp::Named("alpha") = states_output(mcmc_run),
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
       Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
   } break;
   case 2: {
-    return Rcpp::List::create(
+    out = Rcpp::List::create(
       Rcpp::Named("alphahat") = mcmc_run.alphahat.t(), Rcpp::Named("Vt") = mcmc_run.Vt,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
       Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
   } break;
+  case 4: {
+    out = Rcpp::List::create(
+      Rcpp::Named("alphahat") = mcmc_run.alpha_sketch.mean().t(),
+      Rcpp::Named("alpha_quantiles") = quantiles_output(mcmc_run, probs),
+      Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      Rcpp::Named("counts") = mcmc_run.count_storage,
+      Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+  } break;
   case 3: {
-    return Rcpp::List::create(
+    out = Rcpp::List::create(
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
       Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
   } break;
   }
-  
-  return Rcpp::List::create(Rcpp::Named("error") = "error");
+  if (n_temps > 1) {
+    out.push_back(mcmc_run.beta, "beta");
+    out.push_back(mcmc_run.swap_rate, "swap_rate");
+  }
+  return out;
 }
 
 
@@ -264,7 +411,10 @@ Rcpp::List nongaussian_da_mcmc(const Rcpp::List& model_,
   const bool end_ram, const unsigned int n_threads, const bool local_approx,
   const arma::vec initial_mode, const unsigned int max_iter, const double conv_tol,
   const unsigned int simulation_method, const int model_type,
-  const arma::uvec& Z_ind, const arma::uvec& T_ind, const arma::uvec& R_ind) {
+  const arma::uvec& Z_ind, const arma::uvec& T_ind, const arma::uvec& R_ind,
+  const std::string& output_file, const unsigned int precision,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval,
+  const arma::vec& probs) {
   
   arma::vec a1 = Rcpp::as<arma::vec>(model_["a1"]);
   unsigned int m = a1.n_elem;
@@ -279,7 +429,8 @@ Rcpp::List nongaussian_da_mcmc(const Rcpp::List& model_,
   }
   
   mcmc mcmc_run(n_iter, n_burnin, n_thin, n, m,
-    target_acceptance, gamma, S, type);
+    target_acceptance, gamma, S, type, output_file, precision);
+  mcmc_run.set_checkpoint(checkpoint_file, checkpoint_interval, seed);
   
   switch (model_type) {
   case 1: {
@@ -353,9 +504,10 @@ Rcpp::List nongaussian_da_mcmc(const Rcpp::List& model_,
   } break;
   }
   
+  mcmc_run.close_output();
   switch (type) { 
   case 1: {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    return Rcpp::List::create(Rcpp::Named("alpha") = states_output(mcmc_run),
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
@@ -369,6 +521,15 @@ Rcpp::List nongaussian_da_mcmc(const Rcpp::List& model_,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
       Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
   } break;
+  case 4: {
+    return Rcpp::List::create(
+      Rcpp::Named("alphahat") = mcmc_run.alpha_sketch.mean().t(),
+      Rcpp::Named("alpha_quantiles") = quantiles_output(mcmc_run, probs),
+      Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      Rcpp::Named("counts") = mcmc_run.count_storage,
+      Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+  } break;
   case 3: {
     return Rcpp::List::create(
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
@@ -392,7 +553,11 @@ Rcpp::List nongaussian_is_mcmc(const Rcpp::List& model_,
   const bool end_ram, const unsigned int n_threads, const bool local_approx,
   const arma::vec initial_mode, const unsigned int max_iter, const double conv_tol,
   const unsigned int simulation_method, const unsigned int is_type, const int model_type,
-  const arma::uvec& Z_ind, const arma::uvec& T_ind, const arma::uvec& R_ind) {
+  const arma::uvec& Z_ind, const arma::uvec& T_ind, const arma::uvec& R_ind,
+  const bool pipeline, const unsigned int n_temps, const std::string& output_file,
+  const unsigned int precision,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval,
+  const arma::vec& probs) {
   
   arma::vec a1 = Rcpp::as<arma::vec>(model_["a1"]);
   unsigned int m = a1.n_elem;
@@ -407,7 +572,9 @@ Rcpp::List nongaussian_is_mcmc(const Rcpp::List& model_,
   }
   
   ung_amcmc mcmc_run(n_iter, n_burnin, n_thin, n, m,
-    target_acceptance, gamma, S, type, simulation_method != 2);
+    target_acceptance, gamma, S, type, simulation_method != 2, output_file, 
+    precision);
+  mcmc_run.set_checkpoint(checkpoint_file, checkpoint_interval, seed);
   if (nsim_states <= 1) {
     mcmc_run.alpha_storage.zeros();
     mcmc_run.weight_storage.ones();
@@ -415,101 +582,143 @@ Rcpp::List nongaussian_is_mcmc(const Rcpp::List& model_,
   switch (model_type) {
   case 1: {
     ung_ssm model(clone(model_), seed, Z_ind, T_ind, R_ind);
-    mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
-      max_iter, conv_tol);
-    if(nsim_states > 1) {
-      if(is_type == 3) {
-        mcmc_run.expand();
+    if (pipeline && nsim_states > 1) {
+      mcmc_run.pipelined_is_mcmc(model, end_ram, local_approx, initial_mode,
+        max_iter, conv_tol, simulation_method, nsim_states, is_type, n_threads);
+    } else {
+      if (n_temps > 1) {
+        mcmc_run.pt_approx_mcmc(model, end_ram, initial_mode, max_iter, conv_tol, 
+          n_temps, seed, n_threads);
+      } else {
+        mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
+          max_iter, conv_tol);
       }
-      switch (simulation_method) {
-      case 1:
-        mcmc_run.is_correction_psi(model, nsim_states, is_type, n_threads);
-        break;
-      case 2:
-        mcmc_run.is_correction_bsf(model, nsim_states, is_type, n_threads);
-        break;
-      case 3:
-        mcmc_run.is_correction_spdk(model, nsim_states, is_type, n_threads);
-        break;
+      if(nsim_states > 1) {
+        if(is_type == 3) {
+          mcmc_run.expand();
+        }
+        switch (simulation_method) {
+        case 1:
+          mcmc_run.is_correction_psi(model, nsim_states, is_type, n_threads);
+          break;
+        case 2:
+          mcmc_run.is_correction_bsf(model, nsim_states, is_type, n_threads);
+          break;
+        case 3:
+          mcmc_run.is_correction_spdk(model, nsim_states, is_type, n_threads);
+          break;
+        }
+      } else {
+        if(nsim_states == 1) mcmc_run.approx_state_posterior(model, n_threads);
       }
-    } else {
-      if(nsim_states == 1) mcmc_run.approx_state_posterior(model, n_threads);
     }
   } break;
   case 2: {
     ung_bsm model(clone(model_), seed);
-    mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
-      max_iter, conv_tol);
-    if(nsim_states > 1) {
-      if(is_type == 3) {
-        mcmc_run.expand();
+    if (pipeline && nsim_states > 1) {
+      mcmc_run.pipelined_is_mcmc(model, end_ram, local_approx, initial_mode,
+        max_iter, conv_tol, simulation_method, nsim_states, is_type, n_threads);
+    } else {
+      if (n_temps > 1) {
+        mcmc_run.pt_approx_mcmc(model, end_ram, initial_mode, max_iter, conv_tol, 
+          n_temps, seed, n_threads);
+      } else {
+        mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
+          max_iter, conv_tol);
       }
-      switch (simulation_method) {
-      case 1:
-        mcmc_run.is_correction_psi(model, nsim_states, is_type, n_threads);
-        break;
-      case 2:
-        mcmc_run.is_correction_bsf(model, nsim_states, is_type, n_threads);
-        break;
-      case 3:
-        mcmc_run.is_correction_spdk(model, nsim_states, is_type, n_threads);
-        break;
+      if(nsim_states > 1) {
+        if(is_type == 3) {
+          mcmc_run.expand();
+        }
+        switch (simulation_method) {
+        case 1:
+          mcmc_run.is_correction_psi(model, nsim_states, is_type, n_threads);
+          break;
+        case 2:
+          mcmc_run.is_correction_bsf(model, nsim_states, is_type, n_threads);
+          break;
+        case 3:
+          mcmc_run.is_correction_spdk(model, nsim_states, is_type, n_threads);
+          break;
+        }
+      } else {
+        if(nsim_states == 1) mcmc_run.approx_state_posterior(model, n_threads);
       }
-    } else {
-      if(nsim_states == 1) mcmc_run.approx_state_posterior(model, n_threads);
     }
   } break;
   case 3: {
     ung_svm model(clone(model_), seed);
-    mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
-      max_iter, conv_tol);
-    if(nsim_states > 1) {
-      if(is_type == 3) {
-        mcmc_run.expand();
+    if (pipeline && nsim_states > 1) {
+      mcmc_run.pipelined_is_mcmc(model, end_ram, local_approx, initial_mode,
+        max_iter, conv_tol, simulation_method, nsim_states, is_type, n_threads);
+    } else {
+      if (n_temps > 1) {
+        mcmc_run.pt_approx_mcmc(model, end_ram, initial_mode, max_iter, conv_tol, 
+          n_temps, seed, n_threads);
+      } else {
+        mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
+          max_iter, conv_tol);
       }
-      switch (simulation_method) {
-      case 1:
-        mcmc_run.is_correction_psi(model, nsim_states, is_type, n_threads);
-        break;
-      case 2:
-        mcmc_run.is_correction_bsf(model, nsim_states, is_type, n_threads);
-        break;
-      case 3:
-        mcmc_run.is_correction_spdk(model, nsim_states, is_type, n_threads);
-        break;
+      if(nsim_states > 1) {
+        if(is_type == 3) {
+          mcmc_run.expand();
+        }
+        switch (simulation_method) {
+        case 1:
+          mcmc_run.is_correction_psi(model, nsim_states, is_type, n_threads);
+          break;
+        case 2:
+          mcmc_run.is_correction_bsf(model, nsim_states, is_type, n_threads);
+          break;
+        case 3:
+          mcmc_run.is_correction_spdk(model, nsim_states, is_type, n_threads);
+          break;
+        }
+      } else {
+        if(nsim_states == 1) mcmc_run.approx_state_posterior(model, n_threads);
       }
-    } else {
-      if(nsim_states == 1) mcmc_run.approx_state_posterior(model, n_threads);
     }
   } break;  
   case 4: {
     ung_ar1 model(clone(model_), seed);
-    mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
-      max_iter, conv_tol);
-    if(nsim_states > 1) {
-      if(is_type == 3) {
-        mcmc_run.expand();
+    if (pipeline && nsim_states > 1) {
+      mcmc_run.pipelined_is_mcmc(model, end_ram, local_approx, initial_mode,
+        max_iter, conv_tol, simulation_method, nsim_states, is_type, n_threads);
+    } else {
+      if (n_temps > 1) {
+        mcmc_run.pt_approx_mcmc(model, end_ram, initial_mode, max_iter, conv_tol, 
+          n_temps, seed, n_threads);
+      } else {
+        mcmc_run.approx_mcmc(model, end_ram, local_approx, initial_mode,
+          max_iter, conv_tol);
       }
-      switch (simulation_method) {
-      case 1:
-        mcmc_run.is_correction_psi(model, nsim_states, is_type, n_threads);
-        break;
-      case 2:
-        mcmc_run.is_correction_bsf(model, nsim_states, is_type, n_threads);
-        break;
-      case 3:
-        mcmc_run.is_correction_spdk(model, nsim_states, is_type, n_threads);
-        break;
+      if(nsim_states > 1) {
+        if(is_type == 3) {
+          mcmc_run.expand();
+        }
+        switch (simulation_method) {
+        case 1:
+          mcmc_run.is_correction_psi(model, nsim_states, is_type, n_threads);
+          break;
+        case 2:
+          mcmc_run.is_correction_bsf(model, nsim_states, is_type, n_threads);
+          break;
+        case 3:
+          mcmc_run.is_correction_spdk(model, nsim_states, is_type, n_threads);
+          break;
+        }
+      } else {
+        if(nsim_states == 1) mcmc_run.approx_state_posterior(model, n_threads);
       }
-    } else {
-      if(nsim_states == 1) mcmc_run.approx_state_posterior(model, n_threads);
     }
   } break;
   }
   
+  mcmc_run.close_output();
+  Rcpp::List out = Rcpp::List::create(Rcpp::Named("error") = "error");
   switch (type) { 
   case 1: {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    out = Rcpp::List::create(Rcpp::Named("alpha") = states_output(mcmc_run),
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("weights") = mcmc_run.weight_storage,
       Rcpp::Named("counts") = mcmc_run.count_storage,
@@ -517,7 +726,7 @@ Rcpp::List nongaussian_is_mcmc(const Rcpp::List& model_,
       Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
   } break;
   case 2: {
-    return Rcpp::List::create(
+    out = Rcpp::List::create(
       Rcpp::Named("alphahat") = mcmc_run.alphahat.t(), Rcpp::Named("Vt") = mcmc_run.Vt,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("weights") = mcmc_run.weight_storage,
@@ -525,8 +734,18 @@ Rcpp::List nongaussian_is_mcmc(const Rcpp::List& model_,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
       Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
   } break;
+  case 4: {
+    out = Rcpp::List::create(
+      Rcpp::Named("alphahat") = mcmc_run.alpha_sketch.mean().t(),
+      Rcpp::Named("alpha_quantiles") = quantiles_output(mcmc_run, probs),
+      Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      Rcpp::Named("weights") = mcmc_run.weight_storage,
+      Rcpp::Named("counts") = mcmc_run.count_storage,
+      Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+  } break;
   case 3: {
-    return Rcpp::List::create(
+    out = Rcpp::List::create(
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("weights") = mcmc_run.weight_storage,
       Rcpp::Named("counts") = mcmc_run.count_storage,
@@ -534,8 +753,11 @@ Rcpp::List nongaussian_is_mcmc(const Rcpp::List& model_,
       Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
   } break;
   }
-  
-  return Rcpp::List::create(Rcpp::Named("error") = "error");
+  if (n_temps > 1) {
+    out.push_back(mcmc_run.beta, "beta");
+    out.push_back(mcmc_run.swap_rate, "swap_rate");
+  }
+  return out;
 }
 
 // [[Rcpp::export]]
@@ -550,7 +772,11 @@ Rcpp::List nonlinear_pm_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   const bool end_ram, const unsigned int n_threads,
   const unsigned int max_iter, const double conv_tol,
   const unsigned int simulation_method, const unsigned int iekf_iter,
-  const unsigned int type) {
+  const unsigned int type, const unsigned int n_temps, const bool speculative,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval,
+  const unsigned int mode_cache_size,
+  SEXP T_batch, SEXP Z_batch, const bool parallel_scan,
+  const bool unscented, const bool auxiliary) {
   
   
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
@@ -566,29 +792,43 @@ Rcpp::List nonlinear_pm_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   nlg_ssm model(y, *xpfun_Z, *xpfun_H, *xpfun_T, *xpfun_R, *xpfun_Zg, *xpfun_Tg, 
     *xpfun_a1, *xpfun_P1,  theta, *xpfun_prior, known_params, known_tv_params, n_states, n_etas,
     time_varying, seed);
+  model.set_batch_fns(T_batch, Z_batch);
+  model.cached_modes = mode_cache(mode_cache_size);
+  model.n_threads = n_threads;
+  model.parallel_scan = parallel_scan;
+  model.unscented_approx = unscented;
+  model.auxiliary = auxiliary;
   
   mcmc mcmc_run(n_iter, n_burnin, n_thin, model.n,
     model.m, target_acceptance, gamma, S, type);
+  mcmc_run.set_checkpoint(checkpoint_file, checkpoint_interval, seed);
   
-  switch (simulation_method) {
-  case 1:
-    mcmc_run.pm_mcmc_psi_nlg(model, end_ram, nsim_states, max_iter, conv_tol, iekf_iter);
-    break;
-  case 2:
-    mcmc_run.pm_mcmc_bsf_nlg(model, end_ram, nsim_states);
-    break;
+  if (n_temps > 1) {
+    mcmc_run.pt_mcmc_bsf_nlg(model, end_ram, nsim_states, n_temps, seed, n_threads);
+  } else if (speculative) {
+    mcmc_run.spec_mcmc_bsf_nlg(model, end_ram, nsim_states, n_threads);
+  } else {
+    switch (simulation_method) {
+    case 1:
+      mcmc_run.pm_mcmc_psi_nlg(model, end_ram, nsim_states, max_iter, conv_tol, iekf_iter);
+      break;
+    case 2:
+      mcmc_run.pm_mcmc_bsf_nlg(model, end_ram, nsim_states);
+      break;
+    }
   }
   
+  Rcpp::List out = Rcpp::List::create(Rcpp::Named("error") = "error");
   switch (type) { 
   case 1: {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    out = Rcpp::List::create(Rcpp::Named("alpha") = states_output(mcmc_run),
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
       Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
   } break;
   case 2: {
-    return Rcpp::List::create(
+    out = Rcpp::List::create(
       Rcpp::Named("alphahat") = mcmc_run.alphahat.t(), Rcpp::Named("Vt") = mcmc_run.Vt,
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
@@ -596,15 +836,18 @@ Rcpp::List nonlinear_pm_mcmc(const arma::mat& y, SEXP Z, SEXP H,
       Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
   } break;
   case 3: {
-    return Rcpp::List::create(
+    out = Rcpp::List::create(
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
       Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
   } break;
   }
-  
-  return Rcpp::List::create(Rcpp::Named("error") = "error");
+  if (n_temps > 1) {
+    out.push_back(mcmc_run.beta, "beta");
+    out.push_back(mcmc_run.swap_rate, "swap_rate");
+  }
+  return out;
 }
 // [[Rcpp::export]]
 Rcpp::List nonlinear_da_mcmc(const arma::mat& y, SEXP Z, SEXP H,
@@ -618,7 +861,11 @@ Rcpp::List nonlinear_da_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   const bool end_ram, const unsigned int n_threads,
   const unsigned int max_iter, const double conv_tol,
   const unsigned int simulation_method, const unsigned int iekf_iter,
-  const unsigned int type) {
+  const unsigned int type,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval,
+  const unsigned int mode_cache_size,
+  SEXP T_batch, SEXP Z_batch, const bool parallel_scan,
+  const bool unscented, const bool auxiliary) {
   
   
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
@@ -634,9 +881,16 @@ Rcpp::List nonlinear_da_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   nlg_ssm model(y, *xpfun_Z, *xpfun_H, *xpfun_T, *xpfun_R, *xpfun_Zg, *xpfun_Tg, 
     *xpfun_a1, *xpfun_P1,  theta, *xpfun_prior, known_params, known_tv_params, n_states, n_etas,
     time_varying, seed);
+  model.set_batch_fns(T_batch, Z_batch);
+  model.cached_modes = mode_cache(mode_cache_size);
+  model.n_threads = n_threads;
+  model.parallel_scan = parallel_scan;
+  model.unscented_approx = unscented;
+  model.auxiliary = auxiliary;
   
   mcmc mcmc_run(n_iter, n_burnin, n_thin, model.n,
     model.m, target_acceptance, gamma, S, type);
+  mcmc_run.set_checkpoint(checkpoint_file, checkpoint_interval, seed);
   
   
   switch (simulation_method) {
@@ -650,7 +904,7 @@ Rcpp::List nonlinear_da_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   
   switch (type) { 
   case 1: {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    return Rcpp::List::create(Rcpp::Named("alpha") = states_output(mcmc_run),
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
@@ -686,7 +940,8 @@ Rcpp::List nonlinear_ekf_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   const unsigned int n_burnin, const unsigned int n_thin,
   const double gamma, const double target_acceptance, const arma::mat S,
   const bool end_ram, const unsigned int n_threads, 
-  const unsigned int iekf_iter, const unsigned int type) {
+  const unsigned int iekf_iter, const unsigned int type,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval) {
   
   
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
@@ -705,6 +960,7 @@ Rcpp::List nonlinear_ekf_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   
   nlg_amcmc mcmc_run(n_iter, n_burnin, n_thin, model.n,
     model.m, target_acceptance, gamma, S, type, false);
+  mcmc_run.set_checkpoint(checkpoint_file, checkpoint_interval, seed);
   
   mcmc_run.ekf_mcmc(model, end_ram, iekf_iter);
   
@@ -723,7 +979,7 @@ Rcpp::List nonlinear_ekf_mcmc(const arma::mat& y, SEXP Z, SEXP H,
     
     if (type == 1) {
       mcmc_run.state_ekf_sample(model, n_threads, iekf_iter);
-      return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+      return Rcpp::List::create(Rcpp::Named("alpha") = states_output(mcmc_run),
         Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
         Rcpp::Named("counts") = mcmc_run.count_storage,
         Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
@@ -750,7 +1006,11 @@ Rcpp::List nonlinear_is_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   const bool end_ram, const unsigned int n_threads, const unsigned int is_type,
   const unsigned int simulation_method, const unsigned int max_iter,
   const double conv_tol, const unsigned int iekf_iter,
-  const unsigned int type) {
+  const unsigned int type, const bool pipeline,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval,
+  const unsigned int mode_cache_size,
+  SEXP T_batch, SEXP Z_batch, const bool parallel_scan,
+  const bool unscented, const bool auxiliary) {
   
   
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
@@ -766,25 +1026,37 @@ Rcpp::List nonlinear_is_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   nlg_ssm model(y, *xpfun_Z, *xpfun_H, *xpfun_T, *xpfun_R, *xpfun_Zg, *xpfun_Tg, 
     *xpfun_a1, *xpfun_P1,  theta, *xpfun_prior, known_params, known_tv_params, n_states, n_etas,
     time_varying, seed);
+  model.set_batch_fns(T_batch, Z_batch);
+  model.cached_modes = mode_cache(mode_cache_size);
+  model.n_threads = n_threads;
+  model.parallel_scan = parallel_scan;
+  model.unscented_approx = unscented;
+  model.auxiliary = auxiliary;
   
   nlg_amcmc mcmc_run(n_iter, n_burnin, n_thin, model.n,
     model.m, target_acceptance, gamma, S, type, simulation_method == 1);
+  mcmc_run.set_checkpoint(checkpoint_file, checkpoint_interval, seed);
   
-  mcmc_run.approx_mcmc(model, max_iter, conv_tol, end_ram, iekf_iter);
-  if(nsim_states > 0) {
-    if (is_type == 3) {
-      mcmc_run.expand();
-    }
-    if (simulation_method == 1) {
-      mcmc_run.is_correction_psi(model, nsim_states, is_type, n_threads);
+  if (pipeline && nsim_states > 0) {
+    mcmc_run.pipelined_is_mcmc(model, max_iter, conv_tol, end_ram, iekf_iter,
+      simulation_method, nsim_states, is_type, n_threads);
+  } else {
+    mcmc_run.approx_mcmc(model, max_iter, conv_tol, end_ram, iekf_iter);
+    if(nsim_states > 0) {
+      if (is_type == 3) {
+        mcmc_run.expand();
+      }
+      if (simulation_method == 1) {
+        mcmc_run.is_correction_psi(model, nsim_states, is_type, n_threads);
+      } else {
+        mcmc_run.is_correction_bsf(model, nsim_states, is_type, n_threads);
+      }
     } else {
-      mcmc_run.is_correction_bsf(model, nsim_states, is_type, n_threads);
+      mcmc_run.alpha_storage.zeros();
+      mcmc_run.weight_storage.ones();
     }
-  } else {
-    mcmc_run.alpha_storage.zeros();
-    mcmc_run.weight_storage.ones();
   }
-  return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+  return Rcpp::List::create(Rcpp::Named("alpha") = states_output(mcmc_run),
     Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
     Rcpp::Named("weights") = mcmc_run.weight_storage,
     Rcpp::Named("counts") = mcmc_run.count_storage,
@@ -804,7 +1076,8 @@ Rcpp::List general_gaussian_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   const unsigned int seed, const unsigned int n_iter,
   const unsigned int n_burnin, const unsigned int n_thin,
   const double gamma, const double target_acceptance, const arma::mat S,
-  const bool end_ram, const unsigned int n_threads, const unsigned int type) {
+  const bool end_ram, const unsigned int n_threads, const unsigned int type,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval) {
   
   Rcpp::XPtr<lmat_fnPtr> xpfun_Z(Z);
   Rcpp::XPtr<lmat_fnPtr> xpfun_H(H);
@@ -822,12 +1095,13 @@ Rcpp::List general_gaussian_mcmc(const arma::mat& y, SEXP Z, SEXP H,
   
   mcmc mcmc_run(n_iter, n_burnin, n_thin,
     model.n, model.m, target_acceptance, gamma, S, type);
+  mcmc_run.set_checkpoint(checkpoint_file, checkpoint_interval, seed);
   
   mcmc_run.mcmc_gaussian(model, end_ram);
   if(type == 1) mcmc_run.state_posterior(model, n_threads);
   
   if(type == 1) {
-    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+    return Rcpp::List::create(Rcpp::Named("alpha") = states_output(mcmc_run),
       Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
       Rcpp::Named("counts") = mcmc_run.count_storage,
       Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
@@ -0,0 +1,131 @@
+#include "msde_ssm.h"
+#include "R_sde.h"
+
+// model object from the external pointers of the model functions, the 
+// Euler-Maruyama scheme is used if the derivatives of the diffusion are not given
+msde_ssm msde_model(const arma::mat& y, const arma::vec& x0, 
+  SEXP drift_pntr, SEXP diffusion_pntr, 
+  SEXP ddiffusion_pntr, SEXP log_prior_pdf_pntr, SEXP log_obs_density_pntr,
+  const arma::vec& theta, const unsigned int seed,
+  SEXP drift_batch_pntr, SEXP diffusion_batch_pntr) {
+  
+  Rcpp::XPtr<mdrift_fnPtr> xpfun_drift(drift_pntr);
+  Rcpp::XPtr<mdiffusion_fnPtr> xpfun_diffusion(diffusion_pntr);
+  Rcpp::XPtr<mprior_fnPtr> xpfun_prior(log_prior_pdf_pntr);
+  Rcpp::XPtr<mobs_fnPtr> xpfun_obs(log_obs_density_pntr);
+  mddiffusion_fnPtr ddiffusion = nullptr;
+  if (!Rf_isNull(ddiffusion_pntr)) {
+    Rcpp::XPtr<mddiffusion_fnPtr> xpfun_ddiffusion(ddiffusion_pntr);
+    ddiffusion = *xpfun_ddiffusion;
+  }
+  
+  msde_ssm model(y, theta, x0, seed, *xpfun_drift,
+    *xpfun_diffusion, ddiffusion, *xpfun_prior, *xpfun_obs);
+  model.set_batch_fns(drift_batch_pntr, diffusion_batch_pntr);
+  return model;
+}
+
+// [[Rcpp::export]]
+double loglik_msde(const arma::mat& y, const arma::vec& x0, 
+  SEXP drift_pntr, SEXP diffusion_pntr, 
+  SEXP ddiffusion_pntr, SEXP log_prior_pdf_pntr, SEXP log_obs_density_pntr,
+  const arma::vec& theta, const unsigned int nsim_states, 
+  const unsigned int L, const unsigned int seed,
+  SEXP drift_batch_pntr, SEXP diffusion_batch_pntr) {
+  
+  msde_ssm model = msde_model(y, x0, drift_pntr, diffusion_pntr, 
+    ddiffusion_pntr, log_prior_pdf_pntr, log_obs_density_pntr, theta, seed,
+    drift_batch_pntr, diffusion_batch_pntr);
+  return sde_loglik(model, nsim_states, L);
+}
+
+// [[Rcpp::export]]
+Rcpp::List bsf_msde(const arma::mat& y, const arma::vec& x0, 
+  SEXP drift_pntr, SEXP diffusion_pntr, 
+  SEXP ddiffusion_pntr, SEXP log_prior_pdf_pntr, SEXP log_obs_density_pntr,
+  const arma::vec& theta, const unsigned int nsim_states, 
+  const unsigned int L, const unsigned int seed,
+  SEXP drift_batch_pntr, SEXP diffusion_batch_pntr) {
+  
+  msde_ssm model = msde_model(y, x0, drift_pntr, diffusion_pntr, 
+    ddiffusion_pntr, log_prior_pdf_pntr, log_obs_density_pntr, theta, seed,
+    drift_batch_pntr, diffusion_batch_pntr);
+  return sde_bsf(model, nsim_states, L);
+}
+
+// [[Rcpp::export]]
+Rcpp::List bsf_smoother_msde(const arma::mat& y, const arma::vec& x0, 
+  SEXP drift_pntr, SEXP diffusion_pntr, 
+  SEXP ddiffusion_pntr, SEXP log_prior_pdf_pntr, SEXP log_obs_density_pntr,
+  const arma::vec& theta, const unsigned int nsim_states, 
+  const unsigned int L, const unsigned int seed,
+  SEXP drift_batch_pntr, SEXP diffusion_batch_pntr) {
+  
+  msde_ssm model = msde_model(y, x0, drift_pntr, diffusion_pntr, 
+    ddiffusion_pntr, log_prior_pdf_pntr, log_obs_density_pntr, theta, seed,
+    drift_batch_pntr, diffusion_batch_pntr);
+  return sde_bsf_smoother(model, nsim_states, L);
+}
+
+// [[Rcpp::export]]
+Rcpp::List msde_pm_mcmc(const arma::mat& y, const arma::vec& x0, 
+  SEXP drift_pntr, SEXP diffusion_pntr, 
+  SEXP ddiffusion_pntr, SEXP log_prior_pdf_pntr, SEXP log_obs_density_pntr,
+  const arma::vec& theta, const unsigned int nsim_states, 
+  const unsigned int L, 
+  const unsigned int seed, const unsigned int n_iter, 
+  const unsigned int n_burnin, const unsigned int n_thin,
+  const double gamma, const double target_acceptance, const arma::mat S,
+  const bool end_ram, const unsigned int type,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval,
+  SEXP drift_batch_pntr, SEXP diffusion_batch_pntr) {
+  
+  msde_ssm model = msde_model(y, x0, drift_pntr, diffusion_pntr, 
+    ddiffusion_pntr, log_prior_pdf_pntr, log_obs_density_pntr, theta, seed,
+    drift_batch_pntr, diffusion_batch_pntr);
+  return sde_pm_mcmc_run(model, nsim_states, L, seed, n_iter, n_burnin, n_thin,
+    gamma, target_acceptance, S, end_ram, type, checkpoint_file, checkpoint_interval);
+}
+
+// [[Rcpp::export]]
+Rcpp::List msde_da_mcmc(const arma::mat& y, const arma::vec& x0, 
+  SEXP drift_pntr, SEXP diffusion_pntr, 
+  SEXP ddiffusion_pntr, SEXP log_prior_pdf_pntr, SEXP log_obs_density_pntr,
+  const arma::vec& theta, const unsigned int nsim_states, 
+  const unsigned int L_c, const unsigned int L_f, const unsigned int seed, 
+  const unsigned int n_iter, 
+  const unsigned int n_burnin, const unsigned int n_thin,
+  const double gamma, const double target_acceptance, const arma::mat S,
+  const bool end_ram, const unsigned int type,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval,
+  SEXP drift_batch_pntr, SEXP diffusion_batch_pntr) {
+  
+  msde_ssm model = msde_model(y, x0, drift_pntr, diffusion_pntr, 
+    ddiffusion_pntr, log_prior_pdf_pntr, log_obs_density_pntr, theta, seed,
+    drift_batch_pntr, diffusion_batch_pntr);
+  return sde_da_mcmc_run(model, nsim_states, L_c, L_f, seed, n_iter, n_burnin, 
+    n_thin, gamma, target_acceptance, S, end_ram, type, checkpoint_file, 
+    checkpoint_interval);
+}
+
+// [[Rcpp::export]]
+Rcpp::List msde_is_mcmc(const arma::mat& y, const arma::vec& x0, 
+  SEXP drift_pntr, SEXP diffusion_pntr, 
+  SEXP ddiffusion_pntr, SEXP log_prior_pdf_pntr, SEXP log_obs_density_pntr,
+  const arma::vec& theta, const unsigned int nsim_states, 
+  const unsigned int L_c, const unsigned int L_f, const unsigned int seed, 
+  const unsigned int n_iter, 
+  const unsigned int n_burnin, const unsigned int n_thin,
+  const double gamma, const double target_acceptance, const arma::mat S,
+  const bool end_ram, const unsigned int is_type, const unsigned int n_threads,
+  const unsigned int type,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval,
+  SEXP drift_batch_pntr, SEXP diffusion_batch_pntr) {
+  
+  msde_ssm model = msde_model(y, x0, drift_pntr, diffusion_pntr, 
+    ddiffusion_pntr, log_prior_pdf_pntr, log_obs_density_pntr, theta, seed,
+    drift_batch_pntr, diffusion_batch_pntr);
+  return sde_is_mcmc_run(model, nsim_states, L_c, L_f, seed, n_iter, n_burnin, 
+    n_thin, gamma, target_acceptance, S, end_ram, is_type, n_threads, type, 
+    checkpoint_file, checkpoint_interval);
+}
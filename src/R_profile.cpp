@@ -0,0 +1,11 @@
+#include "profiler.h"
+
+// [[Rcpp::export]]
+void profile_reset(const bool enable) {
+  profiler::reset(enable);
+}
+
+// [[Rcpp::export]]
+Rcpp::List profile_results() {
+  return profiler::results();
+}
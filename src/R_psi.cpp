@@ -9,12 +9,13 @@
 #include "filter_smoother.h"
 #include "ng_psi_filter.h"
 #include "summary.h"
+#include "packed_states.h"
 
 // [[Rcpp::export]]
 Rcpp::List psi_smoother(const Rcpp::List& model_, const arma::vec mode_estimate,
   const unsigned int nsim_states, const unsigned int seed, 
   const unsigned int max_iter, const double conv_tol,
-  const int model_type) {
+  const int model_type, const unsigned int precision) {
   
   switch (model_type) {
   case 1: {
@@ -37,7 +38,7 @@ Rcpp::List psi_smoother(const Rcpp::List& model_, const arma::vec mode_estimate,
   return Rcpp::List::create(
     Rcpp::Named("alphahat") = alphahat, Rcpp::Named("Vt") = Vt, 
     Rcpp::Named("weights") = weights,
-    Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
+    Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = pack_states(alpha, precision));
 } break;
   case 2: {
     ung_bsm model(clone(model_), seed);
@@ -58,7 +59,7 @@ Rcpp::List psi_smoother(const Rcpp::List& model_, const arma::vec mode_estimate,
     return Rcpp::List::create(
       Rcpp::Named("alphahat") = alphahat, Rcpp::Named("Vt") = Vt, 
       Rcpp::Named("weights") = weights,
-      Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
+      Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = pack_states(alpha, precision));
   } break;
   case 3: {
     ung_svm model(clone(model_), seed);
@@ -79,7 +80,7 @@ Rcpp::List psi_smoother(const Rcpp::List& model_, const arma::vec mode_estimate,
     return Rcpp::List::create(
       Rcpp::Named("alphahat") = alphahat, Rcpp::Named("Vt") = Vt, 
       Rcpp::Named("weights") = weights,
-      Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
+      Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = pack_states(alpha, precision));
   } break;
   case 4: {
     ung_ar1 model(clone(model_), seed);
@@ -100,7 +101,7 @@ Rcpp::List psi_smoother(const Rcpp::List& model_, const arma::vec mode_estimate,
     return Rcpp::List::create(
       Rcpp::Named("alphahat") = alphahat, Rcpp::Named("Vt") = Vt, 
       Rcpp::Named("weights") = weights,
-      Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
+      Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = pack_states(alpha, precision));
   } break;
   }
   return Rcpp::List::create(Rcpp::Named("error") = 0);
@@ -113,7 +114,8 @@ Rcpp::List psi_smoother_nlg(const arma::mat& y, SEXP Z, SEXP H,
   const unsigned int n_etas,  const arma::uvec& time_varying,
   const unsigned int nsim_states, 
   const unsigned int seed, const unsigned int max_iter, 
-  const double conv_tol, const unsigned int iekf_iter) {
+  const double conv_tol, const unsigned int iekf_iter,
+  SEXP T_batch, SEXP Z_batch) {
   
   
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
@@ -129,6 +131,7 @@ Rcpp::List psi_smoother_nlg(const arma::mat& y, SEXP Z, SEXP H,
   nlg_ssm model(y, *xpfun_Z, *xpfun_H, *xpfun_T, *xpfun_R, *xpfun_Zg, *xpfun_Tg, 
     *xpfun_a1, *xpfun_P1,  theta, *xpfun_prior, known_params, known_tv_params, n_states, n_etas,
     time_varying, seed);
+  model.set_batch_fns(T_batch, Z_batch);
   
   unsigned int m = model.m;
   unsigned n = model.n;
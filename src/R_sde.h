@@ -0,0 +1,169 @@
+// the filters and samplers called from R, shared by sde_ssm and msde_ssm models
+
+#ifndef R_SDE_H
+#define R_SDE_H
+
+#include "bssm.h"
+#include "filter_smoother.h"
+#include "summary.h"
+#include "mcmc.h"
+#include "sde_amcmc.h"
+
+template <class T>
+double sde_loglik(T& model, const unsigned int nsim_states, const unsigned int L) {
+  
+  unsigned int n = model.n;
+  arma::cube alpha(model.m, n + 1, nsim_states);
+  arma::mat weights(nsim_states, n + 1);
+  arma::umat indices(nsim_states, n);
+  return model.bsf_filter(nsim_states, L, alpha, weights, indices);
+}
+
+template <class T>
+Rcpp::List sde_bsf(T& model, const unsigned int nsim_states, const unsigned int L) {
+  
+  unsigned int n = model.n;
+  arma::cube alpha(model.m, n + 1, nsim_states);
+  arma::mat weights(nsim_states, n + 1);
+  arma::umat indices(nsim_states, n);
+  double loglik = model.bsf_filter(nsim_states, L, alpha, weights, indices);
+  
+  arma::mat at(model.m, n + 1);
+  arma::mat att(model.m, n + 1);
+  arma::cube Pt(model.m, model.m, n + 1);
+  arma::cube Ptt(model.m, model.m, n + 1);
+  filter_summary(alpha, at, att, Pt, Ptt, weights);
+  
+  arma::inplace_trans(at);
+  arma::inplace_trans(att);
+  return Rcpp::List::create(
+    Rcpp::Named("at") = at, Rcpp::Named("att") = att,
+    Rcpp::Named("Pt") = Pt, Rcpp::Named("Ptt") = Ptt,
+    Rcpp::Named("weights") = weights,
+    Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
+}
+
+template <class T>
+Rcpp::List sde_bsf_smoother(T& model, const unsigned int nsim_states,
+  const unsigned int L) {
+  
+  unsigned int n = model.n;
+  arma::cube alpha(model.m, n + 1, nsim_states);
+  arma::mat weights(nsim_states, n + 1);
+  arma::umat indices(nsim_states, n);
+  double loglik = model.bsf_filter(nsim_states, L, alpha, weights, indices);
+  
+  arma::mat alphahat(model.m, n + 1);
+  arma::cube Vt(model.m, model.m, n + 1);
+  
+  filter_smoother(alpha, indices);
+  weighted_summary(alpha, alphahat, Vt, weights.col(n));
+  
+  arma::inplace_trans(alphahat);
+  
+  return Rcpp::List::create(
+    Rcpp::Named("alphahat") = alphahat, Rcpp::Named("Vt") = Vt,
+    Rcpp::Named("weights") = weights,
+    Rcpp::Named("logLik") = loglik, Rcpp::Named("alpha") = alpha);
+}
+
+// output of the PM and DA samplers, type is 1 (full), 2 (summary) or 3 (theta)
+inline Rcpp::List sde_mcmc_output(const mcmc& mcmc_run, const unsigned int type) {
+  
+  switch (type) {
+  case 1: {
+    return Rcpp::List::create(Rcpp::Named("alpha") = mcmc_run.alpha_storage,
+      Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      Rcpp::Named("counts") = mcmc_run.count_storage,
+      Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+  } break;
+  case 2: {
+    return Rcpp::List::create(
+      Rcpp::Named("alphahat") = mcmc_run.alphahat.t(), Rcpp::Named("Vt") = mcmc_run.Vt,
+      Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      Rcpp::Named("counts") = mcmc_run.count_storage,
+      Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+  } break;
+  case 3: {
+    return Rcpp::List::create(
+      Rcpp::Named("theta") = mcmc_run.theta_storage.t(),
+      Rcpp::Named("counts") = mcmc_run.count_storage,
+      Rcpp::Named("acceptance_rate") = mcmc_run.acceptance_rate,
+      Rcpp::Named("S") = mcmc_run.S,  Rcpp::Named("posterior") = mcmc_run.posterior_storage);
+  } break;
+  }
+  
+  return Rcpp::List::create(Rcpp::Named("error") = "error");
+}
+
+// output of the IS samplers, with the IS weights
+inline Rcpp::List sde_mcmc_output(const sde_amcmc& mcmc_run, const unsigned int type) {
+  
+  Rcpp::List out = sde_mcmc_output(static_cast<const mcmc&>(mcmc_run), type);
+  if (type >= 1 && type <= 3) {
+    out.push_back(Rcpp::wrap(mcmc_run.weight_storage), "weights");
+  }
+  return out;
+}
+
+template <class T>
+Rcpp::List sde_pm_mcmc_run(T& model, const unsigned int nsim_states,
+  const unsigned int L, const unsigned int seed, const unsigned int n_iter,
+  const unsigned int n_burnin, const unsigned int n_thin,
+  const double gamma, const double target_acceptance, const arma::mat& S,
+  const bool end_ram, const unsigned int type,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval) {
+  
+  mcmc mcmc_run(n_iter, n_burnin,
+    n_thin, model.n, model.m, target_acceptance, gamma, S, type);
+  mcmc_run.set_checkpoint(checkpoint_file, checkpoint_interval, seed);
+  
+  mcmc_run.pm_mcmc_bsf_sde(model, end_ram, nsim_states, L);
+  
+  return sde_mcmc_output(mcmc_run, type);
+}
+
+template <class T>
+Rcpp::List sde_da_mcmc_run(T& model, const unsigned int nsim_states,
+  const unsigned int L_c, const unsigned int L_f, const unsigned int seed,
+  const unsigned int n_iter, const unsigned int n_burnin, const unsigned int n_thin,
+  const double gamma, const double target_acceptance, const arma::mat& S,
+  const bool end_ram, const unsigned int type,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval) {
+  
+  mcmc mcmc_run(n_iter, n_burnin,
+    n_thin, model.n, model.m, target_acceptance, gamma, S, type);
+  mcmc_run.set_checkpoint(checkpoint_file, checkpoint_interval, seed);
+  
+  mcmc_run.da_mcmc_bsf_sde(model, end_ram, nsim_states, L_c, L_f);
+  
+  return sde_mcmc_output(mcmc_run, type);
+}
+
+template <class T>
+Rcpp::List sde_is_mcmc_run(T& model, const unsigned int nsim_states,
+  const unsigned int L_c, const unsigned int L_f, const unsigned int seed,
+  const unsigned int n_iter, const unsigned int n_burnin, const unsigned int n_thin,
+  const double gamma, const double target_acceptance, const arma::mat& S,
+  const bool end_ram, const unsigned int is_type, const unsigned int n_threads,
+  const unsigned int type,
+  const std::string& checkpoint_file, const unsigned int checkpoint_interval) {
+  
+  sde_amcmc mcmc_run(n_iter, n_burnin, n_thin, model.n, model.m,
+    target_acceptance, gamma, S, type);
+  mcmc_run.set_checkpoint(checkpoint_file, checkpoint_interval, seed);
+  
+  mcmc_run.approx_mcmc(model, end_ram, nsim_states, L_c);
+  
+  if(is_type == 3) {
+    mcmc_run.expand();
+  }
+  
+  mcmc_run.is_correction_bsf(model, nsim_states, L_c, L_f, is_type, n_threads);
+  
+  return sde_mcmc_output(mcmc_run, type);
+}
+
+#endif
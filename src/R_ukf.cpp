@@ -7,7 +7,7 @@ Rcpp::List ukf_nlg(const arma::mat& y, SEXP Z, SEXP H,
   const arma::mat& known_tv_params, const unsigned int n_states, 
   const unsigned int n_etas,  const arma::uvec& time_varying, 
   const double alpha, const double beta, 
-  const double kappa) {
+  const double kappa, const bool square_root) {
   
   Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
   Rcpp::XPtr<nmat_fnPtr> xpfun_H(H);
@@ -28,7 +28,7 @@ Rcpp::List ukf_nlg(const arma::mat& y, SEXP Z, SEXP H,
   arma::cube Pt(model.m, model.m, model.n + 1);
   arma::cube Ptt(model.m, model.m, model.n);
   
-  double logLik = model.ukf(at, att, Pt, Ptt, alpha, beta, kappa);
+  double logLik = model.ukf(at, att, Pt, Ptt, alpha, beta, kappa, square_root);
   
   arma::inplace_trans(at);
   arma::inplace_trans(att);
@@ -40,3 +40,39 @@ Rcpp::List ukf_nlg(const arma::mat& y, SEXP Z, SEXP H,
     Rcpp::Named("Ptt") = Ptt,
     Rcpp::Named("logLik") = logLik);
 }
+
+// [[Rcpp::export]]
+Rcpp::List ukf_smoother_nlg(const arma::mat& y, SEXP Z, SEXP H, 
+  SEXP T, SEXP R, SEXP Zg, SEXP Tg, SEXP a1, SEXP P1, 
+  const arma::vec& theta, SEXP log_prior_pdf, const arma::vec& known_params, 
+  const arma::mat& known_tv_params, const unsigned int n_states, 
+  const unsigned int n_etas,  const arma::uvec& time_varying, 
+  const double alpha, const double beta, 
+  const double kappa, const bool square_root) {
+  
+  Rcpp::XPtr<nvec_fnPtr> xpfun_Z(Z);
+  Rcpp::XPtr<nmat_fnPtr> xpfun_H(H);
+  Rcpp::XPtr<nvec_fnPtr> xpfun_T(T);
+  Rcpp::XPtr<nmat_fnPtr> xpfun_R(R);
+  Rcpp::XPtr<nmat_fnPtr> xpfun_Zg(Zg);
+  Rcpp::XPtr<nmat_fnPtr> xpfun_Tg(Tg);
+  Rcpp::XPtr<a1_fnPtr> xpfun_a1(a1);
+  Rcpp::XPtr<P1_fnPtr> xpfun_P1(P1);
+  Rcpp::XPtr<prior_fnPtr> xpfun_prior(log_prior_pdf);
+  
+  nlg_ssm model(y, *xpfun_Z, *xpfun_H, *xpfun_T, *xpfun_R, *xpfun_Zg, *xpfun_Tg, 
+    *xpfun_a1, *xpfun_P1,  theta, *xpfun_prior, known_params, known_tv_params, n_states, n_etas,
+    time_varying, 1);
+  
+  arma::mat alphahat(model.m, model.n);
+  arma::cube Vt(model.m, model.m, model.n);
+  
+  double logLik = model.ukf_smoother(alphahat, Vt, alpha, beta, kappa, square_root);
+  
+  arma::inplace_trans(alphahat);
+  
+  return Rcpp::List::create(
+    Rcpp::Named("alphahat") = alphahat,
+    Rcpp::Named("Vt") = Vt,
+    Rcpp::Named("logLik") = logLik);
+}
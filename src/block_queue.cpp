@@ -0,0 +1,38 @@
+#include "block_queue.h"
+
+block_queue::block_queue(const unsigned int capacity) : 
+  capacity(capacity), closed(false) {
+}
+
+bool block_queue::push(const unsigned int index) {
+  std::unique_lock<std::mutex> lock(mtx);
+  not_full.wait(lock, [this]{ return indices.size() < capacity || closed; });
+  if (closed) {
+    return false;
+  }
+  indices.push_back(index);
+  lock.unlock();
+  not_empty.notify_one();
+  return true;
+}
+
+bool block_queue::pop(unsigned int& index) {
+  std::unique_lock<std::mutex> lock(mtx);
+  not_empty.wait(lock, [this]{ return !indices.empty() || closed; });
+  if (indices.empty()) {
+    return false;
+  }
+  index = indices.front();
+  indices.pop_front();
+  lock.unlock();
+  not_full.notify_one();
+  return true;
+}
+
+void block_queue::close() {
+  std::unique_lock<std::mutex> lock(mtx);
+  closed = true;
+  lock.unlock();
+  not_empty.notify_all();
+  not_full.notify_all();
+}
@@ -0,0 +1,35 @@
+// bounded FIFO queue of storage indices used for passing closed jump chain 
+// blocks from the MCMC thread to the threads performing the IS-correction
+
+#ifndef BLOCK_QUEUE_H
+#define BLOCK_QUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+class block_queue {
+  
+public:
+  
+  block_queue(const unsigned int capacity);
+  
+  // add index of a closed block, waits while the queue is full, returns false
+  // (without adding the index) if the queue has been closed
+  bool push(const unsigned int index);
+  // get the next index, returns false if the queue is closed and empty
+  bool pop(unsigned int& index);
+  // no more blocks will be added
+  void close();
+  
+private:
+  
+  const unsigned int capacity;
+  bool closed;
+  std::deque<unsigned int> indices;
+  std::mutex mtx;
+  std::condition_variable not_empty;
+  std::condition_variable not_full;
+};
+
+#endif
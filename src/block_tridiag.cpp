@@ -0,0 +1,48 @@
+#include "block_tridiag.h"
+
+bool block_tridiag_solve(const arma::cube& A, const arma::cube& B, 
+  const arma::mat& b, arma::mat& x) {
+  
+  unsigned int m = A.n_rows;
+  unsigned int n = A.n_slices;
+  
+  // A = LL' where L has lower triangular diagonal blocks L.slice(t) and 
+  // subdiagonal blocks M.slice(t) = L[t + 1, t]
+  arma::cube L(m, m, n);
+  arma::cube M(m, m, n);
+  arma::mat z(m, n);
+  if (!arma::chol(L.slice(0), A.slice(0), "lower")) {
+    return false;
+  }
+  z.col(0) = arma::solve(arma::trimatl(L.slice(0)), b.col(0));
+  for (unsigned int t = 1; t < n; t++) {
+    M.slice(t - 1) = arma::solve(arma::trimatl(L.slice(t - 1)), 
+      B.slice(t - 1).t()).t();
+    arma::mat S = A.slice(t) - M.slice(t - 1) * M.slice(t - 1).t();
+    if (!arma::chol(L.slice(t), arma::symmatu(S), "lower")) {
+      return false;
+    }
+    z.col(t) = arma::solve(arma::trimatl(L.slice(t)), 
+      b.col(t) - M.slice(t - 1) * z.col(t - 1));
+  }
+  x.set_size(m, n);
+  x.col(n - 1) = arma::solve(arma::trimatu(L.slice(n - 1).t()), z.col(n - 1));
+  for (int t = n - 2; t >= 0; t--) {
+    x.col(t) = arma::solve(arma::trimatu(L.slice(t).t()), 
+      z.col(t) - M.slice(t).t() * x.col(t + 1));
+  }
+  return true;
+}
+
+double block_tridiag_quad(const arma::cube& A, const arma::cube& B, 
+  const arma::mat& x) {
+  
+  double q = 0.0;
+  for (unsigned int t = 0; t < A.n_slices; t++) {
+    q += arma::as_scalar(x.col(t).t() * A.slice(t) * x.col(t));
+  }
+  for (unsigned int t = 0; t + 1 < A.n_slices; t++) {
+    q += 2.0 * arma::as_scalar(x.col(t + 1).t() * B.slice(t) * x.col(t));
+  }
+  return q;
+}
@@ -0,0 +1,17 @@
+#ifndef BLOCK_TRIDIAG_H
+#define BLOCK_TRIDIAG_H
+
+#include "bssm.h"
+
+// symmetric block tridiagonal matrices with m x m diagonal blocks A.slice(t), 
+// t = 0, ..., n - 1, and subdiagonal blocks B.slice(t) = A[t + 1, t]
+
+// solve A x = b for x (m x n) using the block Cholesky decomposition in 
+// O(n m^3) operations, returns false if A is not positive definite
+bool block_tridiag_solve(const arma::cube& A, const arma::cube& B, 
+  const arma::mat& b, arma::mat& x);
+// quadratic form x' A x
+double block_tridiag_quad(const arma::cube& A, const arma::cube& B, 
+  const arma::mat& x);
+
+#endif
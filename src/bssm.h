@@ -1,9 +1,77 @@
 #ifndef BSSM_H
 #define BSSM_H
 
+// the numerical core can be compiled without R by defining BSSM_STANDALONE,
+// in which case only Armadillo (and sitmo) are needed, the conversions from
+// and to R objects are left out, and errors are thrown as std::runtime_error
+
+#ifdef BSSM_STANDALONE
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <armadillo>
+
+#else
+
 //#define ARMA_NO_DEBUG
 #include <RcppArmadillo.h>
 // [[Rcpp::depends(RcppArmadillo)]]
 // [[Rcpp::plugins(cpp11)]]
 
 #endif
+
+namespace bssm {
+
+#ifdef BSSM_STANDALONE
+
+// replace the printf style conversions of fmt (%s, %d etc.) with the arguments
+inline void format(std::ostringstream& out, const char* fmt) {
+  for (; *fmt != '\0'; fmt++) {
+    out << *fmt;
+    if (fmt[0] == '%' && fmt[1] == '%') fmt++;
+  }
+}
+template <class T, class... Args>
+void format(std::ostringstream& out, const char* fmt, const T& x,
+  const Args&... args) {
+  for (; *fmt != '\0'; fmt++) {
+    if (fmt[0] == '%' && fmt[1] == '%') {
+      out << '%';
+      fmt++;
+    } else if (fmt[0] == '%' && fmt[1] != '\0') {
+      out << x;
+      format(out, fmt + 2, args...);
+      return;
+    } else {
+      out << *fmt;
+    }
+  }
+}
+
+template <class... Args>
+[[noreturn]] void stop(const char* fmt, const Args&... args) {
+  std::ostringstream out;
+  format(out, fmt, args...);
+  throw std::runtime_error(out.str());
+}
+
+inline void check_interrupt() {}
+
+#else
+
+// R errors and user interrupts, only to be called from the main thread
+template <class... Args>
+[[noreturn]] void stop(const char* fmt, const Args&... args) {
+  Rcpp::stop(fmt, args...);
+}
+
+inline void check_interrupt() {
+  Rcpp::checkUserInterrupt();
+}
+
+#endif
+
+}
+
+#endif
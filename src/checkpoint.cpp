@@ -0,0 +1,159 @@
+#include <cstdio>
+#include <cstring>
+#include "checkpoint.h"
+#include "packed_states.h"
+#include "quantile_sketch.h"
+
+namespace {
+const char magic[9] = "BSSMCKPT";
+const unsigned int version = 1;
+}
+
+checkpoint::checkpoint(const std::string& file_name, const unsigned int interval) :
+  interval(interval), file_name(file_name), reading(false) {
+}
+
+bool checkpoint::open_read(const std::string& tag, const arma::uvec& info) {
+
+  file.open(file_name.c_str(), std::ios::in | std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  reading = true;
+  char file_magic[8];
+  file.read(file_magic, 8);
+  unsigned int file_version = 0;
+  if (file) io(file_version);
+  if (!file || std::memcmp(file_magic, magic, 8) != 0 || file_version != version) {
+    file.close();
+    bssm::stop("File '%s' is not a checkpoint file of 'run_mcmc'.", file_name);
+  }
+  std::string file_tag;
+  arma::uvec file_info;
+  io(file_tag);
+  io(file_info);
+  if (file_tag != tag || file_info.n_elem != info.n_elem ||
+    arma::any(file_info != info)) {
+    file.close();
+    bssm::stop("Checkpoint '%s' was created with a different model, algorithm or settings.",
+      file_name);
+  }
+  return true;
+}
+
+void checkpoint::open_write(const std::string& tag, const arma::uvec& info) {
+
+  std::string tmp_name = file_name + ".tmp";
+  file.open(tmp_name.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    bssm::stop("Could not open the checkpoint file '%s'.", tmp_name);
+  }
+  reading = false;
+  file.write(magic, 8);
+  unsigned int file_version = version;
+  io(file_version);
+  std::string file_tag = tag;
+  arma::uvec file_info = info;
+  io(file_tag);
+  io(file_info);
+}
+
+void checkpoint::close() {
+  if (!file) {
+    file.close();
+    bssm::stop(reading ? "Reading the checkpoint '%s' failed." :
+      "Writing the checkpoint '%s' failed.", file_name);
+  }
+  file.close();
+  if (!reading) {
+    // replace the previous checkpoint only once the new one is complete
+    std::string tmp_name = file_name + ".tmp";
+    std::remove(file_name.c_str());
+    if (std::rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+      bssm::stop("Could not rename the checkpoint file '%s'.", tmp_name);
+    }
+  }
+}
+
+void checkpoint::bytes(void* x, const size_t n) {
+  if (n == 0) return;
+  if (reading) {
+    file.read(static_cast<char*>(x), n);
+  } else {
+    file.write(static_cast<const char*>(x), n);
+  }
+}
+
+void checkpoint::check_size(const unsigned int n, const unsigned int max_n) {
+  if (n > max_n) {
+    file.close();
+    bssm::stop("Checkpoint '%s' does not match the storage of the samples.", file_name);
+  }
+}
+
+void checkpoint::io(double& x) {
+  bytes(&x, sizeof(double));
+}
+
+void checkpoint::io(unsigned int& x) {
+  bytes(&x, sizeof(unsigned int));
+}
+
+void checkpoint::io(bool& x) {
+  unsigned char value = x;
+  bytes(&value, 1);
+  x = value;
+}
+
+void checkpoint::io(std::string& x) {
+  unsigned int n = x.size();
+  io(n);
+  if (reading) x.resize(n);
+  bytes(&x[0], n);
+}
+
+// the engine consists of plain integer arrays and counters
+void checkpoint::io(sitmo::prng_engine& x) {
+  bytes(&x, sizeof(sitmo::prng_engine));
+}
+
+void checkpoint::io(quantile_sketch& x) {
+  io(x.n_buffered);
+  io(x.buffer);
+  io(x.buffer_weights);
+  io(x.centroid_means);
+  io(x.centroid_weights);
+  io(x.n_centroids);
+  io(x.min_x);
+  io(x.max_x);
+  io(x.sum_x);
+  io(x.total_weight);
+}
+
+void checkpoint::sync_cols(arma::mat& x, const unsigned int n) {
+  unsigned int n_cols = n;
+  io(n_cols);
+  check_size(n_cols, x.n_cols);
+  bytes(x.memptr(), static_cast<size_t>(x.n_rows) * n_cols * sizeof(double));
+}
+
+void checkpoint::sync_slices(arma::cube& x, const unsigned int n) {
+  unsigned int n_slices = n;
+  io(n_slices);
+  check_size(n_slices, x.n_slices);
+  bytes(x.memptr(), static_cast<size_t>(x.n_elem_slice) * n_slices * sizeof(double));
+}
+
+void checkpoint::sync_slices(packed_states& x, const unsigned int n) {
+  unsigned int n_slices = n;
+  io(n_slices);
+  check_size(n_slices, x.n_slices);
+  size_t size = static_cast<size_t>(x.n_rows) * x.n_cols * x.bytes;
+  if (n_slices > 0) {
+    bytes(&x.data[0], size * n_slices);
+  }
+  if (x.precision > 2) {
+    sync_cols(x.offset, n_slices);
+    sync_cols(x.scale, n_slices);
+  }
+}
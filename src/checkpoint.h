@@ -0,0 +1,169 @@
+// binary checkpoints of the MCMC samplers, so that an interrupted run can be
+// resumed and continued exactly as the uninterrupted run
+//
+// a checkpoint consists of a header (magic "BSSMCKPT", name of the algorithm and
+// the dimensions and settings of the run), the adapted S, the samples (or the
+// quantile sketches) stored so far, and the state of the sampling loop
+// (current theta, log-likelihood estimates, approximations and the states of
+// the random number engine and distributions). The same sync calls are used
+// for writing and reading. A new checkpoint is first written to a temporary
+// file which then replaces the previous checkpoint, so the checkpoint stays
+// usable even if the run is interrupted while writing. The files are not
+// portable between platforms.
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sitmo.h>
+#include "bssm.h"
+#include "mcmc.h"
+
+class packed_states;
+class quantile_sketch;
+
+class checkpoint {
+
+public:
+
+  checkpoint(const std::string& file_name, const unsigned int interval);
+
+  // open the previous checkpoint for reading, returns false if it does not exist
+  bool open_read(const std::string& tag, const arma::uvec& info);
+  void open_write(const std::string& tag, const arma::uvec& info);
+  void close();
+
+  // write or read the values depending on the mode of the checkpoint
+  void sync() {}
+  template <class T, class... Args>
+  void sync(T& x, Args&... args) {
+    io(x);
+    sync(args...);
+  }
+  // write or read only the first n elements, columns or slices of the storage,
+  // which has its final size already when reading
+  template <class eT>
+  void sync_head(arma::Col<eT>& x, const unsigned int n);
+  void sync_cols(arma::mat& x, const unsigned int n);
+  void sync_slices(arma::cube& x, const unsigned int n);
+  void sync_slices(packed_states& x, const unsigned int n);
+
+  // number of iterations between the checkpoints
+  const unsigned int interval;
+
+private:
+
+  void io(double& x);
+  void io(unsigned int& x);
+  void io(bool& x);
+  void io(std::string& x);
+  void io(sitmo::prng_engine& x);
+  void io(quantile_sketch& x);
+  template <class eT>
+  void io(arma::Col<eT>& x);
+  template <class eT>
+  void io(arma::Mat<eT>& x);
+  template <class eT>
+  void io(arma::Cube<eT>& x);
+  // random number distributions are stored using their stream operators
+  template <class T>
+  void io(T& x);
+
+  void bytes(void* x, const size_t n);
+  void check_size(const unsigned int n, const unsigned int max_n);
+
+  const std::string file_name;
+  std::fstream file;
+  bool reading;
+};
+
+template <class eT>
+void checkpoint::sync_head(arma::Col<eT>& x, const unsigned int n) {
+  unsigned int n_elem = n;
+  io(n_elem);
+  check_size(n_elem, x.n_elem);
+  bytes(x.memptr(), static_cast<size_t>(n_elem) * sizeof(eT));
+}
+
+template <class eT>
+void checkpoint::io(arma::Col<eT>& x) {
+  unsigned int n = x.n_elem;
+  io(n);
+  if (reading) x.set_size(n);
+  bytes(x.memptr(), static_cast<size_t>(n) * sizeof(eT));
+}
+
+template <class eT>
+void checkpoint::io(arma::Mat<eT>& x) {
+  unsigned int n_rows = x.n_rows;
+  unsigned int n_cols = x.n_cols;
+  io(n_rows);
+  io(n_cols);
+  if (reading) x.set_size(n_rows, n_cols);
+  bytes(x.memptr(), static_cast<size_t>(x.n_elem) * sizeof(eT));
+}
+
+template <class eT>
+void checkpoint::io(arma::Cube<eT>& x) {
+  unsigned int n_rows = x.n_rows;
+  unsigned int n_cols = x.n_cols;
+  unsigned int n_slices = x.n_slices;
+  io(n_rows);
+  io(n_cols);
+  io(n_slices);
+  if (reading) x.set_size(n_rows, n_cols, n_slices);
+  bytes(x.memptr(), static_cast<size_t>(x.n_elem) * sizeof(eT));
+}
+
+template <class T>
+void checkpoint::io(T& x) {
+  std::string state;
+  if (reading) {
+    unsigned int n;
+    io(n);
+    state.resize(n);
+    bytes(&state[0], n);
+    std::istringstream stream(state);
+    stream >> x;
+  } else {
+    std::ostringstream stream;
+    stream << x;
+    state = stream.str();
+    unsigned int n = state.size();
+    io(n);
+    bytes(&state[0], n);
+  }
+}
+
+// resume the sampling loop from the checkpoint if one exists, returns the
+// first iteration to run
+template <class... Args>
+unsigned int mcmc::resume_checkpoint(const std::string& tag, Args&... state) {
+  if (!ckpt || !ckpt->open_read(tag, checkpoint_info())) {
+    return 1;
+  }
+  unsigned int i;
+  ckpt->sync(i);
+  sync_storage(*ckpt);
+  ckpt->sync(state...);
+  ckpt->close();
+  return i + 1;
+}
+
+// write the checkpoint after every interval iterations and after the last
+// iteration, so that only the remaining steps are repeated after resuming
+template <class... Args>
+void mcmc::save_checkpoint(unsigned int i, const std::string& tag, Args&... state) {
+  if (!ckpt || (i % ckpt->interval != 0 && i != n_iter)) {
+    return;
+  }
+  ckpt->open_write(tag, checkpoint_info());
+  ckpt->sync(i);
+  sync_storage(*ckpt);
+  ckpt->sync(state...);
+  ckpt->close();
+}
+
+#endif
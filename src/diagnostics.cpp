@@ -0,0 +1,169 @@
+#include "diagnostics.h"
+
+#ifdef BSSM_STANDALONE
+namespace {
+// standard normal quantile function, rational approximation of Acklam
+// refined with one step of Halley's method
+double qnorm(const double p) {
+  const double a[6] = {-3.969683028665376e+01, 2.209460984245205e+02,
+    -2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01,
+    2.506628277459239e+00};
+  const double b[5] = {-5.447609879822406e+01, 1.615858368580409e+02,
+    -1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01};
+  const double c[6] = {-7.784894002430293e-03, -3.223964580411365e-01,
+    -2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00,
+    2.938163982698783e+00};
+  const double d[4] = {7.784695709041462e-03, 3.224671290700398e-01,
+    2.445134137142996e+00, 3.754408661907416e+00};
+  
+  double x;
+  if (p < 0.02425) {
+    double q = std::sqrt(-2.0 * std::log(p));
+    x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+      ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+  } else if (p > 1.0 - 0.02425) {
+    double q = std::sqrt(-2.0 * std::log(1.0 - p));
+    x = -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+      ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+  } else {
+    double q = p - 0.5;
+    double r = q * q;
+    x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+      (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+  }
+  double e = 0.5 * std::erfc(-x / std::sqrt(2.0)) - p;
+  double u = e * std::sqrt(2.0 * M_PI) * std::exp(x * x / 2.0);
+  return x - u / (1.0 + x * u / 2.0);
+}
+}
+#endif
+
+// replace draws with normal scores of their pooled (average) ranks
+arma::mat rank_normalize(const arma::mat& draws) {
+  
+  unsigned int n = draws.n_elem;
+  arma::vec x = arma::vectorise(draws);
+  arma::uvec ordering = arma::sort_index(x);
+  arma::vec sorted = x.elem(ordering);
+  arma::vec ranks(n);
+  unsigned int i = 0;
+  while (i < n) {
+    // ties get the average rank
+    unsigned int j = i;
+    while (j + 1 < n && sorted(j + 1) == sorted(i)) {
+      j++;
+    }
+    for (unsigned int k = i; k <= j; k++) {
+      ranks(ordering(k)) = 0.5 * (i + j) + 1.0;
+    }
+    i = j + 1;
+  }
+  arma::mat z(draws.n_rows, draws.n_cols);
+  for (unsigned int k = 0; k < n; k++) {
+#ifdef BSSM_STANDALONE
+    z(k) = qnorm((ranks(k) - 0.375) / (n + 0.25));
+#else
+    z(k) = R::qnorm((ranks(k) - 0.375) / (n + 0.25), 0.0, 1.0, 1, 0);
+#endif
+  }
+  return z;
+}
+
+// split each chain into two halves, middle draw is dropped for odd lengths
+arma::mat split_chains(const arma::mat& draws) {
+  
+  unsigned int half = draws.n_rows / 2;
+  arma::mat split(half, 2 * draws.n_cols);
+  for (unsigned int j = 0; j < draws.n_cols; j++) {
+    split.col(2 * j) = draws.col(j).head(half);
+    split.col(2 * j + 1) = draws.col(j).tail(half);
+  }
+  return split;
+}
+
+// rank-normalized split-R-hat
+double split_rhat(const arma::mat& draws) {
+  
+  if (draws.n_rows < 4 || !draws.is_finite()) {
+    return arma::datum::nan;
+  }
+  arma::mat x = split_chains(rank_normalize(draws));
+  double n = x.n_rows;
+  arma::rowvec chain_mean = arma::mean(x);
+  arma::rowvec chain_var = arma::var(x);
+  double B = n * arma::var(chain_mean);
+  double W = arma::mean(chain_var);
+  double var_hat = (n - 1.0) / n * W + B / n;
+  return std::sqrt(var_hat / W);
+}
+
+// autocovariances of a single chain up to lag n - 1, computed using FFT
+arma::vec autocovariance(const arma::vec& x) {
+  
+  unsigned int n = x.n_elem;
+  unsigned int n_fft = 1;
+  while (n_fft < 2 * n) {
+    n_fft *= 2;
+  }
+  arma::vec x_centered = x - arma::mean(x);
+  arma::cx_vec transform = arma::fft(x_centered, n_fft);
+  arma::vec acov = arma::real(arma::ifft(transform % arma::conj(transform)));
+  return acov.head(n) / n;
+}
+
+// bulk effective sample size using Geyer's initial monotone sequence
+double bulk_ess(const arma::mat& draws) {
+  
+  if (draws.n_rows < 4 || !draws.is_finite()) {
+    return arma::datum::nan;
+  }
+  arma::mat x = split_chains(rank_normalize(draws));
+  unsigned int n = x.n_rows;
+  unsigned int n_chains = x.n_cols;
+  
+  arma::mat acov(n, n_chains);
+  for (unsigned int j = 0; j < n_chains; j++) {
+    acov.col(j) = autocovariance(x.col(j));
+  }
+  arma::vec mean_acov = arma::mean(acov, 1);
+  
+  double mean_var = mean_acov(0) * n / (n - 1.0);
+  double var_plus = mean_var * (n - 1.0) / n + arma::var(arma::mean(x).t());
+  
+  arma::vec rho(n, arma::fill::zeros);
+  rho(0) = 1.0;
+  double rho_even = 1.0;
+  double rho_odd = 1.0 - (mean_var - mean_acov(1)) / var_plus;
+  rho(1) = rho_odd;
+  unsigned int t = 0;
+  while (t + 5 < n && std::isfinite(rho_even + rho_odd) && 
+    (rho_even + rho_odd) > 0) {
+    t += 2;
+    rho_even = 1.0 - (mean_var - mean_acov(t)) / var_plus;
+    rho_odd = 1.0 - (mean_var - mean_acov(t + 1)) / var_plus;
+    if ((rho_even + rho_odd) >= 0) {
+      rho(t) = rho_even;
+      rho(t + 1) = rho_odd;
+    }
+  }
+  unsigned int max_t = t;
+  if (rho_even > 0) {
+    rho(max_t) = rho_even;
+  }
+  // enforce monotonicity of the sums of consecutive pairs
+  t = 0;
+  while (t + 4 <= max_t) {
+    t += 2;
+    if (rho(t) + rho(t + 1) > rho(t - 2) + rho(t - 1)) {
+      rho(t) = 0.5 * (rho(t - 2) + rho(t - 1));
+      rho(t + 1) = rho(t);
+    }
+  }
+  double ess = n * n_chains;
+  double tau = -1.0 + rho(max_t);
+  if (max_t > 0) {
+    tau += 2.0 * arma::accu(rho.head(max_t));
+  }
+  tau = std::max(tau, 1.0 / std::log10(ess));
+  return ess / tau;
+}
@@ -0,0 +1,13 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include "bssm.h"
+
+// convergence diagnostics of Vehtari et al. (2021) for a matrix of draws 
+// where each column corresponds to one chain of equal length
+arma::mat rank_normalize(const arma::mat& draws);
+arma::mat split_chains(const arma::mat& draws);
+double split_rhat(const arma::mat& draws);
+double bulk_ess(const arma::mat& draws);
+
+#endif
@@ -4,6 +4,17 @@
 #include "bssm.h"
 #include "distr_consts.h"
 
+#ifdef BSSM_STANDALONE
+namespace {
+// log of the binomial coefficient for real n, as in R for n >= k >= 0
+double lchoose(const double n, const double k) {
+  return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+}
+}
+#else
+using R::lchoose;
+#endif
+
 double norm_log_const(double sd) {
   return -0.5 * std::log(2.0 * M_PI) - std::log(sd);
 }
@@ -13,11 +24,11 @@ double poisson_log_const(double y, double u) {
 }
 
 double binomial_log_const(double y, double u) {
-  return R::lchoose(u, y);
+  return lchoose(u, y);
 }
 
 double negbin_log_const(double y, double u, double phi) {
-  return R::lchoose(y + phi - 1, y) + phi * std::log(phi) + y * std::log(u);
+  return lchoose(y + phi - 1, y) + phi * std::log(phi) + y * std::log(u);
 }
 
 
@@ -36,7 +47,7 @@ double poisson_log_const(const arma::vec& y, const arma::vec& u) {
 double binomial_log_const(const arma::vec& y, const arma::vec& u) {
   double res = 0.0;
   for(unsigned int i = 0; i < y.n_elem; i++) {
-    res += R::lchoose(u(i), y(i));
+    res += lchoose(u(i), y(i));
   }
   return res;
 }
@@ -44,7 +55,7 @@ double binomial_log_const(const arma::vec& y, const arma::vec& u) {
 double negbin_log_const(const arma::vec&  y, const arma::vec& u, double phi) {
   double res = 0.0;
   for(unsigned int i = 0; i < y.n_elem; i++) {
-    res += R::lchoose(y(i) + phi - 1, y(i)) + phi * std::log(phi) + y(i) * std::log(u(i));
+    res += lchoose(y(i) + phi - 1, y(i)) + phi * std::log(phi) + y(i) * std::log(u(i));
   }
   return res;
 }
@@ -84,3 +84,18 @@ double fast_dmvnorm(const arma::vec& x, const arma::vec& mean,
   return constant - 0.5 * arma::accu(tmp % tmp);
 }
 
+double chol_dmvnorm(const arma::vec& x, const arma::vec& mean, 
+  const arma::mat& L, const arma::uvec& nonzero) { 
+  
+  arma::vec tmp;
+  double constant = -0.5 * nonzero.n_elem * std::log(2.0 * M_PI);
+  if (nonzero.n_elem == L.n_cols) {
+    tmp = arma::solve(arma::trimatl(L), x - mean);
+    constant -= arma::accu(arma::log(L.diag()));
+  } else {
+    arma::mat L_nonzero = L(nonzero, nonzero);
+    tmp = arma::solve(arma::trimatl(L_nonzero), x.rows(nonzero) - mean.rows(nonzero));
+    constant -= arma::accu(arma::log(L_nonzero.diag()));
+  }
+  return constant - 0.5 * arma::accu(tmp % tmp);
+}
@@ -9,4 +9,8 @@ double precompute_dmvnorm(const arma::mat& sigma, arma::mat& Linv,
   const arma::uvec& nonzero);
 double fast_dmvnorm(const arma::vec& x, const arma::vec& mean, 
   const arma::mat& Linv, const arma::uvec& nonzero, const double constant);
+// log-density with the lower triangular Cholesky factor L of the covariance, 
+// for factors which are used only once
+double chol_dmvnorm(const arma::vec& x, const arma::vec& mean, 
+  const arma::mat& L, const arma::uvec& nonzero);
 #endif
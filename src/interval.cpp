@@ -1,3 +1,9 @@
+// prediction intervals are only computed for R
+#ifndef BSSM_STANDALONE
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include <boost/function.hpp>
 #include <boost/math/distributions/normal.hpp>
 #include <boost/math/tools/roots.hpp>
@@ -17,6 +23,28 @@ private:
   double prob;
 };
 
+// weighted mixture of normal distributions, using R::pnorm which does not 
+// allocate R objects so that it can be called within parallel regions
+struct objective_mixture {
+  objective_mixture(const arma::vec& means, const arma::vec& sds, 
+    const arma::vec& weights, double prob) : 
+  means(means), sds(sds), weights(weights), prob(prob) {}
+  
+  double operator()(double b) const {
+    double cdf = 0.0;
+    for (unsigned int i = 0; i < means.n_elem; i++) {
+      cdf += weights(i) * R::pnorm(b, means(i), sds(i), 1, 0);
+    }
+    return cdf - prob;
+  }
+  
+private:
+  const arma::vec& means;
+  const arma::vec& sds;
+  const arma::vec& weights;
+  double prob;
+};
+
 // [[Rcpp::depends(BH)]]
 // [[Rcpp::depends(RcppArmadillo)]]
 arma::mat intervals(arma::mat& means, const arma::mat& sds, const arma::vec& probs, unsigned int n_ahead) {
@@ -44,3 +72,50 @@ arma::mat intervals(arma::mat& means, const arma::mat& sds, const arma::vec& pro
   }
   return intv;
 }
+
+// quantiles of the mixtures of N(means(t, i), sds(t, i)^2) with weights(i) for each 
+// row t, in parallel over the rows. The lower bracket of each quantile is the 
+// previous quantile, and the brackets are widened until they contain the root
+arma::mat mixture_intervals(const arma::mat& means, const arma::mat& sds, 
+  const arma::vec& weights, const arma::vec& probs, const unsigned int n_threads) {
+  
+  unsigned int n = means.n_rows;
+  arma::vec w = weights / arma::accu(weights);
+  arma::mat intv(n, probs.n_elem);
+  
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1 && !omp_in_parallel())
+#endif
+  for (unsigned int t = 0; t < n; t++) {
+    arma::vec means_t = means.row(t).t();
+    arma::vec sds_t = sds.row(t).t();
+    double width = std::max(sds_t.max(), 1e-8);
+    double lower = means_t.min() - 2 * width;
+    double upper = means_t.max() + 2 * width;
+    boost::math::tools::eps_tolerance<double> tol;
+    for (unsigned int j = 0; j < probs.n_elem; j++) {
+      objective_mixture f(means_t, sds_t, w, probs(j));
+      double a = lower;
+      double b = upper;
+      for (unsigned int k = 0; k < 50 && f(a) > 0; k++) {
+        a -= width * std::pow(2.0, k);
+      }
+      for (unsigned int k = 0; k < 50 && f(b) < 0; k++) {
+        b += width * std::pow(2.0, k);
+      }
+      // bisect throws if the root is not bracketed, which is not allowed here
+      if (!(f(a) <= 0 && f(b) >= 0)) {
+        intv(t, j) = std::numeric_limits<double>::quiet_NaN();
+        continue;
+      }
+      boost::uintmax_t max_iter = 1000;
+      std::pair<double, double> r =
+        boost::math::tools::bisect(f, a, b, tol, max_iter);
+      intv(t, j) = r.first + (r.second - r.first) / 2.0;
+      lower = intv(t, j);
+    }
+  }
+  return intv;
+}
+
+#endif
@@ -3,8 +3,13 @@
 
 #include "bssm.h"
 
+#ifndef BSSM_STANDALONE
 arma::mat intervals(arma::mat& means, const arma::mat& sds, const arma::vec& probs, 
   unsigned int n_ahead);
+// quantiles of the weighted normal mixtures of each row of means and sds
+arma::mat mixture_intervals(const arma::mat& means, const arma::mat& sds, 
+  const arma::vec& weights, const arma::vec& probs, const unsigned int n_threads);
+#endif
 
 
 #endif
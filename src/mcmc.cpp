@@ -1,7 +1,8 @@
 #ifdef _OPENMP
 #include <omp.h>
 #endif
-#include <ramcmc.h>
+#include <exception>
+#include "ram.h"
 #include "mcmc.h"
 #include "ugg_ssm.h"
 #include "ung_ssm.h"
@@ -10,6 +11,7 @@
 #include "ung_svm.h"
 #include "nlg_ssm.h"
 #include "sde_ssm.h"
+#include "msde_ssm.h"
 #include "mgg_ssm.h"
 #include "lgg_ssm.h"
 #include "ung_ar1.h"
@@ -18,30 +20,201 @@
 #include "distr_consts.h"
 #include "filter_smoother.h"
 #include "summary.h"
+#include "rep_mat.h"
+#include "diagnostics.h"
+#include "pt_mcmc.h"
+#include "pm_loglik.h"
+#include "spec_mcmc.h"
+#include "output_sink.h"
+#include "checkpoint.h"
 
 mcmc::mcmc(const unsigned int n_iter, const unsigned int n_burnin,
   const unsigned int n_thin, const unsigned int n, const unsigned int m,
   const double target_acceptance, const double gamma, const arma::mat& S,
-  const unsigned int output_type) :
+  const unsigned int output_type, const std::string& output_file, 
+  const unsigned int precision) :
   n_iter(n_iter), n_burnin(n_burnin), n_thin(n_thin),
   n_samples(std::floor(static_cast <double> (n_iter - n_burnin) / n_thin)),
   n_par(S.n_rows),
-  target_acceptance(target_acceptance), gamma(gamma), n_stored(0),
+  target_acceptance(target_acceptance), gamma(gamma), n_stored(0), checkpoint_seed(0),
   posterior_storage(arma::vec(n_samples)),
   theta_storage(arma::mat(n_par, n_samples)),
   count_storage(arma::uvec(n_samples, arma::fill::zeros)),
-  alpha_storage(arma::cube((output_type == 1) * n + 1, m, (output_type == 1) * n_samples)), 
+  alpha_storage(arma::cube((output_type == 1 || output_type == 4) * n + 1, m, 
+    (output_type == 1 && output_file.empty() && precision == 1) * n_samples)), 
+  packed_alpha((output_type == 1 && precision > 1) * n + 1, m, 
+    (output_type == 1 && precision > 1) * n_samples, precision),
+  alpha_sketch((output_type == 4) * m, (output_type == 4) * (n + 1)),
   alphahat(arma::mat(m, (output_type == 2) * n + 1, arma::fill::zeros)), 
   Vt(arma::cube(m, m, (output_type == 2) * n + 1, arma::fill::zeros)), S(S),
-  acceptance_rate(0.0), output_type(output_type) {
+  acceptance_rate(0.0), output_type(output_type), stop_iter(n_iter) {
+  
+  if (output_type == 1 && !output_file.empty()) {
+    sink = std::make_shared<output_sink>(output_file, n + 1, m, n_par);
+  }
 }
 
 void mcmc::trim_storage() {
   theta_storage.resize(n_par, n_stored);
   posterior_storage.resize(n_stored);
   count_storage.resize(n_stored);
-  if (output_type == 1)
-    alpha_storage.resize(alpha_storage.n_rows, alpha_storage.n_cols, n_stored);
+  if (output_type == 1 && !sink) {
+    if (packed_alpha.precision > 1) {
+      packed_alpha.resize(n_stored);
+    } else {
+      alpha_storage.resize(alpha_storage.n_rows, alpha_storage.n_cols, n_stored);
+    }
+  }
+}
+
+void mcmc::store_states(const unsigned int i, const arma::mat& alpha) {
+  if (sink) {
+#ifdef _OPENMP
+#pragma omp critical(output_sink)
+#endif
+{
+  sink->write(i, alpha);
+}
+  } else {
+    if (packed_alpha.precision > 1) {
+      packed_alpha.pack(i, alpha);
+    } else {
+      alpha_storage.slice(i) = alpha;
+    }
+  }
+}
+
+void mcmc::sketch_states(const arma::mat& alpha, const double weight) {
+#ifdef _OPENMP
+#pragma omp critical(alpha_sketch)
+#endif
+{
+  alpha_sketch.add(alpha, weight);
+}
+}
+
+void mcmc::sketch_states(const arma::cube& alpha, const arma::vec& weights,
+  const double weight) {
+  
+  double sum_w = arma::accu(weights);
+#ifdef _OPENMP
+#pragma omp critical(alpha_sketch)
+#endif
+{
+  for (unsigned int j = 0; j < alpha.n_slices; j++) {
+    alpha_sketch.add(alpha.slice(j), weight * weights(j) / sum_w);
+  }
+}
+}
+
+void mcmc::close_output() {
+  if (sink) {
+    sink->close(theta_storage, posterior_storage, count_storage, arma::vec());
+  }
+}
+
+void mcmc::set_checkpoint(const std::string& file_name, const unsigned int interval,
+  const unsigned int seed) {
+  if (!file_name.empty()) {
+    ckpt = std::make_shared<checkpoint>(file_name, interval);
+    checkpoint_seed = seed;
+  }
+}
+
+arma::uvec mcmc::checkpoint_info() const {
+  arma::uvec info = {checkpoint_seed, n_iter, n_burnin, n_thin, n_par, output_type,
+    alpha_storage.n_rows, alpha_storage.n_cols, packed_alpha.precision};
+  return info;
+}
+
+void mcmc::sync_storage(checkpoint& file) {
+  file.sync(S, acceptance_rate, n_stored, alphahat, Vt);
+  file.sync_head(posterior_storage, n_stored);
+  file.sync_cols(theta_storage, n_stored);
+  file.sync_head(count_storage, n_stored);
+  if (output_type == 1) {
+    if (packed_alpha.precision > 1) {
+      file.sync_slices(packed_alpha, n_stored);
+    } else {
+      file.sync_slices(alpha_storage, n_stored);
+    }
+  }
+  if (output_type == 4) {
+    file.sync(alpha_sketch);
+  }
+}
+
+void mcmc::check_interrupt() const {
+#ifdef _OPENMP
+  if (omp_get_thread_num() != 0) return;
+#endif
+  bssm::check_interrupt();
+}
+
+void mcmc::combine_chains(const std::vector<mcmc>& chains) {
+  
+  n_stored = 0;
+  for (unsigned int i = 0; i < chains.size(); i++) {
+    n_stored += chains[i].n_stored;
+  }
+  theta_storage.set_size(n_par, n_stored);
+  posterior_storage.set_size(n_stored);
+  count_storage.set_size(n_stored);
+  chain_storage.set_size(n_stored);
+  if (output_type == 1 && !sink) {
+    if (packed_alpha.precision > 1) {
+      packed_alpha.resize(n_stored);
+    } else {
+      alpha_storage.set_size(alpha_storage.n_rows, alpha_storage.n_cols, n_stored);
+    }
+  }
+  acceptance_rate = 0.0;
+  unsigned int start = 0;
+  for (unsigned int i = 0; i < chains.size(); i++) {
+    if (chains[i].n_stored > 0) {
+      unsigned int end = start + chains[i].n_stored - 1;
+      theta_storage.cols(start, end) = chains[i].theta_storage;
+      posterior_storage.subvec(start, end) = chains[i].posterior_storage;
+      count_storage.subvec(start, end) = chains[i].count_storage;
+      chain_storage.subvec(start, end).fill(i + 1);
+      start = end + 1;
+    }
+    acceptance_rate += chains[i].acceptance_rate / chains.size();
+  }
+  // S of the first chain is returned
+  S = chains[0].S;
+}
+
+void mcmc::chain_diagnostics(const std::vector<mcmc>& chains) {
+  
+  unsigned int n_chains = chains.size();
+  // expand the jump chains and use the common length
+  std::vector<arma::mat> draws(n_chains);
+  unsigned int n_draws = std::numeric_limits<unsigned int>::max();
+  for (unsigned int i = 0; i < n_chains; i++) {
+    unsigned int n_i = chains[i].n_stored;
+    if (n_i > 0) {
+      draws[i] = rep_mat(chains[i].theta_storage.cols(0, n_i - 1), 
+        chains[i].count_storage.subvec(0, n_i - 1));
+    }
+    n_draws = std::min(n_draws, static_cast<unsigned int>(draws[i].n_cols));
+  }
+  rhat.set_size(n_par);
+  ess.set_size(n_par);
+  // at least two draws per split chain are needed
+  if (n_draws < 4) {
+    rhat.fill(arma::datum::nan);
+    ess.fill(arma::datum::nan);
+    return;
+  }
+  arma::mat x(n_draws, n_chains);
+  for (unsigned int j = 0; j < n_par; j++) {
+    for (unsigned int i = 0; i < n_chains; i++) {
+      x.col(i) = draws[i].submat(j, 0, j, n_draws - 1).t();
+    }
+    rhat(j) = split_rhat(x);
+    ess(j) = bulk_ess(x);
+  }
 }
 
 
@@ -53,29 +226,71 @@ template void mcmc::state_posterior(lgg_ssm model, const unsigned int n_threads)
 template <class T>
 void mcmc::state_posterior(T model, const unsigned int n_threads) {
   
-  if(n_threads > 1) {
+  if (n_stored == 0) return;
+  
+  // the samples are split into contiguous pieces, one for each thread, and 
+  // each piece is sampled using its own random number stream
+  unsigned int n_pieces = 1;
 #ifdef _OPENMP
-#pragma omp parallel num_threads(n_threads) default(none) firstprivate(model)
-{
-  model.engine = sitmo::prng_engine(omp_get_thread_num() + 1);
-  unsigned thread_size =
-    static_cast <unsigned int>(std::floor(static_cast <double> (n_stored) / n_threads));
-  unsigned int start = omp_get_thread_num() * thread_size;
-  unsigned int end = (omp_get_thread_num() + 1) * thread_size - 1;
-  if(omp_get_thread_num() == static_cast<int>(n_threads - 1)) {
-    end = n_stored - 1;
-  }
-  
-  arma::mat theta_piece = theta_storage(arma::span::all, arma::span(start, end));
-  arma::cube alpha_piece = alpha_storage.slices(start, end);
-  state_sampler(model, theta_piece, alpha_piece);
-  alpha_storage.slices(start, end) = alpha_piece;
-}
-#else
-    state_sampler(model, theta_storage, alpha_storage);
+  if (n_threads > 1) n_pieces = n_threads;
 #endif
+  std::vector<T> models(n_pieces, model);
+  if (n_pieces > 1) {
+    for (unsigned int i = 0; i < n_pieces; i++) {
+      models[i].engine = sitmo::prng_engine(i + 1);
+    }
+  }
+  
+  if (sink || packed_alpha.precision > 1 || output_type == 4) {
+    // sample the states in chunks which are written to the file, packed or
+    // added to the quantile sketches, in the latter cases the chunks are at most 64MB
+    // the pieces and their random number streams continue over the chunks, 
+    // so the states are identical to the ones of the in-memory output
+    unsigned int chunk_size = sink ? sink->chunk_size : std::max(n_threads, 
+      (64u << 20) / (8 * alpha_storage.n_rows * alpha_storage.n_cols));
+    arma::cube alpha_chunk;
+    for (unsigned int start = 0; start < n_stored; start += chunk_size) {
+      unsigned int end = std::min(start + chunk_size, n_stored) - 1;
+      alpha_chunk.set_size(alpha_storage.n_rows, alpha_storage.n_cols, end - start + 1);
+      state_posterior(models, start, end, alpha_chunk);
+      if (sink) {
+        sink->write(start, alpha_chunk);
+      } else if (output_type == 4) {
+        for (unsigned int i = 0; i < alpha_chunk.n_slices; i++) {
+          alpha_sketch.add(alpha_chunk.slice(i).t(), count_storage(start + i));
+        }
+      } else {
+        for (unsigned int i = 0; i < alpha_chunk.n_slices; i++) {
+          packed_alpha.pack(start + i, alpha_chunk.slice(i));
+        }
+      }
+      check_interrupt();
+    }
   } else {
-    state_sampler(model, theta_storage, alpha_storage);
+    state_posterior(models, 0, n_stored - 1, alpha_storage);
+  }
+}
+
+template <class T>
+void mcmc::state_posterior(std::vector<T>& models, const unsigned int start, 
+  const unsigned int end, arma::cube& alpha) {
+  
+  unsigned int n_pieces = models.size();
+  unsigned int piece_size = n_stored / n_pieces;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_pieces) if(n_pieces > 1)
+#endif
+  for (unsigned int i = 0; i < n_pieces; i++) {
+    // the last piece contains also the remaining samples
+    unsigned int piece_start = std::max(start, i * piece_size);
+    unsigned int piece_end = std::min(end + 1, 
+      (i == n_pieces - 1) ? n_stored : (i + 1) * piece_size);
+    if (piece_start < piece_end) {
+      arma::cube alpha_piece(alpha.n_rows, alpha.n_cols, piece_end - piece_start);
+      state_sampler(models[i], theta_storage.cols(piece_start, piece_end - 1), 
+        alpha_piece);
+      alpha.slices(piece_start - start, piece_end - start - 1) = alpha_piece;
+    }
   }
 }
 
@@ -148,80 +363,95 @@ template void mcmc::mcmc_gaussian(ugg_bsm model, const bool end_ram);
 template void mcmc::mcmc_gaussian(ugg_ar1 model, const bool end_ram);
 template void mcmc::mcmc_gaussian(mgg_ssm model, const bool end_ram);
 
+// one iteration of the random walk Metropolis for linear-Gaussian models
+template<class T>
+void mcmc::gaussian_step(T& model, const unsigned int i, const bool end_ram,
+  std::normal_distribution<>& normal, std::uniform_real_distribution<>& unif,
+  arma::vec& theta, double& logprior, bool& new_value, unsigned int& n_values,
+  double& loglik) {
+  
+  // sample from standard normal distribution
+  arma::vec u(n_par);
+  for(unsigned int j = 0; j < n_par; j++) {
+    u(j) = normal(model.engine);
+  }
+  // propose new theta
+  arma::vec theta_prop = theta + S * u;
+  // compute prior
+  double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
+  double acceptance_prob = 0.0;
+  
+  if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
+    // update model based on the proposal
+    model.update_model(theta_prop);
+    // compute log-likelihood with proposed theta
+    double loglik_prop = model.log_likelihood();
+    //compute the acceptance probability
+    // use explicit min(...) as we need this value later
+    acceptance_prob = 
+      std::min(1.0, std::exp(loglik_prop - loglik + logprior_prop - logprior + 
+      model.log_proposal_ratio(theta_prop, theta)));
+    //accept
+    if (unif(model.engine) < acceptance_prob) {
+      if (i > n_burnin) {
+        acceptance_rate++;
+        n_values++;
+      }
+      loglik = loglik_prop;
+      logprior = logprior_prop;
+      theta = theta_prop;
+      new_value = true;
+      
+    }
+  }
+  
+  if (i > n_burnin && n_values % n_thin == 0) {
+    //new block
+    if (new_value) {
+      posterior_storage(n_stored) = logprior + loglik;
+      theta_storage.col(n_stored) = theta;
+      count_storage(n_stored) = 1;
+      n_stored++;
+      new_value = false;
+    } else {
+      count_storage(n_stored - 1)++;
+    }
+  }
+  if (!end_ram || i <= n_burnin) {
+    profiler::timer ram_timer(profiler::ram_adaptation);
+    ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
+  }
+}
+
 template<class T>
 void mcmc::mcmc_gaussian(T model, const bool end_ram) {
   
   arma::vec theta = model.theta;
-  double logprior = model.log_prior_pdf(theta);
+  double logprior = profiler::log_prior_pdf(model, theta);
   double loglik = model.log_likelihood();
   
   if (!std::isfinite(logprior))
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   
   std::normal_distribution<> normal(0.0, 1.0);
   std::uniform_real_distribution<> unif(0.0, 1.0);
   
-  double acceptance_prob = 0.0;
   bool new_value = true;
   unsigned int n_values = 0;
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("mcmc_gaussian", model.engine, normal, unif,
+    theta, logprior, new_value, n_values, loglik);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
-    }
-    
-    // sample from standard normal distribution
-    arma::vec u(n_par);
-    for(unsigned int j = 0; j < n_par; j++) {
-      u(j) = normal(model.engine);
-    }
-    // propose new theta
-    arma::vec theta_prop = theta + S * u;
-    // compute prior
-    double logprior_prop = model.log_prior_pdf(theta_prop);
-    
-    if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
-      // update model based on the proposal
-      model.update_model(theta_prop);
-      // compute log-likelihood with proposed theta
-      double loglik_prop = model.log_likelihood();
-      //compute the acceptance probability
-      // use explicit min(...) as we need this value later
-      acceptance_prob = 
-        std::min(1.0, std::exp(loglik_prop - loglik + logprior_prop - logprior + 
-        model.log_proposal_ratio(theta_prop, theta)));
-      //accept
-      if (unif(model.engine) < acceptance_prob) {
-        if (i > n_burnin) {
-          acceptance_rate++;
-          n_values++;
-        }
-        loglik = loglik_prop;
-        logprior = logprior_prop;
-        theta = theta_prop;
-        new_value = true;
-        
-      }
-    } else acceptance_prob = 0.0;
-    
-    if (i > n_burnin && n_values % n_thin == 0) {
-      //new block
-      if (new_value) {
-        posterior_storage(n_stored) = logprior + loglik;
-        theta_storage.col(n_stored) = theta;
-        count_storage(n_stored) = 1;
-        n_stored++;
-        new_value = false;
-      } else {
-        count_storage(n_stored - 1)++;
-      }
-    }
-    if (!end_ram || i <= n_burnin) {
-      ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
+      check_interrupt();
     }
+    gaussian_step(model, i, end_ram, normal, unif, theta, logprior, new_value, 
+      n_values, loglik);
+    save_checkpoint(i, "mcmc_gaussian", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, loglik);
     
   }
   
@@ -234,7 +464,7 @@ void mcmc::mcmc_gaussian<lgg_ssm>(lgg_ssm model, const bool end_ram) {
   
   mgg_ssm mgg_model = model.build_mgg();
   arma::vec theta = model.theta;
-  double logprior = model.log_prior_pdf(model.theta);
+  double logprior = profiler::log_prior_pdf(model, model.theta);
   double loglik = mgg_model.log_likelihood();
   
   std::normal_distribution<> normal(0.0, 1.0);
@@ -243,10 +473,12 @@ void mcmc::mcmc_gaussian<lgg_ssm>(lgg_ssm model, const bool end_ram) {
   double acceptance_prob = 0.0;
   bool new_value = true;
   unsigned int n_values = 0;
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("mcmc_gaussian", model.engine, normal, unif,
+    theta, logprior, new_value, n_values, loglik);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -258,7 +490,7 @@ void mcmc::mcmc_gaussian<lgg_ssm>(lgg_ssm model, const bool end_ram) {
     arma::vec theta_prop = theta + S * u;
     // compute prior
     model.theta = theta_prop;
-    double logprior_prop = model.log_prior_pdf(model.theta);
+    double logprior_prop = profiler::log_prior_pdf(model, model.theta);
     model.update_mgg(mgg_model);
     if (arma::is_finite(logprior_prop)) {
       
@@ -296,14 +528,248 @@ void mcmc::mcmc_gaussian<lgg_ssm>(lgg_ssm model, const bool end_ram) {
       }
     }
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "mcmc_gaussian", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, loglik);
     
   }
   trim_storage();
   acceptance_rate /= (n_iter - n_burnin);
 }
 
+template void mcmc::mcmc_gaussian_chains(ugg_ssm model, const bool end_ram, 
+  const unsigned int seed, const unsigned int n_chains, const bool shared_warmup, 
+  const unsigned int n_threads, const double max_rhat, const double min_ess, 
+  const unsigned int check_interval);
+template void mcmc::mcmc_gaussian_chains(ugg_bsm model, const bool end_ram, 
+  const unsigned int seed, const unsigned int n_chains, const bool shared_warmup, 
+  const unsigned int n_threads, const double max_rhat, const double min_ess, 
+  const unsigned int check_interval);
+template void mcmc::mcmc_gaussian_chains(ugg_ar1 model, const bool end_ram, 
+  const unsigned int seed, const unsigned int n_chains, const bool shared_warmup, 
+  const unsigned int n_threads, const double max_rhat, const double min_ess, 
+  const unsigned int check_interval);
+
+template<class T>
+void mcmc::mcmc_gaussian_chains(T model, const bool end_ram, const unsigned int seed,
+  const unsigned int n_chains, const bool shared_warmup, const unsigned int n_threads,
+  const double max_rhat, const double min_ess, const unsigned int check_interval) {
+  
+  // check the initial values here as bssm::stop can't be used by the other threads
+  double logprior = profiler::log_prior_pdf(model, model.theta);
+  if (!std::isfinite(logprior))
+    bssm::stop("Initial prior probability is not finite.");
+  
+  double loglik = model.log_likelihood();
+  if (!std::isfinite(loglik))
+    bssm::stop("Initial log-likelihood is not finite.");
+  
+  unsigned int chain_iter = n_iter;
+  unsigned int chain_burnin = n_burnin;
+  bool chain_end_ram = end_ram;
+  
+  if (shared_warmup && n_burnin > 0) {
+    // adapt S using a single chain, after which all chains start from its 
+    // last state and S is kept fixed
+    mcmc warmup(n_burnin + 1, n_burnin, 1, model.n, model.m, 
+      target_acceptance, gamma, S, 3);
+    model.engine = sitmo::prng_engine(seed + n_chains);
+    warmup.mcmc_gaussian(model, true);
+    S = warmup.S;
+    model.update_model(warmup.theta_storage.col(warmup.n_stored - 1));
+    logprior = profiler::log_prior_pdf(model, model.theta);
+    loglik = model.log_likelihood();
+    chain_iter = n_iter - n_burnin;
+    chain_burnin = 0;
+    chain_end_ram = true;
+  }
+  
+  // the chains are run in rounds of check_interval iterations after the 
+  // burn-in, and stopped once the diagnostics of all parameters pass
+  bool early_stop = std::isfinite(max_rhat) || min_ess > 0;
+  unsigned int round_length = early_stop ? std::max(check_interval, 1u) : chain_iter;
+  
+  std::vector<mcmc> chains;
+  chains.reserve(n_chains);
+  // state of the sampling loop of each chain
+  std::vector<T> models(n_chains, model);
+  std::vector<std::normal_distribution<> > normal(n_chains, 
+    std::normal_distribution<>(0.0, 1.0));
+  std::vector<std::uniform_real_distribution<> > unif(n_chains, 
+    std::uniform_real_distribution<>(0.0, 1.0));
+  std::vector<arma::vec> theta(n_chains, model.theta);
+  std::vector<double> chain_logprior(n_chains, logprior);
+  std::vector<double> chain_loglik(n_chains, loglik);
+  std::vector<char> new_value(n_chains, true);
+  std::vector<unsigned int> n_values(n_chains, 0);
+  for (unsigned int i = 0; i < n_chains; i++) {
+    chains.push_back(mcmc(chain_iter, chain_burnin, n_thin, model.n, model.m,
+      target_acceptance, gamma, S, 3));
+    // independent random number streams for each chain
+    models[i].engine = sitmo::prng_engine(seed + i);
+  }
+  std::vector<std::exception_ptr> errors(n_chains);
+  
+  unsigned int i_done = 0;
+  while (i_done < chain_iter) {
+    unsigned int i_end = std::min(chain_iter, 
+      std::max(i_done, chain_burnin) + round_length);
+    
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(dynamic)
+#endif
+    for (unsigned int j = 0; j < n_chains; j++) {
+      try {
+        bool new_value_j = new_value[j];
+        for (unsigned int i = i_done + 1; i <= i_end; i++) {
+          if (i % 16 == 0) {
+            chains[j].check_interrupt();
+          }
+          chains[j].gaussian_step(models[j], i, chain_end_ram, normal[j], unif[j], 
+            theta[j], chain_logprior[j], new_value_j, n_values[j], chain_loglik[j]);
+        }
+        new_value[j] = new_value_j;
+      } catch (...) {
+        errors[j] = std::current_exception();
+      }
+    }
+    for (unsigned int j = 0; j < n_chains; j++) {
+      if (errors[j]) {
+        std::rethrow_exception(errors[j]);
+      }
+    }
+    i_done = i_end;
+    if (early_stop && i_done > chain_burnin && i_done < chain_iter) {
+      chain_diagnostics(chains);
+      if (arma::all(rhat < max_rhat) && arma::all(ess > min_ess)) {
+        break;
+      }
+    }
+  }
+  for (unsigned int j = 0; j < n_chains; j++) {
+    chains[j].trim_storage();
+    chains[j].acceptance_rate /= (i_done - chain_burnin);
+  }
+  stop_iter = i_done + n_iter - chain_iter;
+  chain_diagnostics(chains);
+  combine_chains(chains);
+}
+
+// parallel tempering for linear-Gaussian models
+template void mcmc::pt_mcmc_gaussian(ugg_ssm model, const bool end_ram, 
+  const unsigned int n_temps, const unsigned int seed, const unsigned int n_threads);
+template void mcmc::pt_mcmc_gaussian(ugg_bsm model, const bool end_ram, 
+  const unsigned int n_temps, const unsigned int seed, const unsigned int n_threads);
+template void mcmc::pt_mcmc_gaussian(ugg_ar1 model, const bool end_ram, 
+  const unsigned int n_temps, const unsigned int seed, const unsigned int n_threads);
+
+template<class T>
+void mcmc::pt_mcmc_gaussian(T model, const bool end_ram, const unsigned int n_temps,
+  const unsigned int seed, const unsigned int n_threads) {
+  
+  pt_mcmc(model, gaussian_loglik<T>(), end_ram, n_temps, seed, n_threads);
+}
+
+// pseudo-marginal parallel tempering, only theta is stored
+template void mcmc::pt_mcmc_pm(ung_ssm model, const bool end_ram, 
+  const unsigned int nsim_states, const unsigned int simulation_method, 
+  const bool local_approx, const arma::vec& initial_mode, const unsigned int max_iter, 
+  const double conv_tol, const unsigned int n_temps, const unsigned int seed, 
+  const unsigned int n_threads);
+template void mcmc::pt_mcmc_pm(ung_bsm model, const bool end_ram, 
+  const unsigned int nsim_states, const unsigned int simulation_method, 
+  const bool local_approx, const arma::vec& initial_mode, const unsigned int max_iter, 
+  const double conv_tol, const unsigned int n_temps, const unsigned int seed, 
+  const unsigned int n_threads);
+template void mcmc::pt_mcmc_pm(ung_svm model, const bool end_ram, 
+  const unsigned int nsim_states, const unsigned int simulation_method, 
+  const bool local_approx, const arma::vec& initial_mode, const unsigned int max_iter, 
+  const double conv_tol, const unsigned int n_temps, const unsigned int seed, 
+  const unsigned int n_threads);
+template void mcmc::pt_mcmc_pm(ung_ar1 model, const bool end_ram, 
+  const unsigned int nsim_states, const unsigned int simulation_method, 
+  const bool local_approx, const arma::vec& initial_mode, const unsigned int max_iter, 
+  const double conv_tol, const unsigned int n_temps, const unsigned int seed, 
+  const unsigned int n_threads);
+
+template<class T>
+void mcmc::pt_mcmc_pm(T model, const bool end_ram, const unsigned int nsim_states, 
+  const unsigned int simulation_method, const bool local_approx, 
+  const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol,
+  const unsigned int n_temps, const unsigned int seed, const unsigned int n_threads) {
+  
+  switch (simulation_method) {
+  case 1:
+    pt_mcmc(model, psi_loglik<T>(model, nsim_states, local_approx, initial_mode, 
+      max_iter, conv_tol), end_ram, n_temps, seed, n_threads);
+    break;
+  case 2:
+    pt_mcmc(model, bsf_loglik<T>(model, nsim_states), end_ram, n_temps, seed, 
+      n_threads);
+    break;
+  case 3:
+    pt_mcmc(model, spdk_loglik<T>(model, nsim_states, local_approx, initial_mode, 
+      max_iter, conv_tol), end_ram, n_temps, seed, n_threads);
+    break;
+  }
+}
+
+// speculative MCMC for linear-Gaussian models, gives the same chain as mcmc_gaussian
+template void mcmc::spec_mcmc_gaussian(ugg_ssm model, const bool end_ram, 
+  const unsigned int n_threads);
+template void mcmc::spec_mcmc_gaussian(ugg_bsm model, const bool end_ram, 
+  const unsigned int n_threads);
+template void mcmc::spec_mcmc_gaussian(ugg_ar1 model, const bool end_ram, 
+  const unsigned int n_threads);
+
+template<class T>
+void mcmc::spec_mcmc_gaussian(T model, const bool end_ram, const unsigned int n_threads) {
+  spec_mcmc(model, gaussian_loglik<T>(), end_ram, false, n_threads);
+}
+
+// speculative pseudo-marginal MCMC, only theta is stored
+// the result does not depend on the number of threads as the particle filter 
+// uses separate random number stream at each iteration, and the approximations
+// are always done locally
+template void mcmc::spec_mcmc_pm(ung_ssm model, const bool end_ram, 
+  const unsigned int nsim_states, const unsigned int simulation_method, 
+  const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol, 
+  const unsigned int n_threads);
+template void mcmc::spec_mcmc_pm(ung_bsm model, const bool end_ram, 
+  const unsigned int nsim_states, const unsigned int simulation_method, 
+  const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol, 
+  const unsigned int n_threads);
+template void mcmc::spec_mcmc_pm(ung_svm model, const bool end_ram, 
+  const unsigned int nsim_states, const unsigned int simulation_method, 
+  const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol, 
+  const unsigned int n_threads);
+template void mcmc::spec_mcmc_pm(ung_ar1 model, const bool end_ram, 
+  const unsigned int nsim_states, const unsigned int simulation_method, 
+  const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol, 
+  const unsigned int n_threads);
+
+template<class T>
+void mcmc::spec_mcmc_pm(T model, const bool end_ram, const unsigned int nsim_states, 
+  const unsigned int simulation_method, const arma::vec& initial_mode, 
+  const unsigned int max_iter, const double conv_tol, const unsigned int n_threads) {
+  
+  switch (simulation_method) {
+  case 1:
+    spec_mcmc(model, psi_loglik<T>(model, nsim_states, true, initial_mode, 
+      max_iter, conv_tol), end_ram, true, n_threads);
+    break;
+  case 2:
+    spec_mcmc(model, bsf_loglik<T>(model, nsim_states), end_ram, true, n_threads);
+    break;
+  case 3:
+    spec_mcmc(model, spdk_loglik<T>(model, nsim_states, true, initial_mode, 
+      max_iter, conv_tol), end_ram, true, n_threads);
+    break;
+  }
+}
+
 
 // run pseudo-marginal MCMC for non-linear and/or non-Gaussian state space model
 // using psi-PF
@@ -331,9 +797,9 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
   // get the current values of theta
   arma::vec theta = model.theta;
   // compute the log[p(theta)]
-  double logprior = model.log_prior_pdf(theta);
+  double logprior = profiler::log_prior_pdf(model, theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::vec mode_estimate = initial_mode;
@@ -343,7 +809,7 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
   double gaussian_loglik = approx_model.log_likelihood();
   
   if (!std::isfinite(gaussian_loglik))
-    Rcpp::stop("Initial gaussian log-likelihood is not finite.");
+    bssm::stop("Initial gaussian log-likelihood is not finite.");
   
   // compute unnormalized mode-based correction terms
   // log[g(y_t | ^alpha_t) / ~g(y_t | ^alpha_t)]
@@ -368,17 +834,21 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
   double ll_w = std::log(arma::accu(weights) / nsim_states);
   double loglik = gaussian_loglik + const_term + sum_scales + ll_w;
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   double acceptance_prob = 0.0;
   bool new_value = true;
   unsigned int n_values = 0;
   std::normal_distribution<> normal(0.0, 1.0);
   std::uniform_real_distribution<> unif(0.0, 1.0);
   
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("pm_mcmc_spdk", model.engine, normal, unif,
+    theta, logprior, new_value, n_values, loglik, ll_w, mode_estimate, approx_model.y,
+    approx_model.H, approx_model.HH, approx_model.engine, sampled_alpha, alphahat_i,
+    Vt_i, Valphahat);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -390,7 +860,7 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
     // propose new theta
     arma::vec theta_prop = theta + S * u;
     // compute prior
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
       // update parameters
@@ -399,9 +869,9 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
       if (local_approx) {
         // construct the approximate Gaussian model
         mode_estimate = initial_mode;
-        model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
+        model.approximate(approx_model, mode_estimate, max_iter, conv_tol, &gaussian_loglik);
       } else {
-        model.approximate(approx_model, mode_estimate, 0, conv_tol);
+        model.approximate(approx_model, mode_estimate, 0, conv_tol, &gaussian_loglik);
       }
       // compute unnormalized mode-based correction terms
       // log[g(y_t | ^alpha_t) / ~g(y_t | ^alpha_t)]
@@ -415,7 +885,7 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
       ll_w = std::log(arma::accu(weights) / nsim_states);
       
       double loglik_prop =
-        approx_model.log_likelihood() + const_term + sum_scales + ll_w;
+        gaussian_loglik + const_term + sum_scales + ll_w;
       
       //compute the acceptance probability
       // use explicit min(...) as we need this value later
@@ -430,7 +900,7 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
           n_values++;
         }
         if (output_type != 3) {
-          if (output_type == 1) {
+          if (output_type != 2) {
             std::discrete_distribution<unsigned int> sample(weights.begin(), weights.end());
             sampled_alpha = alpha.slice(ind);
           } else {
@@ -463,18 +933,25 @@ void mcmc::pm_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
         theta_storage.col(n_stored) = theta;
         count_storage(n_stored) = 1;
         if (output_type == 1) {
-          alpha_storage.slice(n_stored) = sampled_alpha.t();
+          store_states(n_stored, sampled_alpha.t());
         }
         n_stored++;
         new_value = false;
       } else {
         count_storage(n_stored - 1)++;
       }
+      if (output_type == 4) {
+        sketch_states(sampled_alpha, 1.0);
+      }
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "pm_mcmc_spdk", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, loglik, ll_w, mode_estimate, approx_model.y, approx_model.H,
+      approx_model.HH, approx_model.engine, sampled_alpha, alphahat_i, Vt_i, Valphahat);
   }
   if (output_type == 2) {
     Vt += Valphahat / (n_iter - n_burnin); // Var[E(alpha)] + E[Var(alpha)]
@@ -510,9 +987,9 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
   // get the current values of theta
   arma::vec theta = model.theta;
   // compute the log[p(theta)]
-  double logprior = model.log_prior_pdf(theta);
+  double logprior = profiler::log_prior_pdf(model, theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::vec mode_estimate = initial_mode;
@@ -537,7 +1014,7 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
   double loglik = model.psi_filter(approx_model, approx_loglik, scales,
     nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
@@ -553,10 +1030,14 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
   unsigned int n_values = 0;
   std::normal_distribution<> normal(0.0, 1.0);
   std::uniform_real_distribution<> unif(0.0, 1.0);
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("pm_mcmc_psi", model.engine, normal, unif,
+    theta, logprior, new_value, n_values, loglik, mode_estimate, approx_model.y,
+    approx_model.H, approx_model.HH, approx_model.engine, sampled_alpha, alphahat_i,
+    Vt_i, Valphahat);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -568,7 +1049,7 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
     // propose new theta
     arma::vec theta_prop = theta + S * u;
     // compute prior
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
       // update parameters
@@ -577,9 +1058,9 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
       if (local_approx) {
         // construct the approximate Gaussian model
         mode_estimate = initial_mode;
-        model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
+        model.approximate(approx_model, mode_estimate, max_iter, conv_tol, &gaussian_loglik);
       } else {
-        model.approximate(approx_model, mode_estimate, 0, conv_tol);
+        model.approximate(approx_model, mode_estimate, 0, conv_tol, &gaussian_loglik);
       }
       // compute unnormalized mode-based correction terms
       // log[g(y_t | ^alpha_t) / ~g(y_t | ^alpha_t)]
@@ -587,8 +1068,6 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
       sum_scales = arma::accu(scales);
       // compute the constant term
       const_term = compute_const_term(model, approx_model);
-      // compute the log-likelihood of the approximate model
-      gaussian_loglik = approx_model.log_likelihood();
       approx_loglik = gaussian_loglik + const_term + sum_scales;
       
       double loglik_prop = model.psi_filter(approx_model, approx_loglik, scales,
@@ -611,7 +1090,7 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
         if (output_type != 3) {
           filter_smoother(alpha, indices);
           w = weights.col(n);
-          if (output_type == 1) {
+          if (output_type != 2) {
             std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
             sampled_alpha = alpha.slice(sample(model.engine));
           } else {
@@ -643,18 +1122,25 @@ void mcmc::pm_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
         theta_storage.col(n_stored) = theta;
         count_storage(n_stored) = 1;
         if (output_type == 1) {
-          alpha_storage.slice(n_stored) = sampled_alpha.t();
+          store_states(n_stored, sampled_alpha.t());
         }
         n_stored++;
         new_value = false;
       } else {
         count_storage(n_stored - 1)++;
       }
+      if (output_type == 4) {
+        sketch_states(sampled_alpha, 1.0);
+      }
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "pm_mcmc_psi", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, loglik, mode_estimate, approx_model.y, approx_model.H,
+      approx_model.HH, approx_model.engine, sampled_alpha, alphahat_i, Vt_i, Valphahat);
   }
   if (output_type == 2) {
     Vt += Valphahat / (n_iter - n_burnin); // Var[E(alpha)] + E[Var(alpha)]
@@ -684,16 +1170,16 @@ void mcmc::pm_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
   arma::vec theta = model.theta;
   
   // compute the log[p(theta)]
-  double logprior = model.log_prior_pdf(theta);
+  double logprior = profiler::log_prior_pdf(model, theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   arma::cube alpha(m, n + 1, nsim_states);
   arma::mat weights(nsim_states, n + 1);
   arma::umat indices(nsim_states, n);
   double loglik = model.bsf_filter(nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -709,10 +1195,13 @@ void mcmc::pm_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
   std::normal_distribution<> normal(0.0, 1.0);
   std::uniform_real_distribution<> unif(0.0, 1.0);
   
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("pm_mcmc_bsf", model.engine, normal, unif,
+    theta, logprior, new_value, n_values, loglik, sampled_alpha, alphahat_i, Vt_i,
+    Valphahat);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -724,7 +1213,7 @@ void mcmc::pm_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
     // propose new theta
     arma::vec theta_prop = theta + S * u;
     // compute prior
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
       // update parameters
@@ -749,7 +1238,7 @@ void mcmc::pm_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
         if (output_type != 3) {
           filter_smoother(alpha, indices);
           w = weights.col(n);
-          if (output_type == 1) {
+          if (output_type != 2) {
             std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
             sampled_alpha = alpha.slice(sample(model.engine));
           } else {
@@ -780,18 +1269,24 @@ void mcmc::pm_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
         theta_storage.col(n_stored) = theta;
         count_storage(n_stored) = 1;
         if (output_type == 1) {
-          alpha_storage.slice(n_stored) = sampled_alpha.t();
+          store_states(n_stored, sampled_alpha.t());
         }
         n_stored++;
         new_value = false;
       } else {
         count_storage(n_stored - 1)++;
       }
+      if (output_type == 4) {
+        sketch_states(sampled_alpha, 1.0);
+      }
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "pm_mcmc_bsf", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, loglik, sampled_alpha, alphahat_i, Vt_i, Valphahat);
   }
   if (output_type == 2) {
     Vt += Valphahat / (n_iter - n_burnin); // Var[E(alpha)] + E[Var(alpha)]
@@ -826,9 +1321,9 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
   // get the current values of theta
   arma::vec theta = model.theta;
   // compute the log[p(theta)]
-  double logprior = model.log_prior_pdf(theta);
+  double logprior = profiler::log_prior_pdf(model, theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::vec mode_estimate = initial_mode;
@@ -860,16 +1355,20 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
   double ll_w = std::log(arma::accu(weights) / nsim_states);
   double loglik = gaussian_loglik + const_term + sum_scales + ll_w;
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   double acceptance_prob = 0.0;
   bool new_value = true;
   unsigned int n_values = 0;
   std::normal_distribution<> normal(0.0, 1.0);
   std::uniform_real_distribution<> unif(0.0, 1.0);
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("da_mcmc_spdk", model.engine, normal, unif,
+    theta, logprior, new_value, n_values, loglik, approx_loglik, ll_w, mode_estimate,
+    approx_model.y, approx_model.H, approx_model.HH, approx_model.engine, sampled_alpha,
+    alphahat_i, Vt_i, Valphahat);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -881,7 +1380,7 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
     // propose new theta
     arma::vec theta_prop = theta + S * u;
     // compute prior
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
       // update parameters
@@ -890,9 +1389,9 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
       if (local_approx) {
         // construct the approximate Gaussian model
         mode_estimate = initial_mode;
-        model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
+        model.approximate(approx_model, mode_estimate, max_iter, conv_tol, &gaussian_loglik);
       } else {
-        model.approximate(approx_model, mode_estimate, 0, conv_tol);
+        model.approximate(approx_model, mode_estimate, 0, conv_tol, &gaussian_loglik);
       }
       // compute unnormalized mode-based correction terms
       // log[g(y_t | ^alpha_t) / ~g(y_t | ^alpha_t)]
@@ -900,8 +1399,6 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
       sum_scales = arma::accu(scales);
       // compute the constant term
       const_term = compute_const_term(model, approx_model);
-      // compute the log-likelihood of the approximate model
-      gaussian_loglik = approx_model.log_likelihood();
       double approx_loglik_prop = gaussian_loglik + const_term + sum_scales;
       
       // stage 1 acceptance probability, used in RAM as well
@@ -927,7 +1424,7 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
               n_values++;
             }
             if (output_type != 3) {
-              if (output_type == 1) {
+              if (output_type != 2) {
                 std::discrete_distribution<unsigned int> sample(weights.begin(), weights.end());
                 sampled_alpha = alpha.slice(sample(model.engine));
               } else {
@@ -963,18 +1460,26 @@ void mcmc::da_mcmc_spdk(T model, const bool end_ram, const unsigned int nsim_sta
         theta_storage.col(n_stored) = theta;
         count_storage(n_stored) = 1;
         if (output_type == 1) {
-          alpha_storage.slice(n_stored) = sampled_alpha.t();
+          store_states(n_stored, sampled_alpha.t());
         }
         n_stored++;
         new_value = false;
       } else {
         count_storage(n_stored - 1)++;
       }
+      if (output_type == 4) {
+        sketch_states(sampled_alpha, 1.0);
+      }
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "da_mcmc_spdk", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, loglik, approx_loglik, ll_w, mode_estimate, approx_model.y,
+      approx_model.H, approx_model.HH, approx_model.engine, sampled_alpha, alphahat_i,
+      Vt_i, Valphahat);
   }
   if (output_type == 2) {
     Vt += Valphahat / (n_iter - n_burnin); // Var[E(alpha)] + E[Var(alpha)]
@@ -1009,9 +1514,9 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
   // get the current values of theta
   arma::vec theta = model.theta;
   // compute the log[p(theta)]
-  double logprior = model.log_prior_pdf(theta);
+  double logprior = profiler::log_prior_pdf(model, theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::vec mode_estimate = initial_mode;
@@ -1035,7 +1540,7 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
   double loglik = model.psi_filter(approx_model, approx_loglik, scales,
     nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -1049,10 +1554,14 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
   unsigned int n_values = 0;
   std::normal_distribution<> normal(0.0, 1.0);
   std::uniform_real_distribution<> unif(0.0, 1.0);
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("da_mcmc_psi", model.engine, normal, unif,
+    theta, logprior, new_value, n_values, loglik, approx_loglik, mode_estimate,
+    approx_model.y, approx_model.H, approx_model.HH, approx_model.engine, sampled_alpha,
+    alphahat_i, Vt_i, Valphahat);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -1064,7 +1573,7 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
     // propose new theta
     arma::vec theta_prop = theta + S * u;
     // compute prior
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
       // update parameters
@@ -1073,9 +1582,9 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
       if (local_approx) {
         // construct the approximate Gaussian model
         mode_estimate = initial_mode;
-        model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
+        model.approximate(approx_model, mode_estimate, max_iter, conv_tol, &gaussian_loglik);
       } else {
-        model.approximate(approx_model, mode_estimate, 0, conv_tol);
+        model.approximate(approx_model, mode_estimate, 0, conv_tol, &gaussian_loglik);
       }
       // compute unnormalized mode-based correction terms
       // log[g(y_t | ^alpha_t) / ~g(y_t | ^alpha_t)]
@@ -1083,8 +1592,6 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
       sum_scales = arma::accu(scales);
       // compute the constant term
       const_term = compute_const_term(model, approx_model);
-      // compute the log-likelihood of the approximate model
-      gaussian_loglik = approx_model.log_likelihood();
       double approx_loglik_prop = gaussian_loglik + const_term + sum_scales;
       
       // stage 1 acceptance probability, used in RAM as well
@@ -1111,7 +1618,7 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
             if (output_type != 3) {
               filter_smoother(alpha, indices);
               w = weights.col(n);
-              if (output_type == 1) {
+              if (output_type != 2) {
                 std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
                 sampled_alpha = alpha.slice(sample(model.engine));
               } else {
@@ -1145,18 +1652,26 @@ void mcmc::da_mcmc_psi(T model, const bool end_ram, const unsigned int nsim_stat
         theta_storage.col(n_stored) = theta;
         count_storage(n_stored) = 1;
         if (output_type == 1) {
-          alpha_storage.slice(n_stored) = sampled_alpha.t();
+          store_states(n_stored, sampled_alpha.t());
         }
         n_stored++;
         new_value = false;
       } else {
         count_storage(n_stored - 1)++;
       }
+      if (output_type == 4) {
+        sketch_states(sampled_alpha, 1.0);
+      }
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "da_mcmc_psi", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, loglik, approx_loglik, mode_estimate, approx_model.y,
+      approx_model.H, approx_model.HH, approx_model.engine, sampled_alpha, alphahat_i,
+      Vt_i, Valphahat);
   }
   if (output_type == 2) {
     Vt += Valphahat / (n_iter - n_burnin); // Var[E(alpha)] + E[Var(alpha)]
@@ -1190,9 +1705,9 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
   // get the current values of theta
   arma::vec theta = model.theta;
   // compute the log[p(theta)]
-  double logprior = model.log_prior_pdf(theta);
+  double logprior = profiler::log_prior_pdf(model, theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::vec mode_estimate = initial_mode;
@@ -1215,7 +1730,7 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
   arma::umat indices(nsim_states, n);
   double loglik = model.bsf_filter(nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -1230,10 +1745,14 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
   unsigned int n_values = 0;
   std::normal_distribution<> normal(0.0, 1.0);
   std::uniform_real_distribution<> unif(0.0, 1.0);
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("da_mcmc_bsf", model.engine, normal, unif,
+    theta, logprior, new_value, n_values, loglik, approx_loglik, mode_estimate,
+    approx_model.y, approx_model.H, approx_model.HH, approx_model.engine, sampled_alpha,
+    alphahat_i, Vt_i, Valphahat);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -1245,7 +1764,7 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
     // propose new theta
     arma::vec theta_prop = theta + S * u;
     // compute prior
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
       // update parameters
@@ -1254,9 +1773,9 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
       if (local_approx) {
         // construct the approximate Gaussian model
         mode_estimate = initial_mode;
-        model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
+        model.approximate(approx_model, mode_estimate, max_iter, conv_tol, &gaussian_loglik);
       } else {
-        model.approximate(approx_model, mode_estimate, 0, conv_tol);
+        model.approximate(approx_model, mode_estimate, 0, conv_tol, &gaussian_loglik);
       }
       // compute unnormalized mode-based correction terms
       // log[g(y_t | ^alpha_t) / ~g(y_t | ^alpha_t)]
@@ -1264,8 +1783,6 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
       sum_scales = arma::accu(scales);
       // compute the constant term
       const_term = compute_const_term(model, approx_model);
-      // compute the log-likelihood of the approximate model
-      gaussian_loglik = approx_model.log_likelihood();
       double approx_loglik_prop = gaussian_loglik + const_term + sum_scales;
       
       // stage 1 acceptance probability, used in RAM as well
@@ -1290,7 +1807,7 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
             if (output_type != 3) {
               filter_smoother(alpha, indices);
               w = weights.col(n);
-              if (output_type == 1) {
+              if (output_type != 2) {
                 std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
                 sampled_alpha = alpha.slice(sample(model.engine));
               } else {
@@ -1324,18 +1841,26 @@ void mcmc::da_mcmc_bsf(T model, const bool end_ram, const unsigned int nsim_stat
         theta_storage.col(n_stored) = theta;
         count_storage(n_stored) = 1;
         if (output_type == 1) {
-          alpha_storage.slice(n_stored) = sampled_alpha.t();
+          store_states(n_stored, sampled_alpha.t());
         }
         n_stored++;
         new_value = false;
       } else {
         count_storage(n_stored - 1)++;
       }
+      if (output_type == 4) {
+        sketch_states(sampled_alpha, 1.0);
+      }
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "da_mcmc_bsf", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, loglik, approx_loglik, mode_estimate, approx_model.y,
+      approx_model.H, approx_model.HH, approx_model.engine, sampled_alpha, alphahat_i,
+      Vt_i, Valphahat);
   }
   if (output_type == 2) {
     Vt += Valphahat / (n_iter - n_burnin); // Var[E(alpha)] + E[Var(alpha)]
@@ -1353,15 +1878,15 @@ void mcmc::pm_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
   unsigned int m = model.m;
   unsigned n = model.n;
   // compute the log[p(theta)]
-  double logprior = model.log_prior_pdf(model.theta);
+  double logprior = profiler::log_prior_pdf(model, model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::mat mode_estimate(m, n);
   mgg_ssm approx_model0 = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter);
   if(!arma::is_finite(mode_estimate)) {
-    Rcpp::stop("Approximation did not converge. ");
+    bssm::stop("Approximation did not converge. ");
   }
   // compute the log-likelihood of the gaussian model
   double gaussian_loglik = approx_model0.log_likelihood();
@@ -1373,7 +1898,7 @@ void mcmc::pm_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
   double loglik = model.psi_filter(approx_model0, gaussian_loglik,
     nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -1389,10 +1914,13 @@ void mcmc::pm_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
   std::normal_distribution<> normal(0.0, 1.0);
   std::uniform_real_distribution<> unif(0.0, 1.0);
   arma::vec theta = model.theta;
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("pm_mcmc_psi_nlg", model.engine, normal,
+    unif, theta, logprior, new_value, n_values, model.theta, loglik, mode_estimate,
+    sampled_alpha, alphahat_i, Vt_i, Valphahat);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -1405,7 +1933,7 @@ void mcmc::pm_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
     arma::vec theta_prop = theta + S * u;
     // compute prior
     
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (arma::is_finite(logprior_prop)) {
       // update parameters
@@ -1443,7 +1971,7 @@ void mcmc::pm_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
         if (output_type != 3) {
           filter_smoother(alpha, indices);
           w = weights.col(n);
-          if (output_type == 1) {
+          if (output_type != 2) {
             std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
             sampled_alpha = alpha.slice(sample(model.engine));
           } else {
@@ -1474,18 +2002,25 @@ void mcmc::pm_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
         theta_storage.col(n_stored) = theta;
         count_storage(n_stored) = 1;
         if (output_type == 1) {
-          alpha_storage.slice(n_stored) = sampled_alpha.t();
+          store_states(n_stored, sampled_alpha.t());
         }
         n_stored++;
         new_value = false;
       } else {
         count_storage(n_stored - 1)++;
       }
+      if (output_type == 4) {
+        sketch_states(sampled_alpha, 1.0);
+      }
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "pm_mcmc_psi_nlg", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, model.theta, loglik, mode_estimate, sampled_alpha,
+      alphahat_i, Vt_i, Valphahat);
   }
   if (output_type == 2) {
     Vt += Valphahat / (n_iter - n_burnin); // Var[E(alpha)] + E[Var(alpha)]
@@ -1501,9 +2036,9 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
   unsigned int m = model.m;
   unsigned n = model.n;
   // compute the log[p(theta)]
-  double logprior = model.log_prior_pdf(model.theta);
+  double logprior = profiler::log_prior_pdf(model, model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   
   arma::cube alpha(m, n + 1, nsim_states);
@@ -1511,7 +2046,7 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
   arma::umat indices(nsim_states, n);
   double loglik = model.bsf_filter(nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -1528,10 +2063,13 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
   std::uniform_real_distribution<> unif(0.0, 1.0);
   arma::vec theta = model.theta;
   
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("pm_mcmc_bsf_nlg", model.engine, normal,
+    unif, theta, logprior, new_value, n_values, model.theta, loglik, sampled_alpha,
+    alphahat_i, Vt_i, Valphahat);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -1544,7 +2082,7 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
     arma::vec theta_prop = theta + S * u;
     // compute prior
     
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (arma::is_finite(logprior_prop)) {
       // update parameters
@@ -1568,7 +2106,7 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
         if (output_type != 3) {
           filter_smoother(alpha, indices);
           w = weights.col(n);
-          if (output_type == 1) {
+          if (output_type != 2) {
             std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
             sampled_alpha = alpha.slice(sample(model.engine));
           } else {
@@ -1599,18 +2137,25 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
         theta_storage.col(n_stored) = theta;
         count_storage(n_stored) = 1;
         if (output_type == 1) {
-          alpha_storage.slice(n_stored) = sampled_alpha.t();
+          store_states(n_stored, sampled_alpha.t());
         }
         n_stored++;
         new_value = false;
       } else {
         count_storage(n_stored - 1)++;
       }
+      if (output_type == 4) {
+        sketch_states(sampled_alpha, 1.0);
+      }
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "pm_mcmc_bsf_nlg", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, model.theta, loglik, sampled_alpha, alphahat_i, Vt_i,
+      Valphahat);
   }
   if (output_type == 2) {
     Vt += Valphahat / (n_iter - n_burnin); // Var[E(alpha)] + E[Var(alpha)]
@@ -1619,6 +2164,24 @@ void mcmc::pm_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram,
   acceptance_rate /= (n_iter - n_burnin);
 }
 
+// pseudo-marginal parallel tempering for non-linear Gaussian state space model
+// using bsf-PF, only theta is stored
+void mcmc::pt_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, 
+  const unsigned int nsim_states, const unsigned int n_temps, const unsigned int seed, 
+  const unsigned int n_threads) {
+  
+  pt_mcmc(model, bsf_loglik<nlg_ssm>(model, nsim_states), end_ram, n_temps, seed, 
+    n_threads);
+}
+
+// speculative pseudo-marginal MCMC for non-linear Gaussian state space model
+// using bsf-PF, only theta is stored
+void mcmc::spec_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, 
+  const unsigned int nsim_states, const unsigned int n_threads) {
+  
+  spec_mcmc(model, bsf_loglik<nlg_ssm>(model, nsim_states), end_ram, true, n_threads);
+}
+
 // run delayed acceptance MCMC for non-linear Gaussian state space model
 // using psi-PF
 void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
@@ -1628,15 +2191,15 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
   unsigned int m = model.m;
   unsigned n = model.n;
   // compute the log[p(theta)]
-  double logprior = model.log_prior_pdf(model.theta);
+  double logprior = profiler::log_prior_pdf(model, model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::mat mode_estimate(m, n);
   mgg_ssm approx_model0 = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter);
   if(!arma::is_finite(mode_estimate)) {
-    Rcpp::stop("Approximation did not converge.");
+    bssm::stop("Approximation did not converge.");
   }
   // compute the log-likelihood of the approximate model
   double approx_loglik = approx_model0.log_likelihood();
@@ -1647,7 +2210,7 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
   double loglik = model.psi_filter(approx_model0, approx_loglik,
     nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   approx_loglik += arma::accu(model.scaling_factors(approx_model0, mode_estimate));
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
@@ -1665,10 +2228,13 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
   std::uniform_real_distribution<> unif(0.0, 1.0);
   arma::vec theta = model.theta;
   
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("da_mcmc_psi_nlg", model.engine, normal,
+    unif, theta, logprior, new_value, n_values, model.theta, loglik, approx_loglik,
+    mode_estimate, sampled_alpha, alphahat_i, Vt_i, Valphahat);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -1680,7 +2246,7 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
     // propose new theta
     arma::vec theta_prop = theta + S * u;
     // compute prior
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
       // update parameters
@@ -1718,7 +2284,7 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
               if (output_type != 3) {
                 filter_smoother(alpha, indices);
                 w = weights.col(n);
-                if (output_type == 1) {
+                if (output_type != 2) {
                   std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
                   sampled_alpha = alpha.slice(sample(model.engine));
                 } else {
@@ -1753,18 +2319,25 @@ void mcmc::da_mcmc_psi_nlg(nlg_ssm model, const bool end_ram,
         theta_storage.col(n_stored) = theta;
         count_storage(n_stored) = 1;
         if (output_type == 1) {
-          alpha_storage.slice(n_stored) = sampled_alpha.t();
+          store_states(n_stored, sampled_alpha.t());
         }
         n_stored++;
         new_value = false;
       } else {
         count_storage(n_stored - 1)++;
       }
+      if (output_type == 4) {
+        sketch_states(sampled_alpha, 1.0);
+      }
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "da_mcmc_psi_nlg", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, model.theta, loglik, approx_loglik, mode_estimate,
+      sampled_alpha, alphahat_i, Vt_i, Valphahat);
   }
   if (output_type == 2) {
     Vt += Valphahat / (n_iter - n_burnin); // Var[E(alpha)] + E[Var(alpha)]
@@ -1781,15 +2354,15 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
   unsigned int m = model.m;
   unsigned n = model.n;
   // compute the log[p(theta)]
-  double logprior = model.log_prior_pdf(model.theta);
+  double logprior = profiler::log_prior_pdf(model, model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::mat mode_estimate(m, n);
   mgg_ssm approx_model0 = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter);
   if(!arma::is_finite(mode_estimate)) {
-    Rcpp::stop("Approximation did not converge. ");
+    bssm::stop("Approximation did not converge. ");
   }
   // compute the log-likelihood of the approximate model
   double sum_scales = arma::accu(model.scaling_factors(approx_model0, mode_estimate));
@@ -1800,7 +2373,7 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
   arma::umat indices(nsim_states, n);
   double loglik = model.bsf_filter(nsim_states, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -1817,10 +2390,13 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
   std::uniform_real_distribution<> unif(0.0, 1.0);
   arma::vec theta = model.theta;
   
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("da_mcmc_bsf_nlg", model.engine, normal,
+    unif, theta, logprior, new_value, n_values, model.theta, loglik, approx_loglik,
+    mode_estimate, sampled_alpha, alphahat_i, Vt_i, Valphahat);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -1832,7 +2408,7 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
     // propose new theta
     arma::vec theta_prop = theta + S * u;
     // compute prior
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
       // update parameters
@@ -1874,7 +2450,7 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
               if (output_type != 3) {
                 filter_smoother(alpha, indices);
                 w = weights.col(n);
-                if (output_type == 1) {
+                if (output_type != 2) {
                   std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
                   sampled_alpha = alpha.slice(sample(model.engine));
                 } else {
@@ -1909,18 +2485,25 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
         theta_storage.col(n_stored) = theta;
         count_storage(n_stored) = 1;
         if (output_type == 1) {
-          alpha_storage.slice(n_stored) = sampled_alpha.t();
+          store_states(n_stored, sampled_alpha.t());
         }
         n_stored++;
         new_value = false;
       } else {
         count_storage(n_stored - 1)++;
       }
+      if (output_type == 4) {
+        sketch_states(sampled_alpha, 1.0);
+      }
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "da_mcmc_bsf_nlg", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, model.theta, loglik, approx_loglik, mode_estimate,
+      sampled_alpha, alphahat_i, Vt_i, Valphahat);
   }
   if (output_type == 2) {
     Vt += Valphahat / (n_iter - n_burnin); // Var[E(alpha)] + E[Var(alpha)]
@@ -1929,16 +2512,22 @@ void mcmc::da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int
   acceptance_rate /= (n_iter - n_burnin);
 }
 
+template void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
+  const unsigned int nsim_states, const unsigned int L);
+template void mcmc::pm_mcmc_bsf_sde(msde_ssm model, const bool end_ram,
+  const unsigned int nsim_states, const unsigned int L);
+
 // PMCMC for SDE model
-void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
+template<class T>
+void mcmc::pm_mcmc_bsf_sde(T model, const bool end_ram,
   const unsigned int nsim_states, const unsigned int L) {
   
-  unsigned int m = 1;
+  unsigned int m = model.m;
   unsigned n = model.n;
   // compute the log[p(theta)]
-  double logprior = model.log_prior_pdf(model.theta);
+  double logprior = profiler::log_prior_pdf(model, model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   
   arma::cube alpha(m, n + 1, nsim_states);
@@ -1946,7 +2535,7 @@ void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
   arma::umat indices(nsim_states, n);
   double loglik = model.bsf_filter(nsim_states, L, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -1964,10 +2553,13 @@ void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
   std::uniform_real_distribution<> unif(0.0, 1.0);
   arma::vec theta = model.theta;
   
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("pm_mcmc_bsf_sde", model.engine, normal,
+    unif, theta, logprior, new_value, n_values, model.theta, model.coarse_engine,
+    loglik, sampled_alpha, alphahat_i, Vt_i, Valphahat);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 4 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -1980,7 +2572,7 @@ void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
     arma::vec theta_prop = theta + S * u;
     // compute prior
     
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (arma::is_finite(logprior_prop)) {
       // update parameters
@@ -2003,7 +2595,7 @@ void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
         if (output_type != 3) {
           filter_smoother(alpha, indices);
           w = weights.col(n);
-          if (output_type == 1) {
+          if (output_type != 2) {
             std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
             sampled_alpha = alpha.slice(sample(model.engine));
           } else {
@@ -2034,18 +2626,25 @@ void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
         theta_storage.col(n_stored) = theta;
         count_storage(n_stored) = 1;
         if (output_type == 1) {
-          alpha_storage.slice(n_stored) = sampled_alpha.t();
+          store_states(n_stored, sampled_alpha.t());
         }
         n_stored++;
         new_value = false;
       } else {
         count_storage(n_stored - 1)++;
       }
+      if (output_type == 4) {
+        sketch_states(sampled_alpha, 1.0);
+      }
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "pm_mcmc_bsf_sde", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, model.theta, model.coarse_engine, loglik, sampled_alpha,
+      alphahat_i, Vt_i, Valphahat);
   }
   if (output_type == 2) {
     Vt += Valphahat / (n_iter - n_burnin); // Var[E(alpha)] + E[Var(alpha)]
@@ -2054,17 +2653,25 @@ void mcmc::pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
   acceptance_rate /= (n_iter - n_burnin);
 }
 
+template void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
+  const unsigned int nsim_states, const unsigned int L_c,
+  const unsigned int L_f, const bool target_full);
+template void mcmc::da_mcmc_bsf_sde(msde_ssm model, const bool end_ram,
+  const unsigned int nsim_states, const unsigned int L_c,
+  const unsigned int L_f, const bool target_full);
+
 // run delayed acceptance MCMC for SDE model using BSF
-void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
+template<class T>
+void mcmc::da_mcmc_bsf_sde(T model, const bool end_ram,
   const unsigned int nsim_states, const unsigned int L_c,
   const unsigned int L_f, const bool target_full) {
   
-  unsigned int m = 1;
+  unsigned int m = model.m;
   unsigned n = model.n;
   // compute the log[p(theta)]
-  double logprior = model.log_prior_pdf(model.theta);
+  double logprior = profiler::log_prior_pdf(model, model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   arma::cube alpha(m, n + 1, nsim_states);
   arma::mat weights(nsim_states, n + 1);
@@ -2074,7 +2681,7 @@ void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
   double loglik_f = 0.0;
   loglik_f = model.bsf_filter(nsim_states, L_f, alpha, weights, indices);
   if (!std::isfinite(loglik_f))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   filter_smoother(alpha, indices);
   arma::vec w = weights.col(n);
   std::discrete_distribution<unsigned int> sample0(w.begin(), w.end());
@@ -2091,10 +2698,13 @@ void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
   std::uniform_real_distribution<> unif(0.0, 1.0);
   arma::vec theta = model.theta;
   
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("da_mcmc_bsf_sde", model.engine, normal,
+    unif, theta, logprior, new_value, n_values, model.theta, model.coarse_engine,
+    loglik_c, loglik_f, sampled_alpha, alphahat_i, Vt_i, Valphahat);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -2106,7 +2716,7 @@ void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
     // propose new theta
     arma::vec theta_prop = theta + S * u;
     // compute prior
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
       // update parameters
@@ -2147,7 +2757,7 @@ void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
               if (output_type != 3) {
                 filter_smoother(alpha, indices);
                 w = weights.col(n);
-                if (output_type == 1) {
+                if (output_type != 2) {
                   std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
                   sampled_alpha = alpha.slice(sample(model.engine));
                 } else {
@@ -2186,18 +2796,25 @@ void mcmc::da_mcmc_bsf_sde(sde_ssm model, const bool end_ram,
         theta_storage.col(n_stored) = theta;
         count_storage(n_stored) = 1;
         if (output_type == 1) {
-          alpha_storage.slice(n_stored) = sampled_alpha.t();
+          store_states(n_stored, sampled_alpha.t());
         }
         n_stored++;
         new_value = false;
       } else {
         count_storage(n_stored - 1)++;
       }
+      if (output_type == 4) {
+        sketch_states(sampled_alpha, 1.0);
+      }
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "da_mcmc_bsf_sde", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, model.theta, model.coarse_engine, loglik_c, loglik_f,
+      sampled_alpha, alphahat_i, Vt_i, Valphahat);
   }
   if (output_type == 2) {
     Vt += Valphahat / (n_iter - n_burnin); // Var[E(alpha)] + E[Var(alpha)]
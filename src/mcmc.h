@@ -1,17 +1,58 @@
 #ifndef MCMC_H
 #define MCMC_H
 
+#include <memory>
+#include <random>
+#include <vector>
 #include "bssm.h"
+#include "packed_states.h"
+#include "quantile_sketch.h"
+#include "profiler.h"
 
 class nlg_ssm;
 class lgg_ssm;
 class sde_ssm;
+class output_sink;
+class checkpoint;
 
 class mcmc {
   
 protected:
   
   virtual void trim_storage();
+  // R API can only be used from the master thread
+  void check_interrupt() const;
+  // combine the storages of independent chains
+  void combine_chains(const std::vector<mcmc>& chains);
+  // store the states of sample i to alpha_storage, packed_alpha or the output file
+  void store_states(const unsigned int i, const arma::mat& alpha);
+  // add the m x (n + 1) states with weight to the quantile sketches, can be
+  // called by multiple threads
+  void sketch_states(const arma::mat& alpha, const double weight);
+  // add the slices of alpha, the weights are normalized to sum to weight
+  void sketch_states(const arma::cube& alpha, const arma::vec& weights, 
+    const double weight);
+  // sample states of the stored samples start, ..., end to alpha, the samples
+  // are split into models.size() pieces sampled in parallel using models[i]
+  template <class T>
+  void state_posterior(std::vector<T>& models, const unsigned int start, 
+    const unsigned int end, arma::cube& alpha);
+  // resume the sampling loop from the checkpoint and save the state of the
+  // loop to the checkpoint, defined in checkpoint.h
+  template <class... Args>
+  unsigned int resume_checkpoint(const std::string& tag, Args&... state);
+  template <class... Args>
+  void save_checkpoint(unsigned int i, const std::string& tag, Args&... state);
+  // write or read the samples stored so far
+  virtual void sync_storage(checkpoint& file);
+  // settings which must match when resuming from the checkpoint
+  arma::uvec checkpoint_info() const;
+  // one iteration of mcmc_gaussian, also used by mcmc_gaussian_chains
+  template<class T>
+  void gaussian_step(T& model, const unsigned int i, const bool end_ram,
+    std::normal_distribution<>& normal, std::uniform_real_distribution<>& unif,
+    arma::vec& theta, double& logprior, bool& new_value, unsigned int& n_values,
+    double& loglik);
   
   const unsigned int n_iter;
   const unsigned int n_burnin;
@@ -21,6 +62,11 @@ protected:
   const double target_acceptance;
   const double gamma;
   unsigned int n_stored;
+  // if not NULL, the sampled states are written to a file
+  std::shared_ptr<output_sink> sink;
+  // if not NULL, the state of the sampler is saved to a checkpoint file
+  std::shared_ptr<checkpoint> ckpt;
+  unsigned int checkpoint_seed;
   
 public:
   
@@ -28,7 +74,16 @@ public:
   mcmc(const unsigned int n_iter, const unsigned int n_burnin, 
     const unsigned int n_thin, const unsigned int n, const unsigned int m,
     const double target_acceptance, const double gamma, const arma::mat& S, 
-    const unsigned int output_type = 1);
+    const unsigned int output_type = 1, const std::string& output_file = "",
+    const unsigned int precision = 1);
+  
+  // write the remaining samples to the output file
+  virtual void close_output();
+  
+  // save checkpoints every interval iterations, and resume from the 
+  // checkpoint if the file exists
+  void set_checkpoint(const std::string& file_name, const unsigned int interval, 
+    const unsigned int seed);
   
   // sample states given theta
   template <class T>
@@ -41,6 +96,46 @@ public:
   // gaussian mcmc
   template<class T>
   void mcmc_gaussian(T model, const bool end_ram);
+  // multiple independent chains run in parallel, stopped early once split-R-hat
+  // is below max_rhat and bulk-ESS above min_ess for all parameters, checked
+  // every check_interval iterations after the burn-in
+  template<class T>
+  void mcmc_gaussian_chains(T model, const bool end_ram, const unsigned int seed,
+    const unsigned int n_chains, const bool shared_warmup, const unsigned int n_threads,
+    const double max_rhat = arma::datum::inf, const double min_ess = 0.0,
+    const unsigned int check_interval = 1000);
+  
+  // split-R-hat and bulk-ESS of theta based on the samples of the chains so far
+  void chain_diagnostics(const std::vector<mcmc>& chains);
+  
+  // parallel tempering with n_temps replicas, defined in pt_mcmc.h
+  template<class T, class F>
+  void pt_mcmc(T model, F loglik_fn, const bool end_ram, const unsigned int n_temps,
+    const unsigned int seed, const unsigned int n_threads);
+  template<class T>
+  void pt_mcmc_gaussian(T model, const bool end_ram, const unsigned int n_temps,
+    const unsigned int seed, const unsigned int n_threads);
+  template<class T>
+  void pt_mcmc_pm(T model, const bool end_ram, const unsigned int nsim_states, 
+    const unsigned int simulation_method, const bool local_approx, 
+    const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol,
+    const unsigned int n_temps, const unsigned int seed, const unsigned int n_threads);
+  void pt_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int nsim_states,
+    const unsigned int n_temps, const unsigned int seed, const unsigned int n_threads);
+  
+  // speculative random walk Metropolis using n_threads evaluations at a time, 
+  // defined in spec_mcmc.h
+  template<class T, class F>
+  void spec_mcmc(T model, F loglik_fn, const bool end_ram, const bool reseed,
+    const unsigned int n_threads);
+  template<class T>
+  void spec_mcmc_gaussian(T model, const bool end_ram, const unsigned int n_threads);
+  template<class T>
+  void spec_mcmc_pm(T model, const bool end_ram, const unsigned int nsim_states, 
+    const unsigned int simulation_method, const arma::vec& initial_mode, 
+    const unsigned int max_iter, const double conv_tol, const unsigned int n_threads);
+  void spec_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int nsim_states,
+    const unsigned int n_threads);
   
   // pseudo-marginal mcmc
   template<class T>
@@ -80,21 +175,35 @@ public:
   void da_mcmc_bsf_nlg(nlg_ssm model, const bool end_ram, const unsigned int nsim_states,
     const unsigned int max_iter, const double conv_tol, const unsigned int iekf_iter);
   
-  // sde models
-  void pm_mcmc_bsf_sde(sde_ssm model, const bool end_ram, const unsigned int nsim_states,
+  // sde models, univariate sde_ssm or multivariate msde_ssm
+  template<class T>
+  void pm_mcmc_bsf_sde(T model, const bool end_ram, const unsigned int nsim_states,
     const unsigned int L);
-  void da_mcmc_bsf_sde(sde_ssm model, const bool end_ram, const unsigned int nsim_states,
+  template<class T>
+  void da_mcmc_bsf_sde(T model, const bool end_ram, const unsigned int nsim_states,
     const unsigned int L_c, const unsigned int L_f, const bool target_full = false);
   
   arma::vec posterior_storage;
   arma::mat theta_storage;
   arma::uvec count_storage;
+  arma::uvec chain_storage;
   arma::cube alpha_storage;
+  // samples of states with reduced precision, used instead of alpha_storage
+  // if precision > 1
+  packed_states packed_alpha;
+  // streaming quantiles of the m x (n + 1) states if output_type == 4
+  quantile_sketch alpha_sketch;
   arma::mat alphahat;
   arma::cube Vt;
   arma::mat S;
   double acceptance_rate;
   unsigned int output_type;
+  // last iteration of the run, smaller than n_iter if the chains were stopped early
+  unsigned int stop_iter;
+  arma::vec rhat;
+  arma::vec ess;
+  arma::vec beta;
+  arma::vec swap_rate;
   
 };
 
@@ -1,6 +1,8 @@
 #include "mgg_ssm.h"
 #include "psd_chol.h"
+#include "profiler.h"
 
+#ifndef BSSM_STANDALONE
 // General constructor of mgg_ssm object from Rcpp::List
 // with parameter indices
 mgg_ssm::mgg_ssm(const Rcpp::List& model, const unsigned int seed,
@@ -29,6 +31,7 @@ mgg_ssm::mgg_ssm(const Rcpp::List& model, const unsigned int seed,
   compute_HH();
   compute_RR();
 }
+#endif
 
 // General constructor of mgg_ssm object for approximating models
 mgg_ssm::mgg_ssm(const arma::mat& y, const arma::cube& Z, const arma::cube& H,
@@ -140,6 +143,7 @@ void mgg_ssm::compute_xbeta(){
 }
 
 double mgg_ssm::log_likelihood() const {
+  profiler::timer timer(profiler::kalman_filter);
   
   double logLik = 0;
   arma::vec at = a1;
@@ -200,6 +204,7 @@ double mgg_ssm::log_likelihood() const {
 
 // Kalman smoother
 void mgg_ssm::smoother(arma::mat& at, arma::cube& Pt) const {
+  profiler::timer timer(profiler::kalman_smoother);
   
   arma::mat y_tmp = y;
   if(xreg.n_cols > 0) {
@@ -287,6 +292,7 @@ void mgg_ssm::smoother(arma::mat& at, arma::cube& Pt) const {
  * which are needed in simulation smoother and Laplace approximation
  */
 arma::mat mgg_ssm::fast_smoother() const {
+  profiler::timer timer(profiler::kalman_smoother);
   arma::mat y_tmp = y;
   if(xreg.n_cols > 0) {
     y_tmp -= xbeta.t();
@@ -385,6 +391,7 @@ arma::mat mgg_ssm::fast_smoother() const {
 // smoother which returns also cov(alpha_t, alpha_t-1)
 // used in psi particle filter
 void mgg_ssm::smoother_ccov(arma::mat& at, arma::cube& Pt, arma::cube& ccov) const {
+  profiler::timer timer(profiler::kalman_smoother);
   
   arma::mat y_tmp = y;
   if(xreg.n_cols > 0) {
@@ -482,6 +489,7 @@ void mgg_ssm::smoother_ccov(arma::mat& at, arma::cube& Pt, arma::cube& ccov) con
 
 double mgg_ssm::filter(arma::mat& at, arma::mat& att,
   arma::cube& Pt, arma::cube& Ptt) const {
+  profiler::timer timer(profiler::kalman_filter);
   
   arma::mat y_tmp = y;
   if(xreg.n_cols > 0) {
@@ -560,6 +568,7 @@ double mgg_ssm::filter(arma::mat& at, arma::mat& att,
 
 
 arma::cube mgg_ssm::simulate_states() {
+  profiler::timer timer(profiler::simulation_smoother);
   
   arma::mat L_P1 = psd_chol(P1);
   arma::cube asim(m, n + 1, 1);
@@ -0,0 +1,60 @@
+#include <algorithm>
+#include "mode_cache.h"
+
+mode_cache::mode_cache(const unsigned int capacity) : capacity(capacity), clock(0) {
+}
+
+int mode_cache::find(const arma::vec& theta, bool& exact) {
+
+  exact = false;
+  if (thetas.empty()) return -1;
+
+  // scale the dimensions by the standard deviations of the cached thetas
+  arma::vec scale(theta.n_elem, arma::fill::ones);
+  if (thetas.size() > 1) {
+    arma::mat x(theta.n_elem, thetas.size());
+    for (unsigned int i = 0; i < thetas.size(); i++) {
+      x.col(i) = thetas[i];
+    }
+    scale = arma::stddev(x, 0, 1);
+    scale(arma::find(scale <= 0)).ones();
+  }
+  int nearest = 0;
+  double min_dist = arma::datum::inf;
+  for (unsigned int i = 0; i < thetas.size(); i++) {
+    double dist = arma::accu(arma::square((thetas[i] - theta) / scale));
+    if (dist < min_dist) {
+      min_dist = dist;
+      nearest = i;
+    }
+  }
+  exact = arma::all(thetas[nearest] == theta);
+  last_used[nearest] = ++clock;
+  return nearest;
+}
+
+void mode_cache::insert(const arma::vec& theta, const arma::mat& mode,
+  const arma::mat& approx) {
+
+  if (capacity == 0) return;
+
+  unsigned int i = 0;
+  for (; i < thetas.size(); i++) {
+    if (arma::all(thetas[i] == theta)) break;
+  }
+  if (i == thetas.size()) {
+    if (thetas.size() < capacity) {
+      thetas.push_back(theta);
+      modes.push_back(mode);
+      approxs.push_back(approx);
+      last_used.push_back(++clock);
+      return;
+    }
+    // replace the least recently used entry
+    i = std::min_element(last_used.begin(), last_used.end()) - last_used.begin();
+    thetas[i] = theta;
+  }
+  modes[i] = mode;
+  approxs[i] = approx;
+  last_used[i] = ++clock;
+}
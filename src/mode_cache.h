@@ -0,0 +1,43 @@
+// bounded cache of the converged modes of the Laplace approximations keyed by
+// theta, so that the mode search can be started from the mode of the nearest
+// previously visited theta, or skipped altogether when theta is in the cache
+//
+// the distances between the thetas are scaled by the standard deviations of
+// the cached thetas, and the least recently used entry is replaced when the
+// cache is full. Along with the mode, an entry can store other quantities
+// of the approximation such as the pseudo-observations.
+
+#ifndef MODE_CACHE_H
+#define MODE_CACHE_H
+
+#include <vector>
+#include "bssm.h"
+
+class mode_cache {
+
+public:
+
+  mode_cache(const unsigned int capacity = 0);
+
+  // index of the entry nearest to theta, or -1 if the cache is empty
+  // exact is set to true if the theta of the entry equals theta
+  int find(const arma::vec& theta, bool& exact);
+  // add a new entry, or replace the stored values if theta is already cached
+  void insert(const arma::vec& theta, const arma::mat& mode,
+    const arma::mat& approx = arma::mat());
+
+  const arma::mat& mode(const unsigned int i) const { return modes[i]; }
+  const arma::mat& approx(const unsigned int i) const { return approxs[i]; }
+
+  unsigned int capacity;
+
+private:
+
+  std::vector<arma::vec> thetas;
+  std::vector<arma::mat> modes;
+  std::vector<arma::mat> approxs;
+  std::vector<unsigned int> last_used;
+  unsigned int clock;
+};
+
+#endif
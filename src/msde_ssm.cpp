@@ -0,0 +1,163 @@
+#include "msde_ssm.h"
+#include "sample.h"
+#include "profiler.h"
+
+msde_ssm::msde_ssm(const arma::mat& y, const arma::vec& theta,
+  const arma::vec& x0, const unsigned int seed,
+  mdrift_fnPtr drift_, mdiffusion_fnPtr diffusion_, mddiffusion_fnPtr ddiffusion_,
+  mprior_fnPtr log_prior_pdf_, mobs_fnPtr log_obs_density_) :
+  y(y), theta(theta), x0(x0), n(y.n_cols), m(x0.n_elem),
+  k(diffusion_(x0, theta).n_cols),
+  seed(seed), coarse_engine(seed), engine(seed + 1),
+  drift(drift_), diffusion(diffusion_), ddiffusion(ddiffusion_),
+  drift_batch_fn(nullptr), diffusion_batch_fn(nullptr),
+  log_prior_pdf(log_prior_pdf_), log_obs_density(log_obs_density_) {
+}
+
+void msde_ssm::drift_cols(const arma::mat& X, arma::mat& result) const {
+  if (drift_batch_fn) {
+    drift_batch_fn(X, theta, result);
+  } else {
+    for (unsigned int i = 0; i < X.n_cols; i++) {
+      result.col(i) = drift(X.col(i), theta);
+    }
+  }
+}
+
+void msde_ssm::diffusion_cols(const arma::mat& X, arma::cube& result) const {
+  if (diffusion_batch_fn) {
+    diffusion_batch_fn(X, theta, result);
+  } else {
+    for (unsigned int i = 0; i < X.n_cols; i++) {
+      result.slice(i) = diffusion(X.col(i), theta);
+    }
+  }
+}
+
+#ifndef BSSM_STANDALONE
+void msde_ssm::set_batch_fns(SEXP drift_batch, SEXP diffusion_batch) {
+  if (!Rf_isNull(drift_batch)) {
+    Rcpp::XPtr<mdrift_batch_fnPtr> xpfun_drift(drift_batch);
+    drift_batch_fn = *xpfun_drift;
+  }
+  if (!Rf_isNull(diffusion_batch)) {
+    Rcpp::XPtr<mdiffusion_batch_fnPtr> xpfun_diffusion(diffusion_batch);
+    diffusion_batch_fn = *xpfun_diffusion;
+  }
+}
+#endif
+
+// The Brownian increments are drawn particle by particle in the same order as
+// in milstein() of sde_ssm, so that the univariate case gives identical paths.
+// Drift and diffusion are then evaluated for all particles at once per step.
+// With commutative noise the Milstein correction only needs the products of
+// the increments, 0.5 * sum_j (L^j sigma) (dW_j dW - dt e_j), where
+// L^j sigma = sum_l sigma_lj d(sigma) / dx_l, so no Levy areas are simulated
+void msde_ssm::propagate(arma::mat& X, const unsigned int L,
+  sitmo::prng_engine& eng) const {
+
+  unsigned int n_steps = std::pow(2, L);
+  double dt = 1.0 / n_steps;
+  std::normal_distribution<> normal(0.0, std::sqrt(dt));
+  // k x n_steps x N
+  arma::cube dW(k, n_steps, X.n_cols);
+  for (unsigned int j = 0; j < dW.n_elem; j++) {
+    dW(j) = normal(eng);
+  }
+  arma::mat mu(m, X.n_cols);
+  arma::cube sigma(m, k, X.n_cols);
+
+  for (unsigned int s = 0; s < n_steps; s++) {
+    drift_cols(X, mu);
+    diffusion_cols(X, sigma);
+    for (unsigned int i = 0; i < X.n_cols; i++) {
+      arma::vec dW_i = dW.slice(i).col(s);
+      if (ddiffusion) {
+        // derivatives at the state before the update
+        arma::cube dsigma = ddiffusion(X.col(i), theta);
+        for (unsigned int j = 0; j < k; j++) {
+          arma::mat L_sigma(m, k, arma::fill::zeros);
+          for (unsigned int l = 0; l < m; l++) {
+            L_sigma += sigma(l, j, i) * dsigma.slice(l);
+          }
+          arma::vec dWdW = dW_i(j) * dW_i;
+          dWdW(j) -= dt;
+          X.col(i) += 0.5 * L_sigma * dWdW;
+        }
+      }
+      X.col(i) += mu.col(i) * dt + sigma.slice(i) * dW_i;
+    }
+  }
+}
+
+double msde_ssm::bsf_filter(const unsigned int nsim, const unsigned int L,
+  arma::cube& alpha, arma::mat& weights, arma::umat& indices) {
+  profiler::timer timer(profiler::bsf_filter);
+  // alpha is m x (n + 1) x nsim, X contains the states of time t for all particles
+  arma::mat X(m, nsim);
+  X.each_col() = x0;
+  propagate(X, L, coarse_engine);
+  for (unsigned int i = 0; i < nsim; i++) {
+    alpha.slice(i).col(0) = X.col(i);
+  }
+
+  std::uniform_real_distribution<> unif(0.0, 1.0);
+  arma::vec normalized_weights(nsim);
+  double loglik = 0.0;
+
+  arma::uvec obs_y = arma::find_finite(y.col(0));
+  if(obs_y.n_elem > 0) {
+    weights.col(0) = log_obs_density(y.col(0), X, theta);
+    double max_weight = weights.col(0).max();
+    weights.col(0) = arma::exp(weights.col(0) - max_weight);
+    double sum_weights = arma::accu(weights.col(0));
+
+    if(sum_weights > 0.0){
+      normalized_weights = weights.col(0) / sum_weights;
+    } else {
+      return -std::numeric_limits<double>::infinity();
+    }
+    loglik = max_weight + std::log(sum_weights / nsim);
+  } else {
+    weights.col(0).ones();
+    normalized_weights.fill(1.0 / nsim);
+  }
+  for (unsigned int t = 0; t < n; t++) {
+
+    arma::vec r(nsim);
+    for (unsigned int i = 0; i < nsim; i++) {
+      r(i) = unif(engine);
+    }
+
+    indices.col(t) = stratified_sample(normalized_weights, r, nsim);
+
+    for (unsigned int i = 0; i < nsim; i++) {
+      X.col(i) = alpha.slice(indices(i, t)).col(t);
+    }
+    propagate(X, L, coarse_engine);
+    for (unsigned int i = 0; i < nsim; i++) {
+      alpha.slice(i).col(t + 1) = X.col(i);
+    }
+
+    if (t < (n - 1)) {
+      obs_y = arma::find_finite(y.col(t + 1));
+    }
+    if ((t < (n - 1)) && obs_y.n_elem > 0) {
+      weights.col(t + 1) = log_obs_density(y.col(t + 1), X, theta);
+
+      double max_weight = weights.col(t + 1).max();
+      weights.col(t + 1) = arma::exp(weights.col(t + 1) - max_weight);
+      double sum_weights = arma::accu(weights.col(t + 1));
+      if(sum_weights > 0.0){
+        normalized_weights = weights.col(t + 1) / sum_weights;
+      } else {
+        return -std::numeric_limits<double>::infinity();
+      }
+      loglik += max_weight + std::log(sum_weights / nsim);
+    } else {
+      weights.col(t + 1).ones();
+      normalized_weights.fill(1.0/nsim);
+    }
+  }
+  return loglik;
+}
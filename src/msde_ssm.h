@@ -0,0 +1,92 @@
+// multivariate state space model with continuous SDE dynamics
+// dx_t = mu(x_t, theta) dt + sigma(x_t, theta) dW_t, where x_t is m-dimensional
+// and W_t is k-dimensional Brownian motion, observed at integer times
+
+#ifndef MSDE_SSM_H
+#define MSDE_SSM_H
+
+#include <sitmo.h>
+#include "bssm.h"
+
+// typedef for a pointer of drift function returning m-vector
+typedef arma::vec (*mdrift_fnPtr)(const arma::vec& x, const arma::vec& theta);
+// typedef for a pointer of diffusion function returning m x k matrix
+typedef arma::mat (*mdiffusion_fnPtr)(const arma::vec& x, const arma::vec& theta);
+// typedef for a pointer of derivatives of the diffusion function, returning
+// m x k x m cube with the partial derivatives with respect to x_l in slice l
+typedef arma::cube (*mddiffusion_fnPtr)(const arma::vec& x, const arma::vec& theta);
+// typedefs for pointers of batched drift and diffusion functions, which evaluate
+// the functions at all columns (particles) of the m x N matrix X at once and write
+// the values to the preallocated m x N matrix or m x k x N cube result
+typedef void (*mdrift_batch_fnPtr)(const arma::mat& X, const arma::vec& theta,
+  arma::mat& result);
+typedef void (*mdiffusion_batch_fnPtr)(const arma::mat& X, const arma::vec& theta,
+  arma::cube& result);
+// typedef for a pointer of log-prior function
+typedef double (*mprior_fnPtr)(const arma::vec& theta);
+// typedef for a pointer of log-density of y_t given the states of all particles
+// (columns of the m x N matrix alpha), returning N-vector
+typedef arma::vec (*mobs_fnPtr)(const arma::vec& y,
+  const arma::mat& alpha, const arma::vec& theta);
+
+class msde_ssm {
+
+public:
+
+  msde_ssm(const arma::mat& y, const arma::vec& theta,
+    const arma::vec& x0, const unsigned int seed,
+    mdrift_fnPtr drift_, mdiffusion_fnPtr diffusion_,
+    mddiffusion_fnPtr ddiffusion_, mprior_fnPtr log_prior_pdf_,
+    mobs_fnPtr log_obs_density_);
+
+  // values of drift and diffusion at the columns of X, using the batched
+  // functions if available
+  void drift_cols(const arma::mat& X, arma::mat& result) const;
+  void diffusion_cols(const arma::mat& X, arma::cube& result) const;
+
+#ifndef BSSM_STANDALONE
+  // set the batched functions given as external pointers (or NULL)
+  void set_batch_fns(SEXP drift_batch, SEXP diffusion_batch);
+#endif
+
+  // advance the states X (m x N) over a unit time interval using 2^L steps of
+  // the Milstein scheme for commutative noise if ddiffusion is given, and of
+  // the Euler-Maruyama scheme otherwise
+  void propagate(arma::mat& X, const unsigned int L, sitmo::prng_engine& eng) const;
+
+  // bootstrap filter
+  double bsf_filter(const unsigned int nsim, const unsigned int L,
+    arma::cube& alpha, arma::mat& weights, arma::umat& indices);
+
+  // p x n observations
+  arma::mat y;
+  // Parameter vector used in _all_ functions
+  arma::vec theta;
+
+  const arma::vec x0;
+  const unsigned int n;
+  const unsigned int m;
+  // dimension of the Brownian motion
+  const unsigned int k;
+  unsigned int seed;
+  // PRNG used for simulating Brownian motion on coarse scale
+  sitmo::prng_engine coarse_engine;
+  // PRNG use for everything else
+  sitmo::prng_engine engine;
+
+  mdrift_fnPtr drift;
+  mdiffusion_fnPtr diffusion;
+  // null for Euler-Maruyama scheme
+  mddiffusion_fnPtr ddiffusion;
+  // optional batched versions of drift and diffusion (null if not given)
+  mdrift_batch_fnPtr drift_batch_fn;
+  mdiffusion_batch_fnPtr diffusion_batch_fn;
+
+  //prior log-pdf
+  mprior_fnPtr log_prior_pdf;
+  //log-pdf for observational level
+  mobs_fnPtr log_obs_density;
+};
+
+
+#endif
@@ -1,14 +1,17 @@
 #ifdef _OPENMP
 #include <omp.h>
 #endif
+#include <exception>
 #include <sitmo.h>
-#include <ramcmc.h>
+#include "ram.h"
 #include "nlg_amcmc.h"
 #include "nlg_ssm.h"
 
 #include "rep_mat.h"
 #include "filter_smoother.h"
 #include "summary.h"
+#include "block_queue.h"
+#include "checkpoint.h"
 
 nlg_amcmc::nlg_amcmc(const unsigned int n_iter, 
   const unsigned int n_burnin, const unsigned int n_thin, const unsigned int n, 
@@ -40,6 +43,16 @@ void nlg_amcmc::trim_storage() {
   }
 }
 
+void nlg_amcmc::sync_storage(checkpoint& file) {
+  mcmc::sync_storage(file);
+  file.sync_head(approx_loglik_storage, n_stored);
+  file.sync_head(prior_storage, n_stored);
+  if (store_modes) {
+    file.sync_head(scales_storage, n_stored);
+    file.sync_slices(mode_storage, n_stored);
+  }
+}
+
 void nlg_amcmc::expand() {
   
   //trim extras first just in case
@@ -89,25 +102,26 @@ void nlg_amcmc::expand() {
 // non-linear Gaussian state space model
 
 void nlg_amcmc::approx_mcmc(nlg_ssm model, const unsigned int max_iter, 
-  const double conv_tol, const bool end_ram, const unsigned int iekf_iter) {
+  const double conv_tol, const bool end_ram, const unsigned int iekf_iter,
+  block_queue* queue) {
   
   unsigned int m = model.m;
   unsigned n = model.n;
   
-  double logprior = model.log_prior_pdf(model.theta);
+  double logprior = profiler::log_prior_pdf(model, model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   arma::mat mode_estimate(m, n);
   mgg_ssm approx_model0 = model.approximate(mode_estimate, max_iter, conv_tol, iekf_iter);
   if (!arma::is_finite(mode_estimate)) {
-    Rcpp::stop("Approximation based on initial theta failed.");
+    bssm::stop("Approximation based on initial theta failed.");
   }
   double sum_scales = arma::accu(model.scaling_factors(approx_model0, mode_estimate));
   // compute the log-likelihood of the approximate model
   double loglik = approx_model0.log_likelihood() + sum_scales;
   if (!arma::is_finite(loglik)) {
-    Rcpp::stop("Initial approximate likelihood is not finite.");
+    bssm::stop("Initial approximate likelihood is not finite.");
   }
   double acceptance_prob = 0.0;
   std::normal_distribution<> normal(0.0, 1.0);
@@ -117,9 +131,12 @@ void nlg_amcmc::approx_mcmc(nlg_ssm model, const unsigned int max_iter,
   bool new_value = true;
   unsigned int n_values = 0;
   
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("approx_mcmc_nlg", model.engine, normal,
+    unif, theta, logprior, new_value, n_values, model.theta, loglik, sum_scales,
+    mode_estimate);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -131,7 +148,7 @@ void nlg_amcmc::approx_mcmc(nlg_ssm model, const unsigned int max_iter,
     // propose new theta
     arma::vec theta_prop = theta + S * u;
     // compute prior
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
       
@@ -187,28 +204,42 @@ void nlg_amcmc::approx_mcmc(nlg_ssm model, const unsigned int max_iter,
         }
         n_stored++;
         new_value = false;
+        // previous block is now closed and can be corrected
+        if (queue != NULL && n_stored > 1) {
+          queue->push(n_stored - 2);
+        }
       } else {
         count_storage(n_stored - 1)++;
       }
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "approx_mcmc_nlg", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, model.theta, loglik, sum_scales, mode_estimate);
   }
   
-  trim_storage();
+  if (queue != NULL) {
+    // storage is trimmed by the caller once all the blocks are corrected
+    if (n_stored > 0) {
+      queue->push(n_stored - 1);
+    }
+  } else {
+    trim_storage();
+  }
   acceptance_rate /= (n_iter - n_burnin);
 }
 
 void nlg_amcmc::ekf_mcmc(nlg_ssm model, const bool end_ram, const unsigned int iekf_iter) {
   
-  double logprior = model.log_prior_pdf(model.theta);
+  double logprior = profiler::log_prior_pdf(model, model.theta);
   
   // compute the log-likelihood
   double loglik = model.ekf_loglik(iekf_iter);
   if (!arma::is_finite(loglik)) {
-    Rcpp::stop("Initial approximate likelihood is not finite.");
+    bssm::stop("Initial approximate likelihood is not finite.");
   }
   double acceptance_prob = 0.0;
   std::normal_distribution<> normal(0.0, 1.0);
@@ -218,9 +249,11 @@ void nlg_amcmc::ekf_mcmc(nlg_ssm model, const bool end_ram, const unsigned int i
   bool new_value = true;
   unsigned int n_values = 0;
   
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("ekf_mcmc_nlg", model.engine, normal, unif,
+    theta, logprior, new_value, n_values, model.theta, loglik);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -232,7 +265,7 @@ void nlg_amcmc::ekf_mcmc(nlg_ssm model, const bool end_ram, const unsigned int i
     // propose new theta
     arma::vec theta_prop = theta + S * u;
     // compute prior
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
       // update parameters
@@ -275,70 +308,39 @@ void nlg_amcmc::ekf_mcmc(nlg_ssm model, const bool end_ram, const unsigned int i
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "ekf_mcmc_nlg", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, model.theta, loglik);
   }
   
   trim_storage();
   acceptance_rate /= (n_iter - n_burnin);
 }
 
-void nlg_amcmc::is_correction_bsf(nlg_ssm model, const unsigned int nsim_states, 
-  const unsigned int is_type, const unsigned int n_threads) {
-  
-  arma::cube Valpha(model.m, model.m, model.n + 1, arma::fill::zeros);
-  double sum_w = 0.0;
+void nlg_amcmc::update_summary(const arma::mat& alphahat_i, const arma::cube& Vt_i, 
+  const unsigned int i, arma::cube& Valpha, double& sum_w) {
   
 #ifdef _OPENMP
-#pragma omp parallel num_threads(n_threads) default(none) shared(Valpha, sum_w) firstprivate(model) 
-{
-  
-  model.engine = sitmo::prng_engine(omp_get_thread_num() + 1);
-  
-#pragma omp for schedule(dynamic)
-  for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
-    
-    model.theta = theta_storage.col(i);
-    
-    unsigned int nsim = nsim_states;
-    if (is_type == 1) {
-      nsim *= count_storage(i);
-    }
-    
-    arma::cube alpha_i(model.m, model.n + 1, nsim);
-    arma::mat weights_i(nsim, model.n + 1);
-    arma::umat indices(nsim, model.n);
-    
-    double loglik = model.bsf_filter(nsim, alpha_i, weights_i, indices);
-    weight_storage(i) = std::exp(loglik - approx_loglik_storage(i));
-    if (output_type != 3) {
-      filter_smoother(alpha_i, indices);
-      arma::vec w = weights_i.col(model.n);
-      if (output_type == 1) {
-        std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
-        alpha_storage.slice(i) = alpha_i.slice(sample(model.engine)).t();
-      } else {
-        arma::mat alphahat_i(model.m, model.n + 1);
-        arma::cube Vt_i(model.m, model.m, model.n + 1);
-        weighted_summary(alpha_i, alphahat_i, Vt_i, w);
 #pragma omp critical
+#endif
 {
   arma::mat diff = alphahat_i - alphahat;
   double tmp = count_storage(i) + sum_w;
   alphahat = (alphahat * sum_w + alphahat_i * count_storage(i)) / tmp;
-  for (unsigned int t = 0; t < model.n + 1; t++) {
+  for (unsigned int t = 0; t < alphahat_i.n_cols; t++) {
     Valpha.slice(t) += diff.col(t) * (alphahat_i.col(t) - alphahat.col(t)).t();
   }
   Vt = (Vt * sum_w + Vt_i * count_storage(i)) / tmp;
   sum_w = tmp;
 }
-      }
-    }
-    
-  }
 }
-#else
-for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
+
+void nlg_amcmc::bsf_correction(nlg_ssm& model, const unsigned int i,
+  const unsigned int nsim_states, const unsigned int is_type, 
+  arma::cube& Valpha, double& sum_w) {
+  profiler::timer timer(profiler::is_correction);
   
   model.theta = theta_storage.col(i);
   
@@ -352,7 +354,6 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
   arma::umat indices(nsim, model.n);
   
   double loglik = model.bsf_filter(nsim, alpha_i, weights_i, indices);
-  
   weight_storage(i) = std::exp(loglik - approx_loglik_storage(i));
   if (output_type != 3) {
     filter_smoother(alpha_i, indices);
@@ -364,38 +365,43 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
       arma::mat alphahat_i(model.m, model.n + 1);
       arma::cube Vt_i(model.m, model.m, model.n + 1);
       weighted_summary(alpha_i, alphahat_i, Vt_i, w);
-      
-      arma::mat diff = alphahat_i - alphahat;
-      double tmp = count_storage(i) + sum_w;
-      alphahat = (alphahat * sum_w + alphahat_i * count_storage(i)) / tmp;
-      for (unsigned int t = 0; t < model.n + 1; t++) {
-        Valpha.slice(t) += diff.col(t) * (alphahat_i.col(t) - alphahat.col(t)).t();
-      }
-      Vt = (Vt * sum_w + Vt_i * count_storage(i)) / tmp;
-      sum_w = tmp;
-      
+      update_summary(alphahat_i, Vt_i, i, Valpha, sum_w);
     }
   }
 }
-#endif
-if (output_type == 2) {
-  Vt += Valpha / theta_storage.n_cols; // Var[E(alpha)] + E[Var(alpha)]
-}
-posterior_storage = prior_storage + arma::log(weight_storage);
-}
-
 
-void nlg_amcmc::is_correction_psi(nlg_ssm model, const unsigned int nsim_states, 
+void nlg_amcmc::is_correction_bsf(nlg_ssm model, const unsigned int nsim_states, 
   const unsigned int is_type, const unsigned int n_threads) {
   
   arma::cube Valpha(model.m, model.m, model.n + 1, arma::fill::zeros);
   double sum_w = 0.0;
   
 #ifdef _OPENMP
-#pragma omp parallel num_threads(n_threads) default(none) shared(Valpha, sum_w) firstprivate(model)
+#pragma omp parallel num_threads(n_threads) default(none) shared(Valpha, sum_w) firstprivate(model) 
 {
+  
   model.engine = sitmo::prng_engine(omp_get_thread_num() + 1);
   
+#pragma omp for schedule(dynamic)
+  for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
+    bsf_correction(model, i, nsim_states, is_type, Valpha, sum_w);
+  }
+}
+#else
+for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
+  bsf_correction(model, i, nsim_states, is_type, Valpha, sum_w);
+}
+#endif
+if (output_type == 2) {
+  Vt += Valpha / theta_storage.n_cols; // Var[E(alpha)] + E[Var(alpha)]
+}
+posterior_storage = prior_storage + arma::log(weight_storage);
+}
+
+// linear-Gaussian model with correct dimensions, 
+// system matrices are updated in psi_correction
+mgg_ssm nlg_amcmc::psi_approx_model(nlg_ssm& model) {
+  
   unsigned int p = model.p;
   unsigned int n = model.n;
   unsigned int m = model.m;
@@ -412,108 +418,19 @@ void nlg_amcmc::is_correction_psi(nlg_ssm model, const unsigned int nsim_states,
   
   mgg_ssm approx_model(model.y, Z, H, T, R, a1, P1, arma::cube(0,0,0),
     arma::mat(0,0), D, C, model.seed);
-  
-#pragma omp for schedule(dynamic)
-  for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
-    
-    model.theta = theta_storage.col(i);
-    
-    approx_model.a1 = model.a1_fn(model.theta, model.known_params);
-    approx_model.P1 = model.P1_fn(model.theta, model.known_params);
-    for (unsigned int t = 0; t < Z.n_slices; t++) {
-      approx_model.Z.slice(t) = model.Z_gn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
-      approx_model.T.slice(t) = model.T_gn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
-      approx_model.D.col(t) = model.Z_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params) -
-        approx_model.Z.slice(t) * mode_storage.slice(i).col(t);
-      approx_model.C.col(t) =  model.T_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params) -
-        approx_model.T.slice(t) * mode_storage.slice(i).col(t);
-    }
-    for (unsigned int t = 0; t < H.n_slices; t++) {
-      approx_model.H.slice(t) = model.H_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
-    }
-    for (unsigned int t = 0; t < R.n_slices; t++) {
-      approx_model.R.slice(t) = model.R_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
-    }
-    approx_model.compute_HH();
-    approx_model.compute_RR();
-    
-    unsigned int nsim = nsim_states;
-    if (is_type == 1) {
-      nsim *= count_storage(i);
-    }
-    
-    arma::cube alpha_i(model.m, model.n + 1, nsim);
-    arma::mat weights_i(nsim, model.n + 1);
-    arma::umat indices(nsim, model.n);
-    
-    double loglik = model.psi_filter(approx_model, 0.0, nsim, alpha_i, weights_i, indices);
-    
-    weight_storage(i) = std::exp(loglik);
-    if (output_type != 3) {
-      filter_smoother(alpha_i, indices);
-      arma::vec w = weights_i.col(model.n);
-      if (output_type == 1) {
-        std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
-        alpha_storage.slice(i) = alpha_i.slice(sample(model.engine)).t();
-      } else {
-        arma::mat alphahat_i(model.m, model.n + 1);
-        arma::cube Vt_i(model.m, model.m, model.n + 1);
-        weighted_summary(alpha_i, alphahat_i, Vt_i, w);
-#pragma omp critical
-{
-  arma::mat diff = alphahat_i - alphahat;
-  double tmp = count_storage(i) + sum_w;
-  alphahat = (alphahat * sum_w + alphahat_i * count_storage(i)) / tmp;
-  for (unsigned int t = 0; t < model.n + 1; t++) {
-    Valpha.slice(t) += diff.col(t) * (alphahat_i.col(t) - alphahat.col(t)).t();
-  }
-  Vt = (Vt * sum_w + Vt_i * count_storage(i)) / tmp;
-  sum_w = tmp;
+  return approx_model;
 }
-      }
-    }
-  }
-}
-#else
-unsigned int p = model.p;
-unsigned int n = model.n;
-unsigned int m = model.m;
-unsigned int k = model.k;
 
-arma::vec a1(m);
-arma::mat P1(m, m);
-arma::cube Z(p, m, n);
-arma::cube H(p, p, (n - 1) * model.Htv + 1);
-arma::cube T(m, m, n);
-arma::cube R(m, k, (n - 1) * model.Rtv + 1);
-arma::mat D(p, n);
-arma::mat C(m, n);
-
-mgg_ssm approx_model(model.y, Z, H, T, R, a1, P1, arma::cube(0,0,0),
-  arma::mat(0,0), D, C, model.seed);
-
-for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
+void nlg_amcmc::psi_correction(nlg_ssm& model, mgg_ssm& approx_model, 
+  const unsigned int i, const unsigned int nsim_states, const unsigned int is_type, 
+  arma::cube& Valpha, double& sum_w) {
+  profiler::timer timer(profiler::is_correction);
   
   model.theta = theta_storage.col(i);
   
   approx_model.a1 = model.a1_fn(model.theta, model.known_params);
   approx_model.P1 = model.P1_fn(model.theta, model.known_params);
-  for (unsigned int t = 0; t < Z.n_slices; t++) {
-    approx_model.Z.slice(t) = model.Z_gn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
-    approx_model.T.slice(t) = model.T_gn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
-    approx_model.D.col(t) = model.Z_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params) -
-      approx_model.Z.slice(t) * mode_storage.slice(i).col(t);
-    approx_model.C.col(t) =  model.T_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params) -
-      approx_model.T.slice(t) * mode_storage.slice(i).col(t);
-  }
-  for (unsigned int t = 0; t < H.n_slices; t++) {
-    approx_model.H.slice(t) = model.H_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
-  }
-  for (unsigned int t = 0; t < R.n_slices; t++) {
-    approx_model.R.slice(t) = model.R_fn(t, mode_storage.slice(i).col(t), model.theta, model.known_params, model.known_tv_params);
-  }
-  approx_model.compute_HH();
-  approx_model.compute_RR();
+  model.linearize(approx_model, mode_storage.slice(i));
   
   unsigned int nsim = nsim_states;
   if (is_type == 1) {
@@ -527,7 +444,6 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
   double loglik = model.psi_filter(approx_model, 0.0, nsim, alpha_i, weights_i, indices);
   
   weight_storage(i) = std::exp(loglik);
-  
   if (output_type != 3) {
     filter_smoother(alpha_i, indices);
     arma::vec w = weights_i.col(model.n);
@@ -538,18 +454,34 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
       arma::mat alphahat_i(model.m, model.n + 1);
       arma::cube Vt_i(model.m, model.m, model.n + 1);
       weighted_summary(alpha_i, alphahat_i, Vt_i, w);
-      arma::mat diff = alphahat_i - alphahat;
-      double tmp = count_storage(i) + sum_w;
-      alphahat = (alphahat * sum_w + alphahat_i * count_storage(i)) / tmp;
-      for (unsigned int t = 0; t < model.n + 1; t++) {
-        Valpha.slice(t) += diff.col(t) * (alphahat_i.col(t) - alphahat.col(t)).t();
-      }
-      Vt = (Vt * sum_w + Vt_i * count_storage(i)) / tmp;
-      sum_w = tmp;
-      
+      update_summary(alphahat_i, Vt_i, i, Valpha, sum_w);
     }
   }
+}
+
+void nlg_amcmc::is_correction_psi(nlg_ssm model, const unsigned int nsim_states, 
+  const unsigned int is_type, const unsigned int n_threads) {
+  
+  arma::cube Valpha(model.m, model.m, model.n + 1, arma::fill::zeros);
+  double sum_w = 0.0;
+  
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads) default(none) shared(Valpha, sum_w) firstprivate(model)
+{
+  model.engine = sitmo::prng_engine(omp_get_thread_num() + 1);
   
+  mgg_ssm approx_model = psi_approx_model(model);
+  
+#pragma omp for schedule(dynamic)
+  for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
+    psi_correction(model, approx_model, i, nsim_states, is_type, Valpha, sum_w);
+  }
+}
+#else
+mgg_ssm approx_model = psi_approx_model(model);
+
+for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
+  psi_correction(model, approx_model, i, nsim_states, is_type, Valpha, sum_w);
 }
 #endif
 if (output_type == 2) {
@@ -559,6 +491,75 @@ posterior_storage = prior_storage + approx_loglik_storage - scales_storage +
   arma::log(weight_storage);
 }
 
+void nlg_amcmc::pipelined_is_mcmc(nlg_ssm model, const unsigned int max_iter, 
+  const double conv_tol, const bool end_ram, const unsigned int iekf_iter,
+  const unsigned int simulation_method, const unsigned int nsim_states, 
+  const unsigned int is_type, const unsigned int n_threads) {
+  
+#ifdef _OPENMP
+  // with is_type 3 the blocks are expanded before the correction
+  if (n_threads > 1 && is_type != 3) {
+    
+    arma::cube Valpha(model.m, model.m, model.n + 1, arma::fill::zeros);
+    double sum_w = 0.0;
+    block_queue queue(16 * n_threads);
+    std::exception_ptr chain_error = nullptr;
+    
+#pragma omp parallel num_threads(n_threads) shared(Valpha, sum_w, queue, chain_error) firstprivate(model) 
+{
+  // master thread runs the chain, all R API calls are done by it
+  if (omp_get_thread_num() == 0) {
+    try {
+      approx_mcmc(model, max_iter, conv_tol, end_ram, iekf_iter, &queue);
+    } catch (...) {
+      chain_error = std::current_exception();
+    }
+    queue.close();
+  }
+  // after the chain is finished the master thread joins the correction
+  model.engine = sitmo::prng_engine(omp_get_thread_num() + 1);
+  
+  unsigned int i;
+  if (simulation_method == 1) {
+    mgg_ssm approx_model = psi_approx_model(model);
+    while (queue.pop(i)) {
+      psi_correction(model, approx_model, i, nsim_states, is_type, Valpha, sum_w);
+    }
+  } else {
+    while (queue.pop(i)) {
+      bsf_correction(model, i, nsim_states, is_type, Valpha, sum_w);
+    }
+  }
+}
+    if (chain_error) {
+      std::rethrow_exception(chain_error);
+    }
+    trim_storage();
+    
+    if (output_type == 2) {
+      Vt += Valpha / theta_storage.n_cols; // Var[E(alpha)] + E[Var(alpha)]
+    }
+    if (simulation_method == 1) {
+      posterior_storage = prior_storage + approx_loglik_storage - scales_storage + 
+        arma::log(weight_storage);
+    } else {
+      posterior_storage = prior_storage + arma::log(weight_storage);
+    }
+    return;
+  }
+#endif
+  
+  approx_mcmc(model, max_iter, conv_tol, end_ram, iekf_iter);
+  if (is_type == 3) {
+    expand();
+  }
+  if (simulation_method == 1) {
+    is_correction_psi(model, nsim_states, is_type, n_threads);
+  } else {
+    is_correction_bsf(model, nsim_states, is_type, n_threads);
+  }
+}
+
 void nlg_amcmc::state_ekf_sample(nlg_ssm model, const unsigned int n_threads, const unsigned int iekf_iter) {
   
 #ifdef _OPENMP
@@ -595,22 +596,7 @@ void nlg_amcmc::state_ekf_sample(nlg_ssm model, const unsigned int n_threads, co
     
     approx_model.a1 = model.a1_fn(model.theta, model.known_params);
     approx_model.P1 = model.P1_fn(model.theta, model.known_params);
-    for (unsigned int t = 0; t < Z.n_slices; t++) {
-      approx_model.Z.slice(t) = model.Z_gn(t, at.col(t), model.theta, model.known_params, model.known_tv_params);
-      approx_model.T.slice(t) = model.T_gn(t, att.col(t), model.theta, model.known_params, model.known_tv_params);
-      approx_model.D.col(t) = model.Z_fn(t, at.col(t), model.theta, model.known_params, model.known_tv_params) -
-        approx_model.Z.slice(t) * at.col(t);
-      approx_model.C.col(t) =  model.T_fn(t, att.col(t), model.theta, model.known_params, model.known_tv_params) -
-        approx_model.T.slice(t) * att.col(t);
-    }
-    for (unsigned int t = 0; t < H.n_slices; t++) {
-      approx_model.H.slice(t) = model.H_fn(t, at.col(t), model.theta, model.known_params, model.known_tv_params);
-    }
-    for (unsigned int t = 0; t < R.n_slices; t++) {
-      approx_model.R.slice(t) = model.R_fn(t, att.col(t), model.theta, model.known_params, model.known_tv_params);
-    }
-    approx_model.compute_HH();
-    approx_model.compute_RR();
+    model.linearize(approx_model, at, att);
     alpha_storage.slice(i) = approx_model.simulate_states().slice(0).t();
     
   }
@@ -646,22 +632,7 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
   
   approx_model.a1 = model.a1_fn(model.theta, model.known_params);
   approx_model.P1 = model.P1_fn(model.theta, model.known_params);
-  for (unsigned int t = 0; t < Z.n_slices; t++) {
-    approx_model.Z.slice(t) = model.Z_gn(t, at.col(t), model.theta, model.known_params, model.known_tv_params);
-    approx_model.T.slice(t) = model.T_gn(t, att.col(t), model.theta, model.known_params, model.known_tv_params);
-    approx_model.D.col(t) = model.Z_fn(t, at.col(t), model.theta, model.known_params, model.known_tv_params) -
-      approx_model.Z.slice(t) * at.col(t);
-    approx_model.C.col(t) =  model.T_fn(t, att.col(t), model.theta, model.known_params, model.known_tv_params) -
-      approx_model.T.slice(t) * att.col(t);
-  }
-  for (unsigned int t = 0; t < H.n_slices; t++) {
-    approx_model.H.slice(t) = model.H_fn(t, at.col(t), model.theta, model.known_params, model.known_tv_params);
-  }
-  for (unsigned int t = 0; t < R.n_slices; t++) {
-    approx_model.R.slice(t) = model.R_fn(t, att.col(t), model.theta, model.known_params, model.known_tv_params);
-  }
-  approx_model.compute_HH();
-  approx_model.compute_RR();
+  model.linearize(approx_model, at, att);
   alpha_storage.slice(i) = approx_model.simulate_states().slice(0).t();
   
 }
@@ -4,6 +4,9 @@
 #include "bssm.h"
 #include "mcmc.h"
 
+class mgg_ssm;
+class block_queue;
+
 class nlg_amcmc: public mcmc {
   
 public:
@@ -17,7 +20,15 @@ public:
   void expand();
   
   void approx_mcmc(nlg_ssm model, const unsigned int max_iter, 
-    const double conv_tol, const bool end_ram, const unsigned int iekf_iter);
+    const double conv_tol, const bool end_ram, const unsigned int iekf_iter,
+    block_queue* queue = NULL);
+  
+  // approximate mcmc where the IS-correction of closed blocks is done 
+  // simultaneously by the other threads
+  void pipelined_is_mcmc(nlg_ssm model, const unsigned int max_iter, 
+    const double conv_tol, const bool end_ram, const unsigned int iekf_iter,
+    const unsigned int simulation_method, const unsigned int nsim_states, 
+    const unsigned int is_type, const unsigned int n_threads);
   
   void ekf_mcmc(nlg_ssm model, const bool end_ram, const unsigned int iekf_iter);
   
@@ -37,6 +48,20 @@ public:
 private:
   
   void trim_storage();
+  void sync_storage(checkpoint& file);
+  
+  // IS-correction of a single block i
+  mgg_ssm psi_approx_model(nlg_ssm& model);
+  void psi_correction(nlg_ssm& model, mgg_ssm& approx_model, const unsigned int i,
+    const unsigned int nsim_states, const unsigned int is_type, 
+    arma::cube& Valpha, double& sum_w);
+  void bsf_correction(nlg_ssm& model, const unsigned int i,
+    const unsigned int nsim_states, const unsigned int is_type, 
+    arma::cube& Valpha, double& sum_w);
+  // add summary statistics of block i to the running estimates
+  void update_summary(const arma::mat& alphahat_i, const arma::cube& Vt_i, 
+    const unsigned int i, arma::cube& Valpha, double& sum_w);
+  
   arma::vec approx_loglik_storage;
   arma::vec scales_storage;
   arma::vec prior_storage;
@@ -1,3 +1,7 @@
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <exception>
 #include "nlg_ssm.h"
 #include "mgg_ssm.h"
 #include "sample.h"
@@ -6,6 +10,8 @@
 #include "rep_mat.h"
 #include "psd_chol.h"
 #include "interval.h"
+#include "profiler.h"
+#include "parallel_smoother.h"
 
 nlg_ssm::nlg_ssm(const arma::mat& y, nvec_fnPtr Z_fn_, nmat_fnPtr H_fn_, nvec_fnPtr T_fn_, 
   nmat_fnPtr R_fn_, nmat_fnPtr Z_gn_, nmat_fnPtr T_gn_, a1_fnPtr a1_fn_, P1_fnPtr P1_fn_,
@@ -13,140 +19,95 @@ nlg_ssm::nlg_ssm(const arma::mat& y, nvec_fnPtr Z_fn_, nmat_fnPtr H_fn_, nvec_fn
   const arma::mat& known_tv_params, const unsigned int m, const unsigned int k,
   const arma::uvec& time_varying, const unsigned int seed) :
   y(y), Z_fn(Z_fn_), H_fn(H_fn_), T_fn(T_fn_), 
-  R_fn(R_fn_), Z_gn(Z_gn_), T_gn(T_gn_),
+  R_fn(R_fn_), Z_gn(Z_gn_), T_gn(T_gn_), T_batch_fn(nullptr), Z_batch_fn(nullptr),
   a1_fn(a1_fn_), P1_fn(P1_fn_), theta(theta), 
   log_prior_pdf(log_prior_pdf_), known_params(known_params), 
   known_tv_params(known_tv_params), m(m), k(k), n(y.n_cols),  p(y.n_rows),
   Zgtv(time_varying(0)), Tgtv(time_varying(1)), Htv(time_varying(2)),
   Rtv(time_varying(3)), seed(seed), 
-  engine(seed), zero_tol(1e-8) {
+  engine(seed), zero_tol(1e-8), n_threads(1), 
+  parallel_scan(false), unscented_approx(false), auxiliary(false) {
+}
+
+void nlg_ssm::T_cols(const unsigned int t, const arma::mat& alpha, arma::mat& result) const {
+  if (T_batch_fn) {
+    T_batch_fn(t, alpha, theta, known_params, known_tv_params, result);
+  } else {
+    for (unsigned int i = 0; i < alpha.n_cols; i++) {
+      result.col(i) = T_fn(t, alpha.col(i), theta, known_params, known_tv_params);
+    }
+  }
+}
+
+void nlg_ssm::Z_cols(const unsigned int t, const arma::mat& alpha, arma::mat& result) const {
+  if (Z_batch_fn) {
+    Z_batch_fn(t, alpha, theta, known_params, known_tv_params, result);
+  } else {
+    for (unsigned int i = 0; i < alpha.n_cols; i++) {
+      result.col(i) = Z_fn(t, alpha.col(i), theta, known_params, known_tv_params);
+    }
+  }
+}
+
+#ifndef BSSM_STANDALONE
+void nlg_ssm::set_batch_fns(SEXP T_batch, SEXP Z_batch) {
+  if (!Rf_isNull(T_batch)) {
+    Rcpp::XPtr<nbatch_fnPtr> xpfun_T(T_batch);
+    T_batch_fn = *xpfun_T;
+  }
+  if (!Rf_isNull(Z_batch)) {
+    Rcpp::XPtr<nbatch_fnPtr> xpfun_Z(Z_batch);
+    Z_batch_fn = *xpfun_Z;
+  }
 }
 
 Rcpp::List nlg_ssm::predict_interval(const arma::vec& probs, const arma::mat& thetasim,
   const arma::mat& alpha_last, const arma::cube& P_last, 
-  const arma::uvec& counts, const unsigned int predict_type) {
-  
-  if(p > 1) 
-    Rcpp::stop("Interval prediction using EKF is currently not supported for multivariate observations.");
-  theta = thetasim.col(0);
-  
-  arma::mat at(m, n);
-  arma::cube Pt(m, m, n);
-  at.col(0) = alpha_last.col(0);
-  Pt.slice(0) = P_last.slice(0);
-  
-  for (unsigned int t = 0; t < (n - 1); t++) {
-    at.col(t + 1) = T_fn(t, at.col(t), theta, known_params, known_tv_params);
-    arma::mat Tg = T_gn(t, at.col(t), theta, known_params, known_tv_params);
-    arma::mat Rt = R_fn(t, at.col(t), theta, known_params, known_tv_params);
-    Pt.slice(t + 1) = Tg * Pt.slice(t) * Tg.t() + Rt * Rt.t();
-  }
+  const arma::uvec& counts, const unsigned int predict_type, 
+  const bool unscented) {
   
+  unsigned int d = p;
+  if (predict_type == 3) d = m;
   unsigned int n_samples = thetasim.n_cols;
   
-  if (predict_type < 3) {
-    
-    arma::mat mean_pred(n, n_samples);
-    arma::mat var_pred(n, n_samples);
-    
-    for(unsigned int t = 0; t < n; t++) {
-      mean_pred(t, 0) = arma::as_scalar(Z_fn(t, at.col(t), theta, known_params, known_tv_params));
-      arma::mat Zg = Z_gn(t, at.col(t), theta, known_params, known_tv_params);
-      var_pred(t, 0) = arma::as_scalar(Zg * Pt.slice(t) * Zg.t());
-    }
-    
-    if (predict_type == 1) {
-      for(unsigned int t = 0; t < n; t++) {
-        arma::mat HHt = H_fn(t, at.col(t), theta, known_params, known_tv_params);
-        var_pred(t, 0) += arma::as_scalar(HHt * HHt.t());
-      }
-    }
-    
-    for (unsigned int i = 1; i < n_samples; i++) {
-      
-      theta = thetasim.col(i);
-      at.col(0) = alpha_last.col(i);
-      Pt.slice(0) = P_last.slice(i);
-      
-      for (unsigned int t = 0; t < (n - 1); t++) {
-        at.col(t + 1) = T_fn(t, at.col(t), theta, known_params, known_tv_params);
-        arma::mat Tg = T_gn(t, at.col(t), theta, known_params, known_tv_params);
-        arma::mat Rt = R_fn(t, at.col(t), theta, known_params, known_tv_params);
-        Pt.slice(t + 1) = Tg * Pt.slice(t) * Tg.t() + Rt * Rt.t();
-      }
-      for(unsigned int t = 0; t < n; t++) {
-        mean_pred(t, i) = arma::as_scalar(Z_fn(t, at.col(t), theta, known_params, known_tv_params));
-        arma::mat Zg = Z_gn(t, at.col(t), theta, known_params, known_tv_params);
-        var_pred(t, i) = arma::as_scalar(Zg * Pt.slice(t) * Zg.t());
-      }
-      
-      if (predict_type == 1) {
-        for(unsigned int t = 0; t < n; t++) {
-          arma::mat HHt = H_fn(t, at.col(t), theta, known_params, known_tv_params);
-          var_pred(t, i) += arma::as_scalar(HHt * HHt.t());
-        }
-      }
-      
-    }
-    
-    arma::mat expanded_sd = rep_mat(arma::sqrt(var_pred), counts);
-    arma::inplace_trans(expanded_sd);
-    arma::mat expanded_mean = rep_mat(mean_pred, counts);
-    arma::inplace_trans(expanded_mean);
-    
-    arma::mat intv = intervals(expanded_mean, expanded_sd, probs, n);
-    
-    return Rcpp::List::create(Rcpp::Named("intervals") = intv,
-      Rcpp::Named("mean_pred") = expanded_mean,
-      Rcpp::Named("sd_pred") = expanded_sd);
-  } else {
-    
-    arma::cube mean_pred(n, n_samples, m);
-    arma::cube var_pred(n, n_samples, m);
-    
+  arma::cube mean_pred(n, n_samples, d);
+  arma::cube var_pred(n, n_samples, d);
+  
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads) if(n_threads > 1 && !omp_in_parallel())
+#endif
+  for (unsigned int i = 0; i < n_samples; i++) {
+    arma::mat mean_i(d, n);
+    arma::cube cov_i(d, d, n);
+    predict_moments(thetasim.col(i), alpha_last.col(i), P_last.slice(i), 
+      predict_type, unscented, mean_i, cov_i);
     for(unsigned int t = 0; t < n; t++) {
-      mean_pred.tube(t, 0) = at.col(t);
-      var_pred.tube(t, 0) = Pt.slice(t).diag();
+      mean_pred.tube(t, i) = mean_i.col(t);
+      var_pred.tube(t, i) = cov_i.slice(t).diag();
     }
-    
-    for (unsigned int i = 1; i < n_samples; i++) {
-      
-      theta = thetasim.col(i);
-      at.col(0) = alpha_last.col(i);
-      Pt.slice(0) = P_last.slice(i);
-      
-      for (unsigned int t = 0; t < (n - 1); t++) {
-        at.col(t + 1) = T_fn(t, at.col(t), theta, known_params, known_tv_params);
-        arma::mat Tg = T_gn(t, at.col(t), theta, known_params, known_tv_params);
-        arma::mat Rt = R_fn(t, at.col(t), theta, known_params, known_tv_params);
-        Pt.slice(t + 1) = Tg * Pt.slice(t) * Tg.t() + Rt * Rt.t();
-      }
-      
-      
-      for(unsigned int t = 0; t < n; t++) {
-        mean_pred.tube(t, i) = at.col(t);
-        var_pred.tube(t, i) = Pt.slice(t).diag();
-      }
-    }
-    
-    arma::cube intv(n, probs.n_elem, m);
-    arma::cube expanded_sd(arma::accu(counts), n, m);
-    arma::cube expanded_mean(arma::accu(counts), n, m);
-    for (unsigned int i = 0; i < m; i++) {
-      arma::mat tmp1 = rep_mat(arma::sqrt(var_pred.slice(i)), counts);
-      expanded_sd.slice(i) = tmp1.t();
-      arma::mat tmp2 = rep_mat(mean_pred.slice(i), counts);
-      expanded_mean.slice(i) = tmp2.t();
-      intv.slice(i) = intervals(expanded_mean.slice(i), expanded_sd.slice(i),
-        probs, n);
-    }
-    
-    
-    return Rcpp::List::create(Rcpp::Named("intervals") = intv,
-      Rcpp::Named("mean_pred") = expanded_mean,
-      Rcpp::Named("sd_pred") = expanded_sd);
   }
+  
+  // marginal intervals from the mixtures of the predictive distributions, 
+  // weighted by the number of times each sample was repeated in the chain
+  arma::vec weights = arma::conv_to<arma::vec>::from(counts);
+  arma::cube intv(n, probs.n_elem, d);
+  arma::cube expanded_sd(arma::accu(counts), n, d);
+  arma::cube expanded_mean(arma::accu(counts), n, d);
+  for (unsigned int i = 0; i < d; i++) {
+    arma::mat sd_i = arma::sqrt(var_pred.slice(i));
+    intv.slice(i) = mixture_intervals(mean_pred.slice(i), sd_i, weights, 
+      probs, n_threads);
+    arma::mat tmp1 = rep_mat(sd_i, counts);
+    expanded_sd.slice(i) = tmp1.t();
+    arma::mat tmp2 = rep_mat(mean_pred.slice(i), counts);
+    expanded_mean.slice(i) = tmp2.t();
+  }
+  
+  return Rcpp::List::create(Rcpp::Named("intervals") = intv,
+    Rcpp::Named("mean_pred") = expanded_mean,
+    Rcpp::Named("sd_pred") = expanded_sd);
 }
+#endif
 
 arma::cube nlg_ssm::predict_sample(const arma::mat& thetasim, 
   const arma::mat& alpha, const arma::uvec& counts, 
@@ -169,6 +130,26 @@ arma::cube nlg_ssm::predict_sample(const arma::mat& thetasim,
   return sample;
 }
 
+quantile_sketch nlg_ssm::predict_summary(const arma::mat& thetasim, 
+  const arma::mat& alpha, const arma::uvec& counts, 
+  const unsigned int predict_type, const unsigned int nsim) {
+  
+  unsigned int d = p;
+  if (predict_type == 3) d = m;
+  // the repeated samples are replaced by the counts as weights
+  quantile_sketch sketch(d, n);
+  for (unsigned int i = 0; i < thetasim.n_cols; i++) {
+    
+    theta = thetasim.col(i);
+    
+    arma::cube sample = sample_model(alpha.col(i), predict_type, nsim);
+    for (unsigned int j = 0; j < nsim; j++) {
+      sketch.add(sample.slice(j), counts(i));
+    }
+  }
+  return sketch;
+}
+
 arma::cube nlg_ssm::sample_model(const arma::vec& a1_sim,
   const unsigned int predict_type, const unsigned int nsim) {
   
@@ -220,6 +201,7 @@ arma::cube nlg_ssm::sample_model(const arma::vec& a1_sim,
 
 double nlg_ssm::ekf(arma::mat& at, arma::mat& att, arma::cube& Pt, 
   arma::cube& Ptt, const unsigned int iekf_iter) const {
+  profiler::timer timer(profiler::ekf);
   
   at.col(0) = a1_fn(theta, known_params);
   Pt.slice(0) = P1_fn(theta, known_params);
@@ -319,6 +301,7 @@ double nlg_ssm::ekf(arma::mat& at, arma::mat& att, arma::cube& Pt,
 
 
 double nlg_ssm::ekf_loglik(const unsigned int iekf_iter) const {
+  profiler::timer timer(profiler::ekf);
   
   
   arma::vec at = a1_fn(theta, known_params);
@@ -419,6 +402,7 @@ double nlg_ssm::ekf_loglik(const unsigned int iekf_iter) const {
 }
 
 double nlg_ssm::ekf_smoother(arma::mat& at, arma::cube& Pt, const unsigned int iekf_iter) const {
+  profiler::timer timer(profiler::ekf);
   
   at.col(0) = a1_fn(theta, known_params);
   
@@ -544,6 +528,7 @@ double nlg_ssm::ekf_smoother(arma::mat& at, arma::cube& Pt, const unsigned int i
 }
 
 double nlg_ssm::ekf_fast_smoother(arma::mat& at, const unsigned int iekf_iter) const {
+  profiler::timer timer(profiler::ekf);
   
   at.col(0) = a1_fn(theta, known_params);
   
@@ -670,11 +655,134 @@ double nlg_ssm::ekf_fast_smoother(arma::mat& at, const unsigned int iekf_iter) c
   return logLik;
 }
 
+// weights of the 2m+1 sigma points of the unscented transform for the mean (wm) 
+// and covariance (wc), returns the scaling sqrt(m + lambda) of the sigma points
+static double sigma_weights(const unsigned int m, const double alpha, 
+  const double beta, const double kappa, arma::vec& wm, arma::vec& wc) {
+  
+  double lambda = alpha * alpha * (m + kappa) - m;
+  unsigned int n_sigma = 2 * m + 1;
+  wm.set_size(n_sigma);
+  wm(0) = lambda / (lambda + m);
+  wm.subvec(1, n_sigma - 1).fill(1.0 / (2.0 * (lambda + m)));
+  wc = wm;
+  wc(0) +=  1.0 - alpha * alpha + beta;
+  return std::sqrt(m + lambda);
+}
+
+// sigma points of N(mean, L L')
+static arma::mat sigma_points(const arma::vec& mean, const arma::mat& L, 
+  const double scale) {
+  
+  unsigned int m = mean.n_elem;
+  arma::mat sigma(m, 2 * m + 1);
+  sigma.col(0) = mean;
+  for (unsigned int i = 1; i <= m; i++) {
+    sigma.col(i) = mean + scale * L.col(i - 1);
+    sigma.col(i + m) = mean - scale * L.col(i - 1);
+  }
+  return sigma;
+}
+
+// square root L of positive semidefinite V with V = L L', from the eigendecomposition 
+// so that it cannot fail within parallel regions
+static arma::mat psd_sqrt(const arma::mat& V) {
+  
+  arma::vec eigval;
+  arma::mat eigvec;
+  if (!arma::eig_sym(eigval, eigvec, arma::symmatu(V))) {
+    return arma::mat(V.n_rows, V.n_cols, arma::fill::zeros);
+  }
+  eigval.elem(arma::find(eigval < 0)).zeros();
+  return eigvec * arma::diagmat(arma::sqrt(eigval));
+}
+
+// predictive means and covariances of alpha_t (predict_type 3), Z(alpha_t) (2) 
+// or y_t (1) for t = 1, ..., n given theta_i and alpha_1 ~ N(a1, P1), using the 
+// prediction steps of EKF, or of UKF if unscented is true
+void nlg_ssm::predict_moments(const arma::vec& theta_i, const arma::vec& a1, 
+  const arma::mat& P1, const unsigned int predict_type, const bool unscented,
+  arma::mat& mean, arma::cube& cov) const {
+  
+  arma::vec at = a1;
+  arma::mat Pt = P1;
+  
+  unsigned int n_sigma = 2 * m + 1;
+  arma::vec wm;
+  arma::vec wc;
+  double sqrt_m_lambda = sigma_weights(m, 1.0, 0.0, 2.0, wm, wc);
+  
+  for (unsigned int t = 0; t < n; t++) {
+    
+    arma::mat sigma;
+    if (unscented) {
+      sigma = sigma_points(at, psd_sqrt(Pt), sqrt_m_lambda);
+    }
+    if (predict_type == 3) {
+      mean.col(t) = at;
+      cov.slice(t) = Pt;
+    } else {
+      if (unscented) {
+        arma::mat sigma_y(p, n_sigma);
+        for (unsigned int i = 0; i < n_sigma; i++) {
+          sigma_y.col(i) = Z_fn(t, sigma.col(i), theta_i, known_params, known_tv_params);
+        }
+        mean.col(t) = sigma_y * wm;
+        cov.slice(t).zeros();
+        for (unsigned int i = 0; i < n_sigma; i++) {
+          arma::vec tmp = sigma_y.col(i) - mean.col(t);
+          cov.slice(t) += wc(i) * tmp * tmp.t();
+        }
+      } else {
+        mean.col(t) = Z_fn(t, at, theta_i, known_params, known_tv_params);
+        arma::mat Zg = Z_gn(t, at, theta_i, known_params, known_tv_params);
+        cov.slice(t) = Zg * Pt * Zg.t();
+      }
+      if (predict_type == 1) {
+        arma::mat Ht = H_fn(t, at, theta_i, known_params, known_tv_params);
+        cov.slice(t) += Ht * Ht.t();
+      }
+    }
+    
+    if (t < (n - 1)) {
+      arma::mat Rt = R_fn(t, at, theta_i, known_params, known_tv_params);
+      if (unscented) {
+        arma::mat sigma_T(m, n_sigma);
+        for (unsigned int i = 0; i < n_sigma; i++) {
+          sigma_T.col(i) = T_fn(t, sigma.col(i), theta_i, known_params, known_tv_params);
+        }
+        at = sigma_T * wm;
+        Pt = Rt * Rt.t();
+        for (unsigned int i = 0; i < n_sigma; i++) {
+          arma::vec tmp = sigma_T.col(i) - at;
+          Pt += wc(i) * tmp * tmp.t();
+        }
+      } else {
+        arma::mat Tg = T_gn(t, at, theta_i, known_params, known_tv_params);
+        at = T_fn(t, at, theta_i, known_params, known_tv_params);
+        Pt = Tg * Pt * Tg.t() + Rt * Rt.t();
+      }
+    }
+  }
+}
+
 // Unscented Kalman filter, Särkkä (2013) p.107 (UKF) and
 // Note that the initial distribution is given for alpha_1
 // so we first do update instead of prediction
 double nlg_ssm::ukf(arma::mat& at, arma::mat& att, arma::cube& Pt, 
-  arma::cube& Ptt, const double alpha, const double beta, const double kappa) const {
+  arma::cube& Ptt, const double alpha, const double beta, const double kappa,
+  const bool square_root) const {
+  
+  arma::cube Ct(0, 0, 0);
+  return ukf(at, att, Pt, Ptt, Ct, alpha, beta, kappa, square_root);
+}
+
+// If square_root is true, the Cholesky factors of the covariances are propagated 
+// instead of the covariances as in van der Merwe and Wan (2001), so that the 
+// sigma points are formed without decomposing the covariance matrices
+double nlg_ssm::ukf(arma::mat& at, arma::mat& att, arma::cube& Pt, 
+  arma::cube& Ptt, arma::cube& Ct, const double alpha, const double beta, 
+  const double kappa, const bool square_root) const {
   
   // // Parameters of UKF, currently fixed for simplicity
   // These are from Särkkä?
@@ -689,98 +797,194 @@ double nlg_ssm::ukf(arma::mat& at, arma::mat& att, arma::cube& Pt,
   const double LOG2PI = std::log(2.0 * M_PI);
   double logLik = 0.0;
   
-  double lambda = alpha * alpha * (m + kappa) - m;
-  
   unsigned int n_sigma = 2 * m + 1;
-  arma::vec wm(n_sigma);
-  wm(0) = lambda / (lambda + m);
-  wm.subvec(1, n_sigma - 1).fill(1.0 / (2.0 * (lambda + m)));
-  arma::vec wc = wm;
-  wc(0) +=  1.0 - alpha * alpha + beta;
-  
-  
-  double sqrt_m_lambda = std::sqrt(m + lambda);
+  arma::vec wm;
+  arma::vec wc;
+  double sqrt_m_lambda = sigma_weights(m, alpha, beta, kappa, wm, wc);
+  arma::vec sqrt_wc = arma::sqrt(wc.subvec(1, n_sigma - 1));
   
   at.col(0) = a1_fn(theta, known_params);
   Pt.slice(0) = P1_fn(theta, known_params);
+  // Cholesky factors of Pt and Ptt
+  arma::mat cholP(m, m);
+  arma::mat cholPtt(m, m);
   
   for (unsigned int t = 0; t < n; t++) {
     // update step
     
-    // compute cholesky of Pt
-    arma::mat cholP(m, m);
-    cholP = psd_chol(Pt.slice(t));
-    
-    // form the sigma points
-    arma::mat sigma(m, n_sigma);
-    sigma.col(0) = at.col(t);
-    for (unsigned int i = 1; i <= m; i++) {
-      sigma.col(i) = at.col(t) + sqrt_m_lambda * cholP.col(i - 1);
-      sigma.col(i + m) = at.col(t) - sqrt_m_lambda * cholP.col(i - 1);
+    if (!square_root || t == 0) {
+      cholP = psd_chol(Pt.slice(t));
     }
+    // form the sigma points
+    arma::mat sigma = sigma_points(at.col(t), cholP, sqrt_m_lambda);
     
     arma::uvec obs_y = arma::find_finite(y.col(t));
     
     if (obs_y.n_elem > 0) {
       
       // propagate sigma points
-      arma::mat sigma_y(obs_y.n_elem, n_sigma);
-      for (unsigned int i = 0; i < n_sigma; i++) {
-        sigma_y.col(i) = Z_fn(t, sigma.col(i), theta, known_params, known_tv_params).rows(obs_y);
-      }
+      arma::mat sigma_y(p, n_sigma);
+      Z_cols(t, sigma, sigma_y);
+      sigma_y = sigma_y.rows(obs_y);
       arma::vec pred_mean = sigma_y * wm;
-      arma::mat pred_var = H_fn(t, at.col(t), theta, known_params, known_tv_params).submat(obs_y, obs_y);
+      arma::mat H = H_fn(t, at.col(t), theta, known_params, known_tv_params).rows(obs_y);
       arma::mat pred_cov(m, obs_y.n_elem, arma::fill::zeros);
       for (unsigned int i = 0; i < n_sigma; i++) {
-        arma::vec tmp = sigma_y.col(i) - pred_mean;
-        pred_var += wc(i) * tmp * tmp.t();
-        pred_cov += wc(i) * (sigma.col(i) - at.col(t)) * tmp.t();
+        pred_cov += wc(i) * (sigma.col(i) - at.col(t)) * (sigma_y.col(i) - pred_mean).t();
+      }
+      // lower triangular Cholesky factor of the prediction variance
+      arma::mat cholF(obs_y.n_elem, obs_y.n_elem);
+      if (square_root) {
+        arma::mat dev = sigma_y.cols(1, n_sigma - 1);
+        dev.each_col() -= pred_mean;
+        dev.each_row() %= sqrt_wc.t();
+        cholF = qr_chol(arma::join_horiz(dev, H));
+        chol_update(cholF, sigma_y.col(0) - pred_mean, wc(0));
+      } else {
+        arma::mat pred_var = H * H.t();
+        for (unsigned int i = 0; i < n_sigma; i++) {
+          arma::vec tmp = sigma_y.col(i) - pred_mean;
+          pred_var += wc(i) * tmp * tmp.t();
+        }
+        // first check to avoid armadillo warnings
+        bool chol_ok = pred_var.is_finite() && arma::all(pred_var.diag() > 0);
+        if (!chol_ok) return -std::numeric_limits<double>::infinity();
+        chol_ok = arma::chol(cholF, pred_var, "lower");
+        if (!chol_ok) return -std::numeric_limits<double>::infinity();
+      }
+      if (!cholF.is_finite() || !arma::all(cholF.diag() > 0)) {
+        return -std::numeric_limits<double>::infinity();
       }
       // filtered estimates
       arma::vec v = arma::mat(y.rows(obs_y)).col(t) - pred_mean;
-      arma::mat K = arma::solve(pred_var, pred_cov.t()).t();
+      // K = pred_cov F^-1 and KF = K L_F
+      arma::mat KF = arma::solve(arma::trimatl(cholF), pred_cov.t()).t();
+      arma::mat K = arma::solve(arma::trimatu(cholF.t()), KF.t()).t();
       att.col(t) = at.col(t) + K * v;
-      Ptt.slice(t) = Pt.slice(t) - K * pred_var * K.t();
+      if (square_root) {
+        cholPtt = cholP;
+        for (unsigned int j = 0; j < obs_y.n_elem; j++) {
+          chol_update(cholPtt, KF.col(j), -1.0);
+        }
+        Ptt.slice(t) = cholPtt * cholPtt.t();
+      } else {
+        Ptt.slice(t) = Pt.slice(t) - KF * KF.t();
+      }
       
-      arma::mat cholF = arma::chol(pred_var);
-      arma::mat inv_cholF = arma::inv(arma::trimatu(cholF));
-      arma::vec Fv = inv_cholF.t() * v; 
+      arma::vec Fv = arma::solve(arma::trimatl(cholF), v); 
       logLik -= 0.5 * arma::as_scalar(obs_y.n_elem * LOG2PI + 
         2.0 * arma::accu(arma::log(arma::diagvec(cholF))) + Fv.t() * Fv);
     } else {
       att.col(t) = at.col(t);
       Ptt.slice(t) = Pt.slice(t);
+      cholPtt = cholP;
     }
     
     // prediction
-    // compute cholesky of Ptt
-    arma::mat cholPtt = psd_chol(Ptt.slice(t));
+    if (!square_root) {
+      cholPtt = psd_chol(Ptt.slice(t));
+    }
     
     // form the sigma points and propagate
-    sigma.col(0) = T_fn(t, att.col(t), theta, known_params, known_tv_params);
-    for (unsigned int i = 1; i <= m; i++) {
-      sigma.col(i) = T_fn(t, att.col(t) + sqrt_m_lambda * cholPtt.col(i - 1), 
-        theta, known_params, known_tv_params);
-      sigma.col(i + m) = T_fn(t, att.col(t) - sqrt_m_lambda * cholPtt.col(i - 1), 
-        theta, known_params, known_tv_params);
-    }
+    sigma = sigma_points(att.col(t), cholPtt, sqrt_m_lambda);
+    arma::mat sigma_T(m, n_sigma);
+    T_cols(t, sigma, sigma_T);
     
-    at.col(t + 1) = sigma * wm;
+    at.col(t + 1) = sigma_T * wm;
     
     arma::mat Rt = R_fn(t, att.col(t), theta, known_params, known_tv_params);
-    Pt.slice(t + 1) = Rt * Rt.t();
-    for (unsigned int i = 0; i < n_sigma; i++) {
-      arma::vec tmp = sigma.col(i) - at.col(t + 1);
-      Pt.slice(t + 1) += wc(i) * tmp * tmp.t();
+    if (square_root) {
+      arma::mat dev = sigma_T.cols(1, n_sigma - 1);
+      dev.each_col() -= at.col(t + 1);
+      dev.each_row() %= sqrt_wc.t();
+      cholP = qr_chol(arma::join_horiz(dev, Rt));
+      chol_update(cholP, sigma_T.col(0) - at.col(t + 1), wc(0));
+      Pt.slice(t + 1) = cholP * cholP.t();
+    } else {
+      Pt.slice(t + 1) = Rt * Rt.t();
+      for (unsigned int i = 0; i < n_sigma; i++) {
+        arma::vec tmp = sigma_T.col(i) - at.col(t + 1);
+        Pt.slice(t + 1) += wc(i) * tmp * tmp.t();
+      }
+    }
+    if (Ct.n_slices > 0) {
+      Ct.slice(t).zeros();
+      for (unsigned int i = 0; i < n_sigma; i++) {
+        Ct.slice(t) += wc(i) * (sigma.col(i) - att.col(t)) * 
+          (sigma_T.col(i) - at.col(t + 1)).t();
+      }
     }
   }
   return logLik;
 }
 
+// Unscented Rauch-Tung-Striebel smoother, Särkkä (2013) p.148
+// alphahat and Vt contain the smoothed means and covariances of alpha_1,...,alpha_n
+double nlg_ssm::ukf_smoother(arma::mat& alphahat, arma::cube& Vt, 
+  const double alpha, const double beta, const double kappa, 
+  const bool square_root) const {
+  
+  arma::mat at(m, n + 1);
+  arma::mat att(m, n);
+  arma::cube Pt(m, m, n + 1);
+  arma::cube Ptt(m, m, n);
+  arma::cube Ct(m, m, n);
+  
+  double logLik = ukf(at, att, Pt, Ptt, Ct, alpha, beta, kappa, square_root);
+  if (!arma::is_finite(logLik)) return logLik;
+  
+  alphahat.col(n - 1) = att.col(n - 1);
+  Vt.slice(n - 1) = Ptt.slice(n - 1);
+  for (int t = (n - 2); t >= 0; t--) {
+    // smoother gain Ct Pt+1^-1
+    arma::mat G;
+    bool solve_ok = Pt.slice(t + 1).is_finite() && 
+      arma::solve(G, Pt.slice(t + 1), Ct.slice(t).t());
+    if (!solve_ok) return -std::numeric_limits<double>::infinity();
+    arma::inplace_trans(G);
+    alphahat.col(t) = att.col(t) + G * (alphahat.col(t + 1) - at.col(t + 1));
+    Vt.slice(t) = arma::symmatu(Ptt.slice(t) + 
+      G * (Vt.slice(t + 1) - Pt.slice(t + 1)) * G.t());
+  }
+  return logLik;
+}
+
 mgg_ssm nlg_ssm::approximate(arma::mat& mode_estimate, 
   const unsigned int max_iter, const double conv_tol, 
   const unsigned int iekf_iter) const {
   
+  if (unscented_approx) {
+    return approximate_unscented(mode_estimate, max_iter, conv_tol);
+  }
+  
+  // start from the cached mode of the nearest theta instead of the EKF, 
+  // and skip the mode search if theta itself is in the cache
+  bool use_cache = max_iter > 0 && cached_modes.capacity > 0;
+  if (use_cache) {
+    bool exact;
+    int i = cached_modes.find(theta, exact);
+    if (i >= 0) {
+      arma::cube Z(p, m, n);
+      arma::cube H(p, p, (n - 1) * Htv + 1);
+      arma::cube T(m, m, n);
+      arma::cube R(m, k, (n - 1) * Rtv + 1);
+      arma::mat D(p, n);
+      arma::mat C(m, n);
+      mgg_ssm approx_model(y, Z, H, T, R, a1_fn(theta, known_params), 
+        P1_fn(theta, known_params), arma::cube(0,0,0), arma::mat(0,0), D, C, seed);
+      linearize(approx_model, cached_modes.mode(i));
+      if (exact) {
+        mode_estimate = cached_modes.mode(i);
+      } else {
+        mode_estimate = approximate(approx_model, max_iter, conv_tol);
+        if (mode_estimate.is_finite()) {
+          cached_modes.insert(theta, mode_estimate);
+        }
+      }
+      return approx_model;
+    }
+  }
+  
   // initial approximation is based on EKF (at and att)
   arma::mat at(m, n + 1);
   arma::mat att(m, n);
@@ -801,49 +1005,233 @@ mgg_ssm nlg_ssm::approximate(arma::mat& mode_estimate,
       arma::mat(0,0), D, C, seed);
     return approx_model;
   }
-  arma::vec a1 = a1_fn(theta, known_params);
-  arma::mat P1 = P1_fn(theta, known_params);
   arma::cube Z(p, m, n);
-  for (unsigned int t = 0; t < Z.n_slices; t++) {
-    Z.slice(t) = Z_gn(t, at.col(t), theta, known_params, known_tv_params);
-  }
   arma::cube H(p, p, (n - 1) * Htv + 1);
-  for (unsigned int t = 0; t < H.n_slices; t++) {
-    H.slice(t) = H_fn(t, at.col(t), theta, known_params, known_tv_params);
-  }
   arma::cube T(m, m, n);
-  for (unsigned int t = 0; t < T.n_slices; t++) {
-    T.slice(t) = T_gn(t, att.col(t), theta, known_params, known_tv_params);
+  arma::cube R(m, k, (n - 1) * Rtv + 1);
+  arma::mat D(p, n);
+  arma::mat C(m, n);
+  mgg_ssm approx_model(y, Z, H, T, R, a1_fn(theta, known_params), 
+    P1_fn(theta, known_params), arma::cube(0,0,0), arma::mat(0,0), D, C, seed);
+  linearize(approx_model, at, att);
+  
+  // Refine approximation iteratively
+  mode_estimate = approximate(approx_model, max_iter, conv_tol);
+  if (use_cache && mode_estimate.is_finite()) {
+    cached_modes.insert(theta, mode_estimate);
+  }
+  return approx_model;
+}
+
+// linearize the model at alpha
+void nlg_ssm::linearize(mgg_ssm& approx_model, const arma::mat& alpha) const {
+  linearize(approx_model, alpha, alpha);
+}
+
+// linearize the observation equation at alpha_Z and the state equation at alpha_T
+// the time points are independent, so they are linearized in parallel in blocks 
+// of consecutive time points (the model functions need to be thread safe), 
+// unless already called from a parallel region
+void nlg_ssm::linearize(mgg_ssm& approx_model, const arma::mat& alpha_Z, 
+  const arma::mat& alpha_T) const {
+  
+  // exceptions of the model functions can not leave the parallel region
+  std::exception_ptr error = nullptr;
+  
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads) if(n_threads > 1 && !omp_in_parallel())
+{
+#endif
+  
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+  for (unsigned int t = 0; t < n; t++) {
+    try {
+      // views to the columns of alpha without copying
+      const arma::vec alpha_Z_t(const_cast<double*>(alpha_Z.colptr(t)), m, false, true);
+      const arma::vec alpha_T_t(const_cast<double*>(alpha_T.colptr(t)), m, false, true);
+      if (t < approx_model.Z.n_slices) {
+        approx_model.Z.slice(t) = Z_gn(t, alpha_Z_t, theta, known_params, known_tv_params);
+      }
+      if (t < approx_model.T.n_slices) {
+        approx_model.T.slice(t) = T_gn(t, alpha_T_t, theta, known_params, known_tv_params);
+      }
+      if (t < approx_model.H.n_slices) {
+        approx_model.H.slice(t) = H_fn(t, alpha_Z_t, theta, known_params, known_tv_params);
+      }
+      if (t < approx_model.R.n_slices) {
+        approx_model.R.slice(t) = R_fn(t, alpha_T_t, theta, known_params, known_tv_params);
+      }
+    } catch (...) {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+{
+  error = std::current_exception();
+}
+    }
+  }
+  // intercepts are computed once all the Jacobians are available
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+  for (unsigned int t = 0; t < n; t++) {
+    try {
+      const arma::vec alpha_Z_t(const_cast<double*>(alpha_Z.colptr(t)), m, false, true);
+      const arma::vec alpha_T_t(const_cast<double*>(alpha_T.colptr(t)), m, false, true);
+      approx_model.D.col(t) = Z_fn(t, alpha_Z_t, theta, known_params, known_tv_params) -
+        approx_model.Z.slice(t * approx_model.Ztv) * alpha_Z_t;
+      approx_model.C.col(t) = T_fn(t, alpha_T_t, theta, known_params, known_tv_params) -
+        approx_model.T.slice(t * approx_model.Ttv) * alpha_T_t;
+    } catch (...) {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+{
+  error = std::current_exception();
+}
+    }
   }
   
-  arma::cube R(m, k, (n - 1) * Rtv + 1);
-  for (unsigned int t = 0; t < R.n_slices; t++) {
-    R.slice(t) = R_fn(t, att.col(t), theta, known_params, known_tv_params);
+#ifdef _OPENMP
+}
+#endif
+  if (error) {
+    std::rethrow_exception(error);
   }
-  arma::mat D(p, n,arma::fill::zeros);
-  arma::mat C(m, n,arma::fill::zeros);
+  approx_model.compute_HH();
+  approx_model.compute_RR();
+}
+
+// statistical linearization of Z and T with respect to N(alpha_t, V_t), i.e. 
+// Z_t = cov(Z(alpha_t), alpha_t) V_t^-1 and D_t = E(Z(alpha_t)) - Z_t alpha_t 
+// computed with the sigma points, and similarly for T and C. The variances are 
+// evaluated at alpha_t as in the mode based linearization.
+void nlg_ssm::statistical_linearize(mgg_ssm& approx_model, const arma::mat& alpha, 
+  const arma::cube& V) const {
   
+  unsigned int n_sigma = 2 * m + 1;
+  arma::vec wm;
+  arma::vec wc;
+  double sqrt_m_lambda = sigma_weights(m, 1.0, 0.0, 2.0, wm, wc);
+  
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1 && !omp_in_parallel())
+#endif
   for (unsigned int t = 0; t < n; t++) {
-    D.col(t) = Z_fn(t, at.col(t), theta, known_params, known_tv_params) -
-      Z.slice(t) * at.col(t);
-    C.col(t) =  T_fn(t, att.col(t), theta, known_params, known_tv_params) -
-      T.slice(t) * att.col(t);
+    // square root and pseudoinverse of V_t from the eigendecomposition, 
+    // as V_t can be singular
+    arma::vec eigval;
+    arma::mat eigvec;
+    if (!arma::eig_sym(eigval, eigvec, arma::symmatu(V.slice(t)))) {
+      eigval.zeros(m);
+      eigvec.eye(m, m);
+    }
+    arma::uvec nonzero = arma::find(eigval > zero_tol * std::max(1.0, eigval.max()));
+    arma::mat L = eigvec.cols(nonzero) * arma::diagmat(arma::sqrt(eigval(nonzero)));
+    arma::mat V_inv = eigvec.cols(nonzero) * arma::diagmat(1.0 / eigval(nonzero)) * 
+      eigvec.cols(nonzero).t();
+    arma::mat sigma = sigma_points(alpha.col(t), 
+      arma::join_horiz(L, arma::zeros(m, m - nonzero.n_elem)), sqrt_m_lambda);
+    
+    arma::mat sigma_Z(p, n_sigma);
+    Z_cols(t, sigma, sigma_Z);
+    arma::vec mean_Z = sigma_Z * wm;
+    arma::mat cov_Z(p, m, arma::fill::zeros);
+    for (unsigned int i = 0; i < n_sigma; i++) {
+      cov_Z += wc(i) * (sigma_Z.col(i) - mean_Z) * (sigma.col(i) - alpha.col(t)).t();
+    }
+    approx_model.Z.slice(t) = cov_Z * V_inv;
+    approx_model.D.col(t) = mean_Z - approx_model.Z.slice(t) * alpha.col(t);
+    
+    arma::mat sigma_T(m, n_sigma);
+    T_cols(t, sigma, sigma_T);
+    arma::vec mean_T = sigma_T * wm;
+    arma::mat cov_T(m, m, arma::fill::zeros);
+    for (unsigned int i = 0; i < n_sigma; i++) {
+      cov_T += wc(i) * (sigma_T.col(i) - mean_T) * (sigma.col(i) - alpha.col(t)).t();
+    }
+    approx_model.T.slice(t) = cov_T * V_inv;
+    approx_model.C.col(t) = mean_T - approx_model.T.slice(t) * alpha.col(t);
+    
+    if (t < approx_model.H.n_slices) {
+      approx_model.H.slice(t) = H_fn(t, alpha.col(t), theta, known_params, known_tv_params);
+    }
+    if (t < approx_model.R.n_slices) {
+      approx_model.R.slice(t) = R_fn(t, alpha.col(t), theta, known_params, known_tv_params);
+    }
   }
+  approx_model.compute_HH();
+  approx_model.compute_RR();
+}
+
+// Gaussian approximation based on the unscented Kalman smoother, refined by 
+// iterated posterior linearization: the model is linearized statistically with 
+// respect to the smoothed distributions of the current approximating model until 
+// the mean squared change of the smoothed means is below conv_tol. 
+// mode_estimate contains the smoothed means of the final approximating model.
+mgg_ssm nlg_ssm::approximate_unscented(arma::mat& mode_estimate, 
+  const unsigned int max_iter, const double conv_tol) const {
+  profiler::timer timer(profiler::approximate);
   
-  mgg_ssm approx_model(y, Z, H, T, R, a1, P1, arma::cube(0,0,0),
-    arma::mat(0,0), D, C, seed);
-  // Refine approximation iteratively
-  mode_estimate = approximate(approx_model, max_iter, conv_tol);
+  arma::cube Z(p, m, n);
+  arma::cube H(p, p, (n - 1) * Htv + 1);
+  arma::cube T(m, m, n);
+  arma::cube R(m, k, (n - 1) * Rtv + 1);
+  arma::mat D(p, n, arma::fill::zeros);
+  arma::mat C(m, n, arma::fill::zeros);
+  mgg_ssm approx_model(y, Z, H, T, R, a1_fn(theta, known_params), 
+    P1_fn(theta, known_params), arma::cube(0,0,0), arma::mat(0,0), D, C, seed);
+  
+  arma::mat alphahat(m, n);
+  arma::cube Vt(m, m, n);
+  double loglik = ukf_smoother(alphahat, Vt);
+  if (!arma::is_finite(loglik)) {
+    mode_estimate.fill(std::numeric_limits<double>::infinity());
+    return approx_model;
+  }
+  statistical_linearize(approx_model, alphahat, Vt);
   
+  arma::mat at(m, n + 1);
+  arma::cube Pt(m, m, n + 1);
+  double diff = 1.0e300;
+  unsigned int i = 0;
+  while (i < max_iter && diff > conv_tol) {
+    i++;
+    profiler::count(profiler::laplace_iterations);
+    approx_model.smoother(at, Pt);
+    if (!at.is_finite() || !Pt.is_finite()) {
+      mode_estimate.fill(std::numeric_limits<double>::infinity());
+      return approx_model;
+    }
+    diff = arma::mean(arma::mean(arma::square(at.head_cols(n) - alphahat)));
+    alphahat = at.head_cols(n);
+    statistical_linearize(approx_model, alphahat, Pt.head_slices(n));
+  }
+  if (i == max_iter && max_iter > 0) {
+    mode_estimate.fill(std::numeric_limits<double>::infinity());
+    return approx_model;
+  }
+  mode_estimate = smoothed_mode(approx_model);
   return approx_model;
 }
 
+// smoothed means of the states of the approximating model
+arma::mat nlg_ssm::smoothed_mode(const mgg_ssm& approx_model) const {
+  if (parallel_scan) {
+    return parallel_smoother(approx_model, n_threads);
+  }
+  return approx_model.fast_smoother().head_cols(n);
+}
+
 arma::mat nlg_ssm::approximate(mgg_ssm& approx_model,
   const unsigned int max_iter, const double conv_tol) const {
+  profiler::timer timer(profiler::approximate);
   
   
   //check model
-  arma::mat mode_estimate = approx_model.fast_smoother().head_cols(n);
+  arma::mat mode_estimate = smoothed_mode(approx_model);
   if (!arma::is_finite(mode_estimate)) {
     return mode_estimate;
   }
@@ -856,31 +1244,11 @@ arma::mat nlg_ssm::approximate(mgg_ssm& approx_model,
   while(i < max_iter && rel_diff > conv_tol && abs_diff > 1e-4) {
     
     i++;
-    for (unsigned int t = 0; t < approx_model.Z.n_slices; t++) {
-      approx_model.Z.slice(t) = Z_gn(t, mode_estimate.col(t), theta, known_params, known_tv_params);
-    }
-    
-    for (unsigned int t = 0; t < approx_model.T.n_slices; t++) {
-      approx_model.T.slice(t) = T_gn(t, mode_estimate.col(t), theta, known_params, known_tv_params);
-    }
-    
-    for (unsigned int t = 0; t < n; t++) {
-      approx_model.D.col(t) = Z_fn(t, mode_estimate.col(t), theta, known_params, known_tv_params) -
-        approx_model.Z.slice(t * Zgtv) * mode_estimate.col(t);
-      approx_model.C.col(t) =  T_fn(t, mode_estimate.col(t), theta, known_params, known_tv_params) -
-        approx_model.T.slice(t * Tgtv) * mode_estimate.col(t);
-    }
-    for (unsigned int t = 0; t < approx_model.H.n_slices; t++) {
-      approx_model.H.slice(t) = H_fn(t, mode_estimate.col(t), theta, known_params, known_tv_params);
-    }
-    for (unsigned int t = 0; t < approx_model.R.n_slices; t++) {
-      approx_model.R.slice(t) = R_fn(t, mode_estimate.col(t), theta, known_params, known_tv_params);
-    }
-    approx_model.compute_HH();
-    approx_model.compute_RR();
+    profiler::count(profiler::laplace_iterations);
+    linearize(approx_model, mode_estimate);
     
     // compute new value of mode
-    arma::mat mode_estimate_new = approx_model.fast_smoother().head_cols(n);
+    arma::mat mode_estimate_new = smoothed_mode(approx_model);
     double ll_new = log_signal_pdf(mode_estimate_new);
     abs_diff = ll_new - ll;
     rel_diff = abs_diff / std::abs(ll);
@@ -935,10 +1303,17 @@ arma::vec nlg_ssm::log_weights(const mgg_ssm& approx_model,
   if (na_y.n_elem < p) {
     
     // original H depends on time or state <=> approx H depends on time or state, or missing values
+    arma::mat alpha_t(m, alpha.n_slices);
+    for (unsigned int i = 0; i < alpha.n_slices; i++) {
+      alpha_t.col(i) = alpha.slice(i).col(t);
+    }
+    arma::mat Z_t(p, alpha.n_slices);
+    Z_cols(t, alpha_t, Z_t);
+    
     if(Htv == 1 || na_y.n_elem > 0) {
       for (unsigned int i = 0; i < alpha.n_slices; i++) {
         weights(i) = 
-          dmvnorm(y.col(t), Z_fn(t, alpha.slice(i).col(t), theta, known_params, known_tv_params), 
+          dmvnorm(y.col(t), Z_t.col(i), 
             H_fn(t, alpha.slice(i).col(t), theta, known_params, known_tv_params), true, true) -
               dmvnorm(y.col(t), approx_model.D.col(t) + approx_model.Z.slice(t * approx_model.Ztv) * alpha.slice(i).col(t),  
                 approx_model.H.slice(t * approx_model.Htv), true, true);
@@ -955,8 +1330,7 @@ arma::vec nlg_ssm::log_weights(const mgg_ssm& approx_model,
       double constant_a = precompute_dmvnorm(H_a, Linv_a, nonzero_a);
       
       for (unsigned int i = 0; i < alpha.n_slices; i++) {
-        weights(i) = fast_dmvnorm(y.col(t), Z_fn(t, alpha.slice(i).col(t), 
-          theta, known_params, known_tv_params), Linv, nonzero, constant) -
+        weights(i) = fast_dmvnorm(y.col(t), Z_t.col(i), Linv, nonzero, constant) -
             fast_dmvnorm(y.col(t), approx_model.D.col(t) + 
             approx_model.Z.slice(t * approx_model.Ztv) * alpha.slice(i).col(t),  
             Linv_a, nonzero_a, constant_a);
@@ -965,9 +1339,11 @@ arma::vec nlg_ssm::log_weights(const mgg_ssm& approx_model,
   }
   arma::vec weights_t(alpha.n_slices, arma::fill::zeros);
   if(t > 0) {
+    arma::mat T_prev(m, alpha.n_slices);
+    T_cols(t - 1, alpha_prev, T_prev);
     for (unsigned int i = 0; i < alpha.n_slices; i++) {
       
-      arma::vec mean = T_fn(t - 1, alpha_prev.col(i), theta, known_params, known_tv_params);
+      arma::vec mean = T_prev.col(i);
       arma::mat cov = R_fn(t - 1, alpha_prev.col(i), theta, known_params, known_tv_params);
       cov = cov * cov.t();
       arma::vec approx_mean = approx_model.C.col(t - 1) + 
@@ -1028,9 +1404,16 @@ arma::vec nlg_ssm::log_obs_density(const unsigned int t,
   
   arma::uvec na_y = arma::find_nonfinite(y.col(t));
   if (na_y.n_elem < p) {
+    arma::mat alpha_t(m, alpha.n_slices);
+    for (unsigned int i = 0; i < alpha.n_slices; i++) {
+      alpha_t.col(i) = alpha.slice(i).col(t);
+    }
+    arma::mat Z_t(p, alpha.n_slices);
+    Z_cols(t, alpha_t, Z_t);
+    // H can depend on the state even if it is not time-varying
     for (unsigned int i = 0; i < alpha.n_slices; i++) {
-      weights(i) = dmvnorm(y.col(t), Z_fn(t, alpha.slice(i).col(t), theta, known_params, known_tv_params), 
-        H_fn(t, alpha.slice(i).col(t), theta, known_params, known_tv_params), true, true);
+      weights(i) = dmvnorm(y.col(t), Z_t.col(i), 
+        H_fn(t, alpha_t.col(i), theta, known_params, known_tv_params), true, true);
     }
   }
   return weights;
@@ -1054,6 +1437,7 @@ double nlg_ssm::psi_filter(const mgg_ssm& approx_model,
   const double approx_loglik,
   const unsigned int nsim, arma::cube& alpha, arma::mat& weights,
   arma::umat& indices) {
+  profiler::timer timer(profiler::psi_filter);
   
   arma::mat alphahat(m, n + 1);
   arma::cube Vt(m, m, n + 1);
@@ -1144,6 +1528,7 @@ double nlg_ssm::psi_filter(const mgg_ssm& approx_model,
 
 double nlg_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
   arma::mat& weights, arma::umat& indices) {
+  profiler::timer timer(profiler::bsf_filter);
   
   arma::vec a1 = a1_fn(theta, known_params);
   arma::mat P1 = P1_fn(theta, known_params);
@@ -1186,6 +1571,35 @@ double nlg_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
       r(i) = unif(engine);
     }
     
+    bool observed = t < (n - 1) && 
+      arma::uvec(arma::find_nonfinite(y.col(t + 1))).n_elem < p;
+    // in the auxiliary filter, the particles are resampled using first stage 
+    // weights g(y_t+1 | T(alpha_t)) evaluated at the predicted means, and the 
+    // likelihood increment is the product of the weighted means of the first 
+    // and second stage weights (Pitt and Shephard, 1999)
+    arma::mat T_t(m, nsim);
+    arma::vec first_stage;
+    if (auxiliary && observed) {
+      arma::mat alpha_t(m, nsim);
+      for (unsigned int i = 0; i < nsim; i++) {
+        alpha_t.col(i) = alpha.slice(i).col(t);
+      }
+      T_cols(t, alpha_t, T_t);
+      for (unsigned int i = 0; i < nsim; i++) {
+        alpha.slice(i).col(t + 1) = T_t.col(i);
+      }
+      first_stage = log_obs_density(t + 1, alpha);
+      double max_weight = first_stage.max();
+      arma::vec aux_weights = normalized_weights % arma::exp(first_stage - max_weight);
+      double sum_weights = arma::accu(aux_weights);
+      if(sum_weights > 0.0){
+        normalized_weights = aux_weights / sum_weights;
+      } else {
+        return -std::numeric_limits<double>::infinity();
+      }
+      loglik += max_weight + std::log(sum_weights);
+    }
+    
     indices.col(t) = stratified_sample(normalized_weights, r, nsim);
     
     arma::mat alphatmp(m, nsim);
@@ -1194,17 +1608,26 @@ double nlg_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
       alphatmp.col(i) = alpha.slice(indices(i, t)).col(t);
     }
     
+    if (auxiliary && observed) {
+      T_t = T_t.cols(arma::uvec(indices.col(t)));
+      first_stage = first_stage.elem(arma::uvec(indices.col(t)));
+    } else {
+      T_cols(t, alphatmp, T_t);
+    }
     for (unsigned int i = 0; i < nsim; i++) {
       arma::vec uk(k);
       for(unsigned int j = 0; j < k; j++) {
         uk(j) = normal(engine);
       }
-      alpha.slice(i).col(t + 1) = T_fn(t, alphatmp.col(i), theta, known_params, known_tv_params) + 
+      alpha.slice(i).col(t + 1) = T_t.col(i) + 
         R_fn(t, alphatmp.col(i), theta, known_params, known_tv_params) * uk;
     }
     
-    if (t < (n - 1) && arma::uvec(arma::find_nonfinite(y.col(t + 1))).n_elem < p) {
+    if (observed) {
       weights.col(t + 1) = log_obs_density(t + 1, alpha);
+      if (auxiliary) {
+        weights.col(t + 1) -= first_stage;
+      }
       
       double max_weight = weights.col(t + 1).max();
       weights.col(t + 1) = arma::exp(weights.col(t + 1) - max_weight);
@@ -1226,18 +1649,42 @@ double nlg_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
 
 // EKF-based particle filter (van der Merwe et al)
 
+// log-density of the proposal sample mean + L * u at u, where L is the lower 
+// triangular Cholesky factor from psd_chol, so that no inversion of L is needed
+static double proposal_log_density(const arma::mat& L, const arma::vec& u) {
+  
+  arma::vec L_diag = L.diag();
+  arma::uvec nonzero = arma::find(L_diag > 0);
+  return -0.5 * (nonzero.n_elem * std::log(2.0 * M_PI) + 
+    arma::accu(arma::square(u(nonzero)))) - arma::accu(arma::log(L_diag(nonzero)));
+}
+
+// particle filter with a proposal from the extended (or unscented) Kalman filter 
+// update of the transition density of each particle. The Cholesky factors of the 
+// proposals and the transition densities are computed once per particle and 
+// reused for sampling and for the weights
 double nlg_ssm::ekf_filter(const unsigned int nsim, arma::cube& alpha,
-  arma::mat& weights, arma::umat& indices) {
+  arma::mat& weights, arma::umat& indices, const bool unscented) {
+  profiler::timer timer(profiler::ekf_filter);
   arma::vec a1 = a1_fn(theta, known_params);
   arma::mat P1 = P1_fn(theta, known_params);
+  arma::mat L_P1 = psd_chol(P1);
   
   arma::vec att1(m);
   arma::mat Ptt1(m, m);
-  ekf_update_step(0, y.col(0), a1, P1, att1, Ptt1);
+  if (unscented) {
+    ukf_update_step(0, y.col(0), a1, L_P1, att1, Ptt1);
+  } else {
+    ekf_update_step(0, y.col(0), a1, P1, att1, Ptt1);
+  }
   
-  arma::uvec nonzero = arma::find(Ptt1.diag() > 0);
   arma::mat L = psd_chol(Ptt1);
+  arma::uvec nonzero_P1 = arma::find(L_P1.diag() > 0);
+  arma::mat Linv_P1(nonzero_P1.n_elem, nonzero_P1.n_elem);
+  double constant_P1 = precompute_dmvnorm(L_P1, Linv_P1, nonzero_P1);
+  
   std::normal_distribution<> normal(0.0, 1.0);
+  arma::vec log_q(nsim);
   for (unsigned int i = 0; i < nsim; i++) {
     
     arma::vec um(m);
@@ -1246,7 +1693,7 @@ double nlg_ssm::ekf_filter(const unsigned int nsim, arma::cube& alpha,
     }
     
     alpha.slice(i).col(0) = att1 + L * um;
-    
+    log_q(i) = proposal_log_density(L, um);
   }
   
   std::uniform_real_distribution<> unif(0.0, 1.0);
@@ -1256,8 +1703,8 @@ double nlg_ssm::ekf_filter(const unsigned int nsim, arma::cube& alpha,
   if (na_y.n_elem < p) { 
     weights.col(0) = log_obs_density(0, alpha);
     for (unsigned int i = 0; i < nsim; i++) {
-      weights(i, 0) +=  dmvnorm(alpha.slice(i).col(0), a1, P1, false, true) -
-        dmvnorm(alpha.slice(i).col(0), att1, L, true, true);
+      weights(i, 0) += fast_dmvnorm(alpha.slice(i).col(0), a1, Linv_P1, 
+        nonzero_P1, constant_P1) - log_q(i);
     }
     
     
@@ -1275,6 +1722,13 @@ double nlg_ssm::ekf_filter(const unsigned int nsim, arma::cube& alpha,
     weights.col(0).ones();
     normalized_weights.fill(1.0 / nsim);
   }
+  
+  arma::mat at(m, nsim);
+  arma::mat att(m, nsim);
+  arma::cube L_Ptt(m, m, nsim);
+  // factors of the transition densities of each particle, as R can depend on 
+  // the state even if it is not time-varying
+  arma::cube L_RR(m, m, nsim);
   for (unsigned int t = 0; t < n; t++) {
     
     arma::vec r(nsim);
@@ -1284,22 +1738,31 @@ double nlg_ssm::ekf_filter(const unsigned int nsim, arma::cube& alpha,
     
     indices.col(t) = stratified_sample(normalized_weights, r, nsim);
     
-    arma::mat att(m, nsim);
-    arma::cube Ptt(m, m, nsim);
     arma::mat alphatmp(m, nsim);
     for (unsigned int i = 0; i < nsim; i++) {
       alphatmp.col(i) = alpha.slice(indices(i, t)).col(t);
-      arma::mat Rt = R_fn(t,  alphatmp.col(i), theta, known_params, known_tv_params);
-      arma::mat Pt = Rt * Rt.t();
-      arma::vec at = T_fn(t, alphatmp.col(i), theta, known_params, known_tv_params);
-      arma::vec tmp(m);
-      if (t < (n - 1)) {
-        ekf_update_step(t + 1, y.col(t + 1), at, Pt, tmp, Ptt.slice(i));
+    }
+    T_cols(t, alphatmp, at);
+    bool update = t < (n - 1) && 
+      arma::uvec(arma::find_nonfinite(y.col(t + 1))).n_elem < p;
+    for (unsigned int i = 0; i < nsim; i++) {
+      arma::mat Rt = R_fn(t, alphatmp.col(i), theta, known_params, known_tv_params);
+      arma::mat RR = Rt * Rt.t();
+      L_RR.slice(i) = psd_chol(RR);
+      const arma::mat& L_RR_i = L_RR.slice(i);
+      if (update) {
+        arma::vec tmp(m);
+        arma::mat Ptt(m, m);
+        if (unscented) {
+          ukf_update_step(t + 1, y.col(t + 1), at.col(i), L_RR_i, tmp, Ptt);
+        } else {
+          ekf_update_step(t + 1, y.col(t + 1), at.col(i), RR, tmp, Ptt);
+        }
         att.col(i) = tmp;
-        Ptt.slice(i) = psd_chol(Ptt.slice(i));
+        L_Ptt.slice(i) = psd_chol(Ptt);
       } else {
-        att.col(i) = at;
-        Ptt.slice(i) = Pt;  
+        att.col(i) = at.col(i);
+        L_Ptt.slice(i) = L_RR_i;
       }
     }
     
@@ -1308,16 +1771,18 @@ double nlg_ssm::ekf_filter(const unsigned int nsim, arma::cube& alpha,
       for(unsigned int j = 0; j < m; j++) {
         um(j) = normal(engine);
       }
-      alpha.slice(i).col(t + 1) = att.col(i) + Ptt.slice(i) * um;
+      alpha.slice(i).col(t + 1) = att.col(i) + L_Ptt.slice(i) * um;
+      if (update) {
+        log_q(i) = proposal_log_density(L_Ptt.slice(i), um);
+      }
     } 
-    if (t < (n - 1) && arma::uvec(arma::find_nonfinite(y.col(t + 1))).n_elem < p) {
+    if (update) {
       weights.col(t + 1) = log_obs_density(t + 1, alpha);
       for (unsigned int i = 0; i < nsim; i++) {
-        arma::mat Rt = R_fn(t,  alphatmp.col(i), theta, known_params, known_tv_params);
-        arma::mat RR = Rt * Rt.t();
-        arma::vec mean = T_fn(t, alphatmp.col(i), theta, known_params, known_tv_params);
-        weights(i, t + 1) +=  dmvnorm(alpha.slice(i).col(t + 1), mean, RR, false, true) -
-          dmvnorm(alpha.slice(i).col(t + 1), att.col(i), Ptt.slice(i), true, true);
+        // each factor is used once, so solve instead of inverting it
+        arma::uvec nonzero_RR = arma::find(L_RR.slice(i).diag() > 0);
+        weights(i, t + 1) += chol_dmvnorm(alpha.slice(i).col(t + 1), at.col(i), 
+          L_RR.slice(i), nonzero_RR) - log_q(i);
       }
       double max_weight = weights.col(t + 1).max();
       weights.col(t + 1) = arma::exp(weights.col(t + 1) - max_weight);
@@ -1369,6 +1834,40 @@ void nlg_ssm::ekf_update_step(const unsigned int t, const arma::vec y,
   } 
 }
 
+// unscented Kalman filter update of N(at, L L') with y_t
+void nlg_ssm::ukf_update_step(const unsigned int t, const arma::vec y, 
+  const arma::vec& at, const arma::mat& L, arma::vec& att, arma::mat& Ptt) const {
+  
+  arma::uvec obs_y = arma::find_finite(y);
+  
+  if (obs_y.n_elem > 0) {
+    unsigned int n_sigma = 2 * m + 1;
+    arma::vec wm;
+    arma::vec wc;
+    double sqrt_m_lambda = sigma_weights(m, 1.0, 0.0, 2.0, wm, wc);
+    arma::mat sigma = sigma_points(at, L, sqrt_m_lambda);
+    
+    arma::mat sigma_y(p, n_sigma);
+    Z_cols(t, sigma, sigma_y);
+    sigma_y = sigma_y.rows(obs_y);
+    arma::vec pred_mean = sigma_y * wm;
+    arma::mat H = H_fn(t, at, theta, known_params, known_tv_params).rows(obs_y);
+    arma::mat pred_var = H * H.t();
+    arma::mat pred_cov(m, obs_y.n_elem, arma::fill::zeros);
+    for (unsigned int i = 0; i < n_sigma; i++) {
+      arma::vec tmp = sigma_y.col(i) - pred_mean;
+      pred_var += wc(i) * tmp * tmp.t();
+      pred_cov += wc(i) * (sigma.col(i) - at) * tmp.t();
+    }
+    arma::mat K = arma::solve(arma::symmatu(pred_var), pred_cov.t()).t();
+    att = at + K * (y.elem(obs_y) - pred_mean);
+    Ptt = arma::symmatu(L * L.t() - K * pred_var * K.t());
+  } else {
+    att = at;
+    Ptt = L * L.t();
+  }
+}
+
 double nlg_ssm::log_signal_pdf(const arma::mat& alpha) const {
   
   double ll = dmvnorm(alpha.col(0), a1_fn(theta, known_params), 
@@ -6,6 +6,8 @@
 #include <sitmo.h>
 #include "bssm.h"
 #include "mgg_ssm.h"
+#include "mode_cache.h"
+#include "quantile_sketch.h"
 
 
 // typedef for a pointer of nonlinear function of model equation returning vec (T, Z)
@@ -14,6 +16,11 @@ typedef arma::vec (*nvec_fnPtr)(const unsigned int t, const arma::vec& alpha, co
 // typedef for a pointer of nonlinear function of model equation returning mat (Tg, Zg, H, R)
 typedef arma::mat (*nmat_fnPtr)(const unsigned int t, const arma::vec& alpha, const arma::vec& theta, 
   const arma::vec& known_params, const arma::mat& known_tv_params);
+// typedef for a pointer of batched nonlinear function of model equation (T, Z), 
+// which evaluates the function at all columns (particles) of alpha at once and 
+// writes the values to the corresponding columns of the preallocated result
+typedef void (*nbatch_fnPtr)(const unsigned int t, const arma::mat& alpha, const arma::vec& theta, 
+  const arma::vec& known_params, const arma::mat& known_tv_params, arma::mat& result);
 
 // typedef for a pointer returning a1
 typedef arma::vec (*a1_fnPtr)(const arma::vec& theta, const arma::vec& known_params);
@@ -40,14 +47,45 @@ public:
   // update the approximating Gaussian model
   arma::mat approximate(mgg_ssm& approx_model, const unsigned int max_iter, 
     const double conv_tol) const;
+  // linearize the model at alpha
+  void linearize(mgg_ssm& approx_model, const arma::mat& alpha) const;
+  void linearize(mgg_ssm& approx_model, const arma::mat& alpha_Z, 
+    const arma::mat& alpha_T) const;
+  // smoothed means of the states of the approximating model
+  arma::mat smoothed_mode(const mgg_ssm& approx_model) const;
+  // find the approximating Gaussian model by statistical linearization
+  mgg_ssm approximate_unscented(arma::mat& mode_estimate, 
+    const unsigned int max_iter, const double conv_tol) const;
+  // linearize the means of the model using sigma points of N(alpha_t, V_t)
+  void statistical_linearize(mgg_ssm& approx_model, const arma::mat& alpha, 
+    const arma::cube& V) const;
+  
+  // values of T and Z at the columns of alpha, using the batched functions if available
+  void T_cols(const unsigned int t, const arma::mat& alpha, arma::mat& result) const;
+  void Z_cols(const unsigned int t, const arma::mat& alpha, arma::mat& result) const;
+  
+#ifndef BSSM_STANDALONE
+  // set the batched functions given as external pointers (or NULL)
+  void set_batch_fns(SEXP T_batch, SEXP Z_batch);
   
   Rcpp::List predict_interval(const arma::vec& probs, const arma::mat& thetasim,
     const arma::mat& alpha_last, const arma::cube& P_last, 
-    const arma::uvec& counts, const unsigned int predict_type);
+    const arma::uvec& counts, const unsigned int predict_type, 
+    const bool unscented = false);
+#endif
+  // predictive means and covariances of the states or observations given 
+  // theta_i and alpha_1 ~ N(a1, P1), d x n and d x d x n
+  void predict_moments(const arma::vec& theta_i, const arma::vec& a1, 
+    const arma::mat& P1, const unsigned int predict_type, const bool unscented,
+    arma::mat& mean, arma::cube& cov) const;
   
   arma::cube predict_sample(const arma::mat& thetasim, const arma::mat& alpha, 
     const arma::uvec& counts, const unsigned int predict_type, 
     const unsigned int nsim);
+  // means and quantiles of the same samples without storing them
+  quantile_sketch predict_summary(const arma::mat& thetasim, const arma::mat& alpha, 
+    const arma::uvec& counts, const unsigned int predict_type, 
+    const unsigned int nsim);
   
   arma::cube sample_model(const arma::vec& a1_sim, 
     const unsigned int predict_type, const unsigned int nsim);
@@ -61,9 +99,17 @@ public:
   double ekf_fast_smoother(arma::mat& at, const unsigned int iekf_iter) const;
   
   double ukf(arma::mat& at, arma::mat& att, arma::cube& Pt, arma::cube& Ptt, 
-    const double alpha = 1.0, const double beta = 0.0, const double kappa = 2.0) const;
+    const double alpha = 1.0, const double beta = 0.0, const double kappa = 2.0,
+    const bool square_root = false) const;
+  // also computes the cross-covariances Ct of alpha_t and alpha_t+1 given y_1:t
+  double ukf(arma::mat& at, arma::mat& att, arma::cube& Pt, arma::cube& Ptt, 
+    arma::cube& Ct, const double alpha, const double beta, const double kappa,
+    const bool square_root) const;
+  double ukf_smoother(arma::mat& alphahat, arma::cube& Vt, 
+    const double alpha = 1.0, const double beta = 0.0, const double kappa = 2.0,
+    const bool square_root = false) const;
   
-    // bootstrap filter  
+  // bootstrap filter, or auxiliary particle filter if auxiliary is true
   double bsf_filter(const unsigned int nsim, arma::cube& alpha, 
     arma::mat& weights, arma::umat& indices);
   
@@ -72,9 +118,9 @@ public:
     const unsigned int nsim, arma::cube& alpha, arma::mat& weights,
     arma::umat& indices);
   
-  // extended Kalman particle filter
+  // extended (or unscented) Kalman particle filter
   double ekf_filter(const unsigned int nsim, arma::cube& alpha,
-    arma::mat& weights, arma::umat& indices);
+    arma::mat& weights, arma::umat& indices, const bool unscented = false);
   
   // compute logarithms of _unnormalized_ importance weights g(y_t | alpha_t) / ~g(~y_t | alpha_t)
   arma::vec log_weights(const mgg_ssm& approx_model, 
@@ -91,6 +137,9 @@ public:
   
   void ekf_update_step(const unsigned int t, const arma::vec y, 
     const arma::vec& at, const arma::mat& Pt, arma::vec& att, arma::mat& Ptt) const;
+  // same using the unscented transform, with the Cholesky factor L of Pt
+  void ukf_update_step(const unsigned int t, const arma::vec y, 
+    const arma::vec& at, const arma::mat& L, arma::vec& att, arma::mat& Ptt) const;
     
   double log_signal_pdf(const arma::mat& alpha) const;
   
@@ -106,6 +155,9 @@ public:
   //and the derivatives
   nmat_fnPtr Z_gn;
   nmat_fnPtr T_gn;
+  // optional batched versions of T and Z (null if not given)
+  nbatch_fnPtr T_batch_fn;
+  nbatch_fnPtr Z_batch_fn;
   //initial value
   a1_fnPtr a1_fn;
   P1_fnPtr P1_fn;
@@ -132,6 +184,16 @@ public:
   unsigned int seed;
   sitmo::prng_engine engine;
   const double zero_tol;
+  // converged modes of the approximations visited in MCMC
+  mutable mode_cache cached_modes;
+  // number of threads used in the linearization of the model
+  unsigned int n_threads;
+  // use the parallel-in-time smoother in the mode search
+  bool parallel_scan;
+  // use statistical linearization instead of the mode in the Gaussian approximation
+  bool unscented_approx;
+  // use the auxiliary particle filter in place of the bootstrap filter
+  bool auxiliary;
   
 };
 
@@ -0,0 +1,109 @@
+#include <stdexcept>
+#include <cstdint>
+#include <algorithm>
+#include "output_sink.h"
+
+namespace {
+const std::streamoff header_size = 64;
+// maximum size of the buffer in bytes
+const unsigned int buffer_bytes = 64 << 20;
+const char magic[8] = "BSSMOUT";
+
+void write_header(std::fstream& file, const unsigned int n_rows,
+  const unsigned int n_cols, const unsigned int n_par, const unsigned int n_stored,
+  const bool weights) {
+
+  char header[header_size] = {0};
+  std::copy(magic, magic + 8, header);
+  int32_t values[6] = {1, static_cast<int32_t>(n_rows), static_cast<int32_t>(n_cols),
+    static_cast<int32_t>(n_par), static_cast<int32_t>(n_stored), weights};
+  std::copy(reinterpret_cast<char*>(values), reinterpret_cast<char*>(values) + sizeof(values),
+    header + 8);
+  file.seekp(0);
+  file.write(header, header_size);
+}
+}
+
+output_sink::output_sink(const std::string& file_name, const unsigned int n_rows,
+  const unsigned int n_cols, const unsigned int n_par) :
+  n_rows(n_rows), n_cols(n_cols), n_par(n_par),
+  chunk_size(std::max(1u, buffer_bytes / (8 * n_rows * n_cols))),
+  file(file_name.c_str(), std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc),
+  buffer(n_rows, n_cols, chunk_size), filled(chunk_size, arma::fill::zeros),
+  buffer_start(0), closed(false) {
+
+  if (!file.is_open()) {
+    bssm::stop("Could not open the output file '%s'.", file_name);
+  }
+  write_header(file, n_rows, n_cols, n_par, 0, false);
+}
+
+void output_sink::write(const unsigned int i, const arma::mat& alpha) {
+
+  if (i < buffer_start || i >= buffer_start + chunk_size) {
+    flush();
+    buffer_start = i;
+  }
+  buffer.slice(i - buffer_start) = alpha;
+  filled(i - buffer_start) = 1;
+}
+
+void output_sink::write(const unsigned int i, const arma::cube& alpha) {
+  write_at(header_size + static_cast<std::streamoff>(i) * n_rows * n_cols * 8,
+    alpha.memptr(), alpha.n_elem);
+}
+
+// write the consecutive filled samples of the buffer at once
+void output_sink::flush() {
+
+  unsigned int j = 0;
+  while (j < chunk_size) {
+    if (filled(j)) {
+      unsigned int k = j;
+      while (k + 1 < chunk_size && filled(k + 1)) k++;
+      write_at(header_size +
+        static_cast<std::streamoff>(buffer_start + j) * n_rows * n_cols * 8,
+        buffer.slice(j).memptr(), (k - j + 1) * n_rows * n_cols);
+      j = k + 1;
+    } else {
+      j++;
+    }
+  }
+  filled.zeros();
+}
+
+void output_sink::write_at(const std::streamoff offset, const double* x,
+  const arma::uword n) {
+
+  file.seekp(offset);
+  file.write(reinterpret_cast<const char*>(x), n * sizeof(double));
+  // can be called from multiple threads, so bssm::stop can't be used here
+  if (!file) {
+    throw std::runtime_error("Writing to the output file failed.");
+  }
+}
+
+void output_sink::close(const arma::mat& theta, const arma::vec& posterior,
+  const arma::uvec& counts, const arma::vec& weights) {
+
+  if (closed) return;
+  flush();
+  unsigned int n_stored = posterior.n_elem;
+  std::streamoff offset = header_size +
+    static_cast<std::streamoff>(n_stored) * n_rows * n_cols * 8;
+  write_at(offset, theta.memptr(), theta.n_elem);
+  offset += theta.n_elem * 8;
+  write_at(offset, posterior.memptr(), n_stored);
+  offset += n_stored * 8;
+  arma::vec counts_double = arma::conv_to<arma::vec>::from(counts);
+  write_at(offset, counts_double.memptr(), n_stored);
+  offset += n_stored * 8;
+  bool has_weights = weights.n_elem == n_stored && n_stored > 0;
+  if (has_weights) {
+    write_at(offset, weights.memptr(), n_stored);
+  }
+  write_header(file, n_rows, n_cols, n_par, n_stored, has_weights);
+  file.close();
+  buffer.reset();
+  closed = true;
+}
@@ -0,0 +1,51 @@
+// writes the sampled states to a binary file instead of keeping them in memory,
+// only a buffer of at most chunk_size samples is kept in memory
+//
+// the file consists of a header of 64 bytes (magic "BSSMOUT", version,
+// dimensions n + 1 and m, n_par, number of samples and indicator for weights as
+// 32-bit integers), followed by the states as doubles in the same (column-major)
+// order as the n + 1 x m x n_samples array returned by run_mcmc, so that the
+// samples can be read (or memory mapped) individually. The theta (n_par x n_samples),
+// posterior, counts and possible weights are appended as doubles when the
+// output is closed.
+
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <fstream>
+#include "bssm.h"
+
+class output_sink {
+
+public:
+
+  output_sink(const std::string& file_name, const unsigned int n_rows,
+    const unsigned int n_cols, const unsigned int n_par);
+
+  // write the states of sample i, samples close to each other are buffered
+  void write(const unsigned int i, const arma::mat& alpha);
+  // write the states of samples i, ..., i + alpha.n_slices - 1 directly
+  void write(const unsigned int i, const arma::cube& alpha);
+  // write the remaining buffer and the parameter samples, and update the header
+  void close(const arma::mat& theta, const arma::vec& posterior,
+    const arma::uvec& counts, const arma::vec& weights);
+
+  const unsigned int n_rows;
+  const unsigned int n_cols;
+  const unsigned int n_par;
+  // maximum number of samples in the buffer
+  const unsigned int chunk_size;
+
+private:
+
+  void flush();
+  void write_at(const std::streamoff offset, const double* x, const arma::uword n);
+
+  std::fstream file;
+  arma::cube buffer;
+  arma::uvec filled;
+  unsigned int buffer_start;
+  bool closed;
+};
+
+#endif
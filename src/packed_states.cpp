@@ -0,0 +1,118 @@
+#include <cstring>
+#include <cstdint>
+#include "packed_states.h"
+#include "rep_mat.h"
+
+packed_states::packed_states(const unsigned int n_rows, const unsigned int n_cols,
+  const unsigned int n_slices, const unsigned int precision) :
+  n_rows(n_rows), n_cols(n_cols), n_slices(n_slices), precision(precision),
+  bytes(precision == 2 ? 4 : (precision == 3 ? 2 : 1)),
+  data(precision > 1 ? static_cast<size_t>(n_rows) * n_cols * n_slices * bytes : 0),
+  offset(n_cols, (precision > 2) * n_slices, arma::fill::zeros),
+  scale(n_cols, (precision > 2) * n_slices, arma::fill::zeros) {
+}
+
+void packed_states::pack(const unsigned int i, const arma::mat& x) {
+
+  unsigned char* ptr = &data[static_cast<size_t>(i) * n_rows * n_cols * bytes];
+  if (precision == 2) {
+    arma::fmat x_float = arma::conv_to<arma::fmat>::from(x);
+    std::memcpy(ptr, x_float.memptr(), x.n_elem * bytes);
+  } else {
+    double levels = precision == 3 ? 65535.0 : 255.0;
+    for (unsigned int j = 0; j < n_cols; j++) {
+      double lo = x.col(j).min();
+      double range = x.col(j).max() - lo;
+      offset(j, i) = lo;
+      scale(j, i) = range > 0 ? range / levels : 0.0;
+      for (unsigned int t = 0; t < n_rows; t++) {
+        double code = range > 0 ? std::round((x(t, j) - lo) / scale(j, i)) : 0.0;
+        if (precision == 3) {
+          uint16_t value = static_cast<uint16_t>(code);
+          std::memcpy(ptr, &value, 2);
+        } else {
+          *ptr = static_cast<uint8_t>(code);
+        }
+        ptr += bytes;
+      }
+    }
+  }
+}
+
+arma::mat packed_states::unpack(const unsigned int i) const {
+
+  arma::mat x(n_rows, n_cols);
+  const unsigned char* ptr = &data[static_cast<size_t>(i) * n_rows * n_cols * bytes];
+  if (precision == 2) {
+    arma::fmat x_float(n_rows, n_cols);
+    std::memcpy(x_float.memptr(), ptr, x.n_elem * bytes);
+    x = arma::conv_to<arma::mat>::from(x_float);
+  } else {
+    for (unsigned int j = 0; j < n_cols; j++) {
+      for (unsigned int t = 0; t < n_rows; t++) {
+        double code;
+        if (precision == 3) {
+          uint16_t value;
+          std::memcpy(&value, ptr, 2);
+          code = value;
+        } else {
+          code = *ptr;
+        }
+        x(t, j) = offset(j, i) + scale(j, i) * code;
+        ptr += bytes;
+      }
+    }
+  }
+  return x;
+}
+
+void packed_states::resize(const unsigned int n) {
+  n_slices = n;
+  data.resize(static_cast<size_t>(n_rows) * n_cols * n_slices * bytes);
+  if (precision > 2) {
+    offset.resize(n_cols, n_slices);
+    scale.resize(n_cols, n_slices);
+  }
+}
+
+void packed_states::expand(const arma::uvec& counts) {
+
+  size_t size = static_cast<size_t>(n_rows) * n_cols * bytes;
+  std::vector<unsigned char> expanded(arma::accu(counts) * size);
+  size_t k = 0;
+  for (unsigned int i = 0; i < counts.n_elem; i++) {
+    for (unsigned int j = 0; j < counts(i); j++) {
+      std::memcpy(&expanded[k * size], &data[i * size], size);
+      k++;
+    }
+  }
+  data.swap(expanded);
+  n_slices = k;
+  if (precision > 2) {
+    offset = rep_mat(offset, counts);
+    scale = rep_mat(scale, counts);
+  }
+}
+
+#ifndef BSSM_STANDALONE
+Rcpp::List packed_states::to_list() const {
+
+  Rcpp::RawVector raw_data(data.begin(), data.end());
+  return Rcpp::List::create(Rcpp::Named("data") = raw_data,
+    Rcpp::Named("dim") = Rcpp::IntegerVector::create(n_rows, n_cols, n_slices),
+    Rcpp::Named("precision") = precision,
+    Rcpp::Named("offset") = offset, Rcpp::Named("scale") = scale);
+}
+
+SEXP pack_states(const arma::cube& alpha, const unsigned int precision) {
+
+  if (precision == 1) {
+    return Rcpp::wrap(alpha);
+  }
+  packed_states packed(alpha.n_cols, alpha.n_rows, alpha.n_slices, precision);
+  for (unsigned int i = 0; i < alpha.n_slices; i++) {
+    packed.pack(i, alpha.slice(i).t());
+  }
+  return packed.to_list();
+}
+#endif
@@ -0,0 +1,52 @@
+// reduced precision storage for the samples of states
+// precision 2 stores the values as floats, and precisions 3 and 4 quantize each
+// column of the sample (the time series of one state) to 16 or 8 bits
+// relative to the minimum of the column. The samples are unpacked back to
+// doubles when needed, in R by the methods of class bssm_packed_states.
+
+#ifndef PACKED_STATES_H
+#define PACKED_STATES_H
+
+#include <vector>
+#include "bssm.h"
+
+class packed_states {
+
+public:
+
+  packed_states(const unsigned int n_rows = 0, const unsigned int n_cols = 0,
+    const unsigned int n_slices = 0, const unsigned int precision = 1);
+
+  // store sample i, different samples can be packed by multiple threads
+  void pack(const unsigned int i, const arma::mat& x);
+  arma::mat unpack(const unsigned int i) const;
+  void resize(const unsigned int n);
+  // repeat the sample i counts(i) times
+  void expand(const arma::uvec& counts);
+#ifndef BSSM_STANDALONE
+  // packed data with the dimensions and the offsets and scales of the columns
+  Rcpp::List to_list() const;
+#endif
+
+  unsigned int n_rows;
+  unsigned int n_cols;
+  unsigned int n_slices;
+  unsigned int precision;
+
+private:
+
+  friend class checkpoint;
+
+  unsigned int bytes;
+  std::vector<unsigned char> data;
+  arma::mat offset;
+  arma::mat scale;
+};
+
+#ifndef BSSM_STANDALONE
+// the states of the cube of m x (n + 1) x nsim samples returned by the
+// particle smoothers either as array (precision 1) or as packed list
+SEXP pack_states(const arma::cube& alpha, const unsigned int precision);
+#endif
+
+#endif
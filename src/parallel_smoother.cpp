@@ -0,0 +1,239 @@
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <algorithm>
+#include <vector>
+#include "parallel_smoother.h"
+#include "mgg_ssm.h"
+#include "profiler.h"
+
+namespace {
+
+// filtering element of time point t, the conditional distribution
+// alpha_t | alpha_t-1, y_t ~ N(A alpha_t-1 + b, C) and the information form
+// (eta, J) of p(y_t | alpha_t-1)
+struct filter_element {
+  arma::mat A;
+  arma::vec b;
+  arma::mat C;
+  arma::vec eta;
+  arma::mat J;
+};
+
+// combination of the element x of earlier time points with the element y
+struct filter_op {
+  filter_element operator()(const filter_element& x, const filter_element& y) const {
+    arma::mat I = arma::eye(x.b.n_elem, x.b.n_elem);
+    arma::mat M = arma::inv(I + x.C * y.J);
+    arma::mat AM = y.A * M;
+    // (I + J_y C_x)^-1 = M' as C and J are symmetric
+    arma::mat AN = x.A.t() * M.t();
+    filter_element z;
+    z.A = AM * x.A;
+    z.b = AM * (x.b + x.C * y.eta) + y.b;
+    z.C = arma::symmatu(AM * x.C * y.A.t() + y.C);
+    z.eta = AN * (y.eta - y.J * x.b) + x.eta;
+    z.J = arma::symmatu(AN * y.J * x.A + x.J);
+    return z;
+  }
+};
+
+// smoothing element of time point t, alpha_t | alpha_t+1, y_1:t ~ N(E alpha_t+1 + g, L)
+struct smoother_element {
+  arma::mat E;
+  arma::vec g;
+  arma::mat L;
+};
+
+// combination of the element x of earlier time points with the element y
+struct smoother_op {
+  smoother_element operator()(const smoother_element& x, const smoother_element& y) const {
+    smoother_element z;
+    z.E = x.E * y.E;
+    z.g = x.E * y.g + x.g;
+    z.L = arma::symmatu(x.E * y.L * x.E.t() + x.L);
+    return z;
+  }
+};
+
+// inclusive scan of x with an associative op(earlier, later), either forward
+// (prefixes) or backward (suffixes). Each thread scans its own block, the
+// totals of the blocks are combined sequentially, and each thread then
+// combines the elements of its block with the total of the preceding blocks
+template <class E, class Op>
+void block_scan(std::vector<E>& x, const Op& op, const bool backward,
+  const unsigned int n_threads) {
+
+  unsigned int n = x.size();
+  unsigned int n_blocks = std::max(1u, std::min(n_threads, n));
+  std::vector<unsigned int> start(n_blocks + 1);
+  for (unsigned int b = 0; b <= n_blocks; b++) {
+    start[b] = static_cast<unsigned long>(b) * n / n_blocks;
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_blocks) if(n_blocks > 1 && !omp_in_parallel())
+#endif
+  for (unsigned int b = 0; b < n_blocks; b++) {
+    if (backward) {
+      for (unsigned int i = start[b + 1] - 1; i > start[b]; i--) {
+        x[i - 1] = op(x[i - 1], x[i]);
+      }
+    } else {
+      for (unsigned int i = start[b] + 1; i < start[b + 1]; i++) {
+        x[i] = op(x[i - 1], x[i]);
+      }
+    }
+  }
+  if (n_blocks == 1) return;
+
+  // carry[b] combines all the elements before (forward) or after (backward) block b
+  std::vector<E> carry(n_blocks);
+  if (backward) {
+    carry[n_blocks - 2] = x[start[n_blocks - 1]];
+    for (unsigned int b = n_blocks - 2; b > 0; b--) {
+      carry[b - 1] = op(x[start[b]], carry[b]);
+    }
+  } else {
+    carry[1] = x[start[1] - 1];
+    for (unsigned int b = 2; b < n_blocks; b++) {
+      carry[b] = op(carry[b - 1], x[start[b] - 1]);
+    }
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_blocks) if(!omp_in_parallel())
+#endif
+  for (unsigned int b = 0; b < n_blocks; b++) {
+    if (backward && b < n_blocks - 1) {
+      for (unsigned int i = start[b]; i < start[b + 1]; i++) {
+        x[i] = op(x[i], carry[b]);
+      }
+    }
+    if (!backward && b > 0) {
+      for (unsigned int i = start[b]; i < start[b + 1]; i++) {
+        x[i] = op(carry[b], x[i]);
+      }
+    }
+  }
+}
+
+}
+
+arma::mat parallel_smoother(const mgg_ssm& model, const unsigned int n_threads) {
+  profiler::timer timer(profiler::kalman_smoother);
+
+  const unsigned int m = model.m;
+  const unsigned int n = model.n;
+  const unsigned int p = model.p;
+
+  arma::mat y_tmp = model.y;
+  if(model.xreg.n_cols > 0) {
+    y_tmp -= model.xbeta.t();
+  }
+
+  arma::mat alphahat(m, n);
+  std::vector<filter_element> filter(n);
+  std::vector<smoother_element> smoother(n);
+  std::vector<char> ok(n, 1);
+
+  // the first element includes the prior of alpha_1 in place of the transition
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1 && !omp_in_parallel())
+#endif
+  for (unsigned int t = 0; t < n; t++) {
+
+    arma::mat F(m, m, arma::fill::zeros);
+    arma::vec c = model.a1;
+    arma::mat Q = model.P1;
+    if (t > 0) {
+      F = model.T.slice((t - 1) * model.Ttv);
+      c = model.C.col((t - 1) * model.Ctv);
+      Q = model.RR.slice((t - 1) * model.Rtv);
+    }
+    filter_element& e = filter[t];
+
+    arma::uvec na_y = arma::find_nonfinite(y_tmp.col(t));
+    if (na_y.n_elem < p) {
+      arma::mat Zt = model.Z.slice(t * model.Ztv);
+      arma::mat HHt = model.HH.slice(t * model.Htv);
+      if (na_y.n_elem > 0) {
+        Zt.rows(na_y).zeros();
+        HHt.rows(na_y).zeros();
+        HHt.cols(na_y).zeros();
+        HHt.submat(na_y, na_y) = arma::eye(na_y.n_elem, na_y.n_elem);
+      }
+      arma::mat S = Zt * Q * Zt.t() + HHt;
+      arma::mat cholS(p, p);
+      if (!S.is_finite() || !arma::all(S.diag() > 0) || !arma::chol(cholS, S)) {
+        ok[t] = 0;
+        continue;
+      }
+      arma::mat inv_cholS = arma::inv(arma::trimatu(cholS));
+      arma::mat Sinv = inv_cholS * inv_cholS.t();
+      arma::vec v = y_tmp.col(t) - model.D.col(t * model.Dtv) - Zt * c;
+      v(na_y).zeros();
+      arma::mat K = Q * Zt.t() * Sinv;
+      arma::mat IKZ = arma::eye(m, m) - K * Zt;
+      arma::mat FZS = F.t() * Zt.t() * Sinv;
+      e.A = IKZ * F;
+      e.b = c + K * v;
+      e.C = arma::symmatu(IKZ * Q * IKZ.t() + K * HHt * K.t());
+      e.eta = FZS * v;
+      e.J = arma::symmatu(FZS * Zt * F);
+    } else {
+      e.A = F;
+      e.b = c;
+      e.C = Q;
+      e.eta.zeros(m);
+      e.J.zeros(m, m);
+    }
+  }
+  for (unsigned int t = 0; t < n; t++) {
+    if (!ok[t]) {
+      alphahat.fill(-std::numeric_limits<double>::infinity());
+      return alphahat;
+    }
+  }
+  // filtered means and covariances are the b and C of the prefixes
+  block_scan(filter, filter_op(), false, n_threads);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads) if(n_threads > 1 && !omp_in_parallel())
+#endif
+  for (unsigned int t = 0; t < n; t++) {
+    const arma::vec& att = filter[t].b;
+    const arma::mat& Ptt = filter[t].C;
+    smoother_element& e = smoother[t];
+    if (t == n - 1) {
+      e.E.zeros(m, m);
+      e.g = att;
+      e.L = Ptt;
+    } else {
+      arma::mat F = model.T.slice(t * model.Ttv);
+      arma::mat FP = F * Ptt;
+      arma::mat Pt = arma::symmatu(FP * F.t() + model.RR.slice(t * model.Rtv));
+      arma::mat Et;
+      if (!Pt.is_finite() || !arma::solve(Et, Pt, FP)) {
+        ok[t] = 0;
+        continue;
+      }
+      e.E = Et.t();
+      e.g = att - e.E * (F * att + model.C.col(t * model.Ctv));
+      e.L = arma::symmatu(Ptt - e.E * FP);
+    }
+  }
+  for (unsigned int t = 0; t < n; t++) {
+    if (!ok[t]) {
+      alphahat.fill(-std::numeric_limits<double>::infinity());
+      return alphahat;
+    }
+  }
+  // smoothed means are the g of the suffixes
+  block_scan(smoother, smoother_op(), true, n_threads);
+
+  for (unsigned int t = 0; t < n; t++) {
+    alphahat.col(t) = smoother[t].g;
+  }
+  return alphahat;
+}
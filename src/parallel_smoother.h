@@ -0,0 +1,22 @@
+// parallel-in-time Kalman filter and smoother for the smoothed means of
+// mgg_ssm, as in Sarkka and Garcia-Fernandez (2021), "Temporal parallelization
+// of Bayesian smoothers", IEEE Transactions on Automatic Control 66(1).
+//
+// the filtering and smoothing recursions are written as associative operations
+// on elements computed independently for each time point, and evaluated with
+// prefix (filter) and suffix (smoother) scans. The scans are done in blocks of
+// consecutive time points for each thread, so the sequential depth is
+// O(n / n_threads + n_threads) instead of O(n).
+
+#ifndef PARALLEL_SMOOTHER_H
+#define PARALLEL_SMOOTHER_H
+
+#include "bssm.h"
+
+class mgg_ssm;
+
+// smoothed means of the states at time points 1, ..., n (m x n), filled with
+// -infinity if the filter fails as in mgg_ssm::fast_smoother
+arma::mat parallel_smoother(const mgg_ssm& model, const unsigned int n_threads);
+
+#endif
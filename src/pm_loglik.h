@@ -0,0 +1,153 @@
+// log-likelihoods and their unbiased estimates as functions of theta
+// used by the samplers which evaluate the likelihood using several copies of
+// the model (pt_mcmc.h and spec_mcmc.h), each copy of these functors holds its
+// own work space
+
+#ifndef PM_LOGLIK_H
+#define PM_LOGLIK_H
+
+#include "bssm.h"
+#include "ugg_ssm.h"
+#include "nlg_ssm.h"
+#include "distr_consts.h"
+
+template <class T>
+inline void set_theta(T& model, const arma::vec& theta) {
+  model.update_model(theta);
+}
+inline void set_theta(nlg_ssm& model, const arma::vec& theta) {
+  model.theta = theta;
+}
+
+// exact log-likelihood of linear-Gaussian model
+template <class T>
+class gaussian_loglik {
+
+public:
+
+  double operator()(T& model, const arma::vec& theta) {
+    model.update_model(theta);
+    return model.log_likelihood();
+  }
+};
+
+// bootstrap filter
+template <class T>
+class bsf_loglik {
+
+public:
+
+  bsf_loglik(const T& model, const unsigned int nsim_states) :
+    nsim_states(nsim_states), alpha(model.m, model.n + 1, nsim_states),
+    weights(nsim_states, model.n + 1), indices(nsim_states, model.n) {
+  }
+
+  double operator()(T& model, const arma::vec& theta) {
+    set_theta(model, theta);
+    return model.bsf_filter(nsim_states, alpha, weights, indices);
+  }
+
+private:
+
+  unsigned int nsim_states;
+  arma::cube alpha;
+  arma::mat weights;
+  arma::umat indices;
+};
+
+// psi-APF using the Gaussian approximation of non-Gaussian model
+template <class T>
+class psi_loglik {
+
+public:
+
+  psi_loglik(T& model, const unsigned int nsim_states, const bool local_approx,
+    const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol) :
+    nsim_states(nsim_states), local_approx(local_approx), initial_mode(initial_mode),
+    max_iter(max_iter), conv_tol(conv_tol), mode_estimate(initial_mode),
+    approx_model(model.approximate(mode_estimate, max_iter, conv_tol)),
+    alpha(model.m, model.n + 1, nsim_states),
+    weights(nsim_states, model.n + 1), indices(nsim_states, model.n) {
+  }
+
+  double operator()(T& model, const arma::vec& theta) {
+    model.update_model(theta);
+    double gaussian_loglik;
+    if (local_approx) {
+      mode_estimate = initial_mode;
+      model.approximate(approx_model, mode_estimate, max_iter, conv_tol, 
+        &gaussian_loglik);
+    } else {
+      model.approximate(approx_model, mode_estimate, 0, conv_tol, 
+        &gaussian_loglik);
+    }
+    arma::vec scales = model.scaling_factors(approx_model, mode_estimate);
+    double approx_loglik = gaussian_loglik +
+      compute_const_term(model, approx_model) + arma::accu(scales);
+    return model.psi_filter(approx_model, approx_loglik, scales,
+      nsim_states, alpha, weights, indices);
+  }
+
+private:
+
+  unsigned int nsim_states;
+  bool local_approx;
+  arma::vec initial_mode;
+  unsigned int max_iter;
+  double conv_tol;
+  arma::vec mode_estimate;
+  ugg_ssm approx_model;
+  arma::cube alpha;
+  arma::mat weights;
+  arma::umat indices;
+};
+
+// importance sampling using the simulation smoother of approximating model
+template <class T>
+class spdk_loglik {
+
+public:
+
+  spdk_loglik(T& model, const unsigned int nsim_states, const bool local_approx,
+    const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol) :
+    nsim_states(nsim_states), local_approx(local_approx), initial_mode(initial_mode),
+    max_iter(max_iter), conv_tol(conv_tol), mode_estimate(initial_mode),
+    approx_model(model.approximate(mode_estimate, max_iter, conv_tol)) {
+  }
+
+  double operator()(T& model, const arma::vec& theta) {
+    model.update_model(theta);
+    double gaussian_loglik;
+    if (local_approx) {
+      mode_estimate = initial_mode;
+      model.approximate(approx_model, mode_estimate, max_iter, conv_tol, 
+        &gaussian_loglik);
+    } else {
+      model.approximate(approx_model, mode_estimate, 0, conv_tol, 
+        &gaussian_loglik);
+    }
+    arma::vec scales = model.scaling_factors(approx_model, mode_estimate);
+    double sum_scales = arma::accu(scales);
+    // the copies of approx_model share the RNG state, so use a new stream
+    // based on the model
+    std::uniform_int_distribution<> unif(0, std::numeric_limits<int>::max());
+    approx_model.engine = sitmo::prng_engine(unif(model.engine));
+    arma::cube alpha = approx_model.simulate_states(nsim_states, true);
+    arma::vec w = arma::exp(model.importance_weights(approx_model, alpha) -
+      sum_scales);
+    return gaussian_loglik + compute_const_term(model, approx_model) +
+      sum_scales + std::log(arma::accu(w) / nsim_states);
+  }
+
+private:
+
+  unsigned int nsim_states;
+  bool local_approx;
+  arma::vec initial_mode;
+  unsigned int max_iter;
+  double conv_tol;
+  arma::vec mode_estimate;
+  ugg_ssm approx_model;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include <limits>
+#include <mutex>
+#include "profiler.h"
+
+namespace profiler {
+
+bool enabled = false;
+
+namespace {
+const char* timer_names[n_timers] = {
+  "approximate", "kalman_filter", "kalman_smoother", "simulation_smoother", "ekf",
+  "psi_filter", "bsf_filter", "ekf_filter", "prior", "ram_adaptation", 
+  "is_correction"
+};
+const char* counter_names[n_counters] = {
+  "laplace_iterations", "resampling_steps"
+};
+
+std::mutex mtx;
+double times[n_timers];
+double calls[n_timers];
+double counts[n_counters];
+double ess_sum;
+double ess_min;
+double n_ess;
+}
+
+void reset(const bool enable) {
+  std::lock_guard<std::mutex> lock(mtx);
+  for (unsigned int i = 0; i < n_timers; i++) {
+    times[i] = 0.0;
+    calls[i] = 0.0;
+  }
+  for (unsigned int i = 0; i < n_counters; i++) {
+    counts[i] = 0.0;
+  }
+  ess_sum = 0.0;
+  ess_min = std::numeric_limits<double>::infinity();
+  n_ess = 0.0;
+  enabled = enable;
+}
+
+void add_time(const timer_type type, const double seconds) {
+  std::lock_guard<std::mutex> lock(mtx);
+  times[type] += seconds;
+  calls[type]++;
+}
+
+void add_count(const counter_type type, const unsigned int n) {
+  std::lock_guard<std::mutex> lock(mtx);
+  counts[type] += n;
+}
+
+void add_ess(const double ess, const unsigned int nsim) {
+  std::lock_guard<std::mutex> lock(mtx);
+  ess_sum += ess / nsim;
+  ess_min = std::min(ess_min, ess / nsim);
+  n_ess++;
+}
+
+#ifndef BSSM_STANDALONE
+Rcpp::List results() {
+  std::lock_guard<std::mutex> lock(mtx);
+  Rcpp::NumericVector time_out(n_timers);
+  Rcpp::NumericVector calls_out(n_timers);
+  Rcpp::CharacterVector names(n_timers);
+  for (unsigned int i = 0; i < n_timers; i++) {
+    time_out[i] = times[i];
+    calls_out[i] = calls[i];
+    names[i] = timer_names[i];
+  }
+  time_out.names() = names;
+  calls_out.names() = names;
+  Rcpp::NumericVector counts_out(n_counters);
+  Rcpp::CharacterVector counter_names_out(n_counters);
+  for (unsigned int i = 0; i < n_counters; i++) {
+    counts_out[i] = counts[i];
+    counter_names_out[i] = counter_names[i];
+  }
+  counts_out.names() = counter_names_out;
+  Rcpp::NumericVector ess = Rcpp::NumericVector::create(
+    Rcpp::Named("mean") = n_ess > 0 ? ess_sum / n_ess : NA_REAL,
+    Rcpp::Named("min") = n_ess > 0 ? ess_min : NA_REAL);
+  return Rcpp::List::create(Rcpp::Named("calls") = calls_out, 
+    Rcpp::Named("time") = time_out, Rcpp::Named("counts") = counts_out, 
+    Rcpp::Named("ess") = ess);
+}
+#endif
+
+}
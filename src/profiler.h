@@ -0,0 +1,79 @@
+// timers and counters of the main computational steps, used for finding out
+// where the time of run_mcmc goes without an external profiler
+//
+// the instrumentation is compiled in but disabled by default, in which case a
+// timer or a counter costs only a check of a flag. The times are inclusive, so
+// the time of a step contains the times of the steps called by it, and with
+// multiple threads the times and counts are summed over the threads.
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include "bssm.h"
+
+namespace profiler {
+
+enum timer_type {
+  approximate, kalman_filter, kalman_smoother, simulation_smoother, ekf,
+  psi_filter, bsf_filter, ekf_filter, prior, ram_adaptation, is_correction,
+  n_timers
+};
+
+enum counter_type {
+  laplace_iterations, resampling_steps, n_counters
+};
+
+extern bool enabled;
+
+// clear the timers and counters and enable or disable the instrumentation
+void reset(const bool enable);
+void add_time(const timer_type type, const double seconds);
+void add_count(const counter_type type, const unsigned int n);
+// effective sample size of the particles at a resampling step
+void add_ess(const double ess, const unsigned int nsim);
+#ifndef BSSM_STANDALONE
+// calls and times of the timers, counters and the relative ESS of the particles
+Rcpp::List results();
+#endif
+
+inline void count(const counter_type type, const unsigned int n = 1) {
+  if (enabled) add_count(type, n);
+}
+
+// measures the time from the construction to stop() or to the end of the scope
+class timer {
+  
+public:
+  
+  explicit timer(const timer_type type) : type(type), running(enabled) {
+    if (running) start = std::chrono::steady_clock::now();
+  }
+  ~timer() { stop(); }
+  
+  void stop() {
+    if (running) {
+      std::chrono::duration<double> elapsed = 
+        std::chrono::steady_clock::now() - start;
+      add_time(type, elapsed.count());
+      running = false;
+    }
+  }
+  
+private:
+  
+  const timer_type type;
+  bool running;
+  std::chrono::steady_clock::time_point start;
+};
+
+// log-prior density of the model, timed
+template <class T>
+double log_prior_pdf(const T& model, const arma::vec& theta) {
+  timer t(prior);
+  return model.log_prior_pdf(theta);
+}
+
+}
+
+#endif
@@ -15,4 +15,46 @@ arma::mat psd_chol(const arma::mat& x) {
   }
   
   return cholx;
-}
\ No newline at end of file
+}
+
+// Falls back to psd_chol of the updated matrix if L has zeros on the diagonal 
+// or the downdated matrix is not positive definite
+void chol_update(arma::mat& L, const arma::vec& x, const double w) {
+  
+  arma::mat L_new = L;
+  arma::vec z = std::sqrt(std::abs(w)) * x;
+  double sign = (w < 0) ? -1.0 : 1.0;
+  unsigned int m = L.n_rows;
+  bool ok = true;
+  for (unsigned int j = 0; j < m && ok; j++) {
+    double r2 = L_new(j, j) * L_new(j, j) + sign * z(j) * z(j);
+    ok = L_new(j, j) > 0 && r2 > 0;
+    if (ok) {
+      double r = std::sqrt(r2);
+      double c = r / L_new(j, j);
+      double s = z(j) / L_new(j, j);
+      L_new(j, j) = r;
+      for (unsigned int i = j + 1; i < m; i++) {
+        L_new(i, j) = (L_new(i, j) + sign * s * z(i)) / c;
+        z(i) = c * z(i) - s * L_new(i, j);
+      }
+    }
+  }
+  if (ok) {
+    L = L_new;
+  } else {
+    L = psd_chol(arma::symmatu(L * L.t() + w * x * x.t()));
+  }
+}
+
+arma::mat qr_chol(const arma::mat& A) {
+  
+  arma::mat Q;
+  arma::mat R;
+  arma::qr_econ(Q, R, A.t());
+  // R'R = A A', make the diagonal positive
+  for (unsigned int i = 0; i < R.n_rows; i++) {
+    if (R(i, i) < 0) R.row(i) = -R.row(i);
+  }
+  return R.t();
+}
@@ -4,5 +4,11 @@
 #include "bssm.h"
 
 arma::mat psd_chol(const arma::mat& x);
+// rank one update of the lower triangular Cholesky factor L of P 
+// to the factor of P + w * x * x', where w can be negative (downdate)
+void chol_update(arma::mat& L, const arma::vec& x, const double w);
+// lower triangular Cholesky factor of A * A' computed from the QR decomposition 
+// of A' without forming A * A'
+arma::mat qr_chol(const arma::mat& A);
 
 #endif
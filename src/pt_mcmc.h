@@ -0,0 +1,225 @@
+// replica exchange (parallel tempering) version of the MCMC algorithms
+// the tempered targets are p(theta) p(y | theta)^beta, with beta_1 = 1
+// corresponding to the original posterior. The temperature ladder is adapted
+// during the burn-in as in Miasojedow, Moulines and Vihola (2013),
+// "An adaptive parallel tempering algorithm", JCGS 22(3).
+//
+// loglik_fn(model, theta) updates the model with theta and returns the
+// (estimate of) log-likelihood, each replica uses its own copy of the model
+// and loglik_fn, so these can contain work space for the likelihood evaluation.
+
+#ifndef PT_MCMC_H
+#define PT_MCMC_H
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <exception>
+#include <vector>
+#include "ram.h"
+#include "mcmc.h"
+
+class nlg_ssm;
+
+template <class T>
+double pt_log_proposal_ratio(const T& model, const arma::vec& new_theta,
+  const arma::vec& old_theta) {
+  return model.log_proposal_ratio(new_theta, old_theta);
+}
+// no parameter transformations in non-linear models
+inline double pt_log_proposal_ratio(const nlg_ssm& model, const arma::vec& new_theta,
+  const arma::vec& old_theta) {
+  return 0.0;
+}
+
+template<class T, class F>
+void mcmc::pt_mcmc(T model, F loglik_fn, const bool end_ram,
+  const unsigned int n_temps, const unsigned int seed, const unsigned int n_threads) {
+
+  // check the initial values here as bssm::stop can't be used by the other threads
+  arma::vec theta = model.theta;
+  double logprior = profiler::log_prior_pdf(model, theta);
+  if (!std::isfinite(logprior))
+    bssm::stop("Initial prior probability is not finite.");
+  double loglik = loglik_fn(model, theta);
+  if (!std::isfinite(loglik))
+    bssm::stop("Initial log-likelihood is not finite.");
+
+  // initial ladder beta_k = 2^-k, parameterized as
+  // 1 / beta_{k+1} = 1 / beta_k + exp(rho_k)
+  arma::vec rho(n_temps - 1);
+  for (unsigned int k = 0; k < n_temps - 1; k++) {
+    rho(k) = k * std::log(2.0);
+  }
+  beta.set_size(n_temps);
+  beta(0) = 1.0;
+  for (unsigned int k = 1; k < n_temps; k++) {
+    beta(k) = 1.0 / (1.0 / beta(k - 1) + std::exp(rho(k - 1)));
+  }
+
+  // replica specific models (with independent random number streams),
+  // likelihood functions and proposal matrices
+  std::vector<T> models(n_temps, model);
+  std::vector<F> loglik_fns(n_temps, loglik_fn);
+  std::vector<arma::mat> S_k(n_temps, S);
+  for (unsigned int k = 0; k < n_temps; k++) {
+    models[k].engine = sitmo::prng_engine(seed + k);
+  }
+  sitmo::prng_engine swap_engine(seed + n_temps);
+
+  arma::mat thetas(n_par, n_temps);
+  thetas.each_col() = theta;
+  arma::vec logpriors(n_temps);
+  logpriors.fill(logprior);
+  arma::vec logliks(n_temps);
+  logliks.fill(loglik);
+  arma::uvec accepted(n_temps);
+
+  arma::vec swap_attempts(n_temps - 1, arma::fill::zeros);
+  swap_rate.zeros(n_temps - 1);
+
+  // used only by the master thread, the replicas have their own distributions
+  std::uniform_real_distribution<> swap_unif(0.0, 1.0);
+
+  bool new_value = true;
+  unsigned int n_values = 0;
+  bool stop = false;
+  std::exception_ptr error = nullptr;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+{
+  for (unsigned int i = 1; i <= n_iter; i++) {
+
+    // random walk Metropolis step for each replica
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (unsigned int k = 0; k < n_temps; k++) {
+      try {
+        // local distributions, as these are stateful and shared by the threads otherwise
+        std::normal_distribution<> normal(0.0, 1.0);
+        std::uniform_real_distribution<> unif(0.0, 1.0);
+        arma::vec u(n_par);
+        for(unsigned int j = 0; j < n_par; j++) {
+          u(j) = normal(models[k].engine);
+        }
+        arma::vec theta_prop = thetas.col(k) + S_k[k] * u;
+        double logprior_prop = profiler::log_prior_pdf(models[k], theta_prop);
+        double acceptance_prob = 0.0;
+        accepted(k) = 0;
+        if (logprior_prop > -std::numeric_limits<double>::infinity() &&
+          !std::isnan(logprior_prop)) {
+          double loglik_prop = loglik_fns[k](models[k], theta_prop);
+          if (loglik_prop > -std::numeric_limits<double>::infinity() &&
+            !std::isnan(loglik_prop)) {
+            acceptance_prob = std::min(1.0,
+              std::exp(beta(k) * (loglik_prop - logliks(k)) +
+                logprior_prop - logpriors(k) +
+                pt_log_proposal_ratio(models[k], theta_prop, thetas.col(k))));
+          }
+          if (unif(models[k].engine) < acceptance_prob) {
+            thetas.col(k) = theta_prop;
+            logpriors(k) = logprior_prop;
+            logliks(k) = loglik_prop;
+            accepted(k) = 1;
+          }
+        }
+        if (!end_ram || i <= n_burnin) {
+          profiler::timer ram_timer(profiler::ram_adaptation);
+          ramcmc::adapt_S(S_k[k], u, acceptance_prob, target_acceptance, i, gamma);
+        }
+      } catch (...) {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+{
+  error = std::current_exception();
+}
+      }
+    }
+
+#ifdef _OPENMP
+#pragma omp master
+#endif
+{
+  // whether the state of the cold chain changed in this iteration
+  bool changed = accepted(0);
+  if (accepted(0) && i > n_burnin) {
+    acceptance_rate++;
+  }
+  // swaps between adjacent replicas, alternating between even and odd pairs
+  for (unsigned int k = i % 2; k + 1 < n_temps; k += 2) {
+    double swap_prob = std::min(1.0,
+      std::exp((beta(k) - beta(k + 1)) * (logliks(k + 1) - logliks(k))));
+    if (!std::isfinite(swap_prob)) {
+      swap_prob = 0.0;
+    }
+    if (swap_unif(swap_engine) < swap_prob) {
+      thetas.swap_cols(k, k + 1);
+      std::swap(logpriors(k), logpriors(k + 1));
+      std::swap(logliks(k), logliks(k + 1));
+      if (k == 0) {
+        changed = true;
+      }
+    }
+    if (i > n_burnin) {
+      swap_rate(k) += swap_prob;
+      swap_attempts(k)++;
+    } else {
+      // adapt the temperature ladder towards the swap rate of 0.234
+      rho(k) += std::pow(i, -gamma) * (swap_prob - 0.234);
+    }
+  }
+  if (changed) {
+    new_value = true;
+    if (i > n_burnin) {
+      n_values++;
+    }
+  }
+  if (i <= n_burnin) {
+    for (unsigned int k = 1; k < n_temps; k++) {
+      beta(k) = 1.0 / (1.0 / beta(k - 1) + std::exp(rho(k - 1)));
+    }
+  }
+
+  if (i > n_burnin && n_values % n_thin == 0) {
+    //new block
+    if (new_value) {
+      posterior_storage(n_stored) = logpriors(0) + logliks(0);
+      theta_storage.col(n_stored) = thetas.col(0);
+      count_storage(n_stored) = 1;
+      n_stored++;
+      new_value = false;
+    } else {
+      count_storage(n_stored - 1)++;
+    }
+  }
+
+  if (i % 16 == 0) {
+    try {
+      check_interrupt();
+    } catch (...) {
+      error = std::current_exception();
+    }
+  }
+  stop = error != nullptr;
+}
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+    if (stop) break;
+  }
+}
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  swap_rate /= arma::clamp(swap_attempts, 1.0, swap_attempts.max() + 1.0);
+  S = S_k[0];
+  trim_storage();
+  acceptance_rate /= (n_iter - n_burnin);
+}
+
+#endif
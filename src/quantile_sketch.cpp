@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "quantile_sketch.h"
+
+quantile_sketch::quantile_sketch(const unsigned int n_rows, const unsigned int n_cols,
+  const double compression, const unsigned int buffer_size) :
+  n_rows(n_rows), n_cols(n_cols), compression(compression),
+  capacity(static_cast<unsigned int>(std::ceil(compression)) + 1),
+  buffer_size(buffer_size), n_buffered(0),
+  buffer(buffer_size * (n_rows * n_cols > 0), n_rows * n_cols),
+  buffer_weights(buffer_size * (n_rows * n_cols > 0)),
+  centroid_means(capacity * (n_rows * n_cols > 0), n_rows * n_cols),
+  centroid_weights(capacity * (n_rows * n_cols > 0), n_rows * n_cols),
+  n_centroids(n_rows * n_cols, arma::fill::zeros),
+  min_x(n_rows * n_cols), max_x(n_rows * n_cols),
+  sum_x(n_rows * n_cols, arma::fill::zeros), total_weight(0.0) {
+
+  min_x.fill(arma::datum::inf);
+  max_x.fill(-arma::datum::inf);
+}
+
+void quantile_sketch::add(const arma::mat& x, const double weight) {
+
+  if (!(weight > 0)) return;
+
+  buffer.row(n_buffered) = arma::vectorise(x).t();
+  buffer_weights(n_buffered) = weight;
+  n_buffered++;
+  total_weight += weight;
+  sum_x += weight * arma::vectorise(x);
+  min_x = arma::min(min_x, arma::vectorise(x));
+  max_x = arma::max(max_x, arma::vectorise(x));
+  if (n_buffered == buffer_size) {
+    merge();
+  }
+}
+
+double quantile_sketch::q_limit(const double q) const {
+  // k1(q) = compression / (2 pi) * asin(2q - 1), limit is k1^-1(k1(q) + 1)
+  double k = compression / (2.0 * M_PI) * std::asin(2.0 * q - 1.0) + 1.0;
+  if (k >= compression / 4.0) {
+    return 1.0;
+  }
+  return (std::sin(2.0 * M_PI * k / compression) + 1.0) / 2.0;
+}
+
+void quantile_sketch::merge() {
+
+  if (n_buffered == 0) return;
+
+  std::vector<std::pair<double, double> > items;
+  items.reserve(capacity + n_buffered);
+  for (unsigned int e = 0; e < n_centroids.n_elem; e++) {
+
+    items.clear();
+    for (unsigned int k = 0; k < n_centroids(e); k++) {
+      items.push_back(std::make_pair(centroid_means(k, e), centroid_weights(k, e)));
+    }
+    for (unsigned int k = 0; k < n_buffered; k++) {
+      items.push_back(std::make_pair(buffer(k, e), buffer_weights(k)));
+    }
+    std::sort(items.begin(), items.end());
+
+    // combine neighbouring items as long as the centroid stays within a unit
+    // of the scale function
+    unsigned int k = 0;
+    double mean = items[0].first;
+    double weight = items[0].second;
+    double w_before = 0.0;
+    double limit = total_weight * q_limit(0.0);
+    for (unsigned int j = 1; j < items.size(); j++) {
+      if (w_before + weight + items[j].second <= limit || k == capacity - 1) {
+        weight += items[j].second;
+        mean += (items[j].first - mean) * items[j].second / weight;
+      } else {
+        centroid_means(k, e) = mean;
+        centroid_weights(k, e) = weight;
+        k++;
+        w_before += weight;
+        limit = total_weight * q_limit(w_before / total_weight);
+        mean = items[j].first;
+        weight = items[j].second;
+      }
+    }
+    centroid_means(k, e) = mean;
+    centroid_weights(k, e) = weight;
+    n_centroids(e) = k + 1;
+  }
+  n_buffered = 0;
+}
+
+arma::mat quantile_sketch::mean() const {
+  arma::mat x = sum_x / total_weight;
+  x.reshape(n_rows, n_cols);
+  return x;
+}
+
+arma::cube quantile_sketch::quantiles(const arma::vec& probs) {
+
+  merge();
+  arma::cube q(n_rows, n_cols, probs.n_elem);
+  q.fill(arma::datum::nan);
+  for (unsigned int e = 0; e < n_centroids.n_elem; e++) {
+    if (n_centroids(e) == 0) continue;
+    for (unsigned int p = 0; p < probs.n_elem; p++) {
+      double target = probs(p) * total_weight;
+      // interpolate linearly between the centres of the centroids, with the
+      // minimum and maximum at the ends
+      double x_prev = min_x(e);
+      double w_prev = 0.0;
+      double cumulative = 0.0;
+      double value = max_x(e);
+      for (unsigned int k = 0; k <= n_centroids(e); k++) {
+        double x_next = max_x(e);
+        double w_next = total_weight;
+        if (k < n_centroids(e)) {
+          x_next = centroid_means(k, e);
+          w_next = cumulative + centroid_weights(k, e) / 2.0;
+          cumulative += centroid_weights(k, e);
+        }
+        if (target <= w_next) {
+          value = w_next > w_prev ?
+            x_prev + (x_next - x_prev) * (target - w_prev) / (w_next - w_prev) : x_next;
+          break;
+        }
+        x_prev = x_next;
+        w_prev = w_next;
+      }
+      q(e % n_rows, e / n_rows, p) = value;
+    }
+  }
+  return q;
+}
@@ -0,0 +1,56 @@
+// streaming weighted quantiles of each element of a matrix, so that the
+// quantiles of the states can be computed without storing the samples
+//
+// each element has its own merging t-digest (Dunning & Ertl, 2019) with the
+// k1 scale function, which keeps the tails accurate: the values are collected
+// to a buffer shared by all elements, and when the buffer is full it is
+// merged with the at most compression + 1 centroids of each element. The
+// weighted means of the elements are computed exactly.
+
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include "bssm.h"
+
+class quantile_sketch {
+
+public:
+
+  quantile_sketch(const unsigned int n_rows = 0, const unsigned int n_cols = 0,
+    const double compression = 100, const unsigned int buffer_size = 32);
+
+  // add the values of x with weight, values with zero weight are ignored
+  void add(const arma::mat& x, const double weight = 1.0);
+  // weighted means of the elements
+  arma::mat mean() const;
+  // quantiles of the elements as n_rows x n_cols x probs.n_elem cube
+  arma::cube quantiles(const arma::vec& probs);
+
+  unsigned int n_rows;
+  unsigned int n_cols;
+
+private:
+
+  friend class checkpoint;
+
+  void merge();
+  // upper limit of the quantile of a centroid starting from quantile q
+  double q_limit(const double q) const;
+
+  double compression;
+  unsigned int capacity;
+  unsigned int buffer_size;
+  unsigned int n_buffered;
+  arma::mat buffer;
+  arma::vec buffer_weights;
+  // centroids of the elements, capacity x n_rows * n_cols
+  arma::mat centroid_means;
+  arma::mat centroid_weights;
+  arma::uvec n_centroids;
+  arma::vec min_x;
+  arma::vec max_x;
+  arma::vec sum_x;
+  double total_weight;
+};
+
+#endif
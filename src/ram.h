@@ -0,0 +1,67 @@
+// robust adaptive Metropolis (Vihola, 2012) updates of the proposal
+// the package uses ramcmc, which depends on RcppArmadillo, so the core
+// library compiled without R uses the same updates defined here
+
+#ifndef RAM_H
+#define RAM_H
+
+#ifdef BSSM_STANDALONE
+
+#include <algorithm>
+#include <cmath>
+#include "bssm.h"
+
+namespace ramcmc {
+
+// rank-one update of the lower triangular Cholesky factor L, LL' + uu'
+inline void chol_update(arma::mat& L, arma::vec& u) {
+  unsigned int n = u.n_elem - 1;
+  for (unsigned int i = 0; i < n; i++) {
+    double r = std::sqrt(L(i, i) * L(i, i) + u(i) * u(i));
+    double c = r / L(i, i);
+    double s = u(i) / L(i, i);
+    L(i, i) = r;
+    L(arma::span(i + 1, n), i) = (L(arma::span(i + 1, n), i) + s * u.rows(i + 1, n)) / c;
+    u.rows(i + 1, n) = c * u.rows(i + 1, n) - s * L(arma::span(i + 1, n), i);
+  }
+  L(n, n) = std::sqrt(L(n, n) * L(n, n) + u(n) * u(n));
+}
+
+// rank-one downdate of the lower triangular Cholesky factor L, LL' - uu'
+inline void chol_downdate(arma::mat& L, arma::vec& u) {
+  unsigned int n = u.n_elem - 1;
+  for (unsigned int i = 0; i < n; i++) {
+    double r = std::sqrt(L(i, i) * L(i, i) - u(i) * u(i));
+    double c = r / L(i, i);
+    double s = u(i) / L(i, i);
+    L(i, i) = r;
+    L(arma::span(i + 1, n), i) = (L(arma::span(i + 1, n), i) - s * u.rows(i + 1, n)) / c;
+    u.rows(i + 1, n) = c * u.rows(i + 1, n) - s * L(arma::span(i + 1, n), i);
+  }
+  L(n, n) = std::sqrt(L(n, n) * L(n, n) - u(n) * u(n));
+}
+
+// adapt the Cholesky factor S of the proposal towards the target acceptance
+// rate given the current acceptance probability, the standard normal draw u
+// of the proposal, iteration n and the decay rate gamma of the adaptation
+inline void adapt_S(arma::mat& S, arma::vec& u, const double current,
+  const double target, const unsigned int n, const double gamma) {
+  double change = current - target;
+  u = S * u / arma::norm(u) *
+    std::sqrt(std::min(1.0, u.n_elem * std::pow(n, -gamma)) * std::abs(change));
+  if (change > 0.0) {
+    chol_update(S, u);
+  } else {
+    chol_downdate(S, u);
+  }
+}
+
+}
+
+#else
+
+#include <ramcmc.h>
+
+#endif
+
+#endif
@@ -2,19 +2,21 @@
 #include <omp.h>
 #endif
 #include <sitmo.h>
-#include <ramcmc.h>
+#include "ram.h"
 #include "sde_amcmc.h"
 #include "sde_ssm.h"
+#include "msde_ssm.h"
 #include "rep_mat.h"
 
 #include "filter_smoother.h"
 #include "summary.h"
+#include "checkpoint.h"
 
 sde_amcmc::sde_amcmc(const unsigned int n_iter, 
   const unsigned int n_burnin, const unsigned int n_thin, const unsigned int n, 
-  const double target_acceptance, const double gamma, 
+  const unsigned int m, const double target_acceptance, const double gamma, 
   const arma::mat& S, const unsigned int output_type) :
-  mcmc(n_iter, n_burnin, n_thin, n, 1,
+  mcmc(n_iter, n_burnin, n_thin, n, m,
     target_acceptance, gamma, S, output_type),
     weight_storage(arma::vec(n_samples, arma::fill::zeros)),
     approx_loglik_storage(arma::vec(n_samples)),
@@ -34,6 +36,12 @@ void sde_amcmc::trim_storage() {
   }
 }
 
+void sde_amcmc::sync_storage(checkpoint& file) {
+  mcmc::sync_storage(file);
+  file.sync_head(approx_loglik_storage, n_stored);
+  file.sync_head(prior_storage, n_stored);
+}
+
 void sde_amcmc::expand() {
   //trim extras first just in case
   trim_storage();
@@ -69,18 +77,24 @@ void sde_amcmc::expand() {
   
 }
 
+template void sde_amcmc::approx_mcmc(sde_ssm model, const bool end_ram, 
+  const unsigned int nsim_states, const unsigned int L);
+template void sde_amcmc::approx_mcmc(msde_ssm model, const bool end_ram, 
+  const unsigned int nsim_states, const unsigned int L);
+
 // run approximate MCMC for
 // non-linear Gaussian state space model
 
-void sde_amcmc::approx_mcmc(sde_ssm model, const bool end_ram, 
+template <class T>
+void sde_amcmc::approx_mcmc(T model, const bool end_ram, 
   const unsigned int nsim_states, const unsigned int L) {
   
-  unsigned int m = 1;
+  unsigned int m = model.m;
   unsigned n = model.n;
   // compute the log[p(theta)]
-  double logprior = model.log_prior_pdf(model.theta);
+  double logprior = profiler::log_prior_pdf(model, model.theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   
   arma::cube alpha(m, n + 1, nsim_states);
@@ -88,7 +102,7 @@ void sde_amcmc::approx_mcmc(sde_ssm model, const bool end_ram,
   arma::umat indices(nsim_states, n);
   double loglik = model.bsf_filter(nsim_states, L, alpha, weights, indices);
   if (!std::isfinite(loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   
   double acceptance_prob = 0.0;
   bool new_value = true;
@@ -97,9 +111,12 @@ void sde_amcmc::approx_mcmc(sde_ssm model, const bool end_ram,
   std::uniform_real_distribution<> unif(0.0, 1.0);
   arma::vec theta = model.theta;
   
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("approx_mcmc_sde", model.engine, normal,
+    unif, theta, logprior, new_value, n_values, model.theta, model.coarse_engine,
+    loglik);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     if (i % 4 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -111,7 +128,7 @@ void sde_amcmc::approx_mcmc(sde_ssm model, const bool end_ram,
     // propose new theta
     arma::vec theta_prop = theta + S * u;
     // compute prior
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (arma::is_finite(logprior_prop)) {
       // update parameters
@@ -152,19 +169,30 @@ void sde_amcmc::approx_mcmc(sde_ssm model, const bool end_ram,
     }
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "approx_mcmc_sde", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, model.theta, model.coarse_engine, loglik);
   }
   
   trim_storage();
   acceptance_rate /= (n_iter - n_burnin);
 }
 
-void sde_amcmc::is_correction_bsf(sde_ssm model, const unsigned int nsim_states, 
+template void sde_amcmc::is_correction_bsf(sde_ssm model, 
+  const unsigned int nsim_states, const unsigned int L_c, const unsigned int L_f, 
+  const unsigned int is_type, const unsigned int n_threads);
+template void sde_amcmc::is_correction_bsf(msde_ssm model, 
+  const unsigned int nsim_states, const unsigned int L_c, const unsigned int L_f, 
+  const unsigned int is_type, const unsigned int n_threads);
+
+template <class T>
+void sde_amcmc::is_correction_bsf(T model, const unsigned int nsim_states, 
   const unsigned int L_c, const unsigned int L_f, 
   const unsigned int is_type, const unsigned int n_threads) {
   
-  arma::cube Valpha(1, 1, model.n + 1, arma::fill::zeros);
+  arma::cube Valpha(model.m, model.m, model.n + 1, arma::fill::zeros);
   double sum_w = 0.0;
   
 #ifdef _OPENMP
@@ -176,12 +204,13 @@ void sde_amcmc::is_correction_bsf(sde_ssm model, const unsigned int nsim_states,
   
 #pragma omp for schedule(dynamic)
   for (unsigned int i = 0; i < n_stored; i++) {
+    profiler::timer timer(profiler::is_correction);
     model.theta = theta_storage.col(i);
     unsigned int nsim = nsim_states;
     if (is_type == 1) {
       nsim *= count_storage(i);
     }
-    arma::cube alpha_i(1, model.n + 1, nsim);
+    arma::cube alpha_i(model.m, model.n + 1, nsim);
     arma::mat weights_i(nsim, model.n + 1);
     arma::umat indices(nsim, model.n);
     double loglik = model.bsf_filter(nsim, L_f, alpha_i, weights_i, indices);
@@ -194,8 +223,8 @@ void sde_amcmc::is_correction_bsf(sde_ssm model, const unsigned int nsim_states,
         std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
         alpha_storage.slice(i) = alpha_i.slice(sample(model.engine)).t();
       } else {
-        arma::mat alphahat_i(1, model.n + 1);
-        arma::cube Vt_i(1, 1, model.n + 1);
+        arma::mat alphahat_i(model.m, model.n + 1);
+        arma::cube Vt_i(model.m, model.m, model.n + 1);
         weighted_summary(alpha_i, alphahat_i, Vt_i, w);
 #pragma omp critical
 {
@@ -214,12 +243,13 @@ void sde_amcmc::is_correction_bsf(sde_ssm model, const unsigned int nsim_states,
 }
 #else
 for (unsigned int i = 0; i < n_stored; i++) {
+  profiler::timer timer(profiler::is_correction);
   model.theta = theta_storage.col(i);
   unsigned int nsim = nsim_states;
   if (is_type == 1) {
     nsim *= count_storage(i);
   }
-  arma::cube alpha_i(1, model.n + 1, nsim);
+  arma::cube alpha_i(model.m, model.n + 1, nsim);
   arma::mat weights_i(nsim, model.n + 1);
   arma::umat indices(nsim, model.n);
   double loglik = model.bsf_filter(nsim, L_f, alpha_i, weights_i, indices);
@@ -232,8 +262,8 @@ for (unsigned int i = 0; i < n_stored; i++) {
       std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
       alpha_storage.slice(i) = alpha_i.slice(sample(model.engine)).t();
     } else {
-      arma::mat alphahat_i(1, model.n + 1);
-      arma::cube Vt_i(1, 1, model.n + 1);
+      arma::mat alphahat_i(model.m, model.n + 1);
+      arma::cube Vt_i(model.m, model.m, model.n + 1);
       weighted_summary(alpha_i, alphahat_i, Vt_i, w);
       
       arma::mat diff = alphahat_i - alphahat;
@@ -10,16 +10,19 @@ public:
   
   // constructor
   sde_amcmc(const unsigned int n_iter, const unsigned int n_burnin,
-    const unsigned int n_thin, const unsigned int n,
+    const unsigned int n_thin, const unsigned int n, const unsigned int m,
     const double target_acceptance, const double gamma, 
     const arma::mat& S, const unsigned int output_type);
   
   void expand();
   
-  void approx_mcmc(sde_ssm model, const bool end_ram, 
+  // T is sde_ssm or msde_ssm
+  template <class T>
+  void approx_mcmc(T model, const bool end_ram, 
     const unsigned int nsim_states, const unsigned int L_c);
   
-  void is_correction_bsf(sde_ssm model, const unsigned int nsim_states, 
+  template <class T>
+  void is_correction_bsf(T model, const unsigned int nsim_states, 
     const unsigned int L_c, const unsigned int L_f, 
     const unsigned int is_type, const unsigned int n_threads);
   
@@ -29,6 +32,7 @@ public:
 private:
   
   void trim_storage();
+  void sync_storage(checkpoint& file);
 };
 
 
@@ -1,12 +1,13 @@
 #include "sde_ssm.h"
 #include "milstein_functions.h"
 #include "sample.h"
+#include "profiler.h"
 
 sde_ssm::sde_ssm(const arma::vec& y, const arma::vec& theta, 
   const double x0, bool positive, const unsigned int seed,
   funcPtr drift_, funcPtr diffusion_, funcPtr ddiffusion_,
   prior_funcPtr log_prior_pdf_, obs_funcPtr log_obs_density_) :
-  y(y), theta(theta), x0(x0), n(y.n_elem),
+  y(y), theta(theta), x0(x0), n(y.n_elem), m(1),
   positive(positive), seed(seed), coarse_engine(seed), engine(seed + 1),
   drift(drift_), diffusion(diffusion_), ddiffusion(ddiffusion_), 
   log_prior_pdf(log_prior_pdf_), log_obs_density(log_obs_density_) {
@@ -14,6 +15,7 @@ sde_ssm::sde_ssm(const arma::vec& y, const arma::vec& theta,
 
 double sde_ssm::bsf_filter(const unsigned int nsim, const unsigned int L, 
   arma::cube& alpha, arma::mat& weights, arma::umat& indices) {
+  profiler::timer timer(profiler::bsf_filter);
   // alpha is  n x 1 x nsim
   for (unsigned int i = 0; i < nsim; i++) {
     alpha(0, 0, i) = milstein(x0, L, 1, theta, drift, diffusion, ddiffusion,
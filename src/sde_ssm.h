@@ -30,6 +30,8 @@ public:
   
   const double x0;
   const unsigned int n;
+  // univariate state, for the samplers shared with msde_ssm
+  const unsigned int m;
   bool positive;
   unsigned int seed;
   // PRNG used for simulating Brownian motion on coarse scale
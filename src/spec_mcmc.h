@@ -0,0 +1,254 @@
+// speculative (prefetching) version of the random walk Metropolis algorithm
+// after the adaptation of S has ended, the next iterations along the most probable
+// accept/reject paths are computed in advance: the proposals and the random numbers
+// are generated sequentially by the master thread using copies of the RNG, and
+// only the (expensive) log-likelihood evaluations are done in parallel. The chain
+// is then advanced along the realized path, so the result is identical to the
+// chain with single evaluation per iteration (see Brockwell (2006),
+// "Parallel Markov chain Monte Carlo simulation by pre-fetching", JCGS 15(1)).
+//
+// if reseed is true, the likelihood evaluation of each iteration uses its own
+// random number stream seeded from the main stream of the chain. This is needed
+// for unbiased likelihood estimates, as otherwise the random numbers used by the
+// chain would depend on the order of evaluations.
+
+#ifndef SPEC_MCMC_H
+#define SPEC_MCMC_H
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <exception>
+#include <vector>
+#include "ram.h"
+#include "mcmc.h"
+#include "pt_mcmc.h"
+
+// single MH iteration along one path of the speculation tree
+struct spec_node {
+  // node whose proposal is the current state at the start of this iteration
+  // (-1 for the state at the start of the round)
+  int current;
+  unsigned int depth;
+  double prob;
+  // RNG states after the draws of this iteration
+  sitmo::prng_engine engine;
+  std::normal_distribution<> normal;
+  arma::vec u;
+  arma::vec theta_prop;
+  double logprior_prop;
+  bool valid;
+  double unif_draw;
+  unsigned int eval_seed;
+  double loglik_prop;
+  // rejection and acceptance branches
+  int child[2];
+};
+
+template<class T, class F>
+void mcmc::spec_mcmc(T model, F loglik_fn, const bool end_ram, const bool reseed,
+  const unsigned int n_threads) {
+  
+  arma::vec theta = model.theta;
+  double logprior = profiler::log_prior_pdf(model, theta);
+  if (!std::isfinite(logprior))
+    bssm::stop("Initial prior probability is not finite.");
+  
+  // model copies and work spaces for each thread
+  std::vector<T> models(n_threads, model);
+  std::vector<F> loglik_fns(n_threads, loglik_fn);
+  
+  std::normal_distribution<> normal(0.0, 1.0);
+  std::uniform_real_distribution<> unif(0.0, 1.0);
+  std::uniform_int_distribution<> seed_dist(0, std::numeric_limits<int>::max());
+  
+  if (reseed) {
+    models[0].engine = sitmo::prng_engine(seed_dist(model.engine));
+  }
+  double loglik = loglik_fns[0](models[0], theta);
+  if (!std::isfinite(loglik))
+    bssm::stop("Initial log-likelihood is not finite.");
+  
+  std::vector<spec_node> nodes;
+  // candidate nodes as (probability, parent, branch)
+  std::vector<std::pair<double, std::pair<int, unsigned int> > > candidates;
+  std::vector<unsigned int> eval_nodes;
+  
+  bool new_value = true;
+  unsigned int n_values = 0;
+  unsigned int i = 1;
+  while (i <= n_iter) {
+  
+    // speculate only when S is no longer adapted
+    bool speculate = n_threads > 1 && end_ram && i > n_burnin;
+    unsigned int max_eval = speculate ? n_threads : 1;
+    unsigned int max_nodes = speculate ? 4 * n_threads : 1;
+  
+    // build the tree
+    nodes.clear();
+    candidates.clear();
+    eval_nodes.clear();
+    candidates.push_back(std::make_pair(1.0, std::make_pair(-1, 0u)));
+    while (!candidates.empty() && eval_nodes.size() < max_eval &&
+      nodes.size() < max_nodes) {
+  
+      unsigned int best = 0;
+      for (unsigned int j = 1; j < candidates.size(); j++) {
+        if (candidates[j].first > candidates[best].first) best = j;
+      }
+      double prob = candidates[best].first;
+      int parent = candidates[best].second.first;
+      unsigned int branch = candidates[best].second.second;
+      candidates.erase(candidates.begin() + best);
+  
+      spec_node node;
+      if (parent < 0) {
+        node.current = -1;
+        node.depth = 0;
+        node.engine = model.engine;
+        node.normal = normal;
+      } else {
+        node.current = branch == 1 ? parent : nodes[parent].current;
+        node.depth = nodes[parent].depth + 1;
+        node.engine = nodes[parent].engine;
+        node.normal = nodes[parent].normal;
+      }
+      node.prob = prob;
+      node.child[0] = node.child[1] = -1;
+  
+      node.u.set_size(n_par);
+      for(unsigned int j = 0; j < n_par; j++) {
+        node.u(j) = node.normal(node.engine);
+      }
+      if (reseed) {
+        node.eval_seed = seed_dist(node.engine);
+      }
+      if (node.current < 0) {
+        node.theta_prop = theta + S * node.u;
+      } else {
+        node.theta_prop = nodes[node.current].theta_prop + S * node.u;
+      }
+      node.logprior_prop = profiler::log_prior_pdf(model, node.theta_prop);
+      node.valid = node.logprior_prop > -std::numeric_limits<double>::infinity() &&
+        !std::isnan(node.logprior_prop);
+      if (node.valid) {
+        node.unif_draw = unif(node.engine);
+      }
+  
+      unsigned int k = nodes.size();
+      if (parent >= 0) {
+        nodes[parent].child[branch] = k;
+      }
+      nodes.push_back(node);
+      if (node.valid) {
+        eval_nodes.push_back(k);
+      }
+      if (speculate && i + node.depth < n_iter) {
+        if (node.valid) {
+          candidates.push_back(std::make_pair(prob * (1.0 - target_acceptance),
+            std::make_pair(static_cast<int>(k), 0u)));
+          candidates.push_back(std::make_pair(prob * target_acceptance,
+            std::make_pair(static_cast<int>(k), 1u)));
+        } else {
+          candidates.push_back(std::make_pair(prob, std::make_pair(static_cast<int>(k), 0u)));
+        }
+      }
+    }
+  
+    // evaluate the log-likelihoods
+    if (eval_nodes.size() > 1) {
+      std::exception_ptr error = nullptr;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(dynamic)
+#endif
+      for (unsigned int j = 0; j < eval_nodes.size(); j++) {
+        unsigned int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        spec_node& node = nodes[eval_nodes[j]];
+        try {
+          if (reseed) {
+            models[thread].engine = sitmo::prng_engine(node.eval_seed);
+          }
+          node.loglik_prop = loglik_fns[thread](models[thread], node.theta_prop);
+        } catch (...) {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+{
+  error = std::current_exception();
+}
+        }
+      }
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    } else {
+      if (eval_nodes.size() == 1) {
+        spec_node& node = nodes[eval_nodes[0]];
+        if (reseed) {
+          models[0].engine = sitmo::prng_engine(node.eval_seed);
+        }
+        node.loglik_prop = loglik_fns[0](models[0], node.theta_prop);
+      }
+    }
+  
+    // advance the chain along the realized path
+    int k = 0;
+    while (k >= 0) {
+  
+      if (i % 16 == 0) {
+        check_interrupt();
+      }
+  
+      const spec_node& node = nodes[k];
+      double acceptance_prob = 0.0;
+      bool accept = false;
+      if (node.valid) {
+        acceptance_prob = std::min(1.0, std::exp(node.loglik_prop - loglik +
+          node.logprior_prop - logprior +
+          pt_log_proposal_ratio(model, node.theta_prop, theta)));
+        accept = node.unif_draw < acceptance_prob;
+      }
+      if (accept) {
+        if (i > n_burnin) {
+          acceptance_rate++;
+          n_values++;
+        }
+        loglik = node.loglik_prop;
+        logprior = node.logprior_prop;
+        theta = node.theta_prop;
+        new_value = true;
+      }
+  
+      if (i > n_burnin && n_values % n_thin == 0) {
+        //new block
+        if (new_value) {
+          posterior_storage(n_stored) = logprior + loglik;
+          theta_storage.col(n_stored) = theta;
+          count_storage(n_stored) = 1;
+          n_stored++;
+          new_value = false;
+        } else {
+          count_storage(n_stored - 1)++;
+        }
+      }
+      if (!end_ram || i <= n_burnin) {
+        profiler::timer ram_timer(profiler::ram_adaptation);
+        // adapt_S modifies u, so the node keeps its own copy
+        arma::vec u = node.u;
+        ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
+      }
+      model.engine = node.engine;
+      normal = node.normal;
+      i++;
+      k = node.child[accept];
+    }
+  }
+  
+  trim_storage();
+  acceptance_rate /= (n_iter - n_burnin);
+}
+
+#endif
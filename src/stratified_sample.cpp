@@ -1,6 +1,7 @@
 // stratified sampling of indices from 0 to length(p)-1
 // modified to armadillo compatible from C code by Matti Vihola
 #include "bssm.h"
+#include "profiler.h"
 
 // p is the target distribution
 // r are random number from U(0,1)
@@ -8,6 +9,11 @@
 
 arma::uvec stratified_sample(arma::vec& p, const arma::vec& r, const unsigned int N) {
 
+  if (profiler::enabled) {
+    profiler::add_count(profiler::resampling_steps, 1);
+    profiler::add_ess(1.0 / arma::accu(arma::square(p)), N);
+  }
+  
   arma::uvec xp(N);
   p = arma::cumsum(p);
   p(p.n_elem - 1) = 1;
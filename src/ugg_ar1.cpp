@@ -1,11 +1,13 @@
 #include "ugg_ar1.h"
 
+#ifndef BSSM_STANDALONE
 // from Rcpp::List
 ugg_ar1::ugg_ar1(const Rcpp::List& model, const unsigned int seed) :
   ugg_ssm(model, seed), 
   mu_est(Rcpp::as<bool>(model["mu_est"])), 
   sd_y_est(Rcpp::as<bool>(model["sd_y_est"])) {
 }
+#endif
 
 void ugg_ar1::update_model(const arma::vec& new_theta) {
   
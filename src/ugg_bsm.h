@@ -7,7 +7,9 @@ class ugg_bsm: public ugg_ssm {
 
 public:
 
+#ifndef BSSM_STANDALONE
   ugg_bsm(const Rcpp::List& model, const unsigned int seed);
+#endif
 
   // update model given the parameters theta
   void update_model(const arma::vec& new_theta);
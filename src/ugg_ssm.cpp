@@ -4,7 +4,9 @@
 #include "sample.h"
 #include "distr_consts.h"
 #include "psd_chol.h"
+#include "profiler.h"
 
+#ifndef BSSM_STANDALONE
 // General constructor of ugg_ssm object from Rcpp::List
 // with parameter indices
 ugg_ssm::ugg_ssm(const Rcpp::List& model,
@@ -33,6 +35,7 @@ ugg_ssm::ugg_ssm(const Rcpp::List& model,
   compute_HH();
   compute_RR();
 }
+#endif
 
 // General constructor of ugg_ssm object
 // with parameter indices
@@ -128,6 +131,7 @@ void ugg_ssm::compute_RR(){
 }
 
 double ugg_ssm::log_likelihood() const {
+  profiler::timer timer(profiler::kalman_filter);
   
   double logLik = 0;
   arma::vec at = a1;
@@ -159,6 +163,7 @@ double ugg_ssm::log_likelihood() const {
 
 
 arma::cube ugg_ssm::simulate_states(const unsigned int nsim, const bool use_antithetic) {
+  profiler::timer timer(profiler::simulation_smoother);
   
   arma::vec y_tmp = y;
   
@@ -270,6 +275,15 @@ arma::cube ugg_ssm::simulate_states(const unsigned int nsim, const bool use_anti
  * which are needed in simulation smoother and Laplace approximation
  */
 arma::mat ugg_ssm::fast_smoother() const {
+  double loglik;
+  return fast_smoother(loglik);
+}
+
+/* Fast state smoothing which returns also the log-likelihood, 
+ * as computed by log_likelihood()
+ */
+arma::mat ugg_ssm::fast_smoother(double& loglik) const {
+  profiler::timer timer(profiler::kalman_smoother);
   
   arma::mat at(m, n + 1);
   arma::mat Pt(m, m);
@@ -285,12 +299,16 @@ arma::mat ugg_ssm::fast_smoother() const {
     y_tmp -= xbeta;
   }
   
+  const double LOG2PI = std::log(2.0 * M_PI);
+  loglik = 0.0;
+  
   for (unsigned int t = 0; t < n; t++) {
     Ft(t) = arma::as_scalar(Z.col(t * Ztv).t() * Pt * Z.col(t * Ztv) + HH(t * Htv));
     if (arma::is_finite(y_tmp(t)) && Ft(t) > zero_tol) {
       Kt.col(t) = Pt * Z.col(t * Ztv) / Ft(t);
       vt(t) = arma::as_scalar(y_tmp(t) - D(t * Dtv) - Z.col(t * Ztv).t() * at.col(t));
       at.col(t + 1) = C.col(t * Ctv) + T.slice(t * Ttv) * (at.col(t) + Kt.col(t) * vt(t));
+      loglik -= 0.5 * (LOG2PI + std::log(Ft(t)) + vt(t) * vt(t) / Ft(t));
       //Pt = arma::symmatu(T.slice(t * Ttv) * (Pt - Kt.col(t) * Kt.col(t).t() * Ft(t)) * T.slice(t * Ttv).t() + RR.slice(t * Rtv));
       // Switched to numerically better form
       arma::mat tmp = arma::eye(m, m) - Kt.col(t) * Z.col(t * Ztv).t();
@@ -333,6 +351,7 @@ arma::mat ugg_ssm::fast_smoother() const {
  */
 arma::mat ugg_ssm::fast_smoother(const arma::vec& Ft, const arma::mat& Kt,
   const arma::cube& Lt) const {
+  profiler::timer timer(profiler::kalman_smoother);
   
   arma::mat at(m, n + 1);
   arma::mat Pt(m, m);
@@ -382,6 +401,7 @@ arma::mat ugg_ssm::fast_smoother(const arma::vec& Ft, const arma::mat& Kt,
 
 arma::mat ugg_ssm::fast_precomputing_smoother(arma::vec& Ft, arma::mat& Kt,
   arma::cube& Lt) const {
+  profiler::timer timer(profiler::kalman_smoother);
   
   arma::mat at(m, n + 1);
   arma::mat Pt(m, m);
@@ -437,6 +457,7 @@ arma::mat ugg_ssm::fast_precomputing_smoother(arma::vec& Ft, arma::mat& Kt,
 // smoother which returns also cov(alpha_t, alpha_t-1)
 // used in psi particle filter
 void ugg_ssm::smoother_ccov(arma::mat& at, arma::cube& Pt, arma::cube& ccov) const {
+  profiler::timer timer(profiler::kalman_smoother);
   
   at.col(0) = a1;
   Pt.slice(0) = P1;
@@ -494,6 +515,7 @@ void ugg_ssm::smoother_ccov(arma::mat& at, arma::cube& Pt, arma::cube& ccov) con
 
 double ugg_ssm::filter(arma::mat& at, arma::mat& att, arma::cube& Pt,
   arma::cube& Ptt) const {
+  profiler::timer timer(profiler::kalman_filter);
   
   double logLik = 0;
   
@@ -531,6 +553,7 @@ double ugg_ssm::filter(arma::mat& at, arma::mat& att, arma::cube& Pt,
 }
 
 void ugg_ssm::smoother(arma::mat& at, arma::cube& Pt) const {
+  profiler::timer timer(profiler::kalman_smoother);
   
   at.col(0) = a1;
   Pt.slice(0) = P1;
@@ -579,6 +602,7 @@ void ugg_ssm::smoother(arma::mat& at, arma::cube& Pt) const {
   }
 }
 
+#ifndef BSSM_STANDALONE
 Rcpp::List ugg_ssm::predict_interval(const arma::vec& probs, const arma::mat& theta_posterior,
   const arma::mat& alpha, const arma::uvec& counts, const unsigned int predict_type) {
   
@@ -676,6 +700,7 @@ Rcpp::List ugg_ssm::predict_interval(const arma::vec& probs, const arma::mat& th
       Rcpp::Named("sd_pred") = expanded_sd);
   }
 }
+#endif
 arma::cube ugg_ssm::predict_sample(const arma::mat& theta_posterior,
   const arma::mat& alpha, const arma::uvec& counts, const unsigned int predict_type, 
   const unsigned int nsim) {
@@ -735,6 +760,7 @@ arma::mat ugg_ssm::sample_model(const unsigned int predict_type, const unsigned
 
 double ugg_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
   arma::mat& weights, arma::umat& indices) {
+  profiler::timer timer(profiler::bsf_filter);
   
   arma::mat L_P1 = psd_chol(P1);
   
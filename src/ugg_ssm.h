@@ -9,6 +9,7 @@ class ugg_ssm {
   
 public:
   
+#ifndef BSSM_STANDALONE
   // constructor from Rcpp::List
   ugg_ssm(const Rcpp::List& model, 
     const unsigned int seed = 1, 
@@ -16,6 +17,7 @@ public:
     const arma::uvec& H_ind_ = arma::uvec(), 
     const arma::uvec& T_ind_ = arma::uvec(), 
     const arma::uvec& R_ind_ = arma::uvec());
+#endif
   
   // constructor from armadillo objects
   ugg_ssm(const arma::vec& y, const arma::mat& Z, const arma::vec& H, 
@@ -51,6 +53,8 @@ public:
   
   // perform fast state smoothing
   arma::mat fast_smoother() const;
+  // fast smoothing which returns also the log-likelihood
+  arma::mat fast_smoother(double& loglik) const;
   // fast smoothing using precomputed matrices
   arma::mat fast_smoother(const arma::vec& Ft, const arma::mat& Kt,
     const arma::cube& Lt) const;
@@ -65,8 +69,10 @@ public:
   double bsf_filter(const unsigned int nsim, arma::cube& alpha,
     arma::mat& weights, arma::umat& indices);
  
+#ifndef BSSM_STANDALONE
   Rcpp::List predict_interval(const arma::vec& probs, const arma::mat& theta,
     const arma::mat& alpha, const arma::uvec& counts, const unsigned int predict_type);
+#endif
   arma::cube predict_sample(const arma::mat& theta,
     const arma::mat& alpha, const arma::uvec& counts, const unsigned int predict_type
     , const unsigned int nsim);
@@ -1,7 +1,8 @@
 #ifdef _OPENMP
 #include <omp.h>
 #endif
-#include <ramcmc.h>
+#include <exception>
+#include "ram.h"
 #include "ung_amcmc.h"
 #include "ugg_ssm.h"
 #include "ung_ssm.h"
@@ -14,13 +15,18 @@
 #include "distr_consts.h"
 #include "filter_smoother.h"
 #include "summary.h"
+#include "block_queue.h"
+#include "pt_mcmc.h"
+#include "output_sink.h"
+#include "checkpoint.h"
 
 ung_amcmc::ung_amcmc(const unsigned int n_iter, 
   const unsigned int n_burnin, const unsigned int n_thin, const unsigned int n, 
   const unsigned int m, const double target_acceptance, const double gamma, 
-  const arma::mat& S, const unsigned int output_type, const bool store_modes) :
+  const arma::mat& S, const unsigned int output_type, const bool store_modes,
+  const std::string& output_file, const unsigned int precision) :
   mcmc(n_iter, n_burnin, n_thin, n, m,
-    target_acceptance, gamma, S, output_type),
+    target_acceptance, gamma, S, output_type, output_file, precision),
     weight_storage(arma::vec(n_samples, arma::fill::zeros)),
     y_storage(arma::mat(n, n_samples * store_modes)), 
     H_storage(arma::mat(n, n_samples * store_modes)),
@@ -33,8 +39,12 @@ void ung_amcmc::trim_storage() {
   theta_storage.resize(n_par, n_stored);
   posterior_storage.resize(n_stored);
   count_storage.resize(n_stored);
-  if (output_type == 1) {
-    alpha_storage.resize(alpha_storage.n_rows, alpha_storage.n_cols, n_stored);
+  if (output_type == 1 && !sink) {
+    if (packed_alpha.precision > 1) {
+      packed_alpha.resize(n_stored);
+    } else {
+      alpha_storage.resize(alpha_storage.n_rows, alpha_storage.n_cols, n_stored);
+    }
   }
   approx_loglik_storage.resize(n_stored);
   weight_storage.resize(n_stored);
@@ -46,6 +56,17 @@ void ung_amcmc::trim_storage() {
   }
 }
 
+void ung_amcmc::sync_storage(checkpoint& file) {
+  mcmc::sync_storage(file);
+  file.sync_head(approx_loglik_storage, n_stored);
+  file.sync_head(prior_storage, n_stored);
+  if (store_modes) {
+    file.sync_cols(y_storage, n_stored);
+    file.sync_cols(H_storage, n_stored);
+    file.sync_cols(scales_storage, n_stored);
+  }
+}
+
 void ung_amcmc::expand() {
   //trim extras first just in case
   trim_storage();
@@ -67,6 +88,10 @@ void ung_amcmc::expand() {
   prior_storage.set_size(n_stored);
   prior_storage = expanded_prior;
   
+  if (output_type == 1 && packed_alpha.precision > 1) {
+    packed_alpha.expand(count_storage);
+  }
+  
   count_storage.resize(n_stored);
   count_storage.ones();
   
@@ -74,7 +99,8 @@ void ung_amcmc::expand() {
   approx_loglik_storage.set_size(n_stored);
   approx_loglik_storage = expanded_approx_loglik;
   
-  if (output_type == 1) {
+  // with streamed output, the states are written only after the expansion
+  if (output_type == 1 && !sink && packed_alpha.precision == 1) {
     arma::cube expanded_alpha = rep_cube(alpha_storage, count_storage);
     alpha_storage.set_size(alpha_storage.n_rows, alpha_storage.n_cols, n_stored);
     alpha_storage = expanded_alpha;
@@ -96,31 +122,38 @@ void ung_amcmc::expand() {
   }
 }
 
+void ung_amcmc::close_output() {
+  if (sink) {
+    sink->close(theta_storage, posterior_storage, count_storage, weight_storage);
+  }
+}
+
 // run approximate MCMC for
 // non-linear and/or non-Gaussian state space model with linear-Gaussian states
 template void ung_amcmc::approx_mcmc(ung_ssm model, const bool end_ram,
   const bool local_approx, const arma::vec& initial_mode,
-  const unsigned int max_iter, const double conv_tol);
+  const unsigned int max_iter, const double conv_tol, block_queue* queue);
 template void ung_amcmc::approx_mcmc(ung_bsm model, const bool end_ram,
   const bool local_approx, const arma::vec& initial_mode,
-  const unsigned int max_iter, const double conv_tol);
+  const unsigned int max_iter, const double conv_tol, block_queue* queue);
 template void ung_amcmc::approx_mcmc(ung_svm model, const bool end_ram,
   const bool local_approx, const arma::vec& initial_mode,
-  const unsigned int max_iter, const double conv_tol);
+  const unsigned int max_iter, const double conv_tol, block_queue* queue);
 template void ung_amcmc::approx_mcmc(ung_ar1 model, const bool end_ram,
   const bool local_approx, const arma::vec& initial_mode,
-  const unsigned int max_iter, const double conv_tol);
+  const unsigned int max_iter, const double conv_tol, block_queue* queue);
 
 template<class T>
 void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx,
-  const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol) {
+  const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol,
+  block_queue* queue) {
   
   // get the current values of theta
   arma::vec theta = model.theta;
   // compute the log[p(theta)]
-  double logprior = model.log_prior_pdf(theta);
+  double logprior = profiler::log_prior_pdf(model, theta);
   if (!arma::is_finite(logprior)) {
-    Rcpp::stop("Initial prior probability is not finite.");
+    bssm::stop("Initial prior probability is not finite.");
   }
   // construct the approximate Gaussian model
   arma::vec mode_estimate = initial_mode;
@@ -138,7 +171,7 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
   // log-likelihood approximation
   double approx_loglik = gaussian_loglik + const_term + sum_scales;
   if (!std::isfinite(approx_loglik))
-    Rcpp::stop("Initial log-likelihood is not finite.");
+    bssm::stop("Initial log-likelihood is not finite.");
   double acceptance_prob = 0.0;
   std::normal_distribution<> normal(0.0, 1.0);
   std::uniform_real_distribution<> unif(0.0, 1.0);
@@ -149,10 +182,14 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
   bool new_value = true;
   unsigned int n_values = 0;
   
-  for (unsigned int i = 1; i <= n_iter; i++) {
+  unsigned int i_start = resume_checkpoint("approx_mcmc", model.engine, normal, unif,
+    theta, logprior, new_value, n_values, approx_loglik, scales, approx_y, approx_H,
+    mode_estimate, approx_model.y, approx_model.H, approx_model.HH,
+    approx_model.engine);
+  for (unsigned int i = i_start; i <= n_iter; i++) {
     
     if (i % 16 == 0) {
-      Rcpp::checkUserInterrupt();
+      check_interrupt();
     }
     
     // sample from standard normal distribution
@@ -164,7 +201,7 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
     // propose new theta
     arma::vec theta_prop = theta + S * u;
     // compute prior
-    double logprior_prop = model.log_prior_pdf(theta_prop);
+    double logprior_prop = profiler::log_prior_pdf(model, theta_prop);
     
     if (logprior_prop > -std::numeric_limits<double>::infinity() && !std::isnan(logprior_prop)) {
       // update parameters
@@ -173,10 +210,10 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
       if (local_approx) {
         // construct the approximate Gaussian model
         mode_estimate = initial_mode;
-        model.approximate(approx_model, mode_estimate, max_iter, conv_tol);
+        model.approximate(approx_model, mode_estimate, max_iter, conv_tol, &gaussian_loglik);
         
       } else {
-        model.approximate(approx_model, mode_estimate, 0, conv_tol);
+        model.approximate(approx_model, mode_estimate, 0, conv_tol, &gaussian_loglik);
         
       }
       // compute unnormalized mode-based correction terms
@@ -186,8 +223,6 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
       // compute the constant term (not really a constant in all cases, bad name!)
       const_term = compute_const_term(model, approx_model);
       // compute the log-likelihood of the approximate model
-      // we could (should) extract this from fast_smoother used in approximation
-      gaussian_loglik = approx_model.log_likelihood();
       double approx_loglik_prop = gaussian_loglik + const_term + sum_scales;
       
       acceptance_prob = std::min(1.0, std::exp(approx_loglik_prop - approx_loglik +
@@ -222,6 +257,11 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
         count_storage(n_stored) = 1;
         n_stored++;
         new_value = false;
+        // previous block is now closed and can be corrected, the queue is 
+        // closed early only if the correction failed, so the chain can stop
+        if (queue != NULL && n_stored > 1 && !queue->push(n_stored - 2)) {
+          break;
+        }
       } else {
         count_storage(n_stored - 1)++;
       }
@@ -229,102 +269,118 @@ void ung_amcmc::approx_mcmc(T model, const bool end_ram, const bool local_approx
     
     
     if (!end_ram || i <= n_burnin) {
+      profiler::timer ram_timer(profiler::ram_adaptation);
       ramcmc::adapt_S(S, u, acceptance_prob, target_acceptance, i, gamma);
     }
+    save_checkpoint(i, "approx_mcmc", model.engine, normal, unif, theta, logprior,
+      new_value, n_values, approx_loglik, scales, approx_y, approx_H, mode_estimate,
+      approx_model.y, approx_model.H, approx_model.HH, approx_model.engine);
   }
   
-  trim_storage();
+  if (queue != NULL) {
+    // storage is trimmed by the caller once all the blocks are corrected
+    if (n_stored > 0) {
+      queue->push(n_stored - 1);
+    }
+  } else {
+    trim_storage();
+  }
   acceptance_rate /= (n_iter - n_burnin);
 }
 
-// approximate MCMC
-
-template void ung_amcmc::is_correction_psi(ung_ssm model, const unsigned int nsim_states, 
-  const unsigned int is_type, const unsigned int n_threads);
-template void ung_amcmc::is_correction_psi(ung_bsm model, const unsigned int nsim_states, 
-  const unsigned int is_type, const unsigned int n_threads);
-template void ung_amcmc::is_correction_psi(ung_svm model, const unsigned int nsim_states, 
-  const unsigned int is_type, const unsigned int n_threads);
-template void ung_amcmc::is_correction_psi(ung_ar1 model, const unsigned int nsim_states, 
-  const unsigned int is_type, const unsigned int n_threads);
+// approximate MCMC with parallel tempering
+// the approximation depends on the path of the chain unless local_approx = TRUE, 
+// so local approximations are used with all replicas, and the approximations at 
+// the stored values of theta are recomputed afterwards
+template void ung_amcmc::pt_approx_mcmc(ung_ssm model, const bool end_ram,
+  const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol, 
+  const unsigned int n_temps, const unsigned int seed, const unsigned int n_threads);
+template void ung_amcmc::pt_approx_mcmc(ung_bsm model, const bool end_ram,
+  const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol, 
+  const unsigned int n_temps, const unsigned int seed, const unsigned int n_threads);
+template void ung_amcmc::pt_approx_mcmc(ung_svm model, const bool end_ram,
+  const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol, 
+  const unsigned int n_temps, const unsigned int seed, const unsigned int n_threads);
+template void ung_amcmc::pt_approx_mcmc(ung_ar1 model, const bool end_ram,
+  const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol, 
+  const unsigned int n_temps, const unsigned int seed, const unsigned int n_threads);
 
-template <class T>
-void ung_amcmc::is_correction_psi(T model, const unsigned int nsim_states, 
-  const unsigned int is_type, const unsigned int n_threads) {
+template<class T>
+void ung_amcmc::pt_approx_mcmc(T model, const bool end_ram, 
+  const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol, 
+  const unsigned int n_temps, const unsigned int seed, const unsigned int n_threads) {
   
-  arma::cube Valpha(model.m, model.m, model.n + 1, arma::fill::zeros);
-  double sum_w = 0.0;
+  arma::vec mode_estimate = initial_mode;
+  ugg_ssm approx_model = model.approximate(mode_estimate, max_iter, conv_tol);
   
+  auto loglik_fn = [=](T& model, const arma::vec& theta) mutable {
+    model.update_model(theta);
+    mode_estimate = initial_mode;
+    double gaussian_loglik;
+    model.approximate(approx_model, mode_estimate, max_iter, conv_tol, 
+      &gaussian_loglik);
+    return gaussian_loglik + compute_const_term(model, approx_model) + 
+      arma::accu(model.scaling_factors(approx_model, mode_estimate));
+  };
+  pt_mcmc(model, loglik_fn, end_ram, n_temps, seed, n_threads);
+  
+  std::exception_ptr error = nullptr;
 #ifdef _OPENMP
-#pragma omp parallel num_threads(n_threads) default(none) shared(Valpha, sum_w) firstprivate(model) 
+#pragma omp parallel for num_threads(n_threads) schedule(dynamic) firstprivate(model, approx_model)
+#endif
+  for (unsigned int i = 0; i < n_stored; i++) {
+    try {
+      arma::vec theta = theta_storage.col(i);
+      model.update_model(theta);
+      arma::vec mode_i = initial_mode;
+      double gaussian_loglik;
+      model.approximate(approx_model, mode_i, max_iter, conv_tol, &gaussian_loglik);
+      arma::vec scales = model.scaling_factors(approx_model, mode_i);
+      approx_loglik_storage(i) = gaussian_loglik + 
+        compute_const_term(model, approx_model) + arma::accu(scales);
+      prior_storage(i) = profiler::log_prior_pdf(model, theta);
+      if (store_modes) {
+        y_storage.col(i) = approx_model.y;
+        H_storage.col(i) = approx_model.H;
+        scales_storage.col(i) = scales;
+      }
+    } catch (...) {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
 {
-  
-  model.engine = sitmo::prng_engine(omp_get_thread_num() + 1);
-  
-  arma::vec tmp(1);
-  ugg_ssm approx_model = model.approximate(tmp, 0, 0);
-  
-#pragma omp for schedule(dynamic)
-  for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
-    
-    model.update_model(theta_storage.col(i));
-    approx_model.Z = model.Z;
-    approx_model.T = model.T;
-    approx_model.R = model.R;
-    approx_model.a1 = model.a1;
-    approx_model.P1 = model.P1;
-    approx_model.beta = model.beta;
-    approx_model.D = model.D;
-    approx_model.C = model.C;
-    approx_model.RR = model.RR;
-    approx_model.xbeta = model.xbeta;
-    approx_model.y = y_storage.col(i);
-    approx_model.H = H_storage.col(i);
-    approx_model.compute_HH();
-    
-    unsigned int nsim = nsim_states;
-    if (is_type == 1) {
-      nsim *= count_storage(i);
+  error = std::current_exception();
+}
     }
-    
-    arma::cube alpha_i(model.m, model.n + 1, nsim);
-    arma::mat weights_i(nsim, model.n + 1);
-    arma::umat indices(nsim, model.n);
-    
-    double loglik = model.psi_filter(approx_model, 0, scales_storage.col(i),
-      nsim, alpha_i, weights_i, indices);
-    
-    weight_storage(i) = std::exp(loglik);
-    if (output_type != 3) {
-      filter_smoother(alpha_i, indices);
-      arma::vec w = weights_i.col(model.n);
-      if (output_type == 1) {
-        std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
-        alpha_storage.slice(i) = alpha_i.slice(sample(model.engine)).t();
-      } else {
-        arma::mat alphahat_i(model.m, model.n + 1);
-        arma::cube Vt_i(model.m, model.m, model.n + 1);
-        weighted_summary(alpha_i, alphahat_i, Vt_i, w);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void ung_amcmc::update_summary(const arma::mat& alphahat_i, const arma::cube& Vt_i, 
+  const unsigned int i, arma::cube& Valpha, double& sum_w) {
+  
+#ifdef _OPENMP
 #pragma omp critical
+#endif
 {
   arma::mat diff = alphahat_i - alphahat;
   double tmp = count_storage(i) + sum_w;
   alphahat = (alphahat * sum_w + alphahat_i * count_storage(i)) / tmp;
-  for (unsigned int t = 0; t < model.n + 1; t++) {
+  for (unsigned int t = 0; t < alphahat_i.n_cols; t++) {
     Valpha.slice(t) += diff.col(t) * (alphahat_i.col(t) - alphahat.col(t)).t();
   }
   Vt = (Vt * sum_w + Vt_i * count_storage(i)) / tmp;
   sum_w = tmp;
 }
-      }
-    }
-  }
 }
-#else
-arma::vec tmp(1);
-ugg_ssm approx_model = model.approximate(tmp, 0, 0);
 
-for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
+template <class T>
+void ung_amcmc::psi_correction(T& model, ugg_ssm& approx_model, const unsigned int i,
+  const unsigned int nsim_states, const unsigned int is_type, 
+  arma::cube& Valpha, double& sum_w) {
+  profiler::timer timer(profiler::is_correction);
   
   model.update_model(theta_storage.col(i));
   approx_model.Z = model.Z;
@@ -349,6 +405,7 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
   arma::cube alpha_i(model.m, model.n + 1, nsim);
   arma::mat weights_i(nsim, model.n + 1);
   arma::umat indices(nsim, model.n);
+  
   double loglik = model.psi_filter(approx_model, 0, scales_storage.col(i),
     nsim, alpha_i, weights_i, indices);
   
@@ -358,24 +415,139 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
     arma::vec w = weights_i.col(model.n);
     if (output_type == 1) {
       std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
-      alpha_storage.slice(i) = alpha_i.slice(sample(model.engine)).t();
+      store_states(i, alpha_i.slice(sample(model.engine)).t());
+    } else if (output_type == 4) {
+      sketch_states(alpha_i, w, count_storage(i) * weight_storage(i));
     } else {
       arma::mat alphahat_i(model.m, model.n + 1);
       arma::cube Vt_i(model.m, model.m, model.n + 1);
       weighted_summary(alpha_i, alphahat_i, Vt_i, w);
-      
-      arma::mat diff = alphahat_i - alphahat;
-      double tmp = count_storage(i) + sum_w;
-      alphahat = (alphahat * sum_w + alphahat_i * count_storage(i)) / tmp;
-      for (unsigned int t = 0; t < model.n + 1; t++) {
-        Valpha.slice(t) += diff.col(t) * (alphahat_i.col(t) - alphahat.col(t)).t();
-      }
-      Vt = (Vt * sum_w + Vt_i * count_storage(i)) / tmp;
-      sum_w = tmp;
+      update_summary(alphahat_i, Vt_i, i, Valpha, sum_w);
     }
   }
 }
 
+template <class T>
+void ung_amcmc::bsf_correction(T& model, const unsigned int i,
+  const unsigned int nsim_states, const unsigned int is_type, 
+  arma::cube& Valpha, double& sum_w) {
+  profiler::timer timer(profiler::is_correction);
+  
+  model.update_model(theta_storage.col(i));
+  
+  unsigned int nsim = nsim_states;
+  if (is_type == 1) {
+    nsim *= count_storage(i);
+  }
+  
+  arma::cube alpha_i(model.m, model.n + 1, nsim);
+  arma::mat weights_i(nsim, model.n + 1);
+  arma::umat indices(nsim, model.n);
+  
+  double loglik = model.bsf_filter(nsim, alpha_i, weights_i, indices);
+  weight_storage(i) = std::exp(loglik - approx_loglik_storage(i));
+  if (output_type != 3) {
+    filter_smoother(alpha_i, indices);
+    arma::vec w = weights_i.col(model.n);
+    if (output_type == 1) {
+      std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
+      store_states(i, alpha_i.slice(sample(model.engine)).t());
+    } else if (output_type == 4) {
+      sketch_states(alpha_i, w, count_storage(i) * weight_storage(i));
+    } else {
+      arma::mat alphahat_i(model.m, model.n + 1);
+      arma::cube Vt_i(model.m, model.m, model.n + 1);
+      weighted_summary(alpha_i, alphahat_i, Vt_i, w);
+      update_summary(alphahat_i, Vt_i, i, Valpha, sum_w);
+    }
+  }
+}
+
+template <class T>
+void ung_amcmc::spdk_correction(T& model, ugg_ssm& approx_model, const unsigned int i,
+  const unsigned int nsim_states, const unsigned int is_type, 
+  arma::cube& Valpha, double& sum_w) {
+  profiler::timer timer(profiler::is_correction);
+  
+  model.update_model(theta_storage.col(i));
+  approx_model.Z = model.Z;
+  approx_model.T = model.T;
+  approx_model.R = model.R;
+  approx_model.a1 = model.a1;
+  approx_model.P1 = model.P1;
+  approx_model.beta = model.beta;
+  approx_model.D = model.D;
+  approx_model.C = model.C;
+  approx_model.RR = model.RR;
+  approx_model.xbeta = model.xbeta;
+  approx_model.y = y_storage.col(i);
+  approx_model.H = H_storage.col(i);
+  approx_model.compute_HH();
+  
+  unsigned int nsim = nsim_states;
+  if (is_type == 1) {
+    nsim *= count_storage(i);
+  }
+  
+  arma::cube alpha_i = approx_model.simulate_states(nsim, true);
+  arma::vec weights_i = model.importance_weights(approx_model, alpha_i);
+  weights_i = arma::exp(weights_i - arma::accu(scales_storage.col(i)));
+  weight_storage(i) = arma::mean(weights_i);
+  if (output_type != 3) {
+    if (output_type == 1) {
+      std::discrete_distribution<unsigned int> sample(weights_i.begin(), weights_i.end());
+      store_states(i, alpha_i.slice(sample(model.engine)).t());
+    } else if (output_type == 4) {
+      sketch_states(alpha_i, weights_i, count_storage(i) * weight_storage(i));
+    } else {
+      arma::mat alphahat_i(model.m, model.n + 1);
+      arma::cube Vt_i(model.m, model.m, model.n + 1);
+      weighted_summary(alpha_i, alphahat_i, Vt_i, weights_i);
+      update_summary(alphahat_i, Vt_i, i, Valpha, sum_w);
+    }
+  }
+}
+
+// approximate MCMC
+
+template void ung_amcmc::is_correction_psi(ung_ssm model, const unsigned int nsim_states, 
+  const unsigned int is_type, const unsigned int n_threads);
+template void ung_amcmc::is_correction_psi(ung_bsm model, const unsigned int nsim_states, 
+  const unsigned int is_type, const unsigned int n_threads);
+template void ung_amcmc::is_correction_psi(ung_svm model, const unsigned int nsim_states, 
+  const unsigned int is_type, const unsigned int n_threads);
+template void ung_amcmc::is_correction_psi(ung_ar1 model, const unsigned int nsim_states, 
+  const unsigned int is_type, const unsigned int n_threads);
+
+template <class T>
+void ung_amcmc::is_correction_psi(T model, const unsigned int nsim_states, 
+  const unsigned int is_type, const unsigned int n_threads) {
+  
+  arma::cube Valpha(model.m, model.m, model.n + 1, arma::fill::zeros);
+  double sum_w = 0.0;
+  
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads) default(none) shared(Valpha, sum_w) firstprivate(model) 
+{
+  
+  model.engine = sitmo::prng_engine(omp_get_thread_num() + 1);
+  
+  arma::vec tmp(1);
+  ugg_ssm approx_model = model.approximate(tmp, 0, 0);
+  
+#pragma omp for schedule(dynamic)
+  for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
+    psi_correction(model, approx_model, i, nsim_states, is_type, Valpha, sum_w);
+  }
+}
+#else
+arma::vec tmp(1);
+ugg_ssm approx_model = model.approximate(tmp, 0, 0);
+
+for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
+  psi_correction(model, approx_model, i, nsim_states, is_type, Valpha, sum_w);
+}
+
 #endif
 if (output_type == 2) {
   Vt += Valpha / theta_storage.n_cols; // Var[E(alpha)] + E[Var(alpha)]
@@ -412,84 +584,12 @@ void ung_amcmc::is_correction_bsf(T model, const unsigned int nsim_states,
   
 #pragma omp for schedule(dynamic)
   for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
-    
-    model.update_model(theta_storage.col(i));
-    
-    unsigned int nsim = nsim_states;
-    if (is_type == 1) {
-      nsim *= count_storage(i);
-    }
-    
-    arma::cube alpha_i(model.m, model.n + 1, nsim);
-    arma::mat weights_i(nsim, model.n + 1);
-    arma::umat indices(nsim, model.n);
-    
-    double loglik = model.bsf_filter(nsim, alpha_i, weights_i, indices);
-    weight_storage(i) = std::exp(loglik - approx_loglik_storage(i));
-    if (output_type != 3) {
-      filter_smoother(alpha_i, indices);
-      arma::vec w = weights_i.col(model.n);
-      if (output_type == 1) {
-        std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
-        alpha_storage.slice(i) = alpha_i.slice(sample(model.engine)).t();
-      } else {
-        arma::mat alphahat_i(model.m, model.n + 1);
-        arma::cube Vt_i(model.m, model.m, model.n + 1);
-        weighted_summary(alpha_i, alphahat_i, Vt_i, w);
-#pragma omp critical
-{
-  arma::mat diff = alphahat_i - alphahat;
-  double tmp = count_storage(i) + sum_w;
-  alphahat = (alphahat * sum_w + alphahat_i * count_storage(i)) / tmp;
-  for (unsigned int t = 0; t < model.n + 1; t++) {
-    Valpha.slice(t) += diff.col(t) * (alphahat_i.col(t) - alphahat.col(t)).t();
-  }
-  Vt = (Vt * sum_w + Vt_i * count_storage(i)) / tmp;
-  sum_w = tmp;
-}
-      }
-    }
-    
+    bsf_correction(model, i, nsim_states, is_type, Valpha, sum_w);
   }
 }
 #else
 for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
-  
-  model.update_model(theta_storage.col(i));
-  
-  unsigned int nsim = nsim_states;
-  if (is_type == 1) {
-    nsim *= count_storage(i);
-  }
-  
-  arma::cube alpha_i(model.m, model.n + 1, nsim);
-  arma::mat weights_i(nsim, model.n + 1);
-  arma::umat indices(nsim, model.n);
-  
-  double loglik = model.bsf_filter(nsim, alpha_i, weights_i, indices);
-  weight_storage(i) = std::exp(loglik - approx_loglik_storage(i));
-  
-  if (output_type != 3) {
-    filter_smoother(alpha_i, indices);
-    arma::vec w = weights_i.col(model.n);
-    if (output_type == 1) {
-      std::discrete_distribution<unsigned int> sample(w.begin(), w.end());
-      alpha_storage.slice(i) = alpha_i.slice(sample(model.engine)).t();
-    } else {
-      arma::mat alphahat_i(model.m, model.n + 1);
-      arma::cube Vt_i(model.m, model.m, model.n + 1);
-      weighted_summary(alpha_i, alphahat_i, Vt_i, w);
-      arma::mat diff = alphahat_i - alphahat;
-      double tmp = count_storage(i) + sum_w;
-      alphahat = (alphahat * sum_w + alphahat_i * count_storage(i)) / tmp;
-      for (unsigned int t = 0; t < model.n + 1; t++) {
-        Valpha.slice(t) += diff.col(t) * (alphahat_i.col(t) - alphahat.col(t)).t();
-      }
-      Vt = (Vt * sum_w + Vt_i * count_storage(i)) / tmp;
-      sum_w = tmp;
-      
-    }
-  }
+  bsf_correction(model, i, nsim_states, is_type, Valpha, sum_w);
 }
 #endif
 if (output_type == 2) {
@@ -525,52 +625,7 @@ void ung_amcmc::is_correction_spdk(T model, const unsigned int nsim_states,
   
 #pragma omp for schedule(dynamic)
   for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
-    
-    model.update_model(theta_storage.col(i));
-    approx_model.Z = model.Z;
-    approx_model.T = model.T;
-    approx_model.R = model.R;
-    approx_model.a1 = model.a1;
-    approx_model.P1 = model.P1;
-    approx_model.beta = model.beta;
-    approx_model.D = model.D;
-    approx_model.C = model.C;
-    approx_model.RR = model.RR;
-    approx_model.xbeta = model.xbeta;
-    approx_model.y = y_storage.col(i);
-    approx_model.H = H_storage.col(i);
-    approx_model.compute_HH();
-    
-    unsigned int nsim = nsim_states;
-    if (is_type == 1) {
-      nsim *= count_storage(i);
-    }
-    
-    arma::cube alpha_i = approx_model.simulate_states(nsim, true);
-    arma::vec weights_i = model.importance_weights(approx_model, alpha_i);
-    weights_i = arma::exp(weights_i - arma::accu(scales_storage.col(i)));
-    weight_storage(i) = arma::mean(weights_i);
-    if (output_type != 3) {
-      if (output_type == 1) {
-        std::discrete_distribution<unsigned int> sample(weights_i.begin(), weights_i.end());
-        alpha_storage.slice(i) = alpha_i.slice(sample(model.engine)).t();
-      } else {
-        arma::mat alphahat_i(model.m, model.n + 1);
-        arma::cube Vt_i(model.m, model.m, model.n + 1);
-        weighted_summary(alpha_i, alphahat_i, Vt_i, weights_i);
-#pragma omp critical
-{
-  arma::mat diff = alphahat_i - alphahat;
-  double tmp = count_storage(i) + sum_w;
-  alphahat = (alphahat * sum_w + alphahat_i * count_storage(i)) / tmp;
-  for (unsigned int t = 0; t < model.n + 1; t++) {
-    Valpha.slice(t) += diff.col(t) * (alphahat_i.col(t) - alphahat.col(t)).t();
-  }
-  Vt = (Vt * sum_w + Vt_i * count_storage(i)) / tmp;
-  sum_w = tmp;
-}
-      }
-    }
+    spdk_correction(model, approx_model, i, nsim_states, is_type, Valpha, sum_w);
   }
   
 }
@@ -579,48 +634,7 @@ arma::vec tmp(1);
 ugg_ssm approx_model = model.approximate(tmp, 0, 0);
 
 for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
-  
-  model.update_model(theta_storage.col(i));
-  approx_model.Z = model.Z;
-  approx_model.T = model.T;
-  approx_model.R = model.R;
-  approx_model.a1 = model.a1;
-  approx_model.P1 = model.P1;
-  approx_model.beta = model.beta;
-  approx_model.D = model.D;
-  approx_model.C = model.C;
-  approx_model.RR = model.RR;
-  approx_model.xbeta = model.xbeta;
-  approx_model.y = y_storage.col(i);
-  approx_model.H = H_storage.col(i);
-  approx_model.compute_HH();
-  
-  unsigned int nsim = nsim_states;
-  if (is_type == 1) {
-    nsim *= count_storage(i);
-  }
-  
-  arma::cube alpha_i = approx_model.simulate_states(nsim, true);
-  arma::vec weights_i = model.importance_weights(approx_model, alpha_i);
-  weights_i = arma::exp(weights_i - arma::accu(scales_storage.col(i)));
-  if (output_type != 3) {
-    if (output_type == 1) {
-      std::discrete_distribution<unsigned int> sample(weights_i.begin(), weights_i.end());
-      alpha_storage.slice(i) = alpha_i.slice(sample(model.engine)).t();
-    } else {
-      arma::mat alphahat_i(model.m, model.n + 1);
-      arma::cube Vt_i(model.m, model.m, model.n + 1);
-      weighted_summary(alpha_i, alphahat_i, Vt_i, weights_i);
-      arma::mat diff = alphahat_i - alphahat;
-      double tmp = count_storage(i) + sum_w;
-      alphahat = (alphahat * sum_w + alphahat_i * count_storage(i)) / tmp;
-      for (unsigned int t = 0; t < model.n + 1; t++) {
-        Valpha.slice(t) += diff.col(t) * (alphahat_i.col(t) - alphahat.col(t)).t();
-      }
-      Vt = (Vt * sum_w + Vt_i * count_storage(i)) / tmp;
-      sum_w = tmp;
-    }
-  }
+  spdk_correction(model, approx_model, i, nsim_states, is_type, Valpha, sum_w);
 }
 
 #endif
@@ -631,6 +645,126 @@ posterior_storage = prior_storage + approx_loglik_storage +
   arma::log(weight_storage);
 }
 
+template void ung_amcmc::pipelined_is_mcmc(ung_ssm model, const bool end_ram, 
+  const bool local_approx, const arma::vec& initial_mode, 
+  const unsigned int max_iter, const double conv_tol,
+  const unsigned int simulation_method, const unsigned int nsim_states, 
+  const unsigned int is_type, const unsigned int n_threads);
+template void ung_amcmc::pipelined_is_mcmc(ung_bsm model, const bool end_ram, 
+  const bool local_approx, const arma::vec& initial_mode, 
+  const unsigned int max_iter, const double conv_tol,
+  const unsigned int simulation_method, const unsigned int nsim_states, 
+  const unsigned int is_type, const unsigned int n_threads);
+template void ung_amcmc::pipelined_is_mcmc(ung_svm model, const bool end_ram, 
+  const bool local_approx, const arma::vec& initial_mode, 
+  const unsigned int max_iter, const double conv_tol,
+  const unsigned int simulation_method, const unsigned int nsim_states, 
+  const unsigned int is_type, const unsigned int n_threads);
+template void ung_amcmc::pipelined_is_mcmc(ung_ar1 model, const bool end_ram, 
+  const bool local_approx, const arma::vec& initial_mode, 
+  const unsigned int max_iter, const double conv_tol,
+  const unsigned int simulation_method, const unsigned int nsim_states, 
+  const unsigned int is_type, const unsigned int n_threads);
+
+template<class T>
+void ung_amcmc::pipelined_is_mcmc(T model, const bool end_ram, const bool local_approx,
+  const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol,
+  const unsigned int simulation_method, const unsigned int nsim_states, 
+  const unsigned int is_type, const unsigned int n_threads) {
+  
+#ifdef _OPENMP
+  // with is_type 3 the blocks are expanded before the correction
+  if (n_threads > 1 && is_type != 3) {
+    
+    arma::cube Valpha(model.m, model.m, model.n + 1, arma::fill::zeros);
+    double sum_w = 0.0;
+    block_queue queue(16 * n_threads);
+    std::exception_ptr chain_error = nullptr;
+    std::exception_ptr correction_error = nullptr;
+    
+#pragma omp parallel num_threads(n_threads) shared(Valpha, sum_w, queue, chain_error, correction_error) firstprivate(model) 
+{
+  // master thread runs the chain, all R API calls are done by it
+  if (omp_get_thread_num() == 0) {
+    try {
+      approx_mcmc(model, end_ram, local_approx, initial_mode, max_iter, conv_tol, 
+        &queue);
+    } catch (...) {
+      chain_error = std::current_exception();
+    }
+    queue.close();
+  }
+  // after the chain is finished the master thread joins the correction
+  model.engine = sitmo::prng_engine(omp_get_thread_num() + 1);
+  
+  // exceptions can't leave the parallel region, so the first one is stored and 
+  // the queue is closed, which stops the chain and lets the other threads drain it
+  try {
+    arma::vec tmp(1);
+    ugg_ssm approx_model = model.approximate(tmp, 0, 0);
+    
+    unsigned int i;
+    while (queue.pop(i)) {
+      switch (simulation_method) {
+      case 1:
+        psi_correction(model, approx_model, i, nsim_states, is_type, Valpha, sum_w);
+        break;
+      case 2:
+        bsf_correction(model, i, nsim_states, is_type, Valpha, sum_w);
+        break;
+      case 3:
+        spdk_correction(model, approx_model, i, nsim_states, is_type, Valpha, sum_w);
+        break;
+      }
+    }
+  } catch (...) {
+#pragma omp critical
+{
+  if (!correction_error) {
+    correction_error = std::current_exception();
+  }
+}
+    queue.close();
+  }
+}
+    if (chain_error) {
+      std::rethrow_exception(chain_error);
+    }
+    if (correction_error) {
+      std::rethrow_exception(correction_error);
+    }
+    trim_storage();
+    
+    if (output_type == 2) {
+      Vt += Valpha / theta_storage.n_cols; // Var[E(alpha)] + E[Var(alpha)]
+    }
+    if (simulation_method == 2) {
+      posterior_storage = prior_storage + arma::log(weight_storage);
+    } else {
+      posterior_storage = prior_storage + approx_loglik_storage + 
+        arma::log(weight_storage);
+    }
+    return;
+  }
+#endif
+  
+  approx_mcmc(model, end_ram, local_approx, initial_mode, max_iter, conv_tol);
+  if(is_type == 3) {
+    expand();
+  }
+  switch (simulation_method) {
+  case 1:
+    is_correction_psi(model, nsim_states, is_type, n_threads);
+    break;
+  case 2:
+    is_correction_bsf(model, nsim_states, is_type, n_threads);
+    break;
+  case 3:
+    is_correction_spdk(model, nsim_states, is_type, n_threads);
+    break;
+  }
+}
+
 template void ung_amcmc::approx_state_posterior(ung_ssm model, const unsigned int n_threads);
 template void ung_amcmc::approx_state_posterior(ung_bsm model, const unsigned int n_threads);
 template void ung_amcmc::approx_state_posterior(ung_svm model, const unsigned int n_threads);
@@ -665,7 +799,11 @@ void ung_amcmc::approx_state_posterior(T model, const unsigned int n_threads) {
     approx_model.y = y_storage.col(i);
     approx_model.H = H_storage.col(i);
     approx_model.compute_HH();
-    alpha_storage.slice(i) = approx_model.simulate_states(1).slice(0).t();
+    if (output_type == 4) {
+      sketch_states(approx_model.simulate_states(1).slice(0), count_storage(i));
+    } else {
+      store_states(i, approx_model.simulate_states(1).slice(0).t());
+    }
   }
 }
 #else
@@ -688,7 +826,11 @@ for (unsigned int i = 0; i < theta_storage.n_cols; i++) {
   approx_model.y = y_storage.col(i);
   approx_model.H = H_storage.col(i);
   approx_model.compute_HH();
-  alpha_storage.slice(i) = approx_model.simulate_states(1).slice(0).t();
+  if (output_type == 4) {
+    sketch_states(approx_model.simulate_states(1).slice(0), count_storage(i));
+  } else {
+    store_states(i, approx_model.simulate_states(1).slice(0).t());
+  }
 }
 #endif
 
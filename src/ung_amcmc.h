@@ -4,6 +4,9 @@
 #include "bssm.h"
 #include "mcmc.h"
 
+class ugg_ssm;
+class block_queue;
+
 class ung_amcmc: public mcmc {
   
 public:
@@ -12,14 +15,33 @@ public:
   ung_amcmc(const unsigned int n_iter, const unsigned int n_burnin, const unsigned int n_thin, 
     const unsigned int n, const unsigned int m, const double target_acceptance, 
     const double gamma, const arma::mat& S, const unsigned int output_type = 1, 
-    const bool store_modes = true);
+    const bool store_modes = true, const std::string& output_file = "", 
+    const unsigned int precision = 1);
   
   void expand();
   
+  // write the remaining samples and the weights to the output file
+  void close_output();
+  
   //approximate mcmc
   template<class T>
   void approx_mcmc(T model, const bool end_ram, const bool local_approx, 
-    const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol);
+    const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol,
+    block_queue* queue = NULL);
+  
+  // approximate mcmc where the IS-correction of closed blocks is done 
+  // simultaneously by the other threads
+  template<class T>
+  void pipelined_is_mcmc(T model, const bool end_ram, const bool local_approx, 
+    const arma::vec& initial_mode, const unsigned int max_iter, const double conv_tol,
+    const unsigned int simulation_method, const unsigned int nsim_states, 
+    const unsigned int is_type, const unsigned int n_threads);
+  
+  // approximate mcmc with parallel tempering, uses always local approximations
+  template<class T>
+  void pt_approx_mcmc(T model, const bool end_ram, const arma::vec& initial_mode, 
+    const unsigned int max_iter, const double conv_tol, const unsigned int n_temps, 
+    const unsigned int seed, const unsigned int n_threads);
   
   template <class T>
   void is_correction_psi(T model, const unsigned int nsim_states, 
@@ -44,6 +66,25 @@ public:
 private:
   
   void trim_storage();
+  void sync_storage(checkpoint& file);
+  
+  // IS-correction of a single block i
+  template <class T>
+  void psi_correction(T& model, ugg_ssm& approx_model, const unsigned int i,
+    const unsigned int nsim_states, const unsigned int is_type, 
+    arma::cube& Valpha, double& sum_w);
+  template <class T>
+  void bsf_correction(T& model, const unsigned int i,
+    const unsigned int nsim_states, const unsigned int is_type, 
+    arma::cube& Valpha, double& sum_w);
+  template <class T>
+  void spdk_correction(T& model, ugg_ssm& approx_model, const unsigned int i,
+    const unsigned int nsim_states, const unsigned int is_type, 
+    arma::cube& Valpha, double& sum_w);
+  // add summary statistics of block i to the running estimates
+  void update_summary(const arma::mat& alphahat_i, const arma::cube& Vt_i, 
+    const unsigned int i, arma::cube& Valpha, double& sum_w);
+  
   arma::mat scales_storage;
   arma::vec approx_loglik_storage;
   arma::vec prior_storage;
@@ -1,9 +1,12 @@
 #include "ung_ar1.h"
 
+#ifndef BSSM_STANDALONE
 // from Rcpp::List
 ung_ar1::ung_ar1(const Rcpp::List& model, const unsigned int seed) :
   ung_ssm(model, seed), mu_est(Rcpp::as<bool>(model["mu_est"])) {
+  theta_matrices |= T_theta | R_theta | a1_theta | P1_theta | C_theta;
 }
+#endif
 
 void ung_ar1::update_model(const arma::vec& new_theta) {
   
@@ -1,5 +1,6 @@
 #include "ung_bsm.h"
 
+#ifndef BSSM_STANDALONE
 // from Rcpp::List
 ung_bsm::ung_bsm(const Rcpp::List& model, const unsigned int seed) :
   ung_ssm(model, seed), slope(Rcpp::as<bool>(model["slope"])),
@@ -7,7 +8,9 @@ ung_bsm::ung_bsm(const Rcpp::List& model, const unsigned int seed) :
   noise(Rcpp::as<bool>(model["noise"])),
   fixed(Rcpp::as<arma::uvec>(model["fixed"])), level_est(fixed(0) == 0),
   slope_est(slope && fixed(1) == 0), seasonal_est(seasonal && fixed(2) == 0) {
+  theta_matrices |= R_theta | P1_theta;
 }
+#endif
 
 void ung_bsm::update_model(const arma::vec& new_theta) {
 
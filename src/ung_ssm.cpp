@@ -4,7 +4,10 @@
 #include "distr_consts.h"
 #include "sample.h"
 #include "rep_mat.h"
+#include "profiler.h"
+#include "block_tridiag.h"
 
+#ifndef BSSM_STANDALONE
 // General constructor of ung_ssm object from Rcpp::List
 // with parameter indices
 ung_ssm::ung_ssm(const Rcpp::List& model, const unsigned int seed,
@@ -25,12 +28,46 @@ ung_ssm::ung_ssm(const Rcpp::List& model, const unsigned int seed,
   theta(Rcpp::as<arma::vec>(model["theta"])), 
   prior_distributions(Rcpp::as<arma::uvec>(model["prior_distributions"])), 
   prior_parameters(Rcpp::as<arma::mat>(model["prior_parameters"])),
+  newton(model.containsElementNamed("newton") && Rcpp::as<bool>(model["newton"])),
+  auxiliary(model.containsElementNamed("auxiliary") && Rcpp::as<bool>(model["auxiliary"])),
+  cached_modes(model.containsElementNamed("mode_cache") ? 
+      Rcpp::as<unsigned int>(model["mode_cache"]) : 0),
   Z_ind(Z_ind), T_ind(T_ind), R_ind(R_ind) {
   
   if(xreg.n_cols > 0) {
     compute_xbeta();
   }
   compute_RR();
+  theta_matrices = (Z_ind.n_elem > 0) * Z_theta | (T_ind.n_elem > 0) * T_theta |
+    (R_ind.n_elem > 0) * R_theta;
+}
+#endif
+
+// General constructor of ung_ssm object
+// with parameter indices
+ung_ssm::ung_ssm(const arma::vec& y, const arma::mat& Z, const arma::cube& T, 
+  const arma::cube& R, const arma::vec& a1, const arma::mat& P1, 
+  const double phi, const arma::vec& u, const unsigned int distribution,
+  const arma::mat& xreg, const arma::vec& beta, const arma::vec& D, 
+  const arma::mat& C, const unsigned int seed, const arma::vec& theta,
+  const arma::uvec& prior_distributions, const arma::mat& prior_parameters, 
+  const arma::uvec& Z_ind, const arma::uvec& T_ind, const arma::uvec& R_ind) :
+  y(y), Z(Z), T(T), R(R), a1(a1), P1(P1), xreg(xreg), beta(beta), D(D), C(C),
+  Ztv(Z.n_cols > 1), Ttv(T.n_slices > 1), Rtv(R.n_slices > 1), Dtv(D.n_elem > 1),
+  Ctv(C.n_cols > 1),
+  n(y.n_elem), m(a1.n_elem), k(R.n_cols), RR(arma::cube(m, m, Rtv * (n - 1) + 1)),
+  xbeta(arma::vec(n, arma::fill::zeros)), engine(seed), zero_tol(1e-8),
+  phi(phi), u(u), distribution(distribution), phi_est(false), max_iter(100), 
+  conv_tol(1.0e-8), theta(theta), prior_distributions(prior_distributions), 
+  prior_parameters(prior_parameters), newton(false), auxiliary(false),
+  Z_ind(Z_ind), T_ind(T_ind), R_ind(R_ind) {
+  
+  if(xreg.n_cols > 0) {
+    compute_xbeta();
+  }
+  compute_RR();
+  theta_matrices = (Z_ind.n_elem > 0) * Z_theta | (T_ind.n_elem > 0) * T_theta |
+    (R_ind.n_elem > 0) * R_theta;
 }
 
 void ung_ssm::compute_RR(){
@@ -147,6 +184,7 @@ void ung_ssm::laplace_iter(const arma::vec& signal, arma::vec& approx_y,
 // in case of potential divergence etc...
 ugg_ssm ung_ssm::approximate(arma::vec& mode_estimate, const unsigned int max_iter,
   const double conv_tol) {
+  profiler::timer timer(profiler::approximate);
   
   //Construct y and H for the Gaussian model
   arma::vec approx_y(n, arma::fill::zeros);
@@ -160,8 +198,14 @@ ugg_ssm ung_ssm::approximate(arma::vec& mode_estimate, const unsigned int max_it
   
   unsigned int i = 0;
   double diff = conv_tol + 1;
+  if (newton && max_iter > 0 && newton_mode(mode_estimate, max_iter, conv_tol, diff)) {
+    laplace_iter(mode_estimate, approx_model.y, approx_model.H);
+    approx_model.compute_HH();
+    i = max_iter;
+  }
   while(i < max_iter && diff > conv_tol) {
     i++;
+    profiler::count(profiler::laplace_iterations);
     //Construct y and H for the Gaussian model
     laplace_iter(mode_estimate, approx_model.y, approx_model.H);
     approx_model.compute_HH();
@@ -184,54 +228,220 @@ ugg_ssm ung_ssm::approximate(arma::vec& mode_estimate, const unsigned int max_it
 
 //update previously obtained approximation
 void ung_ssm::approximate(ugg_ssm& approx_model, arma::vec& mode_estimate,
-  const unsigned int max_iter, const double conv_tol) const {
-  
-  //update model
-  approx_model.Z = Z;
-  approx_model.T = T;
-  approx_model.R = R;
-  approx_model.a1 = a1;
-  approx_model.P1 = P1;
-  approx_model.beta = beta;
-  approx_model.D = D;
-  approx_model.C = C;
-  approx_model.RR = RR;
-  approx_model.xbeta = xbeta;
+  const unsigned int max_iter, const double conv_tol, double* gaussian_loglik) const {
+  profiler::timer timer(profiler::approximate);
+  
+  // update model, the system matrices which don't depend on theta are the 
+  // same as in the approximating model constructed from this model, so only 
+  // the matrices changed by update_model are copied
+  if (theta_matrices & Z_theta) {
+    approx_model.Z = Z;
+  }
+  if (theta_matrices & T_theta) {
+    approx_model.T = T;
+  }
+  if (theta_matrices & R_theta) {
+    approx_model.R = R;
+    approx_model.RR = RR;
+  }
+  if (theta_matrices & a1_theta) {
+    approx_model.a1 = a1;
+  }
+  if (theta_matrices & P1_theta) {
+    approx_model.P1 = P1;
+  }
+  if (theta_matrices & C_theta) {
+    approx_model.C = C;
+  }
+  if (xreg.n_cols > 0) {
+    approx_model.beta = beta;
+    approx_model.xbeta = xbeta;
+  }
+  
+  // reuse the cached approximation of the same theta, or start the mode 
+  // search from the cached mode of the nearest theta
+  bool use_cache = max_iter > 0 && cached_modes.capacity > 0;
+  if (use_cache) {
+    bool exact;
+    int i = cached_modes.find(theta, exact);
+    if (i >= 0 && exact) {
+      mode_estimate = cached_modes.mode(i);
+      approx_model.y = cached_modes.approx(i).col(0);
+      approx_model.H = cached_modes.approx(i).col(1);
+      approx_model.compute_HH();
+      if (gaussian_loglik) {
+        *gaussian_loglik = approx_model.log_likelihood();
+      }
+      return;
+    }
+    if (i >= 0) {
+      mode_estimate = cached_modes.mode(i);
+    }
+  }
   
+  // log-likelihood of the approximating model from the last smoothing, 
+  // which is done after the last update of y and H
+  double loglik = 0.0;
+  bool loglik_computed = false;
   if(max_iter == 0 && mode_estimate.n_elem == n) {
     if (distribution == 0) {
-      mode_estimate = arma::vectorise(approx_model.fast_smoother().head_cols(n));
+      mode_estimate = arma::vectorise(approx_model.fast_smoother(loglik).head_cols(n));
     } else {
-      arma::mat alpha = approx_model.fast_smoother().head_cols(n);
+      arma::mat alpha = approx_model.fast_smoother(loglik).head_cols(n);
       for (unsigned int t = 0; t < n; t++) {
         mode_estimate(t) = arma::as_scalar(Z.col(Ztv * t).t() * alpha.col(t));
       }
     }
+    loglik_computed = true;
   }
   unsigned int i = 0;
   double diff = conv_tol + 1;
+  if (newton && max_iter > 0 && newton_mode(mode_estimate, max_iter, conv_tol, diff)) {
+    laplace_iter(mode_estimate, approx_model.y, approx_model.H);
+    approx_model.compute_HH();
+    i = max_iter;
+  }
   while(i < max_iter && diff > conv_tol) {
     i++;
+    profiler::count(profiler::laplace_iterations);
     //Construct y and H for the Gaussian model
     laplace_iter(mode_estimate, approx_model.y, approx_model.H);
     approx_model.compute_HH();
     // compute new guess of mode
     arma::vec mode_estimate_new(n);
     if (distribution == 0) {
-      mode_estimate_new = arma::vectorise(approx_model.fast_smoother().head_cols(n));
+      mode_estimate_new = arma::vectorise(approx_model.fast_smoother(loglik).head_cols(n));
     } else {
-      arma::mat alpha = approx_model.fast_smoother().head_cols(n);
+      arma::mat alpha = approx_model.fast_smoother(loglik).head_cols(n);
       for (unsigned int t = 0; t < n; t++) {
         mode_estimate_new(t) = arma::as_scalar(Z.col(Ztv * t).t() * alpha.col(t));
       }
     }
+    loglik_computed = true;
     diff = arma::mean(arma::square(mode_estimate_new - mode_estimate));
     mode_estimate = mode_estimate_new;
   }
-  
+  if (use_cache && diff <= conv_tol && mode_estimate.is_finite()) {
+    cached_modes.insert(theta, mode_estimate, 
+      arma::join_rows(approx_model.y, approx_model.H));
+  }
+  if (gaussian_loglik) {
+    *gaussian_loglik = loglik_computed ? loglik : approx_model.log_likelihood();
+  }
 }
 
 
+// Newton's method for the mode of the signal, where each step solves the 
+// mode of the current approximating Gaussian model directly from the block 
+// tridiagonal posterior precision of the states in O(n m^3) operations, 
+// instead of running the Kalman filter and smoother, followed by a 
+// backtracking line search on the log-density of the states.
+// As in laplace_iter, the negative binomial case uses the expected 
+// information (Fisher scoring). The precision of the states exists only if 
+// P1 and RR are positive definite, otherwise false is returned and 
+// mode_estimate is left unchanged.
+bool ung_ssm::newton_mode(arma::vec& mode_estimate, const unsigned int max_iter,
+  const double conv_tol, double& diff) const {
+  
+  // prior precisions of the initial state and the state disturbances
+  arma::mat L(m, m);
+  if (!arma::chol(L, P1, "lower")) {
+    return false;
+  }
+  arma::mat L_inv = arma::inv(arma::trimatl(L));
+  arma::mat P1_inv = L_inv.t() * L_inv;
+  arma::cube RR_inv(m, m, RR.n_slices);
+  for (unsigned int t = 0; t < RR.n_slices; t++) {
+    if (!arma::chol(L, RR.slice(t), "lower")) {
+      return false;
+    }
+    L_inv = arma::inv(arma::trimatl(L));
+    RR_inv.slice(t) = L_inv.t() * L_inv;
+  }
+  
+  // precision and linear term of the prior of the states
+  arma::cube A0(m, m, n, arma::fill::zeros);
+  arma::cube B(m, m, n - 1);
+  arma::mat b0(m, n, arma::fill::zeros);
+  A0.slice(0) = P1_inv;
+  b0.col(0) = P1_inv * a1;
+  for (unsigned int t = 0; t < (n - 1); t++) {
+    arma::mat WT = RR_inv.slice(t * Rtv) * T.slice(t * Ttv);
+    A0.slice(t) += T.slice(t * Ttv).t() * WT;
+    A0.slice(t + 1) += RR_inv.slice(t * Rtv);
+    B.slice(t) = -WT;
+    b0.col(t) -= WT.t() * C.col(t * Ctv);
+    b0.col(t + 1) += RR_inv.slice(t * Rtv) * C.col(t * Ctv);
+  }
+  
+  arma::vec signal = mode_estimate;
+  arma::mat alpha(m, n);
+  double ll = -std::numeric_limits<double>::infinity();
+  arma::vec approx_y(n);
+  arma::vec approx_H(n);
+  unsigned int i = 0;
+  diff = conv_tol + 1;
+  while(i < max_iter && diff > conv_tol) {
+    i++;
+    profiler::count(profiler::laplace_iterations);
+    // add the pseudo-observations of the current approximation
+    laplace_iter(signal, approx_y, approx_H);
+    arma::cube A = A0;
+    arma::mat b = b0;
+    for (unsigned int t = 0; t < n; t++) {
+      if (arma::is_finite(approx_y(t))) {
+        double w = 1.0 / (approx_H(t) * approx_H(t));
+        double r = approx_y(t) - D(t * Dtv);
+        if (xreg.n_cols > 0) {
+          r -= xbeta(t);
+        }
+        A.slice(t) += w * Z.col(t * Ztv) * Z.col(t * Ztv).t();
+        b.col(t) += w * r * Z.col(t * Ztv);
+      }
+    }
+    arma::mat alpha_new;
+    if (!block_tridiag_solve(A, B, b, alpha_new)) {
+      return false;
+    }
+    arma::vec signal_new(n);
+    if (distribution == 0) {
+      signal_new = alpha_new.row(0).t();
+    } else {
+      for (unsigned int t = 0; t < n; t++) {
+        signal_new(t) = arma::as_scalar(Z.col(Ztv * t).t() * alpha_new.col(t));
+      }
+    }
+    double ll_new = log_obs_density(signal_new) - 
+      0.5 * block_tridiag_quad(A0, B, alpha_new) + arma::accu(b0 % alpha_new);
+    
+    // backtrack between the previous and the new estimate if the 
+    // log-density decreased
+    if (i > 1 && !(ll_new >= ll)) {
+      arma::mat alpha_full = alpha_new;
+      double step_size = 1.0;
+      for (unsigned int ii = 0; ii < 15 && !(ll_new >= ll); ii++) {
+        step_size /= 2.0;
+        alpha_new = (1.0 - step_size) * alpha + step_size * alpha_full;
+        if (distribution == 0) {
+          signal_new = alpha_new.row(0).t();
+        } else {
+          for (unsigned int t = 0; t < n; t++) {
+            signal_new(t) = arma::as_scalar(Z.col(Ztv * t).t() * alpha_new.col(t));
+          }
+        }
+        ll_new = log_obs_density(signal_new) - 
+          0.5 * block_tridiag_quad(A0, B, alpha_new) + arma::accu(b0 % alpha_new);
+      }
+    }
+    diff = arma::mean(arma::square(signal_new - signal));
+    signal = signal_new;
+    alpha = alpha_new;
+    ll = ll_new;
+  }
+  mode_estimate = signal;
+  return true;
+}
+
 // psi particle filter using Gaussian approximation //
 
 /*
@@ -251,6 +461,7 @@ double ung_ssm::psi_filter(const ugg_ssm& approx_model,
   const double approx_loglik, const arma::vec& scales,
   const unsigned int nsim, arma::cube& alpha, arma::mat& weights,
   arma::umat& indices) {
+  profiler::timer timer(profiler::psi_filter);
   
   arma::mat alphahat(m, n + 1);
   arma::cube Vt(m, m, n + 1);
@@ -483,8 +694,35 @@ arma::vec ung_ssm::log_obs_density(const unsigned int t,
   return weights;
 }
 
+double ung_ssm::log_obs_density(const arma::vec& signal) const {
+  
+  double logdens = 0.0;
+  for (unsigned int t = 0; t < n; t++) {
+    if (arma::is_finite(y(t))) {
+      switch(distribution) {
+      case 0  :
+        logdens -= 0.5 * (signal(t) + std::pow(y(t) / phi, 2.0) * std::exp(-signal(t)));
+        break;
+      case 1  :
+        logdens += y(t) * (signal(t) + xbeta(t)) - u(t) * std::exp(signal(t) + xbeta(t));
+        break;
+      case 2  :
+        logdens += y(t) * (signal(t) + xbeta(t)) - 
+          u(t) * std::log1p(std::exp(signal(t) + xbeta(t)));
+        break;
+      case 3  :
+        logdens += y(t) * (signal(t) + xbeta(t)) - (y(t) + phi) *
+          std::log(phi + u(t) * std::exp(signal(t) + xbeta(t)));
+        break;
+      }
+    }
+  }
+  return logdens;
+}
+
 double ung_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
   arma::mat& weights, arma::umat& indices) {
+  profiler::timer timer(profiler::bsf_filter);
   
   arma::uvec nonzero = arma::find(P1.diag() > 0);
   arma::mat L_P1(m, m, arma::fill::zeros);
@@ -527,6 +765,27 @@ double ung_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
       r(i) = unif(engine);
     }
     
+    bool observed = (t < (n - 1)) && arma::is_finite(y(t + 1));
+    // first stage weights of the auxiliary filter at the predicted means, 
+    // see nlg_ssm::bsf_filter
+    arma::vec first_stage;
+    if (auxiliary && observed) {
+      for (unsigned int i = 0; i < nsim; i++) {
+        alpha.slice(i).col(t + 1) = C.col(t * Ctv) + 
+          T.slice(t * Ttv) * alpha.slice(i).col(t);
+      }
+      first_stage = log_obs_density(t + 1, alpha);
+      double max_weight = first_stage.max();
+      arma::vec aux_weights = normalized_weights % arma::exp(first_stage - max_weight);
+      double sum_weights = arma::accu(aux_weights);
+      if(sum_weights > 0.0){
+        normalized_weights = aux_weights / sum_weights;
+      } else {
+        return -std::numeric_limits<double>::infinity();
+      }
+      loglik += max_weight + std::log(sum_weights);
+    }
+    
     indices.col(t) = stratified_sample(normalized_weights, r, nsim);
     
     arma::mat alphatmp(m, nsim);
@@ -534,6 +793,9 @@ double ung_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
     for (unsigned int i = 0; i < nsim; i++) {
       alphatmp.col(i) = alpha.slice(indices(i, t)).col(t);
     }
+    if (auxiliary && observed) {
+      first_stage = first_stage.elem(arma::uvec(indices.col(t)));
+    }
     
     for (unsigned int i = 0; i < nsim; i++) {
       arma::vec uk(k);
@@ -544,8 +806,11 @@ double ung_ssm::bsf_filter(const unsigned int nsim, arma::cube& alpha,
         T.slice(t * Ttv) * alphatmp.col(i) + R.slice(t * Rtv) * uk;
     }
     
-    if ((t < (n - 1)) && arma::is_finite(y(t + 1))) {
+    if (observed) {
       weights.col(t + 1) = log_obs_density(t + 1, alpha);
+      if (auxiliary) {
+        weights.col(t + 1) -= first_stage;
+      }
       
       double max_weight = weights.col(t + 1).max();
       weights.col(t + 1) = arma::exp(weights.col(t + 1) - max_weight);
@@ -603,6 +868,27 @@ arma::cube ung_ssm::predict_sample(const arma::mat& theta_posterior,
   return sample;
 }
 
+quantile_sketch ung_ssm::predict_summary(const arma::mat& theta_posterior,
+  const arma::mat& alpha, const arma::uvec& counts,
+  const unsigned int predict_type, const unsigned int nsim) {
+  
+  unsigned int d = 1;
+  if (predict_type == 3) d = m;
+  
+  // the repeated samples are replaced by the counts as weights
+  quantile_sketch sketch(d, n);
+  arma::cube sample(d, n, nsim);
+  for (unsigned int i = 0; i < theta_posterior.n_cols; i++) {
+    update_model(theta_posterior.col(i));
+    a1 = alpha.col(i);
+    sample.slices(0, nsim - 1) = sample_model(predict_type, nsim);
+    for (unsigned int j = 0; j < nsim; j++) {
+      sketch.add(sample.slice(j), counts(i));
+    }
+  }
+  return sketch;
+}
+
 
 arma::mat ung_ssm::sample_model(const unsigned int predict_type,
   const unsigned int nsim) {
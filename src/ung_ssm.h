@@ -6,6 +6,8 @@
 
 #include <sitmo.h>
 #include "bssm.h"
+#include "mode_cache.h"
+#include "quantile_sketch.h"
 
 class ugg_ssm;
 
@@ -13,12 +15,27 @@ class ung_ssm {
   
 public:
   
+#ifndef BSSM_STANDALONE
   // constructor from Rcpp::List
   ung_ssm(const Rcpp::List& model, 
     const unsigned int seed = 1, 
     const arma::uvec& Z_ind = arma::uvec(),
     const arma::uvec& T_ind = arma::uvec(), 
     const arma::uvec& R_ind = arma::uvec());
+#endif
+  
+  // constructor from armadillo objects
+  ung_ssm(const arma::vec& y, const arma::mat& Z, const arma::cube& T, 
+    const arma::cube& R, const arma::vec& a1, const arma::mat& P1, 
+    const double phi, const arma::vec& u, const unsigned int distribution,
+    const arma::mat& xreg, const arma::vec& beta, const arma::vec& D, 
+    const arma::mat& C, const unsigned int seed = 1, 
+    const arma::vec& theta = arma::vec(),
+    const arma::uvec& prior_distributions = arma::uvec(),
+    const arma::mat& prior_parameters = arma::mat(), 
+    const arma::uvec& Z_ind = arma::uvec(),
+    const arma::uvec& T_ind = arma::uvec(), 
+    const arma::uvec& R_ind = arma::uvec());
   
   // update model
   virtual void update_model(const arma::vec& new_theta);
@@ -39,9 +56,16 @@ public:
   ugg_ssm approximate(arma::vec& mode_estimate, const unsigned int max_iter, 
     const double conv_tol);
   
-  // update aproximating Gaussian model
+  // update aproximating Gaussian model, and if gaussian_loglik is given, 
+  // compute its log-likelihood (from the last smoothing of the mode search 
+  // when possible)
   void approximate(ugg_ssm& approx_model, arma::vec& mode_estimate, 
-    const unsigned int max_iter, const double conv_tol) const;
+    const unsigned int max_iter, const double conv_tol, 
+    double* gaussian_loglik = nullptr) const;
+  // find the mode of the signal using the block tridiagonal precision of 
+  // the states, returns false if the precision does not exist
+  bool newton_mode(arma::vec& mode_estimate, const unsigned int max_iter, 
+    const double conv_tol, double& diff) const;
   // psi-particle filter
   double psi_filter(const ugg_ssm& approx_model,
     const double approx_loglik, const arma::vec& scales,
@@ -63,12 +87,17 @@ public:
   
   // compute logarithms of _unnormalized_ densities g(y_t | alpha_t)
   arma::vec log_obs_density(const unsigned int t, const arma::cube& alphasim) const;
-  // bootstrap filter  
+  // compute logarithm of _unnormalized_ density g(y | signal)
+  double log_obs_density(const arma::vec& signal) const;
+  // bootstrap filter, or auxiliary particle filter if auxiliary is true
   double bsf_filter(const unsigned int nsim, arma::cube& alphasim, 
       arma::mat& weights, arma::umat& indices);
   
   arma::cube predict_sample(const arma::mat& theta_posterior, const arma::mat& alpha, 
     const arma::uvec& counts, const unsigned int predict_type, const unsigned int nsim);
+  // means and quantiles of the same samples without storing them
+  quantile_sketch predict_summary(const arma::mat& theta_posterior, const arma::mat& alpha, 
+    const arma::uvec& counts, const unsigned int predict_type, const unsigned int nsim);
   
   arma::mat sample_model(const unsigned int predict_type, const unsigned int nsim);
   
@@ -109,6 +138,16 @@ public:
   arma::vec theta;
   const arma::uvec prior_distributions;
   const arma::mat prior_parameters;
+  // find the mode by Newton's method instead of Kalman smoothing
+  bool newton;
+  // use the auxiliary particle filter in place of the bootstrap filter
+  bool auxiliary;
+  // system matrices modified by update_model, set by the constructors
+  enum { Z_theta = 1, T_theta = 2, R_theta = 4, a1_theta = 8, P1_theta = 16, 
+    C_theta = 32 };
+  unsigned int theta_matrices;
+  // converged modes of the approximations visited in MCMC
+  mutable mode_cache cached_modes;
   
 private:
   arma::uvec Z_ind;
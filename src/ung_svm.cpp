@@ -1,9 +1,12 @@
 #include "ung_svm.h"
 
+#ifndef BSSM_STANDALONE
 // construct SV model from Rcpp::List
 ung_svm::ung_svm(const Rcpp::List& model, const unsigned int seed) :
   ung_ssm(model, seed), svm_type(model["svm_type"]) {
+  theta_matrices |= T_theta | R_theta | a1_theta | P1_theta | C_theta;
 }
+#endif
 
 // update model given the parameters theta
 void ung_svm::update_model(const arma::vec& new_theta) {
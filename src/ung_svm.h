@@ -7,7 +7,9 @@ class ung_svm: public ung_ssm {
   
 public:
 
+#ifndef BSSM_STANDALONE
   ung_svm(const Rcpp::List& model, unsigned int seed);
+#endif
 
   
   // update model given the parameters theta
@@ -0,0 +1,347 @@
+// models used in the tests of nlg_ssm, compiled with Rcpp::sourceCpp
+//
+// the non-linear model has two states and two series, with state-dependent
+// H and R, and the linear model is the same as the Gaussian model
+// mv_gssm(y, Z = diag(2), H = diag(theta(0), 2), T = T_lin, R = diag(theta(1), 2))
+//
+// the non-linear model is also defined as a static model class of
+// bssm/nlg_static.h
+
+#include <RcppArmadillo.h>
+// [[Rcpp::depends(RcppArmadillo, sitmo, bssm)]]
+#include <bssm/nlg_static.h>
+
+arma::vec a1_fn(const arma::vec& theta, const arma::vec& known_params) {
+  return arma::zeros(2);
+}
+
+arma::mat P1_fn(const arma::vec& theta, const arma::vec& known_params) {
+  return arma::eye(2, 2);
+}
+
+double log_prior_pdf(const arma::vec& theta) {
+  if (arma::any(theta < 0)) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  return R::dnorm(theta(0), 0, 10, 1) + R::dnorm(theta(1), 0, 10, 1);
+}
+
+// non-linear model
+
+arma::vec Z_fn(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::vec Z(2);
+  Z(0) = alpha(0) + 0.1 * alpha(1) * alpha(1);
+  Z(1) = alpha(1);
+  return Z;
+}
+
+arma::mat Z_gn(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::mat Zg(2, 2, arma::fill::zeros);
+  Zg(0, 0) = 1.0;
+  Zg(0, 1) = 0.2 * alpha(1);
+  Zg(1, 1) = 1.0;
+  return Zg;
+}
+
+arma::mat H_fn(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::mat H(2, 2, arma::fill::zeros);
+  H(0, 0) = theta(0) * std::sqrt(1.0 + 0.1 * alpha(0) * alpha(0));
+  H(1, 1) = theta(0);
+  return H;
+}
+
+arma::vec T_fn(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::vec T(2);
+  T(0) = 0.8 * alpha(0) + 0.3 * std::sin(alpha(1));
+  T(1) = 0.9 * alpha(1);
+  return T;
+}
+
+arma::mat T_gn(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::mat Tg(2, 2, arma::fill::zeros);
+  Tg(0, 0) = 0.8;
+  Tg(0, 1) = 0.3 * std::cos(alpha(1));
+  Tg(1, 1) = 0.9;
+  return Tg;
+}
+
+arma::mat R_fn(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::mat R(2, 2, arma::fill::zeros);
+  R(0, 0) = theta(1) * std::exp(0.2 * std::tanh(alpha(0)));
+  R(1, 1) = theta(1);
+  return R;
+}
+
+void T_batch(const unsigned int t, const arma::mat& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params, arma::mat& result) {
+  result.row(0) = 0.8 * alpha.row(0) + 0.3 * arma::sin(alpha.row(1));
+  result.row(1) = 0.9 * alpha.row(1);
+}
+
+void Z_batch(const unsigned int t, const arma::mat& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params, arma::mat& result) {
+  result.row(0) = alpha.row(0) + 0.1 * arma::square(alpha.row(1));
+  result.row(1) = alpha.row(1);
+}
+
+// linear-Gaussian model
+
+arma::vec Z_lin(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  return alpha;
+}
+
+arma::mat Z_gn_lin(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  return arma::eye(2, 2);
+}
+
+arma::mat H_lin(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  return theta(0) * arma::eye(2, 2);
+}
+
+arma::mat T_gn_lin(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  arma::mat Tg(2, 2, arma::fill::zeros);
+  Tg(0, 0) = 0.8;
+  Tg(0, 1) = 0.3;
+  Tg(1, 1) = 0.9;
+  return Tg;
+}
+
+arma::vec T_lin(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  return T_gn_lin(t, alpha, theta, known_params, known_tv_params) * alpha;
+}
+
+arma::mat R_lin(const unsigned int t, const arma::vec& alpha, const arma::vec& theta,
+  const arma::vec& known_params, const arma::mat& known_tv_params) {
+  return theta(1) * arma::eye(2, 2);
+}
+
+// [[Rcpp::export]]
+Rcpp::List nlg_test_pointers(const bool linear) {
+
+  typedef arma::vec (*nvec_fnPtr)(const unsigned int t, const arma::vec& alpha,
+    const arma::vec& theta, const arma::vec& known_params, const arma::mat& known_tv_params);
+  typedef arma::mat (*nmat_fnPtr)(const unsigned int t, const arma::vec& alpha,
+    const arma::vec& theta, const arma::vec& known_params, const arma::mat& known_tv_params);
+  typedef void (*nbatch_fnPtr)(const unsigned int t, const arma::mat& alpha,
+    const arma::vec& theta, const arma::vec& known_params, const arma::mat& known_tv_params,
+    arma::mat& result);
+  typedef arma::vec (*a1_fnPtr)(const arma::vec& theta, const arma::vec& known_params);
+  typedef arma::mat (*P1_fnPtr)(const arma::vec& theta, const arma::vec& known_params);
+  typedef double (*prior_fnPtr)(const arma::vec&);
+
+  return Rcpp::List::create(
+    Rcpp::Named("a1_fn") = Rcpp::XPtr<a1_fnPtr>(new a1_fnPtr(&a1_fn)),
+    Rcpp::Named("P1_fn") = Rcpp::XPtr<P1_fnPtr>(new P1_fnPtr(&P1_fn)),
+    Rcpp::Named("Z_fn") = Rcpp::XPtr<nvec_fnPtr>(new nvec_fnPtr(linear ? &Z_lin : &Z_fn)),
+    Rcpp::Named("H_fn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(linear ? &H_lin : &H_fn)),
+    Rcpp::Named("T_fn") = Rcpp::XPtr<nvec_fnPtr>(new nvec_fnPtr(linear ? &T_lin : &T_fn)),
+    Rcpp::Named("R_fn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(linear ? &R_lin : &R_fn)),
+    Rcpp::Named("Z_gn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(linear ? &Z_gn_lin : &Z_gn)),
+    Rcpp::Named("T_gn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(linear ? &T_gn_lin : &T_gn)),
+    Rcpp::Named("T_batch") = Rcpp::XPtr<nbatch_fnPtr>(new nbatch_fnPtr(&T_batch)),
+    Rcpp::Named("Z_batch") = Rcpp::XPtr<nbatch_fnPtr>(new nbatch_fnPtr(&Z_batch)),
+    Rcpp::Named("log_prior_pdf") =
+      Rcpp::XPtr<prior_fnPtr>(new prior_fnPtr(&log_prior_pdf)));
+}
+
+// the non-linear model as a static model class
+
+struct static_model : nlg_static_dims<2, 2, 2> {
+
+  static obs_vec Z(const unsigned int t, const state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    return Z_fn(t, alpha, theta, known_params, known_tv_params);
+  }
+  static obs_mat H(const unsigned int t, const state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    return H_fn(t, alpha, theta, known_params, known_tv_params);
+  }
+  static state_vec T(const unsigned int t, const state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    return T_fn(t, alpha, theta, known_params, known_tv_params);
+  }
+  static noise_mat R(const unsigned int t, const state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    return R_fn(t, alpha, theta, known_params, known_tv_params);
+  }
+  static obs_state_mat Z_gn(const unsigned int t, const state_vec& alpha,
+    const arma::vec& theta, const arma::vec& known_params, const arma::mat& known_tv_params) {
+    return ::Z_gn(t, alpha, theta, known_params, known_tv_params);
+  }
+  static state_mat T_gn(const unsigned int t, const state_vec& alpha,
+    const arma::vec& theta, const arma::vec& known_params, const arma::mat& known_tv_params) {
+    return ::T_gn(t, alpha, theta, known_params, known_tv_params);
+  }
+  static state_vec a1(const arma::vec& theta, const arma::vec& known_params) {
+    return a1_fn(theta, known_params);
+  }
+  static state_mat P1(const arma::vec& theta, const arma::vec& known_params) {
+    return P1_fn(theta, known_params);
+  }
+  static double log_prior_pdf(const arma::vec& theta) {
+    return ::log_prior_pdf(theta);
+  }
+};
+
+// [[Rcpp::export]]
+Rcpp::List static_test_pointers() {
+  return nlg_static_pointers<static_model>();
+}
+
+// [[Rcpp::export]]
+double static_ekf_loglik(const arma::mat& y, const arma::vec& theta) {
+  nlg_static_ssm<static_model> model(y, theta, arma::zeros(1), arma::zeros(1, 1), 1);
+  return model.ekf_loglik();
+}
+
+// [[Rcpp::export]]
+double static_bsf_loglik(const arma::mat& y, const arma::vec& theta,
+  const unsigned int nsim, const unsigned int seed) {
+  nlg_static_ssm<static_model> model(y, theta, arma::zeros(1), arma::zeros(1, 1), seed);
+  arma::cube alpha(model.m, model.n + 1, nsim);
+  arma::mat weights(nsim, model.n + 1);
+  arma::umat indices(nsim, model.n);
+  return model.bsf_filter(nsim, alpha, weights, indices);
+}
+
+// the inlined filters as exported to R by the users
+// [[Rcpp::export]]
+double static_loglik(const arma::mat& y, const arma::vec& theta,
+  const unsigned int nsim, const unsigned int seed) {
+  return nlg_static_loglik<static_model>(y, theta, arma::zeros(1),
+    arma::zeros(1, 1), nsim, seed);
+}
+
+// the same model with the Jacobians of Z and T by automatic differentiation
+
+struct ad_model : nlg_static_ad<ad_model, 2, 2, 2> {
+
+  template <class S>
+  static void Z_fn(const unsigned int t, const S* alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params, S* result) {
+    result[0] = alpha[0] + 0.1 * alpha[1] * alpha[1];
+    result[1] = alpha[1];
+  }
+  template <class S>
+  static void T_fn(const unsigned int t, const S* alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params, S* result) {
+    using std::sin;
+    result[0] = 0.8 * alpha[0] + 0.3 * sin(alpha[1]);
+    result[1] = 0.9 * alpha[1];
+  }
+  static obs_mat H(const unsigned int t, const state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    return H_fn(t, alpha, theta, known_params, known_tv_params);
+  }
+  static noise_mat R(const unsigned int t, const state_vec& alpha, const arma::vec& theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params) {
+    return R_fn(t, alpha, theta, known_params, known_tv_params);
+  }
+  static state_vec a1(const arma::vec& theta, const arma::vec& known_params) {
+    return a1_fn(theta, known_params);
+  }
+  static state_mat P1(const arma::vec& theta, const arma::vec& known_params) {
+    return P1_fn(theta, known_params);
+  }
+  static double log_prior_pdf(const arma::vec& theta) {
+    return ::log_prior_pdf(theta);
+  }
+};
+
+// [[Rcpp::export]]
+Rcpp::List ad_test_pointers() {
+  return nlg_static_pointers<ad_model>();
+}
+
+// Jacobians of Z and T at alpha by automatic differentiation and by hand
+// [[Rcpp::export]]
+Rcpp::List test_jacobians(const arma::vec& alpha, const arma::vec& theta) {
+  ad_model::state_vec x(alpha);
+  arma::vec known_params = arma::zeros(1);
+  arma::mat known_tv_params = arma::zeros(1, 1);
+  return Rcpp::List::create(
+    Rcpp::Named("Z_ad") = arma::mat(ad_model::Z_gn(0, x, theta, known_params, known_tv_params)),
+    Rcpp::Named("T_ad") = arma::mat(ad_model::T_gn(0, x, theta, known_params, known_tv_params)),
+    Rcpp::Named("Z_gn") = Z_gn(0, alpha, theta, known_params, known_tv_params),
+    Rcpp::Named("T_gn") = T_gn(0, alpha, theta, known_params, known_tv_params));
+}
+
+// the same model with all functions templated over the scalar type, which
+// gives also the gradient of the EKF log-likelihood with respect to theta
+
+struct grad_model : nlg_static_grad<grad_model, 2, 2, 2, 2> {
+
+  template <class S>
+  static void Z_fn(const unsigned int t, const S* alpha, const S* theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params, S* result) {
+    result[0] = alpha[0] + 0.1 * alpha[1] * alpha[1];
+    result[1] = alpha[1];
+  }
+  template <class S>
+  static void H_fn(const unsigned int t, const S* alpha, const S* theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params, S* result) {
+    using std::sqrt;
+    result[0] = theta[0] * sqrt(1.0 + 0.1 * alpha[0] * alpha[0]);
+    result[1] = 0.0;
+    result[2] = 0.0;
+    result[3] = theta[0];
+  }
+  template <class S>
+  static void T_fn(const unsigned int t, const S* alpha, const S* theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params, S* result) {
+    using std::sin;
+    result[0] = 0.8 * alpha[0] + 0.3 * sin(alpha[1]);
+    result[1] = 0.9 * alpha[1];
+  }
+  template <class S>
+  static void R_fn(const unsigned int t, const S* alpha, const S* theta,
+    const arma::vec& known_params, const arma::mat& known_tv_params, S* result) {
+    using std::exp;
+    using std::tanh;
+    result[0] = theta[1] * exp(0.2 * tanh(alpha[0]));
+    result[1] = 0.0;
+    result[2] = 0.0;
+    result[3] = theta[1];
+  }
+  template <class S>
+  static void a1_fn(const S* theta, const arma::vec& known_params, S* result) {
+    result[0] = 0.0;
+    result[1] = 0.0;
+  }
+  template <class S>
+  static void P1_fn(const S* theta, const arma::vec& known_params, S* result) {
+    result[0] = 1.0;
+    result[1] = 0.0;
+    result[2] = 0.0;
+    result[3] = 1.0;
+  }
+  static double log_prior_pdf(const arma::vec& theta) {
+    return ::log_prior_pdf(theta);
+  }
+};
+
+// [[Rcpp::export]]
+Rcpp::List grad_test_pointers() {
+  return nlg_static_pointers<grad_model>();
+}
+
+// [[Rcpp::export]]
+Rcpp::List static_ekf_gradient(const arma::mat& y, const arma::vec& theta) {
+  nlg_static_ssm<grad_model> model(y, theta, arma::zeros(1), arma::zeros(1, 1), 1);
+  arma::vec gradient;
+  double loglik = model.ekf_loglik_gradient(gradient);
+  return Rcpp::List::create(Rcpp::Named("logLik") = loglik,
+    Rcpp::Named("gradient") = gradient, 
+    Rcpp::Named("ekf_logLik") = model.ekf_loglik());
+}
@@ -0,0 +1,127 @@
+// models used in the tests of sde_ssm and msde_ssm, compiled with Rcpp::sourceCpp
+//
+// geometric Brownian motion dx = theta(0) x dt + theta(1) x dW observed with
+// gaussian noise with standard deviation theta(2), as a univariate sde_ssm and
+// as msde_ssm with m = 1, and m independent copies of it as msde_ssm with
+// batched drift and diffusion
+
+#include <RcppArmadillo.h>
+// [[Rcpp::depends(RcppArmadillo)]]
+
+double log_prior_pdf(const arma::vec& theta) {
+  if (arma::any(theta.tail(2) <= 0)) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  return 0.0;
+}
+
+// univariate functions of sde_ssm
+
+double drift(const double x, const arma::vec& theta) {
+  return theta(0) * x;
+}
+
+double diffusion(const double x, const arma::vec& theta) {
+  return theta(1) * x;
+}
+
+double ddiffusion(const double x, const arma::vec& theta) {
+  return theta(1);
+}
+
+// the Euler-Maruyama scheme with sde_ssm
+double ddiffusion_zero(const double x, const arma::vec& theta) {
+  return 0.0;
+}
+
+arma::vec obs_density(const double y, const arma::vec& alpha,
+  const arma::vec& theta) {
+  return -0.5 * arma::square(y - alpha) / (theta(2) * theta(2)) - std::log(theta(2));
+}
+
+// multivariate functions of msde_ssm
+
+arma::vec mdrift(const arma::vec& x, const arma::vec& theta) {
+  return theta(0) * x;
+}
+
+arma::mat mdiffusion(const arma::vec& x, const arma::vec& theta) {
+  return arma::diagmat(theta(1) * x);
+}
+
+arma::cube mddiffusion(const arma::vec& x, const arma::vec& theta) {
+  arma::cube dsigma(x.n_elem, x.n_elem, x.n_elem, arma::fill::zeros);
+  for (unsigned int l = 0; l < x.n_elem; l++) {
+    dsigma(l, l, l) = theta(1);
+  }
+  return dsigma;
+}
+
+void mdrift_batch(const arma::mat& X, const arma::vec& theta, arma::mat& result) {
+  result = theta(0) * X;
+}
+
+void mdiffusion_batch(const arma::mat& X, const arma::vec& theta, arma::cube& result) {
+  result.zeros();
+  for (unsigned int i = 0; i < X.n_cols; i++) {
+    result.slice(i).diag() = theta(1) * X.col(i);
+  }
+}
+
+arma::vec mobs_density(const arma::vec& y, const arma::mat& alpha,
+  const arma::vec& theta) {
+  arma::vec log_dens(alpha.n_cols, arma::fill::zeros);
+  arma::uvec obs_y = arma::find_finite(y);
+  for (unsigned int j = 0; j < obs_y.n_elem; j++) {
+    log_dens += -0.5 * arma::square(y(obs_y(j)) - alpha.row(obs_y(j)).t()) /
+      (theta(2) * theta(2)) - std::log(theta(2));
+  }
+  return log_dens;
+}
+
+// [[Rcpp::export]]
+Rcpp::List sde_test_pointers() {
+
+  typedef double (*funcPtr)(const double x, const arma::vec& theta);
+  typedef double (*prior_funcPtr)(const arma::vec& theta);
+  typedef arma::vec (*obs_funcPtr)(const double y, const arma::vec& alpha,
+    const arma::vec& theta);
+
+  return Rcpp::List::create(
+    Rcpp::Named("drift") = Rcpp::XPtr<funcPtr>(new funcPtr(&drift)),
+    Rcpp::Named("diffusion") = Rcpp::XPtr<funcPtr>(new funcPtr(&diffusion)),
+    Rcpp::Named("ddiffusion") = Rcpp::XPtr<funcPtr>(new funcPtr(&ddiffusion)),
+    Rcpp::Named("ddiffusion_zero") = Rcpp::XPtr<funcPtr>(new funcPtr(&ddiffusion_zero)),
+    Rcpp::Named("obs_density") = Rcpp::XPtr<obs_funcPtr>(new obs_funcPtr(&obs_density)),
+    Rcpp::Named("log_prior_pdf") =
+      Rcpp::XPtr<prior_funcPtr>(new prior_funcPtr(&log_prior_pdf)));
+}
+
+// [[Rcpp::export]]
+Rcpp::List msde_test_pointers() {
+
+  typedef arma::vec (*mdrift_fnPtr)(const arma::vec& x, const arma::vec& theta);
+  typedef arma::mat (*mdiffusion_fnPtr)(const arma::vec& x, const arma::vec& theta);
+  typedef arma::cube (*mddiffusion_fnPtr)(const arma::vec& x, const arma::vec& theta);
+  typedef void (*mdrift_batch_fnPtr)(const arma::mat& X, const arma::vec& theta,
+    arma::mat& result);
+  typedef void (*mdiffusion_batch_fnPtr)(const arma::mat& X, const arma::vec& theta,
+    arma::cube& result);
+  typedef double (*mprior_fnPtr)(const arma::vec& theta);
+  typedef arma::vec (*mobs_fnPtr)(const arma::vec& y, const arma::mat& alpha,
+    const arma::vec& theta);
+
+  return Rcpp::List::create(
+    Rcpp::Named("drift") = Rcpp::XPtr<mdrift_fnPtr>(new mdrift_fnPtr(&mdrift)),
+    Rcpp::Named("diffusion") =
+      Rcpp::XPtr<mdiffusion_fnPtr>(new mdiffusion_fnPtr(&mdiffusion)),
+    Rcpp::Named("ddiffusion") =
+      Rcpp::XPtr<mddiffusion_fnPtr>(new mddiffusion_fnPtr(&mddiffusion)),
+    Rcpp::Named("drift_batch") =
+      Rcpp::XPtr<mdrift_batch_fnPtr>(new mdrift_batch_fnPtr(&mdrift_batch)),
+    Rcpp::Named("diffusion_batch") =
+      Rcpp::XPtr<mdiffusion_batch_fnPtr>(new mdiffusion_batch_fnPtr(&mdiffusion_batch)),
+    Rcpp::Named("obs_density") = Rcpp::XPtr<mobs_fnPtr>(new mobs_fnPtr(&mobs_density)),
+    Rcpp::Named("log_prior_pdf") =
+      Rcpp::XPtr<mprior_fnPtr>(new mprior_fnPtr(&log_prior_pdf)));
+}
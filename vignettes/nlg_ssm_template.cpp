@@ -78,6 +78,20 @@ arma::vec T_fn(const unsigned int t, const arma::vec& alpha, const arma::vec& th
   return alpha_new;
 }
 
+// batched T function (optional), evaluates T at all particles (columns of alpha)
+// at once, which avoids the overhead of calling T_fn separately for each particle
+// [[Rcpp::export]]
+void T_batch(const unsigned int t, const arma::mat& alpha, const arma::vec& theta, 
+  const arma::vec& known_params, const arma::mat& known_tv_params, arma::mat& result) {
+  
+  double dT = known_params(0);
+  double k = known_params(1);
+  
+  arma::rowvec tmp = arma::exp(alpha.row(0) * dT);
+  result.row(0) = alpha.row(0);
+  result.row(1) = k * alpha.row(1) % tmp / (k + alpha.row(1) % (tmp - 1));
+}
+
 // Jacobian of T function
 // [[Rcpp::export]]
 arma::mat T_gn(const unsigned int t, const arma::vec& alpha, const arma::vec& theta, 
@@ -126,6 +140,11 @@ Rcpp::List create_xptrs() {
   typedef arma::mat (*nmat_fnPtr)(const unsigned int t, const arma::vec& alpha, 
     const arma::vec& theta, const arma::vec& known_params, const arma::mat& known_tv_params);
   
+  // typedef for a pointer of batched nonlinear function (T, Z) 
+  typedef void (*nbatch_fnPtr)(const unsigned int t, const arma::mat& alpha, 
+    const arma::vec& theta, const arma::vec& known_params, const arma::mat& known_tv_params,
+    arma::mat& result);
+  
   // typedef for a pointer returning a1
   typedef arma::vec (*a1_fnPtr)(const arma::vec& theta, const arma::vec& known_params);
   // typedef for a pointer returning P1
@@ -142,6 +161,7 @@ Rcpp::List create_xptrs() {
     Rcpp::Named("R_fn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(&R_fn)),
     Rcpp::Named("Z_gn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(&Z_gn)),
     Rcpp::Named("T_gn") = Rcpp::XPtr<nmat_fnPtr>(new nmat_fnPtr(&T_gn)),
+    Rcpp::Named("T_batch") = Rcpp::XPtr<nbatch_fnPtr>(new nbatch_fnPtr(&T_batch)),
     Rcpp::Named("log_prior_pdf") = 
       Rcpp::XPtr<prior_fnPtr>(new prior_fnPtr(&log_prior_pdf)));
   